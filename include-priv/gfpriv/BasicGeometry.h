@@ -21,6 +21,7 @@
 #ifndef GFPRIV_BASIC_GEOMETRY_H
 #define GFPRIV_BASIC_GEOMETRY_H
 
+#include <gf/Rect.h>
 #include <gf/Span.h>
 #include <gf/Vector.h>
 
@@ -31,6 +32,10 @@ namespace priv {
 
   float computeSignedArea(Span<const Vector2f> points);
 
+  float computeSquareDistance(Vector2f point, const RectF& rect);
+
+  bool computeRayFraction(Vector2f origin, Vector2f displacement, const RectF& rect, float& fraction);
+
 }
 }
 
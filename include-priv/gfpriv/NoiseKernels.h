@@ -0,0 +1,322 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#ifndef GFPRIV_NOISE_KERNELS_H
+#define GFPRIV_NOISE_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include <gf/Noises.h>
+#include <gf/Vector.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GF_NOISE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define GF_NOISE_AVX2 1
+#endif
+
+/*
+ * Batched kernels for the simplex-like noises.
+ *
+ * A kernel evaluates a row of a grid, Pack::Size samples at a time. The
+ * floating-point computations are done on the packs in the same order as in
+ * the scalar getValue() so that the results are the same bit for bit. The
+ * table lookups (permutations, gradients) are done lane by lane.
+ *
+ * The AVX2 pack is defined in Noises_Avx2.cc that is compiled with the
+ * corresponding target. Everything in this header must stay inline or
+ * template: no function of this header may be odr-used with different
+ * targets in different translation units, except through a pack that is only
+ * defined in one of them.
+ */
+
+namespace gf {
+namespace priv {
+
+  constexpr Vector2d SimplexGradients2D[8] = {
+    {  1.0,  2.0 },
+    { -1.0,  2.0 },
+    {  1.0, -2.0 },
+    { -1.0, -2.0 },
+    {  2.0,  1.0 },
+    {  2.0, -1.0 },
+    { -2.0,  1.0 },
+    { -2.0, -1.0 }
+  };
+
+  struct OpenSimplexLatticePoint2D {
+    constexpr OpenSimplexLatticePoint2D(int x, int y)
+    : xsv(x)
+    , ysv(y)
+    , dx(0.0)
+    , dy(0.0)
+    {
+      double ssv = (xsv + ysv) * -0.211324865405187;
+      dx = -xsv - ssv;
+      dy = -ysv - ssv;
+    }
+
+    int xsv, ysv;
+    double dx, dy;
+  };
+
+  struct OpenSimplex2DKernelData {
+    const uint16_t *perm;
+    const Vector2d *gradients;
+    const OpenSimplexLatticePoint2D *lookup;
+    std::size_t points;
+    double attn;
+    OpenSimplexType type;
+    OpenSimplex2DVariant variant;
+  };
+
+#ifdef GF_NOISE_AVX2
+  bool isAvx2Available();
+  int fillSimplexNoise2DRowAvx2(const uint8_t *perm, double originX, double stepX, double y, int width, double *values);
+  int fillOpenSimplexNoise2DRowAvx2(const OpenSimplex2DKernelData& data, double originX, double stepX, double y, int width, double *values);
+#endif
+
+#ifdef GF_NOISE_SSE2
+  struct Sse2Pack {
+    using Type = __m128d;
+    static constexpr int Size = 2;
+
+    static Type broadcast(double value) { return _mm_set1_pd(value); }
+    static Type load(const double *values) { return _mm_loadu_pd(values); }
+    static void store(double *values, Type a) { _mm_storeu_pd(values, a); }
+
+    static Type add(Type a, Type b) { return _mm_add_pd(a, b); }
+    static Type sub(Type a, Type b) { return _mm_sub_pd(a, b); }
+    static Type mul(Type a, Type b) { return _mm_mul_pd(a, b); }
+
+    static Type greater(Type a, Type b) { return _mm_cmpgt_pd(a, b); }
+    // keep a where mask is set, zero elsewhere
+    static Type select(Type mask, Type a) { return _mm_and_pd(mask, a); }
+
+    static Type floor(Type a) {
+      // exact as long as the values fit in an int, like fastFloor()
+      Type truncated = _mm_cvtepi32_pd(_mm_cvttpd_epi32(a));
+      Type adjust = _mm_and_pd(_mm_cmpgt_pd(truncated, a), _mm_set1_pd(1.0));
+      return _mm_sub_pd(truncated, adjust);
+    }
+  };
+#endif
+
+  template<typename Pack>
+  int fillSimplexNoise2DRow(const uint8_t *perm, double originX, double stepX, double y, int width, double *values) {
+    using Type = typename Pack::Type;
+    constexpr int Size = Pack::Size;
+
+    static constexpr double F2 = .366025403784438646763723170752; // (sqrt(3) - 1) / 2
+    static constexpr double G2 = .211324865405187117745425609748; // K / (1 + 2 * K)
+
+    auto gradientAt = [perm](uint8_t i, uint8_t j) -> const Vector2d& {
+      uint8_t index = i;
+      index = perm[index] + j;
+      return SimplexGradients2D[perm[index] % 8];
+    };
+
+    const Type zero = Pack::broadcast(0.0);
+    const Type one = Pack::broadcast(1.0);
+
+    alignas(32) double lanes[3][Size];
+    alignas(32) double gradients[6][Size];
+
+    int i = 0;
+
+    for (; i + Size <= width; i += Size) {
+      for (int k = 0; k < Size; ++k) {
+        lanes[0][k] = originX + (i + k) * stepX;
+      }
+
+      Type vx = Pack::load(lanes[0]);
+      Type vy = Pack::broadcast(y);
+
+      Type s = Pack::mul(Pack::add(vx, vy), Pack::broadcast(F2));
+      Type vi = Pack::floor(Pack::add(vx, s));
+      Type vj = Pack::floor(Pack::add(vy, s));
+
+      Type t = Pack::mul(Pack::add(vi, vj), Pack::broadcast(G2));
+      Type x0 = Pack::sub(vx, Pack::sub(vi, t));
+      Type y0 = Pack::sub(vy, Pack::sub(vj, t));
+
+      Type upper = Pack::greater(x0, y0);
+      Type i1 = Pack::select(upper, one);
+      Type j1 = Pack::sub(one, i1);
+
+      Type x1 = Pack::add(Pack::sub(x0, i1), Pack::broadcast(G2));
+      Type y1 = Pack::add(Pack::sub(y0, j1), Pack::broadcast(G2));
+      Type x2 = Pack::add(Pack::sub(x0, one), Pack::broadcast(2 * G2));
+      Type y2 = Pack::add(Pack::sub(y0, one), Pack::broadcast(2 * G2));
+
+      Pack::store(lanes[0], vi);
+      Pack::store(lanes[1], vj);
+      Pack::store(lanes[2], i1);
+
+      for (int k = 0; k < Size; ++k) {
+        uint8_t ii = static_cast<uint8_t>(static_cast<int>(lanes[0][k]));
+        uint8_t jj = static_cast<uint8_t>(static_cast<int>(lanes[1][k]));
+        uint8_t di = lanes[2][k] > 0.0 ? 1 : 0;
+
+        const Vector2d& g0 = gradientAt(ii, jj);
+        const Vector2d& g1 = gradientAt(ii + di, jj + 1 - di);
+        const Vector2d& g2 = gradientAt(ii + 1, jj + 1);
+
+        gradients[0][k] = g0.x;
+        gradients[1][k] = g0.y;
+        gradients[2][k] = g1.x;
+        gradients[3][k] = g1.y;
+        gradients[4][k] = g2.x;
+        gradients[5][k] = g2.y;
+      }
+
+      Type res = zero;
+
+      auto contribute = [&](Type dx, Type dy, const double *gx, const double *gy) {
+        Type d = Pack::sub(Pack::sub(Pack::broadcast(0.5), Pack::mul(dx, dx)), Pack::mul(dy, dy));
+        Type d2 = Pack::mul(d, d);
+        Type dot = Pack::add(Pack::mul(Pack::load(gx), dx), Pack::mul(Pack::load(gy), dy));
+        res = Pack::add(res, Pack::select(Pack::greater(d, zero), Pack::mul(Pack::mul(d2, d2), dot)));
+      };
+
+      contribute(x0, y0, gradients[0], gradients[1]);
+      contribute(x1, y1, gradients[2], gradients[3]);
+      contribute(x2, y2, gradients[4], gradients[5]);
+
+      Pack::store(values + i, Pack::mul(Pack::broadcast(45.23065), res));
+    }
+
+    return i;
+  }
+
+  template<typename Pack>
+  int fillOpenSimplexNoise2DRow(const OpenSimplex2DKernelData& data, double originX, double stepX, double y, int width, double *values) {
+    using Type = typename Pack::Type;
+    constexpr int Size = Pack::Size;
+    constexpr std::size_t PMask = 2047;
+
+    const Type zero = Pack::broadcast(0.0);
+
+    alignas(32) double lanes[4][Size];
+    alignas(32) double offsets[4][Size];
+    int xsb[Size];
+    int ysb[Size];
+    std::size_t index[Size] = {};
+
+    int i = 0;
+
+    for (; i + Size <= width; i += Size) {
+      for (int k = 0; k < Size; ++k) {
+        lanes[0][k] = originX + (i + k) * stepX;
+      }
+
+      Type vx = Pack::load(lanes[0]);
+      Type vy = Pack::broadcast(y);
+      Type xs = zero;
+      Type ys = zero;
+
+      switch (data.variant) {
+        case OpenSimplex2DVariant::Classic: {
+          Type s = Pack::mul(Pack::broadcast(0.366025403784439), Pack::add(vx, vy));
+          xs = Pack::add(vx, s);
+          ys = Pack::add(vy, s);
+          break;
+        }
+
+        case OpenSimplex2DVariant::XBeforeY: {
+          Type xx = Pack::mul(vx, Pack::broadcast(0.7071067811865476));
+          Type yy = Pack::mul(vy, Pack::broadcast(1.224744871380249));
+          xs = Pack::add(yy, xx);
+          ys = Pack::sub(yy, xx);
+          break;
+        }
+      }
+
+      Type xsf = Pack::floor(xs);
+      Type ysf = Pack::floor(ys);
+      Type xsi = Pack::sub(xs, xsf);
+      Type ysi = Pack::sub(ys, ysf);
+
+      Pack::store(lanes[0], xsf);
+      Pack::store(lanes[1], ysf);
+      Pack::store(lanes[2], xsi);
+      Pack::store(lanes[3], ysi);
+
+      for (int k = 0; k < Size; ++k) {
+        xsb[k] = static_cast<int>(lanes[0][k]);
+        ysb[k] = static_cast<int>(lanes[1][k]);
+        double xi = lanes[2][k];
+        double yi = lanes[3][k];
+
+        switch (data.type) {
+          case OpenSimplexType::Super: {
+            std::size_t a = static_cast<std::size_t>(xi + yi);
+            index[k] = (a << 2) |
+              static_cast<std::size_t>(xi - yi / 2 + 1 - a / 2.0) << 3 |
+              static_cast<std::size_t>(yi - xi / 2 + 1 - a / 2.0) << 4;
+            break;
+          }
+
+          case OpenSimplexType::Fast:
+            index[k] = static_cast<std::size_t>((yi - xi) / 2 + 1);
+            break;
+        }
+      }
+
+      Type ssi = Pack::mul(Pack::add(xsi, ysi), Pack::broadcast(-0.211324865405187));
+      Type vxi = Pack::add(xsi, ssi);
+      Type vyi = Pack::add(ysi, ssi);
+
+      Type value = zero;
+
+      for (std::size_t p = 0; p < data.points; ++p) {
+        for (int k = 0; k < Size; ++k) {
+          const OpenSimplexLatticePoint2D& c = data.lookup[index[k] + p];
+          std::size_t pxm = (xsb[k] + c.xsv) & PMask;
+          std::size_t pym = (ysb[k] + c.ysv) & PMask;
+          const Vector2d& grad = data.gradients[data.perm[pxm] ^ pym];
+          offsets[0][k] = c.dx;
+          offsets[1][k] = c.dy;
+          offsets[2][k] = grad.x;
+          offsets[3][k] = grad.y;
+        }
+
+        Type dx = Pack::add(vxi, Pack::load(offsets[0]));
+        Type dy = Pack::add(vyi, Pack::load(offsets[1]));
+        Type attn = Pack::sub(Pack::sub(Pack::broadcast(data.attn), Pack::mul(dx, dx)), Pack::mul(dy, dy));
+        Type extrapolation = Pack::add(Pack::mul(Pack::load(offsets[2]), dx), Pack::mul(Pack::load(offsets[3]), dy));
+        Type attn2 = Pack::mul(attn, attn);
+        value = Pack::add(value, Pack::select(Pack::greater(attn, zero), Pack::mul(Pack::mul(attn2, attn2), extrapolation)));
+      }
+
+      Pack::store(values + i, value);
+    }
+
+    return i;
+  }
+
+}
+}
+
+#endif // GFPRIV_NOISE_KERNELS_H
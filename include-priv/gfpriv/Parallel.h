@@ -0,0 +1,229 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#ifndef GFPRIV_PARALLEL_H
+#define GFPRIV_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gf {
+namespace priv {
+
+  // set in the threads that are already workers (e.g. the chunk generation
+  // threads) so that the computations they run stay on the same thread
+  inline thread_local bool serialOnly = false;
+
+  inline std::size_t computeThreadCount(std::size_t count) {
+    if (serialOnly) {
+      return 1;
+    }
+
+    std::size_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    return std::min(threadCount, count);
+  }
+
+  /*
+   * Call function(i) for all i in [0, count), on all the available threads.
+   * The calls for the different indices must be independent.
+   */
+  template<typename Function>
+  void parallelFor(std::size_t count, Function function) {
+    const std::size_t threadCount = computeThreadCount(count);
+
+    if (threadCount <= 1) {
+      for (std::size_t i = 0; i < count; ++i) {
+        function(i);
+      }
+
+      return;
+    }
+
+    std::atomic<std::size_t> next(0);
+
+    auto worker = [&]() {
+      for (;;) {
+        std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+
+        if (i >= count) {
+          return;
+        }
+
+        function(i);
+      }
+    };
+
+    std::vector<std::thread> threads;
+
+    for (std::size_t i = 1; i < threadCount; ++i) {
+      threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+
+  /*
+   * A team of threads for many successive parallel loops. The threads are
+   * created once and wait between two loops, so that a computation made of
+   * many short passes does not create new threads for each pass. The calling
+   * thread takes part in the loops.
+   */
+  class ParallelTeam {
+  public:
+    explicit ParallelTeam(std::size_t count)
+    {
+      const std::size_t threadCount = computeThreadCount(count);
+
+      for (std::size_t i = 1; i < threadCount; ++i) {
+        m_threads.emplace_back([this]() { work(); });
+      }
+    }
+
+    ParallelTeam(const ParallelTeam&) = delete;
+    ParallelTeam& operator=(const ParallelTeam&) = delete;
+
+    ~ParallelTeam() {
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+      }
+
+      m_started.notify_all();
+
+      for (auto& thread : m_threads) {
+        thread.join();
+      }
+    }
+
+    /*
+     * Call function(i) for all i in [0, count), on all the threads of the
+     * team, and return when all the calls are finished. The calls for the
+     * different indices must be independent. If a call throws, the remaining
+     * indices are skipped and the exception is thrown in the calling thread.
+     */
+    template<typename Function>
+    void parallelFor(std::size_t count, Function function) {
+      if (m_threads.empty()) {
+        for (std::size_t i = 0; i < count; ++i) {
+          function(i);
+        }
+
+        return;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_job = [&function](std::size_t i) { function(i); };
+        m_count = count;
+        m_next.store(0, std::memory_order_relaxed);
+        m_running = m_threads.size();
+        m_error = nullptr;
+        ++m_generation;
+      }
+
+      m_started.notify_all();
+      runJob();
+
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_finished.wait(lock, [this]() { return m_running == 0; });
+
+      if (m_error) {
+        std::rethrow_exception(m_error);
+      }
+    }
+
+  private:
+    void work() {
+      std::size_t generation = 0;
+
+      for (;;) {
+        {
+          std::unique_lock<std::mutex> lock(m_mutex);
+          m_started.wait(lock, [&]() { return m_stopping || m_generation != generation; });
+
+          if (m_stopping) {
+            return;
+          }
+
+          generation = m_generation;
+        }
+
+        runJob();
+
+        {
+          std::lock_guard<std::mutex> lock(m_mutex);
+          --m_running;
+        }
+
+        m_finished.notify_one();
+      }
+    }
+
+    void runJob() {
+      for (;;) {
+        std::size_t i = m_next.fetch_add(1, std::memory_order_relaxed);
+
+        if (i >= m_count) {
+          return;
+        }
+
+        try {
+          m_job(i);
+        } catch (...) {
+          std::lock_guard<std::mutex> lock(m_mutex);
+
+          if (!m_error) {
+            m_error = std::current_exception();
+          }
+
+          m_next.store(m_count, std::memory_order_relaxed);
+        }
+      }
+    }
+
+  private:
+    std::vector<std::thread> m_threads;
+    std::mutex m_mutex;
+    std::condition_variable m_started;
+    std::condition_variable m_finished;
+    std::function<void(std::size_t)> m_job;
+    std::size_t m_count = 0;
+    std::atomic<std::size_t> m_next{0};
+    std::size_t m_running = 0;
+    std::size_t m_generation = 0;
+    std::exception_ptr m_error;
+    bool m_stopping = false;
+  };
+
+}
+}
+
+#endif // GFPRIV_PARALLEL_H
@@ -335,6 +335,19 @@ inline namespace v1 {
     {
     }
 
+    /**
+     * @brief Constructor with a size and the values
+     *
+     * @param size The size of the array
+     * @param data The values in the array, in the order of the raw data
+     */
+    Array2D(Vector<I, 2> size, std::vector<T> data)
+    : Index2D<I>(size)
+    , m_data(std::move(data))
+    {
+      assert(m_data.size() == static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height));
+    }
+
     /**
      * @brief Default copy constructor
      */
@@ -548,11 +561,7 @@ inline namespace v1 {
   Serializer& operator|(Serializer& ar, const Array2D<T,I>& array) {
     auto size = array.getSize();
     ar | size.width | size.height;
-
-    for (auto& item : array) {
-      ar | const_cast<T&>(item);
-    }
-
+    writeElements(ar, array.getDataPtr(), array.getDataSize());
     return ar;
   }
 
@@ -562,16 +571,25 @@ inline namespace v1 {
    */
   template<typename T, typename I>
   Deserializer& operator|(Deserializer& ar, Array2D<T,I>& array) {
-    Vector<I, 2> size;
+    array = Array2D<T,I>();
+
+    Vector<I, 2> size(0, 0);
     ar | size.width | size.height;
 
-    Array2D<T,I> tmp(size);
+    if constexpr (std::is_signed<I>::value) {
+      if (size.width < 0 || size.height < 0) {
+        return ar;
+      }
+    }
+
+    // the size comes from the stream, the elements are read before the array is allocated
+    std::vector<T> data;
 
-    for (auto& item : tmp) {
-      ar | item;
+    if (!readElements(ar, data, static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height))) {
+      return ar;
     }
 
-    array = std::move(tmp);
+    array = Array2D<T,I>(size, std::move(data));
     return ar;
   }
 
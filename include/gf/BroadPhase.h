@@ -0,0 +1,199 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#ifndef GF_BROAD_PHASE_H
+#define GF_BROAD_PHASE_H
+
+#include <cstddef>
+#include <vector>
+
+#include "BlockAllocator.h"
+#include "CoreApi.h"
+#include "Handle.h"
+#include "Rect.h"
+#include "SpatialTypes.h"
+#include "Spatial_DynamicTree.h"
+#include "Time.h"
+#include "Vector.h"
+
+namespace gf {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+inline namespace v1 {
+#endif
+
+  /**
+   * @ingroup core_spatial
+   * @brief A pair of objects whose bounds overlap
+   *
+   * In a pair, the first spatial id is always lower than the second one.
+   *
+   * @sa gf::BroadPhase
+   */
+  struct GF_CORE_API BroadPhasePair {
+    SpatialId first;  ///< The spatial id of the first object
+    SpatialId second; ///< The spatial id of the second object
+  };
+
+  /**
+   * @ingroup core_spatial
+   * @brief Equality operator for pairs
+   */
+  constexpr bool operator==(const BroadPhasePair& lhs, const BroadPhasePair& rhs) {
+    return lhs.first == rhs.first && lhs.second == rhs.second;
+  }
+
+  /**
+   * @ingroup core_spatial
+   * @brief Comparison operator for pairs
+   */
+  constexpr bool operator<(const BroadPhasePair& lhs, const BroadPhasePair& rhs) {
+    return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+  }
+
+  /**
+   * @ingroup core_spatial
+   * @brief A broad phase for collision detection
+   *
+   * The broad phase finds the pairs of objects whose bounds overlap. The
+   * objects are stored in a gf::DynamicTree. The broad phase keeps a move
+   * buffer with the objects that have been inserted or modified since the
+   * last call to updatePairs(), and only these objects are queried. So,
+   * updatePairs() reports the pairs where at least one object has moved.
+   * Pairs of objects that did not move are not reported again.
+   *
+   * The pairs can then be checked with the narrow phase functions like
+   * gf::collides().
+   *
+   * @sa gf::DynamicTree, gf::BroadPhasePair
+   */
+  class GF_CORE_API BroadPhase {
+  public:
+    /**
+     * @brief Statistics about the last update
+     *
+     * @sa getStatistics()
+     */
+    struct Statistics {
+      std::size_t queries = 0;  ///< The number of objects in the move buffer that have been queried
+      std::size_t pairs = 0;    ///< The number of pairs found
+      Time time;                ///< The time spent in the update
+    };
+
+    /**
+     * @brief Constructor
+     *
+     * @param margin The margin of the fat bounds in the dynamic tree
+     * @sa DynamicTree::setMargin()
+     */
+    explicit BroadPhase(float margin = 0.0f);
+
+    /**
+     * @brief Insert an object in the broad phase
+     *
+     * @param handle A handle that represents the object to insert
+     * @param bounds The bounds of the object
+     * @returns A spatial id
+     */
+    SpatialId insert(Handle handle, const RectF& bounds);
+
+    /**
+     * @brief Modify the bounds of an object
+     *
+     * @param id The spatial id of the object
+     * @param bounds The new bounds of the object
+     * @param displacement The predicted displacement of the object
+     * @sa DynamicTree::modify(SpatialId, RectF, Vector2f)
+     */
+    void modify(SpatialId id, RectF bounds, Vector2f displacement = { 0.0f, 0.0f });
+
+    /**
+     * @brief Remove an object from the broad phase
+     *
+     * @param id The spatial id of the object
+     */
+    void remove(SpatialId id);
+
+    /**
+     * @brief Remove all the objects from the broad phase
+     */
+    void clear();
+
+    /**
+     * @brief Get the handle associated to a spatial id
+     *
+     * @param id The spatial id of the object
+     */
+    Handle operator[](SpatialId id);
+
+    /**
+     * @brief Compute the pairs of overlapping objects
+     *
+     * Only the pairs with at least one object in the move buffer are
+     * computed. The pairs are unique and sorted. After this call, the move
+     * buffer is empty.
+     *
+     * @returns The pairs of overlapping objects
+     */
+    const std::vector<BroadPhasePair>& updatePairs();
+
+    /**
+     * @brief Get the statistics about the last update
+     *
+     * @returns The statistics of the last call to updatePairs()
+     */
+    const Statistics& getStatistics() const {
+      return m_statistics;
+    }
+
+    /**
+     * @brief Get the underlying dynamic tree
+     *
+     * The handles stored in the tree are the spatial ids of the broad phase.
+     *
+     * @returns The dynamic tree
+     */
+    const DynamicTree& getTree() const {
+      return m_tree;
+    }
+
+  private:
+    void bufferMove(std::size_t index);
+
+  private:
+    struct Proxy {
+      Handle handle;
+      RectF bounds;
+      SpatialId id;
+      bool moved;
+    };
+
+    DynamicTree m_tree;
+    BlockAllocator<Proxy> m_proxies;
+    std::vector<std::size_t> m_moveBuffer;
+    std::vector<BroadPhasePair> m_pairs;
+    Statistics m_statistics;
+  };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+}
+#endif
+}
+
+#endif // GF_BROAD_PHASE_H
@@ -21,6 +21,9 @@
 #ifndef GF_COLLISION_H
 #define GF_COLLISION_H
 
+#include <memory>
+#include <vector>
+
 #include "Circ.h"
 #include "CoreApi.h"
 #include "Polygon.h"
@@ -174,6 +177,208 @@ inline namespace v1 {
    */
   GF_CORE_API bool collides(const Polygon& lhs, const Polygon& rhs, Penetration& p);
 
+  /**
+   * @ingroup core_geometry
+   * @brief A collision found in a batch of polygons
+   *
+   * @sa gf::PolygonCollisionBatch
+   */
+  struct GF_CORE_API PolygonCollision {
+    std::size_t first;        ///< The index of the first polygon in the batch
+    std::size_t second;       ///< The index of the second polygon in the batch
+    Penetration penetration;  ///< Data about the collision
+  };
+
+  /**
+   * @ingroup core_geometry
+   * @brief A batch of polygon-polygon collision tests
+   *
+   * The batch is a narrow phase for many pairs of polygons at once. The
+   * polygons are transformed in world coordinates once when they are added,
+   * then the candidate pairs (e.g. given by gf::BroadPhase) are checked with
+   * the same algorithm as gf::collides() for polygons.
+   *
+   * The buffers are kept when the batch is cleared, so that a batch that is
+   * filled again at each frame does not allocate memory.
+   *
+   * ~~~{.cc}
+   * gf::PolygonCollisionBatch batch;
+   *
+   * // at each frame
+   * batch.clear();
+   *
+   * for (auto& body : bodies) {
+   *   body.index = batch.addPolygon(body.polygon, body.transform);
+   * }
+   *
+   * for (auto& pair : pairs) {
+   *   batch.addPair(pair.first->index, pair.second->index);
+   * }
+   *
+   * for (auto& collision : batch.computeCollisions()) {
+   *   // resolve the collision
+   * }
+   * ~~~
+   *
+   * @sa gf::PolygonCollision, gf::BroadPhase
+   */
+  class GF_CORE_API PolygonCollisionBatch {
+  public:
+    /**
+     * @brief Default constructor
+     */
+    PolygonCollisionBatch();
+
+    /**
+     * @brief Destructor
+     */
+    ~PolygonCollisionBatch();
+
+    /**
+     * @brief Remove all the polygons and pairs
+     *
+     * The memory of the buffers is kept for the next frame.
+     */
+    void clear();
+
+    /**
+     * @brief Add a polygon in the batch
+     *
+     * The polygon must be convex.
+     *
+     * @param polygon The polygon in local coordinates
+     * @param transform The transformation of the polygon
+     * @returns The index of the polygon in the batch
+     */
+    std::size_t addPolygon(const Polygon& polygon, const Transform& transform);
+
+    /**
+     * @brief Add a candidate pair of polygons
+     *
+     * @param first The index of the first polygon
+     * @param second The index of the second polygon
+     */
+    void addPair(std::size_t first, std::size_t second);
+
+    /**
+     * @brief Check all the candidate pairs
+     *
+     * The collisions are given in the order of the pairs, whatever the
+     * number of threads. The threads are created by the first call that
+     * needs them and kept for the next calls.
+     *
+     * @param threadCount The number of threads to use, 0 means the number of hardware threads
+     * @returns The collisions between the pairs of polygons
+     */
+    const std::vector<PolygonCollision>& computeCollisions(std::size_t threadCount = 1);
+
+  private:
+    struct Scratch;
+    struct Team;
+
+    struct Range {
+      std::size_t offset;
+      std::size_t count;
+    };
+
+    struct Pair {
+      std::size_t first;
+      std::size_t second;
+    };
+
+    std::vector<Vector2f> m_vertices;
+    std::vector<Range> m_polygons;
+    std::vector<Pair> m_pairs;
+    std::vector<Scratch> m_scratches;
+    std::vector<PolygonCollision> m_collisions;
+    std::unique_ptr<Team> m_team;
+  };
+
+  /**
+   * @ingroup core_geometry
+   * @brief Data about the first contact between two moving objects
+   *
+   * The objects move along a straight line during the time step, without
+   * rotation. The time of impact is given as a fraction of the motions.
+   *
+   * @sa gf::computeImpact()
+   */
+  struct GF_CORE_API Impact {
+    float time;       ///< Time of impact in @f$ [0, 1] @f$, @f$ 0 @f$ if the objects already overlap
+    Vector2f normal;  ///< Contact normal, from the first object to the second one
+  };
+
+  /**
+   * @relates Impact
+   * @brief Compute the time of impact of a moving circle and a moving rectangle
+   * @param lhs The circle at the start of the step
+   * @param lhsMotion The motion of the circle during the step
+   * @param rhs The rectangle at the start of the step
+   * @param rhsMotion The motion of the rectangle during the step
+   * @param impact Data to fill if there is an impact
+   * @return True if the objects touch during the step
+   */
+  GF_CORE_API bool computeImpact(const CircF& lhs, Vector2f lhsMotion, const RectF& rhs, Vector2f rhsMotion, Impact& impact);
+
+  /**
+   * @relates Impact
+   * @brief Compute the time of impact of a moving rectangle and a moving circle
+   * @param lhs The rectangle at the start of the step
+   * @param lhsMotion The motion of the rectangle during the step
+   * @param rhs The circle at the start of the step
+   * @param rhsMotion The motion of the circle during the step
+   * @param impact Data to fill if there is an impact
+   * @return True if the objects touch during the step
+   */
+  GF_CORE_API bool computeImpact(const RectF& lhs, Vector2f lhsMotion, const CircF& rhs, Vector2f rhsMotion, Impact& impact);
+
+  /**
+   * @relates Impact
+   * @brief Compute the time of impact of a moving circle and a moving polygon
+   * @param lhs The circle
+   * @param lhsTrans Transformation of the circle at the start of the step
+   * @param lhsMotion The motion of the circle during the step
+   * @param rhs The polygon, that must be convex
+   * @param rhsTrans Transformation of the polygon at the start of the step
+   * @param rhsMotion The motion of the polygon during the step
+   * @param impact Data to fill if there is an impact
+   * @return True if the objects touch during the step
+   */
+  GF_CORE_API bool computeImpact(const CircF& lhs, const Transform& lhsTrans, Vector2f lhsMotion, const Polygon& rhs, const Transform& rhsTrans, Vector2f rhsMotion, Impact& impact);
+
+  /**
+   * @relates Impact
+   * @brief Compute the time of impact of a moving polygon and a moving circle
+   * @param lhs The polygon, that must be convex
+   * @param lhsTrans Transformation of the polygon at the start of the step
+   * @param lhsMotion The motion of the polygon during the step
+   * @param rhs The circle
+   * @param rhsTrans Transformation of the circle at the start of the step
+   * @param rhsMotion The motion of the circle during the step
+   * @param impact Data to fill if there is an impact
+   * @return True if the objects touch during the step
+   */
+  GF_CORE_API bool computeImpact(const Polygon& lhs, const Transform& lhsTrans, Vector2f lhsMotion, const CircF& rhs, const Transform& rhsTrans, Vector2f rhsMotion, Impact& impact);
+
+  /**
+   * @relates Impact
+   * @brief Compute the time of impact of two moving polygons
+   *
+   * The time of impact is computed with conservative advancement: the
+   * polygons are moved by steps that can not make them overlap, until they
+   * are closer than a small tolerance.
+   *
+   * @param lhs First polygon, that must be convex
+   * @param lhsTrans Transformation of the first polygon at the start of the step
+   * @param lhsMotion The motion of the first polygon during the step
+   * @param rhs Second polygon, that must be convex
+   * @param rhsTrans Transformation of the second polygon at the start of the step
+   * @param rhsMotion The motion of the second polygon during the step
+   * @param impact Data to fill if there is an impact
+   * @return True if the objects touch during the step
+   */
+  GF_CORE_API bool computeImpact(const Polygon& lhs, const Transform& lhsTrans, Vector2f lhsMotion, const Polygon& rhs, const Transform& rhsTrans, Vector2f rhsMotion, Impact& impact);
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 }
 #endif
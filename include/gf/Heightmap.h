@@ -21,6 +21,8 @@
 #ifndef GF_HEIGHTMAP_H
 #define GF_HEIGHTMAP_H
 
+#include <cstddef>
+#include <cstdint>
 #include <tuple>
 
 #include "Array2D.h"
@@ -39,10 +41,25 @@ inline namespace v1 {
    * @ingroup core_procedural_generation
    * @brief A heightmap
    *
+   * The heights can be stored with different types (see
+   * gf::Heightmap::Storage) in order to save memory and bandwidth. All the
+   * operations are available whatever the storage. With a quantized storage,
+   * the operations that are not affine (e.g. the erosions) are computed on
+   * doubles and the result is quantized again.
+   *
    * @sa gf::midpointDisplacement2D(), gf::diamondSquare2D()
    */
   class GF_CORE_API Heightmap {
   public:
+    /**
+     * @brief Storage of the heights
+     */
+    enum class Storage {
+      Double,     ///< 8 bytes per height
+      Float,      ///< 4 bytes per height
+      Quantized,  ///< 2 bytes per height, with 65536 evenly spaced levels between the minimum and the maximum
+    };
+
     /**
      * @brief Default constructor
      */
@@ -52,8 +69,9 @@ inline namespace v1 {
      * @brief Constructor
      *
      * @param size The size of the heightmap
+     * @param storage The storage of the heights
      */
-    Heightmap(Vector2i size);
+    Heightmap(Vector2i size, Storage storage = Storage::Double);
 
     /**
      * @brief Get the size of the heightmap
@@ -61,9 +79,44 @@ inline namespace v1 {
      * @returns The current size of the heightmap
      */
     Vector2i getSize() const {
+      switch (m_storage) {
+        case Storage::Double:
+          return m_data.getSize();
+        case Storage::Float:
+          return m_floatData.getSize();
+        case Storage::Quantized:
+          return m_quantizedData.getSize();
+      }
+
       return m_data.getSize();
     }
 
+    /**
+     * @brief Get the storage of the heights
+     *
+     * @returns The current storage
+     */
+    Storage getStorage() const {
+      return m_storage;
+    }
+
+    /**
+     * @brief Get the memory used by the heights
+     *
+     * @returns The size of the heights in bytes
+     */
+    std::size_t getByteSize() const;
+
+    /**
+     * @brief Convert the heightmap to another storage
+     *
+     * The heights are rounded to the precision of the new storage.
+     *
+     * @param storage The new storage
+     * @returns A new heightmap with the same heights in the new storage
+     */
+    Heightmap convertTo(Storage storage) const;
+
     /**
      * @brief Reset the heightmap
      *
@@ -78,17 +131,41 @@ inline namespace v1 {
      * @returns The value at the given position
      */
     double getValue(Vector2i position) const {
-      return m_data(position);
+      switch (m_storage) {
+        case Storage::Double:
+          return m_data(position);
+        case Storage::Float:
+          return m_floatData(position);
+        case Storage::Quantized:
+          return m_quantizedMin + m_quantizedData(position) * m_quantizedStep;
+      }
+
+      return 0.0;
     }
 
     /**
      * @brief Set the value at the specified position
      *
+     * With a quantized storage, a value outside of the current range of the
+     * heightmap implies to quantize all the heights again. The range is then
+     * at least doubled so that successive writes outside of the range are
+     * rare.
+     *
      * @param position A position
      * @param value The new value
      */
     void setValue(Vector2i position, double value) {
-      m_data(position) = value;
+      switch (m_storage) {
+        case Storage::Double:
+          m_data(position) = value;
+          break;
+        case Storage::Float:
+          m_floatData(position) = static_cast<float>(value);
+          break;
+        case Storage::Quantized:
+          setQuantizedValue(position, value);
+          break;
+      }
     }
 
     /**
@@ -137,6 +214,19 @@ inline namespace v1 {
      */
     void addNoise(Noise2D& noise, double scale = 1.0);
 
+    /**
+     * @brief Add noise sampled on a grid to the heightmap
+     *
+     * The value added at position @f$ (i, j) @f$ is the noise value at
+     * @f$ (origin.x + i * step.x, origin.y + j * step.y) @f$. It can be used
+     * to generate a part of a larger map.
+     *
+     * @param noise The noise function
+     * @param origin The coordinates in the noise of the first position
+     * @param step The distance in the noise between two consecutive positions
+     */
+    void addNoise(Noise2D& noise, Vector2d origin, Vector2d step);
+
     /**
      * @brief Add a constant to the heightmap
      *
@@ -210,6 +300,64 @@ inline namespace v1 {
      */
     void fastErosion(unsigned iterations, double talus, double fraction);
 
+    /**
+     * @brief Precision of the parallel erosion
+     */
+    enum class Precision {
+      Double, ///< Compute with double values
+      Float,  ///< Compute with float values, faster but less precise
+    };
+
+    /**
+     * @brief Apply thermal erosion to the heightmap, in parallel
+     *
+     * The heightmap is split in tiles that are computed on all the available
+     * threads. The result does not depend on the number of threads and is the
+     * same as thermalErosion() up to rounding errors.
+     *
+     * @param iterations The number of iterations
+     * @param talus The minimum difference for a move of material (typically @f$ \frac{4}{N} @f$)
+     * @param fraction The fraction of material that moves (typically @f$ 0.5 @f$)
+     * @param precision The precision of the computation
+     *
+     * @sa thermalErosion()
+     */
+    void parallelThermalErosion(unsigned iterations, double talus, double fraction, Precision precision = Precision::Double);
+
+    /**
+     * @brief Apply hydraulic erosision to the heightmap, in parallel
+     *
+     * The heightmap is split in tiles that are computed on all the available
+     * threads. The result does not depend on the number of threads and is the
+     * same as hydraulicErosion() up to rounding errors.
+     *
+     * @param iterations The number of iterations
+     * @param rainAmount The amount of rain each cell receives at each iteration (typically @f$ 0.01 @f$)
+     * @param solubility The solubility of the terrain (typically @f$ 0.01 @f$)
+     * @param evaporation The proportion of evaporated water at each iteration (typically @f$ 0.5 @f$)
+     * @param capacity The maximum proportion of material that can be carried by water (typically @f$ 0.01 @f$)
+     * @param precision The precision of the computation
+     *
+     * @sa hydraulicErosion()
+     */
+    void parallelHydraulicErosion(unsigned iterations, double rainAmount, double solubility, double evaporation, double capacity, Precision precision = Precision::Double);
+
+    /**
+     * @brief Apply fast erosion to the heightmap, in parallel
+     *
+     * The heightmap is split in tiles that are computed on all the available
+     * threads. The result does not depend on the number of threads and is the
+     * same as fastErosion() up to rounding errors.
+     *
+     * @param iterations The number of iterations
+     * @param talus The maximum difference for a move of material (typically @f$ \frac{8}{N} @f$ or more)
+     * @param fraction The fraction of material that moves (typically @f$ 0.5 @f$)
+     * @param precision The precision of the computation
+     *
+     * @sa fastErosion()
+     */
+    void parallelFastErosion(unsigned iterations, double talus, double fraction, Precision precision = Precision::Double);
+
     /**
      * @brief Compute the erosion score for the heightmap
      *
@@ -277,7 +425,18 @@ inline namespace v1 {
      */
 
   private:
+    void setQuantizedValue(Vector2i position, double value);
+
+    template<typename Function>
+    void modify(Function function);
+
+  private:
+    Storage m_storage = Storage::Double;
     Array2D<double, int> m_data;
+    Array2D<float, int> m_floatData;
+    Array2D<uint16_t, int> m_quantizedData;
+    double m_quantizedMin = 0.0;
+    double m_quantizedStep = 0.0;
   };
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -0,0 +1,205 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#ifndef GF_HEIGHTMAP_CHUNK_GENERATOR_H
+#define GF_HEIGHTMAP_CHUNK_GENERATOR_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "CoreApi.h"
+#include "Heightmap.h"
+#include "Noise.h"
+#include "Vector.h"
+
+namespace gf {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+inline namespace v1 {
+#endif
+
+  /**
+   * @ingroup core_procedural_generation
+   * @brief A generator of heightmap chunks for unbounded worlds
+   *
+   * The world is divided in chunks of the same size that are generated on
+   * demand. The sample @f$ (X, Y) @f$ of the world is the noise value at
+   * @f$ (X * scale, Y * scale) @f$, whatever the chunk that contains it. So
+   * the borders of the chunks are seamless and a chunk does not depend on
+   * the order of generation. If the scale is a power of two (e.g. 1/256),
+   * the samples are exactly the same as in a single large heightmap.
+   *
+   * A process can be applied to each chunk after the noise, for example
+   * an erosion. To stay seamless, the process must be local: the value of a
+   * sample must only depend on the samples at most `apron` samples away. The
+   * chunk is generated with `apron` additional samples on each side before
+   * the process, then these samples are removed. For example, the parallel
+   * erosions of gf::Heightmap (e.g. gf::Heightmap::parallelFastErosion())
+   * are local with an apron of two samples per iteration. A process must not
+   * depend on the whole chunk (e.g. gf::Heightmap::normalize()).
+   *
+   * The chunks are generated on worker threads after a call to request(),
+   * or on the calling thread by getChunk(). The noise is sampled
+   * concurrently by the workers, so its fillGrid() must not modify it,
+   * which is the case of the noises of gf. The generated chunks are kept
+   * in a cache with a fixed capacity, the least recently used chunks are
+   * removed first.
+   *
+   * @sa gf::Heightmap
+   */
+  class GF_CORE_API HeightmapChunkGenerator {
+  public:
+    /**
+     * @brief A process applied on a chunk after the noise
+     */
+    using Process = std::function<void(Heightmap&)>;
+
+    /**
+     * @brief Constructor
+     *
+     * @param noise The noise of the world
+     * @param chunkSize The size of a chunk, in samples
+     * @param scale The distance in the noise between two consecutive samples
+     * @param capacity The maximum number of chunks in the cache
+     * @param process The process applied to each chunk, if any
+     * @param apron The number of samples around a chunk needed by the process
+     * @param threadCount The number of worker threads, or 0 for the number of hardware threads
+     */
+    HeightmapChunkGenerator(Noise2D& noise, Vector2i chunkSize, double scale, std::size_t capacity, Process process = Process(), int apron = 0, std::size_t threadCount = 0);
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    HeightmapChunkGenerator(const HeightmapChunkGenerator&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
+     */
+    HeightmapChunkGenerator& operator=(const HeightmapChunkGenerator&) = delete;
+
+    /**
+     * @brief Destructor
+     *
+     * The pending requests are abandoned and the workers are stopped.
+     */
+    ~HeightmapChunkGenerator();
+
+    /**
+     * @brief Get the size of a chunk
+     *
+     * @returns The size of a chunk, in samples
+     */
+    Vector2i getChunkSize() const {
+      return m_chunkSize;
+    }
+
+    /**
+     * @brief Request the generation of a chunk
+     *
+     * The chunk is generated by a worker thread, if it is not already in
+     * the cache. This function does not wait for the generation.
+     *
+     * @param chunk The coordinates of the chunk
+     */
+    void request(Vector2i chunk);
+
+    /**
+     * @brief Get a chunk if it is already generated
+     *
+     * @param chunk The coordinates of the chunk
+     * @returns The chunk or `nullptr` if it is not in the cache
+     */
+    std::shared_ptr<const Heightmap> findChunk(Vector2i chunk);
+
+    /**
+     * @brief Get a chunk
+     *
+     * If the chunk is not in the cache, it is generated on the calling
+     * thread, or the function waits for the worker that generates it.
+     *
+     * If the generation throws an exception (e.g. in the process), the
+     * exception is thrown by this function. An exception thrown in a worker
+     * is kept and thrown by the next call for the same chunk, then the
+     * chunk can be generated again.
+     *
+     * @param chunk The coordinates of the chunk
+     * @returns The chunk
+     */
+    std::shared_ptr<const Heightmap> getChunk(Vector2i chunk);
+
+    /**
+     * @brief Get the number of chunks in the cache
+     *
+     * @returns The number of generated chunks that are kept
+     */
+    std::size_t getCachedChunkCount() const;
+
+  private:
+    using Key = uint64_t;
+
+    struct Entry {
+      std::shared_ptr<const Heightmap> heightmap;
+      std::list<Key>::iterator usage;
+    };
+
+    static Key computeKey(Vector2i chunk);
+
+    Heightmap generate(Vector2i chunk) const;
+    std::shared_ptr<const Heightmap> lookup(Key key);
+    void store(Key key, std::shared_ptr<const Heightmap> heightmap);
+    void abandon(Key key, std::exception_ptr error);
+    void run();
+
+  private:
+    Noise2D& m_noise;
+    Vector2i m_chunkSize;
+    double m_scale;
+    std::size_t m_capacity;
+    Process m_process;
+    int m_apron;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_requestCondition;
+    std::condition_variable m_chunkCondition;
+    std::deque<Vector2i> m_requests;
+    std::unordered_set<Key> m_pending;
+    std::unordered_map<Key, std::exception_ptr> m_errors;
+    std::unordered_map<Key, Entry> m_cache;
+    std::list<Key> m_usage; // most recently used first
+    bool m_stopped;
+    std::vector<std::thread> m_threads;
+  };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+}
+#endif
+}
+
+#endif // GF_HEIGHTMAP_CHUNK_GENERATOR_H
@@ -21,9 +21,15 @@
 #ifndef GF_MAP_H
 #define GF_MAP_H
 
+#include <cstdint>
+#include <vector>
+
 #include "Array2D.h"
+#include "BlockAllocator.h"
 #include "CoreApi.h"
 #include "Flags.h"
+#include "Rect.h"
+#include "Span.h"
 #include "Vector.h"
 
 namespace gf {
@@ -54,6 +60,17 @@ inline namespace v1 {
    */
   constexpr Flags<CellProperty> EmptyCell = combineFlags(CellProperty::Transparent, CellProperty::Walkable);
 
+  /**
+   * @ingroup core_roguelike
+   * @brief The layout of the cells in memory
+   *
+   * @sa gf::SquareMap
+   */
+  enum class SquareMapLayout {
+    Cells,      ///< The properties of a cell are stored together in a byte
+    BitPlanes,  ///< Each property is stored in its own bit plane
+  };
+
   /**
    * @ingroup core_roguelike
    * @brief Algorithm for computing a field of vision
@@ -61,7 +78,9 @@ inline namespace v1 {
    * @sa gf::SquareMap
    */
   enum class FieldOfVision {
-    Basic,  ///< A basic algorithm based on ray casting
+    Basic,                  ///< A basic algorithm based on ray casting
+    RecursiveShadowcasting, ///< The recursive shadowcasting algorithm, by octants
+    SymmetricShadowcasting, ///< The symmetric shadowcasting algorithm, where a cell sees another cell if and only if the other cell sees it
   };
 
   /**
@@ -77,6 +96,97 @@ inline namespace v1 {
     Excluded, ///< The limits are *not* included in the field of vision
   };
 
+  /**
+   * @ingroup core_roguelike
+   * @brief A layer of visible cells
+   *
+   * A visibility layer is a packed bitset with one bit per cell of a map. It
+   * can be used to keep the field of vision of a group of entities (e.g. a
+   * faction) apart from the map. The layer keeps track of the area where
+   * some cells have been made visible, so that clearing the layer only
+   * touches this area.
+   *
+   * @sa gf::SquareMap::computeFieldOfVisionLayers()
+   */
+  class GF_CORE_API VisibilityLayer {
+  public:
+    /**
+     * @brief Default constructor
+     *
+     * The layer is empty.
+     */
+    VisibilityLayer();
+
+    /**
+     * @brief Constructor
+     *
+     * @param size The size of the layer, the same as the map
+     */
+    explicit VisibilityLayer(Vector2i size);
+
+    /**
+     * @brief Get the size of the layer
+     *
+     * @returns The size of the layer
+     */
+    Vector2i getSize() const;
+
+    /**
+     * @brief Check if a cell is visible
+     *
+     * @param position The position of the cell
+     * @returns True if the cell is visible
+     */
+    bool isVisible(Vector2i position) const;
+
+    /**
+     * @brief Make a cell visible
+     *
+     * @param position The position of the cell
+     */
+    void setVisible(Vector2i position);
+
+    /**
+     * @brief Make the visible cells of another layer visible
+     *
+     * This function can be used to compute the union of some layers.
+     *
+     * @param other Another layer of the same size
+     */
+    void merge(const VisibilityLayer& other);
+
+    /**
+     * @brief Make all the cells not visible
+     *
+     * Only the area where some cells have been made visible since the last
+     * call is cleared.
+     */
+    void clear();
+
+  private:
+    friend class SquareMap;
+
+    static constexpr int WordSize = 64;
+
+    Vector2i m_size;
+    int m_wordsPerRow;
+    std::vector<uint64_t> m_bits;
+    Vector2i m_dirtyMin;
+    Vector2i m_dirtyMax;
+  };
+
+  /**
+   * @ingroup core_roguelike
+   * @brief An observer for computing fields of vision
+   *
+   * @sa gf::SquareMap::computeFieldOfVisionLayers()
+   */
+  struct GF_CORE_API FieldOfVisionObserver {
+    Vector2i position;      ///< The position of the observer
+    int maxRadius = 0;      ///< The maximum radius that the observer can see
+    std::size_t layer = 0;  ///< The index of the layer of the observer
+  };
+
   /**
    * @ingroup core_roguelike
    * @brief Algorithm for computing a route
@@ -84,8 +194,152 @@ inline namespace v1 {
    * @sa gf::SquareMap
    */
   enum class Route {
-    AStar,    ///< The A* algorithm
-    Dijkstra, ///< The Dijkstra algorithm
+    AStar,            ///< The A* algorithm
+    Dijkstra,         ///< The Dijkstra algorithm
+    JumpPointSearch,  ///< The Jump Point Search algorithm, an A* that skips symmetric paths on uniform-cost grids
+    Hierarchical,     ///< The HPA* algorithm, an A* on an abstract graph of clusters, with near-optimal routes
+  };
+
+  class SquareMap;
+
+  /**
+   * @ingroup core_roguelike
+   * @brief A reusable context for computing routes
+   *
+   * A route context keeps the memory needed by the route algorithms between
+   * two computations. Using the same context for many routes on the same map
+   * avoids allocating a result grid and a heap for each route. A context
+   * must not be shared between threads.
+   *
+   * @sa gf::SquareMap::computeRoute()
+   */
+  class GF_CORE_API RouteContext {
+  public:
+    /**
+     * @brief Constructor
+     */
+    RouteContext();
+
+    /**
+     * @brief Release the memory held by the context
+     */
+    void clear();
+
+  private:
+    friend class SquareMap;
+
+    std::vector<Vector2i> computeRoute(const SquareMap& map, Vector2i origin, Vector2i target, float diagonalCost, Route algorithm, const RectI& area);
+    void computeDistances(const SquareMap& map, Vector2i origin, float diagonalCost, const RectI& area);
+    float getDistance(Vector2i position) const;
+
+  private:
+    struct Node {
+      float distance;
+      Vector2i previous;
+      uint32_t generation;
+      bool closed;
+    };
+
+    struct HeapData {
+      Vector2i position;
+      float priority;
+      float distance;
+    };
+
+    void prepare(Vector2i size);
+    Node& getNode(Vector2i position);
+    void push(Vector2i position, float priority, float distance);
+    HeapData pop();
+
+    void search(const SquareMap& map, Vector2i origin, Vector2i target, float diagonalCost, Route algorithm, const RectI& area);
+    void relax(Vector2i position, Vector2i previous, float distance, Vector2i target, float diagonalCost, float heuristicFactor);
+    void expandNeighbors(const SquareMap& map, Vector2i position, Vector2i target, float diagonalCost, float heuristicFactor, const RectI& area);
+    void expandJumpPoints(const SquareMap& map, Vector2i position, Vector2i target, float diagonalCost, const RectI& area);
+    std::vector<Vector2i> buildRoute(Vector2i origin, Vector2i target);
+
+  private:
+    Array2D<Node, int> m_nodes;
+    std::vector<HeapData> m_heap;
+    uint32_t m_generation;
+  };
+
+  /**
+   * @ingroup core_roguelike
+   * @brief A field of distances and directions towards some goals
+   *
+   * A flow field gives, for every cell of a map, the distance to the
+   * nearest goal and the next step towards this goal. It is useful when
+   * many entities share the same goals: the field is computed once and each
+   * entity just follows the next steps. When some cells of the map change,
+   * the field can be updated without computing it again from scratch.
+   *
+   * @sa gf::SquareMap::computeFlowField(), gf::SquareMap::updateFlowField()
+   */
+  class GF_CORE_API FlowField {
+  public:
+    /**
+     * @brief Default constructor
+     *
+     * The field is empty.
+     */
+    FlowField();
+
+    /**
+     * @brief Get the size of the field
+     *
+     * @returns The size of the field, the same as the map
+     */
+    Vector2i getSize() const;
+
+    /**
+     * @brief Check if a goal can be reached from a cell
+     *
+     * @param position The position of the cell
+     * @returns True if a goal can be reached from the cell
+     */
+    bool isReachable(Vector2i position) const;
+
+    /**
+     * @brief Get the distance to the nearest goal
+     *
+     * @param position The position of the cell
+     * @returns The distance to the nearest goal or infinity if no goal can be reached
+     */
+    float getDistance(Vector2i position) const;
+
+    /**
+     * @brief Get the next step towards the nearest goal
+     *
+     * @param position The position of the cell
+     * @returns The next cell on the route, or the same position if the cell is a goal or if no goal can be reached
+     */
+    Vector2i getNextStep(Vector2i position) const;
+
+  private:
+    friend class SquareMap;
+
+    void compute(const SquareMap& map, Span<const Vector2i> goals, float diagonalCost);
+    void update(const SquareMap& map, Span<const Vector2i> cells);
+
+  private:
+    struct Entry {
+      Vector2i position;
+      float distance;
+    };
+
+    void seed(const SquareMap& map, Vector2i position);
+    void relax(Vector2i position, Vector2i next, float distance);
+    void push(Vector2i position, float distance);
+    void propagate(const SquareMap& map);
+
+  private:
+    Array2D<float, int> m_distances;
+    Array2D<uint8_t, int> m_directions;
+    std::vector<Vector2i> m_goals;
+    float m_diagonalCost;
+    float m_bucketWidth;
+    std::vector<std::vector<Entry>> m_buckets;
+    std::size_t m_currentBucket;
   };
 
   /**
@@ -103,7 +357,13 @@ inline namespace v1 {
    * and not walkable (e.g. lava or water), it can be walkable and not
    * transparent (e.g. a secret passage).
    *
-   * @sa gf::CellProperty
+   * By default, the properties of a cell are stored in a byte. For big maps,
+   * the properties can be stored in bit planes (see
+   * gf::SquareMapLayout::BitPlanes). This layout uses 2 times less memory
+   * and clearing a property of the whole map is much faster, but
+   * accessing a single cell is a bit slower.
+   *
+   * @sa gf::CellProperty, gf::SquareMapLayout
    */
   class GF_CORE_API SquareMap {
   public:
@@ -113,8 +373,9 @@ inline namespace v1 {
      * @brief Constructor
      *
      * @param size The size of the map
+     * @param layout The layout of the cells in memory
      */
-    SquareMap(Vector2i size);
+    SquareMap(Vector2i size, SquareMapLayout layout = SquareMapLayout::Cells);
 
     /**
      * @brief Get the size of the map
@@ -132,6 +393,13 @@ inline namespace v1 {
      */
     PositionRange<int> getRange() const;
 
+    /**
+     * @brief Get the layout of the cells in memory
+     *
+     * @returns The layout of the cells
+     */
+    SquareMapLayout getLayout() const;
+
     /**
      * @name Cell properties
      * @{
@@ -267,6 +535,27 @@ inline namespace v1 {
      */
     void computeLocalFieldOfVision(Vector2i pos, int maxRadius = 0, FieldOfVisionLimit limit = FieldOfVisionLimit::Included, FieldOfVision algorithm = FieldOfVision::Basic);
 
+    /**
+     * @brief Compute the fields of vision of many observers
+     *
+     * The fields of vision are not computed in the map but in separate
+     * layers, one for each group of observers (e.g. a faction). A union layer
+     * can be obtained by putting all the observers in the same layer. The
+     * observers are computed in parallel.
+     *
+     * The layers are not cleared before computing the fields of vision, you
+     * should call gf::VisibilityLayer::clear() before, it only clears the
+     * area that was visible.
+     *
+     * @param observers The observers
+     * @param layers The layers, of the same size as the map
+     * @param limit Is the limit included in the field of vision?
+     * @param algorithm The algorithm to use for computing the field of vision
+     *
+     * @sa gf::VisibilityLayer
+     */
+    void computeFieldOfVisionLayers(Span<const FieldOfVisionObserver> observers, Span<VisibilityLayer> layers, FieldOfVisionLimit limit = FieldOfVisionLimit::Included, FieldOfVision algorithm = FieldOfVision::Basic) const;
+
     /**
      * @brief Check if a cell is visible
      *
@@ -288,6 +577,20 @@ inline namespace v1 {
      */
     bool isExplored(Vector2i pos) const;
 
+    /**
+     * @brief Get the number of cells visited by the last field of vision
+     *
+     * A cell is counted each time the algorithm examines it, so a cell can be
+     * counted more than once. It measures the work of the algorithm, not the
+     * size of the field of vision. Only computeFieldOfVision() and
+     * computeLocalFieldOfVision() update this number.
+     *
+     * @returns The number of visited cells
+     */
+    std::size_t getVisitedCellCount() const {
+      return m_visitedCells;
+    }
+
     /**
      * @}
      */
@@ -312,12 +615,152 @@ inline namespace v1 {
      */
     std::vector<Vector2i> computeRoute(Vector2i origin, Vector2i target, float diagonalCost = Sqrt2, Route algorithm = Route::AStar);
 
+    /**
+     * @brief Compute a route between two points with a reusable context
+     *
+     * This function is the same as the other version but it uses a context
+     * that keeps its memory between two calls. It is the preferred way to
+     * compute many routes on the same map.
+     *
+     * gf::Route::JumpPointSearch needs diagonal movement with a cost lower
+     * than 2. Otherwise, the route is computed with gf::Route::AStar.
+     *
+     * @param origin The origin of the route
+     * @param target The target of the route
+     * @param context The context of the computation
+     * @param diagonalCost The cost of going diagonal between two cells (0 means no diagonal movement)
+     * @param algorithm The algorithm to use for computing the route
+     * @returns The route between the two points (included) or if the route doesn't exist, it return an empty vector
+     */
+    std::vector<Vector2i> computeRoute(Vector2i origin, Vector2i target, RouteContext& context, float diagonalCost = Sqrt2, Route algorithm = Route::AStar);
+
+    /**
+     * @brief Compute a flow field towards some goals
+     *
+     * The distances from all the goals are computed in a single pass, with a
+     * bucket queue instead of a heap.
+     *
+     * @param goals The goals of the field
+     * @param diagonalCost The cost of going diagonal between two cells (0 means no diagonal movement)
+     * @returns The flow field
+     *
+     * @sa updateFlowField()
+     */
+    FlowField computeFlowField(Span<const Vector2i> goals, float diagonalCost = Sqrt2) const;
+
+    /**
+     * @brief Compute a flow field towards a goal
+     *
+     * @param goal The goal of the field
+     * @param diagonalCost The cost of going diagonal between two cells (0 means no diagonal movement)
+     * @returns The flow field
+     */
+    FlowField computeFlowField(Vector2i goal, float diagonalCost = Sqrt2) const;
+
+    /**
+     * @brief Update a flow field after some cells changed
+     *
+     * Only the cells whose distance depends on the changed cells are
+     * computed again. The field must have been computed on this map.
+     *
+     * @param field The field to update
+     * @param cells The cells whose walkable property changed
+     */
+    void updateFlowField(FlowField& field, Span<const Vector2i> cells) const;
+
+    /**
+     * @brief Set the size of the clusters for hierarchical routes
+     *
+     * gf::Route::Hierarchical splits the map in square clusters and
+     * precomputes the distances between the entrances of each cluster. The
+     * abstract graph is built on the first hierarchical route. Then, when a
+     * cell changes, only the clusters around this cell are updated. The
+     * default size of a cluster is 16.
+     *
+     * @param clusterSize The size of a cluster
+     */
+    void setRouteClusterSize(int clusterSize);
+
     /**
      * @}
      */
 
   private:
+    class RouteHierarchy {
+    public:
+      RouteHierarchy();
+
+      void setClusterSize(int clusterSize);
+      void invalidate(Vector2i position);
+      void invalidateAll();
+
+      std::vector<Vector2i> computeRoute(const SquareMap& map, Vector2i origin, Vector2i target, RouteContext& context, float diagonalCost);
+
+    private:
+      static constexpr int BorderKindCount = 4;
+
+      struct Edge {
+        std::size_t node;
+        float cost;
+        bool inter;
+      };
+
+      struct Node {
+        Vector2i position;
+        int references;
+        std::vector<Edge> edges;
+      };
+
+      struct Transition {
+        std::size_t first;
+        std::size_t second;
+      };
+
+      struct Cluster {
+        std::vector<std::size_t> nodes;
+        bool dirty = true;
+        bool modified = false;
+      };
+
+      Vector2i getCluster(Vector2i position) const;
+      RectI getClusterArea(Vector2i cluster) const;
+
+      void update(const SquareMap& map, RouteContext& context, float diagonalCost);
+      void updateBorder(const SquareMap& map, int kind, Vector2i cluster, float diagonalCost);
+      void updateCluster(const SquareMap& map, Vector2i cluster, RouteContext& context, float diagonalCost);
+
+      std::size_t acquireNode(Vector2i position);
+      void releaseNode(std::size_t index);
+      void addTransition(std::vector<Transition>& transitions, Vector2i first, Vector2i second, float cost);
+      void removeInterEdge(std::size_t index, std::size_t other);
+
+    private:
+      int m_clusterSize;
+      Vector2i m_mapSize;
+      float m_diagonalCost;
+      bool m_dirty;
+      Array2D<Cluster, int> m_clusters;
+      Array2D<std::vector<Transition>, int> m_borders[BorderKindCount];
+      BlockAllocator<Node> m_nodes;
+      std::size_t m_nodeBound;
+    };
+
+  private:
+    static constexpr int WordSize = 64;
+    static constexpr std::size_t PlaneCount = 4;
+
+    bool testCell(Vector2i pos, CellProperty property) const;
+    void changeCell(Vector2i pos, CellProperty property, bool value);
+    void fillPlane(CellProperty property, bool value);
+
+  private:
+    Index2D<int> m_index;
+    SquareMapLayout m_layout;
     Array2D<Flags<CellProperty>, int> m_cells;
+    int m_wordsPerRow;
+    std::vector<uint64_t> m_planes[PlaneCount];
+    std::size_t m_visitedCells;
+    RouteHierarchy m_hierarchy;
   };
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -22,6 +22,8 @@
 #define GF_NOISE_H
 
 #include "CoreApi.h"
+#include "Span.h"
+#include "Vector.h"
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -61,6 +63,38 @@ inline namespace v1 {
       return getValue(x, y);
     }
 
+    /**
+     * @brief Take the 2D noise values of a grid
+     *
+     * The value of the point @f$ (i, j) @f$ of the grid is the noise value at
+     * @f$ (origin.x + i * step.x, origin.y + j * step.y) @f$ and it is stored
+     * at index @f$ j * size.width + i @f$.
+     *
+     * The default implementation calls getValue() for each point of the
+     * grid. Some noises provide a faster implementation.
+     *
+     * @param origin The coordinates of the first point of the grid
+     * @param step The distance between two consecutive points of the grid
+     * @param size The number of points of the grid in each dimension
+     * @param values The noise values, with at least `size.width * size.height` elements
+     */
+    virtual void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values);
+
+    /**
+     * @brief Take the 2D noise values of a grid in single precision
+     *
+     * The values are computed row by row with fillGrid() and then rounded
+     * to `float`. So each value is the nearest `float` of the corresponding
+     * value of fillGrid().
+     *
+     * @param origin The coordinates of the first point of the grid
+     * @param step The distance between two consecutive points of the grid
+     * @param size The number of points of the grid in each dimension
+     * @param values The noise values, with at least `size.width * size.height` elements
+     *
+     * @sa fillGrid()
+     */
+    void fillFloatGrid(Vector2d origin, Vector2d step, Vector2i size, Span<float> values);
   };
 
 
@@ -96,6 +130,39 @@ inline namespace v1 {
     double operator()(double x, double y, double z) {
       return getValue(x, y, z);
     }
+
+    /**
+     * @brief Take the 3D noise values of a grid
+     *
+     * The value of the point @f$ (i, j, k) @f$ of the grid is the noise value
+     * at @f$ (origin.x + i * step.x, origin.y + j * step.y, origin.z + k * step.z) @f$
+     * and it is stored at index @f$ (k * size.y + j) * size.x + i @f$.
+     *
+     * The default implementation calls getValue() for each point of the
+     * grid. Some noises provide a faster implementation.
+     *
+     * @param origin The coordinates of the first point of the grid
+     * @param step The distance between two consecutive points of the grid
+     * @param size The number of points of the grid in each dimension
+     * @param values The noise values, with at least `size.x * size.y * size.z` elements
+     */
+    virtual void fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values);
+
+    /**
+     * @brief Take the 3D noise values of a grid in single precision
+     *
+     * The values are computed slice by slice with fillGrid() and then
+     * rounded to `float`. So each value is the nearest `float` of the
+     * corresponding value of fillGrid().
+     *
+     * @param origin The coordinates of the first point of the grid
+     * @param step The distance between two consecutive points of the grid
+     * @param size The number of points of the grid in each dimension
+     * @param values The noise values, with at least `size.x * size.y * size.z` elements
+     *
+     * @sa fillGrid()
+     */
+    void fillFloatGrid(Vector3d origin, Vector3d step, Vector3i size, Span<float> values);
   };
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
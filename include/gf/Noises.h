@@ -90,6 +90,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     Step<double> m_step;
     std::array<uint8_t, 256> m_perm;
@@ -119,6 +121,8 @@ inline namespace v1 {
 
     double getValue(double x, double y, double z) override;
 
+    void fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) override;
+
   private:
     Step<double> m_step;
     std::array<uint8_t, 256> m_perm;
@@ -181,6 +185,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     Noise2D& m_noise;
     double m_scale;
@@ -188,6 +194,7 @@ inline namespace v1 {
     double m_lacunarity;
     double m_persistence;
     double m_dimension;
+    std::vector<double> m_weights;
   };
 
 
@@ -215,6 +222,8 @@ inline namespace v1 {
 
     double getValue(double x, double y, double z) override;
 
+    void fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) override;
+
   private:
     Noise3D& m_noise;
     double m_scale;
@@ -222,6 +231,7 @@ inline namespace v1 {
     double m_lacunarity;
     double m_persistence;
     double m_dimension;
+    std::vector<double> m_weights;
   };
 
 
@@ -247,6 +257,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     GradientNoise2D m_gradient;
     FractalNoise2D m_fractal;
@@ -274,6 +286,8 @@ inline namespace v1 {
 
     double getValue(double x, double y, double z) override;
 
+    void fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) override;
+
   private:
     GradientNoise3D m_gradient;
     FractalNoise3D m_fractal;
@@ -303,6 +317,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     std::array<uint8_t, 256> m_perm;
 
@@ -361,6 +377,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     double getValueBase(double xs, double ys) const;
 
@@ -391,6 +409,8 @@ inline namespace v1 {
 
     double getValue(double x, double y, double z) override;
 
+    void fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) override;
+
   private:
     double getValueBase(double xr, double yr, double zr) const;
 
@@ -431,6 +451,15 @@ inline namespace v1 {
    * [Worley noise](https://en.wikipedia.org/wiki/Worley_noise) is a point
    * based noise. It is also known as Voronoi noise or cellular noise or
    * simply cell noise.
+   *
+   * The points are put in buckets of a regular grid so that a value only
+   * needs the points of the nearby buckets. The distance function must be
+   * symmetric and non-decreasing with the absolute difference on each axis,
+   * which is the case of all the distances of gf (e.g.
+   * gf::euclideanDistance() or gf::manhattanDistance()).
+   *
+   * Taking a value does not modify the noise, so it can be sampled from
+   * multiple threads at the same time.
    */
   class GF_CORE_API WorleyNoise2D : public Noise2D {
   public:
@@ -446,11 +475,20 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
+  private:
+    double computeValue(double x, double y, double *nearest) const;
+
   private:
     std::size_t m_count;
     Distance2<double> m_distance;
     std::vector<double> m_coeffs;
     std::vector<Vector2d> m_cells;
+    Vector2d m_origin;
+    double m_bucketSize;
+    int m_bucketCount;
+    std::vector<std::size_t> m_buckets;
   };
 
 
@@ -475,6 +513,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     Noise2D& m_noise;
     double m_scale;
@@ -482,6 +522,7 @@ inline namespace v1 {
     double m_lacunarity;
     double m_persistence;
     double m_dimension;
+    std::vector<double> m_weights;
   };
 
 
@@ -507,6 +548,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     Noise2D& m_noise;
     double m_scale;
@@ -515,6 +558,7 @@ inline namespace v1 {
     double m_lacunarity;
     double m_persistence;
     double m_dimension;
+    std::vector<double> m_weights;
   };
 
   /**
@@ -539,6 +583,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     Noise2D& m_noise;
     double m_scale;
@@ -547,6 +593,7 @@ inline namespace v1 {
     double m_lacunarity;
     double m_persistence;
     double m_dimension;
+    std::vector<double> m_weights;
   };
 
   /**
@@ -572,6 +619,8 @@ inline namespace v1 {
 
     double getValue(double x, double y) override;
 
+    void fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) override;
+
   private:
     Noise2D& m_noise;
     double m_scale;
@@ -581,6 +630,7 @@ inline namespace v1 {
     double m_lacunarity;
     double m_persistence;
     double m_dimension;
+    std::vector<double> m_weights;
   };
 
   /**
@@ -75,13 +75,19 @@ inline namespace v1 {
 
     /**
      * @brief Serialize the object into bytes
+     *
+     * The compact encoding makes smaller packets, it is detected when the
+     * bytes are deserialized.
+     *
+     * @param data The object to serialize
+     * @param encoding The binary encoding of the values
      */
     template<typename T>
-    void is(const T& data) {
+    void is(const T& data, Serializer::Encoding encoding = Serializer::Encoding::Fixed) {
       bytes.clear();
       type = T::type;
       gf::BufferOutputStream stream(&bytes);
-      gf::Serializer serializer(stream);
+      gf::Serializer serializer(stream, 0, Serializer::Mode::Direct, encoding);
       serializer | type | const_cast<T&>(data);
     }
 
@@ -24,6 +24,8 @@
 #include <cstddef>
 #include <cstdint>
 
+#include <vector>
+
 #include "CoreApi.h"
 #include "Stream.h"
 
@@ -42,14 +44,51 @@ inline namespace v1 {
    */
   class GF_CORE_API Serializer {
   public:
+    /**
+     * @brief The way data is sent to the stream
+     */
+    enum class Mode {
+      Direct,   ///< Every value is written to the stream immediately
+      Buffered, ///< Values are accumulated in memory and written when flushed
+    };
+
+    /**
+     * @brief The binary encoding of the values
+     *
+     * The encoding is recorded in the archive header so that
+     * gf::Deserializer detects it automatically.
+     */
+    enum class Encoding {
+      Fixed,    ///< Integers and size headers have a fixed width in big endian
+      Compact,  ///< Integers and size headers are LEB128 varints, signed integers are zig-zag encoded
+    };
 
     /**
      * @brief Constructor
      *
      * @param stream The output stream
      * @param version The version of the archive format
+     * @param mode The way data is sent to the stream
+     * @param encoding The binary encoding of the values
+     */
+    Serializer(OutputStream& stream, uint16_t version = 0, Mode mode = Mode::Direct, Encoding encoding = Encoding::Fixed);
+
+    /**
+     * @brief Destructor
+     *
+     * The pending data is flushed to the stream.
+     */
+    ~Serializer();
+
+    /**
+     * @brief Deleted copy constructor
+     */
+    Serializer(const Serializer&) = delete;
+
+    /**
+     * @brief Deleted copy assignment
      */
-    Serializer(OutputStream& stream, uint16_t version = 0);
+    Serializer& operator=(const Serializer&) = delete;
 
     /**
      * @brief Get the version of the current archive format
@@ -58,6 +97,13 @@ inline namespace v1 {
       return m_version;
     }
 
+    /**
+     * @brief Get the binary encoding of the values
+     */
+    Encoding getEncoding() const {
+      return m_encoding;
+    }
+
     /**
      * @brief Write a boolean object
      */
@@ -128,7 +174,30 @@ inline namespace v1 {
      */
     void writeSizeHeader(std::size_t size);
 
+    /**
+     * @brief Write an array of scalars
+     *
+     * The scalars are written in big endian with a single byte swapped
+     * copy, whatever the encoding. This is the format of floating point
+     * numbers in both encodings and of integers in the fixed encoding.
+     *
+     * @param data The scalars in native representation
+     * @param count The number of scalars
+     * @param size The size of a scalar: 1, 2, 4 or 8
+     */
+    void writeBigEndianArray(const void *data, std::size_t count, std::size_t size);
+
+    /**
+     * @brief Write the pending data to the stream
+     *
+     * In direct mode, this function does nothing.
+     */
+    void flush();
+
   private:
+    void writeBytes(Span<const uint8_t> bytes);
+    void writeVarint(uint64_t data);
+
     void writeBigEndian64(uint64_t data);
     void writeBigEndian32(uint32_t data);
     void writeBigEndian16(uint16_t data);
@@ -137,6 +206,9 @@ inline namespace v1 {
   private:
     OutputStream *m_stream;
     uint16_t m_version;
+    Mode m_mode;
+    Encoding m_encoding;
+    std::vector<uint8_t> m_buffer;
   };
 
 
@@ -164,6 +236,13 @@ inline namespace v1 {
       return m_version;
     }
 
+    /**
+     * @brief Get the binary encoding of the values, as found in the header
+     */
+    Serializer::Encoding getEncoding() const {
+      return m_encoding;
+    }
+
     /**
      * @brief Read a boolean object
      *
@@ -262,17 +341,42 @@ inline namespace v1 {
      */
     bool readSizeHeader(std::size_t& size);
 
+    /**
+     * @brief Read an array of scalars
+     *
+     * The scalars are read with a single copy from the stream and then
+     * byte swapped in place.
+     *
+     * @param data The scalars in native representation
+     * @param count The number of scalars
+     * @param size The size of a scalar: 1, 2, 4 or 8
+     * @returns True if there was no error while reading
+     */
+    bool readBigEndianArray(void *data, std::size_t count, std::size_t size);
+
+    /**
+     * @brief Check if the stream is at the end
+     *
+     * @returns True if there is nothing left to read
+     */
+    bool isEof() const;
+
   private:
     bool readBigEndian64(uint64_t& data);
     bool readBigEndian32(uint32_t& data);
     bool readBigEndian16(uint16_t& data);
     bool readBigEndian8(uint8_t& data);
+    bool readVarint(uint64_t& data, const char *kind);
 
-    bool isEof() const;
+    template<typename T>
+    bool readCompactSigned(T& data);
+    template<typename T>
+    bool readCompactUnsigned(T& data);
 
   private:
     InputStream *m_stream;
     uint16_t m_version;
+    Serializer::Encoding m_encoding;
   };
 
 
@@ -21,6 +21,9 @@
 #ifndef GF_SERIALIZATION_FWD_H
 #define GF_SERIALIZATION_FWD_H
 
+#include <cstddef>
+#include <vector>
+
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
@@ -28,6 +31,15 @@ inline namespace v1 {
   class Serializer;
   class Deserializer;
 
+  template<typename T>
+  void writeElements(Serializer& ar, const T *data, std::size_t count);
+
+  template<typename T>
+  bool readElements(Deserializer& ar, T *data, std::size_t count);
+
+  template<typename T>
+  bool readElements(Deserializer& ar, std::vector<T>& array, std::size_t count);
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 }
 #endif
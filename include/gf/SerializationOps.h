@@ -25,6 +25,7 @@
 #include <cstring>
 #include <string>
 
+#include <algorithm>
 #include <array>
 #include <map>
 #include <set>
@@ -37,12 +38,141 @@
 #include "Flags.h"
 #include "Serialization.h"
 #include "Span.h"
+#include "Vector.h"
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
 #endif
 
+  /**
+   * @ingroup core_serialization
+   * @brief Traits for types that are serialized as a sequence of scalars
+   *
+   * A type is a bulk type if its serialized form is a fixed number of
+   * integer or floating point scalars stored contiguously in memory.
+   * Arrays of bulk types are serialized with a single byte swapped copy
+   * instead of element by element, with the same binary format. In the
+   * compact encoding, only floating point numbers and single bytes have a
+   * fixed width, so arrays of wider integers are still serialized element
+   * by element.
+   */
+  template<typename T>
+  struct SerialTraits {
+    static constexpr bool IsBulk = (std::is_integral<T>::value && !std::is_same<T, bool>::value) || std::is_same<T, float>::value || std::is_same<T, double>::value; ///< Is the type a bulk type
+    static constexpr bool IsVariable = std::is_integral<T>::value && sizeof(T) > 1; ///< Has the type a variable width in the compact encoding
+    static constexpr std::size_t ScalarSize = sizeof(T); ///< The size of a scalar
+    static constexpr std::size_t ScalarCount = 1; ///< The number of scalars in the type
+  };
+
+  /**
+   * @ingroup core_serialization
+   * @brief Traits for vectors
+   */
+  template<typename T, std::size_t N>
+  struct SerialTraits<Vector<T, N>> {
+    static constexpr bool IsBulk = SerialTraits<T>::IsBulk && SerialTraits<T>::ScalarCount == 1 && sizeof(Vector<T, N>) == N * sizeof(T); ///< Is the type a bulk type
+    static constexpr bool IsVariable = SerialTraits<T>::IsVariable; ///< Has the type a variable width in the compact encoding
+    static constexpr std::size_t ScalarSize = sizeof(T); ///< The size of a scalar
+    static constexpr std::size_t ScalarCount = N; ///< The number of scalars in the type
+  };
+
+  /**
+   * @relates Serializer
+   * @brief Serialize the elements of a contiguous array, without size header
+   *
+   * @param ar The archive
+   * @param data The first element of the array
+   * @param count The number of elements in the array
+   */
+  template<typename T>
+  inline
+  void writeElements(Serializer& ar, const T *data, std::size_t count) {
+    using Traits = SerialTraits<T>;
+
+    if constexpr (Traits::IsBulk) {
+      if (!Traits::IsVariable || ar.getEncoding() == Serializer::Encoding::Fixed) {
+        ar.writeBigEndianArray(data, count * Traits::ScalarCount, Traits::ScalarSize);
+        return;
+      }
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      ar | const_cast<T&>(data[i]);
+    }
+  }
+
+  /**
+   * @relates Deserializer
+   * @brief Deserialize the elements of a contiguous array, without size header
+   *
+   * @param ar The archive
+   * @param data The first element of the array
+   * @param count The number of elements in the array
+   * @returns False if the stream ended before the elements of a bulk type
+   */
+  template<typename T>
+  inline
+  bool readElements(Deserializer& ar, T *data, std::size_t count) {
+    using Traits = SerialTraits<T>;
+
+    if constexpr (Traits::IsBulk) {
+      if (!Traits::IsVariable || ar.getEncoding() == Serializer::Encoding::Fixed) {
+        return ar.readBigEndianArray(data, count * Traits::ScalarCount, Traits::ScalarSize);
+      }
+
+      // a varint has at least one byte
+      for (std::size_t i = 0; i < count; ++i) {
+        if (ar.isEof()) {
+          return false;
+        }
+
+        ar | data[i];
+      }
+
+      return true;
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+      ar | data[i];
+    }
+
+    return true;
+  }
+
+  /**
+   * @relates Deserializer
+   * @brief Deserialize the elements of a vector, without size header
+   *
+   * The count comes from the stream and can be corrupted, so the vector
+   * grows by chunks while the elements are read instead of being allocated
+   * at once. If the stream ends before, the vector is cleared.
+   *
+   * @param ar The archive
+   * @param array The vector that receives the elements
+   * @param count The number of elements to read
+   * @returns False if the stream ended before the elements of a bulk type
+   */
+  template<typename T>
+  inline
+  bool readElements(Deserializer& ar, std::vector<T>& array, std::size_t count) {
+    static constexpr std::size_t ChunkSize = std::max(std::size_t(65536) / sizeof(T), std::size_t(1));
+
+    array.clear();
+
+    while (array.size() < count) {
+      std::size_t offset = array.size();
+      array.resize(offset + std::min(count - offset, ChunkSize));
+
+      if (!readElements(ar, array.data() + offset, array.size() - offset)) {
+        array.clear();
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   /**
    * @relates Serializer
    * @brief Serialize a boolean object
@@ -158,11 +288,19 @@ inline namespace v1 {
   inline
   Serializer& operator|(Serializer& ar, const T (&array)[N]) {
     ar.writeSizeHeader(N);
+    writeElements(ar, array, N);
+    return ar;
+  }
 
-    for (auto& item : array) {
-      ar | const_cast<T&>(item);
-    }
-
+  /**
+   * @relates Serializer
+   * @brief Serialize an array object
+   */
+  template<typename T>
+  inline
+  Serializer& operator|(Serializer& ar, Span<T> array) {
+    ar.writeSizeHeader(array.getSize());
+    writeElements<T>(ar, array.getData(), array.getSize());
     return ar;
   }
 
@@ -175,8 +313,12 @@ inline namespace v1 {
   Serializer& operator|(Serializer& ar, const std::vector<T>& array) {
     ar.writeSizeHeader(array.size());
 
-    for (auto& item : array) {
-      ar | const_cast<T&>(item);
+    if constexpr (SerialTraits<T>::IsBulk) {
+      writeElements(ar, array.data(), array.size());
+    } else {
+      for (auto& item : array) {
+        ar | const_cast<T&>(item);
+      }
     }
 
     return ar;
@@ -190,11 +332,7 @@ inline namespace v1 {
   inline
   Serializer& operator|(Serializer& ar, const std::array<T, N>& array) {
     ar.writeSizeHeader(array.size());
-
-    for (auto& item : array) {
-      ar | const_cast<T&>(item);
-    }
-
+    writeElements(ar, array.data(), array.size());
     return ar;
   }
 
@@ -383,10 +521,7 @@ inline namespace v1 {
       return ar;
     }
 
-    for (auto& item : array) {
-      ar | item;
-    }
-
+    readElements(ar, array.getData(), array.getSize());
     return ar;
   }
 
@@ -423,12 +558,16 @@ inline namespace v1 {
       return ar;
     }
 
-    array.clear();
+    if constexpr (SerialTraits<T>::IsBulk) {
+      readElements(ar, array, size);
+    } else {
+      array.clear();
 
-    for (std::size_t i = 0; i < size; ++i) {
-      T item;
-      ar | item;
-      array.emplace_back(std::move(item));
+      for (std::size_t i = 0; i < size; ++i) {
+        T item;
+        ar | item;
+        array.emplace_back(std::move(item));
+      }
     }
 
     return ar;
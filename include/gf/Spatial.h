@@ -27,5 +27,6 @@
 #include "Spatial_Quadtree.h"
 #include "Spatial_RStarTree.h"
 #include "Spatial_SimpleSpatialIndex.h"
+#include "Spatial_SpatialHashGrid.h"
 
 #endif // GF_SPATIAL_H
@@ -66,6 +66,27 @@ inline namespace v1 {
     int level;                  ///< The level of the structure
   };
 
+  /**
+   * @ingroup core_spatial
+   * @brief A callback for spatial structure
+   *
+   * @sa gf::SpatialStructure
+   */
+  using SpatialStructureCallback = std::function<void(const SpatialStructure&)>;
+
+  /**
+   * @ingroup core_spatial
+   * @brief An object to insert in a spatial index
+   *
+   * This type is used for loading many objects at once in a spatial index.
+   *
+   * @sa gf::RStarTree::load()
+   */
+  struct GF_CORE_API SpatialObject {
+    Handle handle;  ///< The handle of the object
+    RectF bounds;   ///< The bounds of the object
+  };
+
   /**
    * @ingroup core_spatial
    * @brief A kind of spatial query
@@ -81,6 +102,16 @@ inline namespace v1 {
    */
   using SpatialQueryCallback = std::function<void(Handle)>;
 
+  /**
+   * @ingroup core_spatial
+   * @brief A callback for spatial raycast
+   *
+   * The callback receives the handle of the object that is hit and the
+   * fraction of the displacement where the hit happens, in @f$ [0, 1] @f$.
+   * The callback returns `true` to continue the query and `false` to stop it.
+   */
+  using SpatialRaycastCallback = std::function<bool(Handle, float)>;
+
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 }
@@ -22,13 +22,18 @@
 #define GF_SPATIAL_DYNAMIC_TREE_H
 
 #include <cassert>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
+#include <boost/container/small_vector.hpp>
+
 #include "BlockAllocator.h"
 #include "CoreApi.h"
 #include "Handle.h"
 #include "Rect.h"
 #include "SpatialTypes.h"
+#include "Vector.h"
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -38,14 +43,81 @@ inline namespace v1 {
   /**
    * @ingroup core_spatial
    * @brief An implementation of dynamic tree
+   *
+   * The objects are stored in the tree with fat bounds, i.e. their bounds
+   * enlarged by a margin and by their predicted displacement. As long as the
+   * new bounds of an object are inside its fat bounds, modify() does not
+   * need to reinsert the object in the tree, unless the fat bounds have
+   * become much larger than needed, e.g. when a fast object slows down. The
+   * margin is 0 by default.
    */
   class GF_CORE_API DynamicTree {
   public:
+    /**
+     * @brief Statistics about modifications
+     *
+     * @sa getStatistics()
+     */
+    struct Statistics {
+      std::size_t modifications = 0;  ///< The number of calls to modify()
+      std::size_t reinsertions = 0;   ///< The number of modifications that needed a reinsertion in the tree
+    };
+
     /**
      * @brief Constructor
      */
     DynamicTree();
 
+    /**
+     * @brief Constructor with a margin
+     *
+     * @param margin The margin of the fat bounds
+     * @sa setMargin()
+     */
+    explicit DynamicTree(float margin);
+
+    /**
+     * @brief Set the margin of the fat bounds
+     *
+     * The margin only applies to objects inserted or reinserted afterwards.
+     *
+     * @param margin The new margin
+     */
+    void setMargin(float margin) {
+      m_margin = margin;
+    }
+
+    /**
+     * @brief Get the margin of the fat bounds
+     *
+     * @returns The current margin
+     */
+    float getMargin() const {
+      return m_margin;
+    }
+
+    /**
+     * @brief Set the displacement multiplier
+     *
+     * The fat bounds of an object are extended in the direction of its
+     * displacement multiplied by this factor. The default value is 2.
+     *
+     * @param multiplier The new multiplier
+     * @sa modify(SpatialId, RectF, Vector2f)
+     */
+    void setDisplacementMultiplier(float multiplier) {
+      m_displacementMultiplier = multiplier;
+    }
+
+    /**
+     * @brief Get the displacement multiplier
+     *
+     * @returns The current multiplier
+     */
+    float getDisplacementMultiplier() const {
+      return m_displacementMultiplier;
+    }
+
     /**
      * @brief Insert an object in the tree
      *
@@ -63,6 +135,19 @@ inline namespace v1 {
      */
     void modify(SpatialId id, RectF bounds);
 
+    /**
+     * @brief Modify the bounds of a moving object
+     *
+     * The displacement is a prediction of the next displacement of the
+     * object, generally its velocity multiplied by the time step. It is used
+     * to extend the fat bounds of the object if it must be reinserted.
+     *
+     * @param id The spatial id of the object
+     * @param bounds The new bounds of the object
+     * @param displacement The predicted displacement of the object
+     */
+    void modify(SpatialId id, RectF bounds, Vector2f displacement);
+
     /**
      * @brief Query objects in the tree
      *
@@ -73,6 +158,74 @@ inline namespace v1 {
      */
     std::size_t query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind = SpatialQuery::Intersect);
 
+    /**
+     * @brief Query objects in the tree
+     *
+     * Contrary to the version with a gf::SpatialQueryCallback, the callback
+     * is not type-erased so it can be inlined in the traversal.
+     *
+     * @param bounds The bounds of the query
+     * @param callback The callback to apply to found objects, with a `void(gf::Handle)` signature
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    template<typename Callback, typename = std::enable_if_t<std::is_invocable_v<Callback&, Handle>>>
+    std::size_t query(const RectF& bounds, Callback callback, SpatialQuery kind = SpatialQuery::Intersect) {
+      return doQuery(bounds, callback, kind);
+    }
+
+    /**
+     * @brief Query objects in the tree and append them to a vector
+     *
+     * @param bounds The bounds of the query
+     * @param handles The vector where the handles of found objects are appended
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    std::size_t query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind = SpatialQuery::Intersect);
+
+    /**
+     * @brief Query the nearest objects in the tree
+     *
+     * The objects are found in increasing order of distance. The distance
+     * between the point and an object is the distance between the point and
+     * the bounds of the object (0 if the point is inside the bounds).
+     *
+     * @param point The point of the query
+     * @param count The maximum number of objects to find
+     * @param callback The callback to apply to found objects
+     * @param maxDistance The maximum distance between the point and the found objects
+     * @returns The number of objects found
+     */
+    std::size_t queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance = std::numeric_limits<float>::max());
+
+    /**
+     * @brief Query the objects hit by a ray
+     *
+     * The ray starts at `origin` and ends at `origin + displacement`. The
+     * objects are found in increasing order of fraction.
+     *
+     * @param origin The origin of the ray
+     * @param displacement The displacement of the ray
+     * @param callback The callback to apply to found objects
+     * @returns The number of objects found
+     */
+    std::size_t queryRaycast(Vector2f origin, Vector2f displacement, SpatialRaycastCallback callback);
+
+    /**
+     * @brief Query the objects hit by a moving box
+     *
+     * The box moves from `bounds` to `bounds` translated by `displacement`.
+     * The objects are found in increasing order of the fraction where the
+     * box first touches them.
+     *
+     * @param bounds The initial bounds of the moving box
+     * @param displacement The displacement of the box
+     * @param callback The callback to apply to found objects
+     * @returns The number of objects found
+     */
+    std::size_t querySweep(const RectF& bounds, Vector2f displacement, SpatialRaycastCallback callback);
+
     /**
      * @brief Remove an object from the tree
      *
@@ -92,19 +245,89 @@ inline namespace v1 {
      */
     Handle operator[](SpatialId id);
 
+    /**
+     * @brief Get the statistics about modifications
+     *
+     * These statistics can be used to tune the margin and the displacement
+     * multiplier: the number of avoided reinsertions is the difference
+     * between the number of modifications and the number of reinsertions.
+     *
+     * @returns The current statistics
+     * @sa resetStatistics()
+     */
+    const Statistics& getStatistics() const {
+      return m_statistics;
+    }
+
+    /**
+     * @brief Reset the statistics about modifications
+     */
+    void resetStatistics() {
+      m_statistics = Statistics();
+    }
+
   private:
     std::size_t allocateNode();
     void disposeNode(std::size_t index);
 
+    RectF computeFatBounds(const RectF& bounds, Vector2f displacement) const;
+
     void doInsert(std::size_t leaf);
     void doRemove(std::size_t leaf);
 
     std::size_t balance(std::size_t iA);
 
+    std::size_t doRaycast(Vector2f origin, Vector2f displacement, Vector2f halfSize, SpatialRaycastCallback& callback);
+
+    template<typename Callback>
+    std::size_t doQuery(const RectF& bounds, Callback& callback, SpatialQuery kind) {
+      std::size_t found = 0;
+
+      boost::container::small_vector<std::size_t, StackSize> stack;
+      stack.push_back(m_root);
+
+      while (!stack.empty()) {
+        std::size_t index = stack.back();
+        stack.pop_back();
+
+        if (index == NullIndex) {
+          continue;
+        }
+
+        const Node& node = m_nodes[index];
+
+        if (node.isLeaf()) {
+          switch (kind) {
+            case SpatialQuery::Contain:
+              if (bounds.contains(node.objectBounds)) {
+                callback(node.handle);
+                ++found;
+              }
+              break;
+
+            case SpatialQuery::Intersect:
+              if (bounds.intersects(node.objectBounds)) {
+                callback(node.handle);
+                ++found;
+              }
+              break;
+          }
+        } else if (bounds.intersects(node.bounds)) {
+          stack.push_back(node.child1);
+          stack.push_back(node.child2);
+        }
+      }
+
+      return found;
+    }
+
   private:
+    static constexpr std::size_t StackSize = 64;
+
     struct Node {
       Handle handle;
-      RectF bounds;
+      RectF bounds; // fat bounds for leafs
+      RectF objectBounds; // only for leafs
       std::size_t parent;
       std::size_t child1;
       std::size_t child2;
@@ -118,6 +341,9 @@ inline namespace v1 {
     BlockAllocator<Node> m_nodes;
 
     std::size_t m_root;
+    float m_margin;
+    float m_displacementMultiplier;
+    Statistics m_statistics;
   };
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -22,6 +22,8 @@
 #define GF_SPATIAL_QUAD_TREE_H
 
 #include <cassert>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 #include "BlockAllocator.h"
@@ -29,6 +31,7 @@
 #include "Handle.h"
 #include "Rect.h"
 #include "SpatialTypes.h"
+#include "Vector.h"
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -76,6 +79,47 @@ inline namespace v1 {
      */
     std::size_t query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind = SpatialQuery::Intersect);
 
+    /**
+     * @brief Query objects in the tree
+     *
+     * Contrary to the version with a gf::SpatialQueryCallback, the callback
+     * is not type-erased so it can be inlined in the traversal.
+     *
+     * @param bounds The bounds of the query
+     * @param callback The callback to apply to found objects, with a `void(gf::Handle)` signature
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    template<typename Callback, typename = std::enable_if_t<std::is_invocable_v<Callback&, Handle>>>
+    std::size_t query(const RectF& bounds, Callback callback, SpatialQuery kind = SpatialQuery::Intersect) {
+      return doQuery(m_root, bounds, callback, kind);
+    }
+
+    /**
+     * @brief Query objects in the tree and append them to a vector
+     *
+     * @param bounds The bounds of the query
+     * @param handles The vector where the handles of found objects are appended
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    std::size_t query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind = SpatialQuery::Intersect);
+
+    /**
+     * @brief Query the nearest objects in the tree
+     *
+     * The objects are found in increasing order of distance. The distance
+     * between the point and an object is the distance between the point and
+     * the bounds of the object (0 if the point is inside the bounds).
+     *
+     * @param point The point of the query
+     * @param count The maximum number of objects to find
+     * @param callback The callback to apply to found objects
+     * @param maxDistance The maximum distance between the point and the found objects
+     * @returns The number of objects found
+     */
+    std::size_t queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance = std::numeric_limits<float>::max());
+
     /**
      * @brief Remove an object from the tree
      *
@@ -103,7 +147,48 @@ inline namespace v1 {
     void disposeNode(std::size_t index);
 
     bool doInsert(std::size_t entryIndex, std::size_t nodeIndex);
-    std::size_t doQuery(std::size_t nodeIndex, const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind);
+    template<typename Callback>
+    std::size_t doQuery(std::size_t nodeIndex, const RectF& bounds, Callback& callback, SpatialQuery kind) {
+      if (nodeIndex == Null) {
+        return 0;
+      }
+
+      const Node& node = m_nodes[nodeIndex];
+
+      if (!node.bounds.intersects(bounds)) {
+        return 0;
+      }
+
+      std::size_t found = 0;
+
+      for (auto entryIndex : node.entries) {
+        const Entry& entry = m_entries[entryIndex];
+
+        switch (kind) {
+          case SpatialQuery::Contain:
+            if (bounds.contains(entry.bounds)) {
+              callback(entry.handle);
+              ++found;
+            }
+            break;
+
+          case SpatialQuery::Intersect:
+            if (bounds.intersects(entry.bounds)) {
+              callback(entry.handle);
+              ++found;
+            }
+            break;
+        }
+      }
+
+      if (!node.isLeaf()) {
+        for (auto childIndex : node.children) {
+          found += doQuery(childIndex, bounds, callback, kind);
+        }
+      }
+
+      return found;
+    }
     void doRemove(std::size_t entryIndex);
 
     void subdivide(std::size_t nodeIndex);
@@ -127,7 +212,7 @@ inline namespace v1 {
       std::size_t parent;
       std::size_t children[4];
 
-      bool isLeaf() {
+      bool isLeaf() const {
         return children[0] == Null;
       }
     };
@@ -22,6 +22,8 @@
 #define GF_SPATIAL_R_STAR_TREE_H
 
 #include <cassert>
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 #include <boost/container/static_vector.hpp>
@@ -30,7 +32,9 @@
 #include "CoreApi.h"
 #include "Handle.h"
 #include "Rect.h"
+#include "Span.h"
 #include "SpatialTypes.h"
+#include "Vector.h"
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -56,6 +60,30 @@ inline namespace v1 {
      */
     RStarTree();
 
+    /**
+     * @brief Constructor with initial objects
+     *
+     * The objects are loaded in the tree at once, see load(). The spatial id
+     * of the i-th object is `static_cast<gf::SpatialId>(i)`.
+     *
+     * @param objects The initial objects of the tree
+     */
+    RStarTree(Span<const SpatialObject> objects);
+
+    /**
+     * @brief Load many objects at once in the tree
+     *
+     * The previous content of the tree is removed. Then, the tree is built
+     * bottom-up with the Sort-Tile-Recursive (STR) algorithm. This is much
+     * faster than inserting the objects one by one and the resulting tree is
+     * packed, i.e. it has fewer nodes that overlap less. The tree can still
+     * be modified afterwards with insert(), modify() and remove().
+     *
+     * @param objects The objects to load in the tree
+     * @returns The spatial ids of the objects, in the same order as the objects
+     */
+    std::vector<SpatialId> load(Span<const SpatialObject> objects);
+
     /**
      * @brief Insert an object in the tree
      *
@@ -83,6 +111,74 @@ inline namespace v1 {
      */
     std::size_t query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind = SpatialQuery::Intersect);
 
+    /**
+     * @brief Query objects in the tree
+     *
+     * Contrary to the version with a gf::SpatialQueryCallback, the callback
+     * is not type-erased so it can be inlined in the traversal.
+     *
+     * @param bounds The bounds of the query
+     * @param callback The callback to apply to found objects, with a `void(gf::Handle)` signature
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    template<typename Callback, typename = std::enable_if_t<std::is_invocable_v<Callback&, Handle>>>
+    std::size_t query(const RectF& bounds, Callback callback, SpatialQuery kind = SpatialQuery::Intersect) {
+      return doQuery(m_root, bounds, callback, kind);
+    }
+
+    /**
+     * @brief Query objects in the tree and append them to a vector
+     *
+     * @param bounds The bounds of the query
+     * @param handles The vector where the handles of found objects are appended
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    std::size_t query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind = SpatialQuery::Intersect);
+
+    /**
+     * @brief Query the nearest objects in the tree
+     *
+     * The objects are found in increasing order of distance. The distance
+     * between the point and an object is the distance between the point and
+     * the bounds of the object (0 if the point is inside the bounds).
+     *
+     * @param point The point of the query
+     * @param count The maximum number of objects to find
+     * @param callback The callback to apply to found objects
+     * @param maxDistance The maximum distance between the point and the found objects
+     * @returns The number of objects found
+     */
+    std::size_t queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance = std::numeric_limits<float>::max());
+
+    /**
+     * @brief Query the objects hit by a ray
+     *
+     * The ray starts at `origin` and ends at `origin + displacement`. The
+     * objects are found in increasing order of fraction.
+     *
+     * @param origin The origin of the ray
+     * @param displacement The displacement of the ray
+     * @param callback The callback to apply to found objects
+     * @returns The number of objects found
+     */
+    std::size_t queryRaycast(Vector2f origin, Vector2f displacement, SpatialRaycastCallback callback);
+
+    /**
+     * @brief Query the objects hit by a moving box
+     *
+     * The box moves from `bounds` to `bounds` translated by `displacement`.
+     * The objects are found in increasing order of the fraction where the
+     * box first touches them.
+     *
+     * @param bounds The initial bounds of the moving box
+     * @param displacement The displacement of the box
+     * @param callback The callback to apply to found objects
+     * @returns The number of objects found
+     */
+    std::size_t querySweep(const RectF& bounds, Vector2f displacement, SpatialRaycastCallback callback);
+
     /**
      * @brief Remove an object from the tree
      *
@@ -102,6 +198,16 @@ inline namespace v1 {
      */
     Handle operator[](SpatialId id);
 
+    /**
+     * @brief Query the structure of the tree
+     *
+     * The callback is called for every node and every object of the tree.
+     * The level of the root is 0.
+     *
+     * @param callback The callback to apply to the structures
+     */
+    void queryStructure(SpatialStructureCallback callback) const;
+
   private:
     std::size_t allocateEntry();
     void disposeEntry(std::size_t index);
@@ -131,7 +237,48 @@ inline namespace v1 {
     std::size_t doInsertInLeaf(std::size_t nodeIndex, std::size_t entryIndex, const RectF& entryBounds);
     std::size_t doInsertInBranch(std::size_t nodeIndex, std::size_t childIndex, const RectF& childBounds);
 
-    std::size_t doQuery(std::size_t nodeIndex, const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind);
+    template<typename Callback>
+    std::size_t doQuery(std::size_t nodeIndex, const RectF& bounds, Callback& callback, SpatialQuery kind) {
+      std::size_t found = 0;
+      const Node& node = m_nodes[nodeIndex];
+
+      switch (node.type) {
+        case Node::Leaf:
+          switch (kind) {
+            case SpatialQuery::Contain:
+              for (auto& member : node.members) {
+                if (bounds.contains(member.bounds)) {
+                  callback(m_entries[member.index].handle);
+                  ++found;
+                }
+              }
+              break;
+
+            case SpatialQuery::Intersect:
+              for (auto& member : node.members) {
+                if (bounds.intersects(member.bounds)) {
+                  callback(m_entries[member.index].handle);
+                  ++found;
+                }
+              }
+              break;
+          }
+          break;
+        case Node::Branch:
+          for (auto& member : node.members) {
+            if (bounds.intersects(member.bounds)) {
+              found += doQuery(member.index, bounds, callback, kind);
+            }
+          }
+          break;
+      }
+
+      return found;
+    }
+
+    std::size_t doRaycast(Vector2f origin, Vector2f displacement, Vector2f halfSize, SpatialRaycastCallback& callback);
+
+    void doQueryStructure(std::size_t nodeIndex, int level, SpatialStructureCallback& callback) const;
 
     void getEntriesAndDispose(std::size_t nodeIndex, std::vector<std::size_t>& eliminated);
     void doRemove(std::size_t entryIndex);
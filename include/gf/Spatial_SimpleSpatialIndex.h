@@ -21,12 +21,15 @@
 #ifndef GF_SPATIAL_SIMPLE_SPATIAL_INDEX_H
 #define GF_SPATIAL_SIMPLE_SPATIAL_INDEX_H
 
+#include <limits>
+#include <type_traits>
 #include <vector>
 
 #include "CoreApi.h"
 #include "Handle.h"
 #include "Rect.h"
 #include "SpatialTypes.h"
+#include "Vector.h"
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -73,6 +76,47 @@ inline namespace v1 {
      */
     std::size_t query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind = SpatialQuery::Intersect);
 
+    /**
+     * @brief Query objects in the index
+     *
+     * Contrary to the version with a gf::SpatialQueryCallback, the callback
+     * is not type-erased so it can be inlined in the traversal.
+     *
+     * @param bounds The bounds of the query
+     * @param callback The callback to apply to found objects, with a `void(gf::Handle)` signature
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    template<typename Callback, typename = std::enable_if_t<std::is_invocable_v<Callback&, Handle>>>
+    std::size_t query(const RectF& bounds, Callback callback, SpatialQuery kind = SpatialQuery::Intersect) {
+      return doQuery(bounds, callback, kind);
+    }
+
+    /**
+     * @brief Query objects in the index and append them to a vector
+     *
+     * @param bounds The bounds of the query
+     * @param handles The vector where the handles of found objects are appended
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    std::size_t query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind = SpatialQuery::Intersect);
+
+    /**
+     * @brief Query the nearest objects in the index
+     *
+     * The objects are found in increasing order of distance. The distance
+     * between the point and an object is the distance between the point and
+     * the bounds of the object (0 if the point is inside the bounds).
+     *
+     * @param point The point of the query
+     * @param count The maximum number of objects to find
+     * @param callback The callback to apply to found objects
+     * @param maxDistance The maximum distance between the point and the found objects
+     * @returns The number of objects found
+     */
+    std::size_t queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance = std::numeric_limits<float>::max());
+
     /**
      * @brief Remove an object from the tree
      *
@@ -92,6 +136,36 @@ inline namespace v1 {
      */
     Handle operator[](SpatialId id);
 
+  private:
+    template<typename Callback>
+    std::size_t doQuery(const RectF& bounds, Callback& callback, SpatialQuery kind) {
+      std::size_t found = 0;
+
+      for (auto& entry : m_entries) {
+        if (entry.next != Occupied) {
+          continue;
+        }
+
+        switch (kind) {
+          case SpatialQuery::Contain:
+            if (bounds.contains(entry.bounds)) {
+              callback(entry.handle);
+              ++found;
+            }
+            break;
+
+          case SpatialQuery::Intersect:
+            if (bounds.intersects(entry.bounds)) {
+              callback(entry.handle);
+              ++found;
+            }
+            break;
+        }
+      }
+
+      return found;
+    }
+
   private:
     static constexpr std::size_t Null = static_cast<std::size_t>(-1);
     static constexpr std::size_t Occupied = static_cast<std::size_t>(-2);
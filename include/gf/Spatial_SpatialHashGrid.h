@@ -0,0 +1,253 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#ifndef GF_SPATIAL_SPATIAL_HASH_GRID_H
+#define GF_SPATIAL_SPATIAL_HASH_GRID_H
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "BlockAllocator.h"
+#include "CoreApi.h"
+#include "Handle.h"
+#include "Rect.h"
+#include "SpatialTypes.h"
+#include "Vector.h"
+
+namespace gf {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+inline namespace v1 {
+#endif
+
+  /**
+   * @ingroup core_spatial
+   * @brief A uniform spatial hash grid
+   *
+   * The plane is divided in cells of the same size and the cells are hashed
+   * in a fixed number of buckets. An object is stored in the buckets of all
+   * the cells it overlaps. This index is well suited for dense collections
+   * of objects of similar sizes: the size of a cell should be close to the
+   * size of the objects. Modifying an object that stays in the same cells
+   * does not touch the buckets. Objects that overlap too many cells are
+   * not stored in the buckets but in a separate list that every query
+   * checks.
+   *
+   * @sa gf::SimpleSpatialIndex, gf::Quadtree
+   * @sa [Spatial hashing - Wikipedia](https://en.wikipedia.org/wiki/Spatial_hashing)
+   */
+  class GF_CORE_API SpatialHashGrid {
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param cellSize The size of a cell
+     * @param bucketCount The number of buckets
+     */
+    SpatialHashGrid(Vector2f cellSize, std::size_t bucketCount = 4096);
+
+    /**
+     * @brief Insert an object in the grid
+     *
+     * @param handle A handle that represents the object to insert
+     * @param bounds The bounds of the object
+     * @returns A spatial id
+     */
+    SpatialId insert(Handle handle, const RectF& bounds);
+
+    /**
+     * @brief Modify the bounds of an object
+     *
+     * @param id The spatial id of the object
+     * @param bounds The new bounds of the object
+     */
+    void modify(SpatialId id, RectF bounds);
+
+    /**
+     * @brief Query objects in the grid
+     *
+     * @param bounds The bounds of the query
+     * @param callback The callback to apply to found objects
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    std::size_t query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind = SpatialQuery::Intersect);
+
+    /**
+     * @brief Query objects in the grid
+     *
+     * Contrary to the version with a gf::SpatialQueryCallback, the callback
+     * is not type-erased so it can be inlined in the traversal.
+     *
+     * @param bounds The bounds of the query
+     * @param callback The callback to apply to found objects, with a `void(gf::Handle)` signature
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    template<typename Callback, typename = std::enable_if_t<std::is_invocable_v<Callback&, Handle>>>
+    std::size_t query(const RectF& bounds, Callback callback, SpatialQuery kind = SpatialQuery::Intersect) {
+      return doQuery(bounds, callback, kind);
+    }
+
+    /**
+     * @brief Query objects in the grid and append them to a vector
+     *
+     * @param bounds The bounds of the query
+     * @param handles The vector where the handles of found objects are appended
+     * @param kind The kind of spatial query
+     * @returns The number of objects found
+     */
+    std::size_t query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind = SpatialQuery::Intersect);
+
+    /**
+     * @brief Query the nearest objects in the grid
+     *
+     * The objects are found in increasing order of distance. The distance
+     * between the point and an object is the distance between the point and
+     * the bounds of the object (0 if the point is inside the bounds).
+     *
+     * @param point The point of the query
+     * @param count The maximum number of objects to find
+     * @param callback The callback to apply to found objects
+     * @param maxDistance The maximum distance between the point and the found objects
+     * @returns The number of objects found
+     */
+    std::size_t queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance = std::numeric_limits<float>::max());
+
+    /**
+     * @brief Remove an object from the grid
+     *
+     * @param id The spatial id of the object
+     */
+    void remove(SpatialId id);
+
+    /**
+     * @brief Remove all the objects from the grid
+     */
+    void clear();
+
+    /**
+     * @brief Get the handle associated to a spatial id
+     *
+     * @param id The spatial id of the object
+     */
+    Handle operator[](SpatialId id);
+
+  private:
+    struct CellRange {
+      Vector2i min;
+      Vector2i max;
+
+      std::size_t getCellCount() const {
+        return static_cast<std::size_t>(max.x - min.x + 1) * static_cast<std::size_t>(max.y - min.y + 1);
+      }
+    };
+
+    static bool isOversized(const CellRange& range);
+
+    CellRange computeCellRange(const RectF& bounds) const;
+    std::size_t computeBucket(Vector2i cell) const;
+
+    void addToBuckets(std::size_t entryIndex, const CellRange& range);
+    void removeFromBuckets(std::size_t entryIndex, const CellRange& range);
+
+    template<typename Callback>
+    void doQueryEntry(std::size_t entryIndex, const RectF& bounds, Callback& callback, SpatialQuery kind, std::size_t& found) {
+      Entry& entry = m_entries[entryIndex];
+
+      if (entry.stamp == m_stamp) {
+        return;
+      }
+
+      entry.stamp = m_stamp;
+
+      switch (kind) {
+        case SpatialQuery::Contain:
+          if (bounds.contains(entry.bounds)) {
+            callback(entry.handle);
+            ++found;
+          }
+          break;
+
+        case SpatialQuery::Intersect:
+          if (bounds.intersects(entry.bounds)) {
+            callback(entry.handle);
+            ++found;
+          }
+          break;
+      }
+    }
+
+    template<typename Callback>
+    std::size_t doQuery(const RectF& bounds, Callback& callback, SpatialQuery kind) {
+      std::size_t found = 0;
+      ++m_stamp;
+
+      CellRange range = computeCellRange(bounds);
+
+      if (range.getCellCount() > m_entryIndices.size()) {
+        // the query is bigger than the grid, it's faster to check every object
+        for (auto entryIndex : m_entryIndices) {
+          doQueryEntry(entryIndex, bounds, callback, kind, found);
+        }
+
+        return found;
+      }
+
+      for (auto entryIndex : m_oversized) {
+        doQueryEntry(entryIndex, bounds, callback, kind, found);
+      }
+
+      for (int y = range.min.y; y <= range.max.y; ++y) {
+        for (int x = range.min.x; x <= range.max.x; ++x) {
+          for (auto entryIndex : m_buckets[computeBucket({ x, y })]) {
+            doQueryEntry(entryIndex, bounds, callback, kind, found);
+          }
+        }
+      }
+
+      return found;
+    }
+
+  private:
+    struct Entry {
+      Handle handle;
+      RectF bounds;
+      CellRange range;
+      std::size_t position; // in m_entryIndices
+      std::size_t stamp;
+    };
+
+    Vector2f m_cellSize;
+    std::vector<std::vector<std::size_t>> m_buckets;
+    BlockAllocator<Entry> m_entries;
+    std::vector<std::size_t> m_entryIndices;
+    std::vector<std::size_t> m_oversized;
+    std::size_t m_stamp;
+  };
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+}
+#endif
+}
+
+#endif // GF_SPATIAL_SPATIAL_HASH_GRID_H
@@ -26,6 +26,7 @@
 #include "CoreApi.h"
 #include "Matrix.h"
 #include "Rect.h"
+#include "Span.h"
 #include "Vector.h"
 
 namespace gf {
@@ -339,6 +340,62 @@ inline namespace v1 {
    */
   GF_CORE_API RectF transform(const Matrix3f& mat, const RectF& rect);
 
+  /**
+   * @relates Transform
+   * @brief Apply a transformation to many 2D points.
+   *
+   * The computation is vectorized when possible. The result can be the same
+   * span as the points.
+   *
+   * @param trans The transformation
+   * @param points The points to transform
+   * @param result The transformed points, at least as many as the points
+   */
+  GF_CORE_API void transform(const Transform& trans, Span<const Vector2f> points, Span<Vector2f> result);
+
+  /**
+   * @relates Transform
+   * @brief Apply a transformation to each 2D point.
+   *
+   * The point at index @f$ i @f$ is transformed by the transformation at
+   * index @f$ i @f$. The computation is vectorized when possible. The result
+   * can be the same span as the points.
+   *
+   * @param transforms The transformations, at least as many as the points
+   * @param points The points to transform
+   * @param result The transformed points, at least as many as the points
+   */
+  GF_CORE_API void transform(Span<const Transform> transforms, Span<const Vector2f> points, Span<Vector2f> result);
+
+  /**
+   * @ingroup core_geometry
+   * @brief Apply an affine transformation to many 2D points.
+   *
+   * The computation is vectorized when possible. The result can be the same
+   * span as the points.
+   *
+   * @param mat The transformation matrix
+   * @param points The points to transform
+   * @param result The transformed points, at least as many as the points
+   */
+  GF_CORE_API void transform(const Matrix3f& mat, Span<const Vector2f> points, Span<Vector2f> result);
+
+  /**
+   * @ingroup core_geometry
+   * @brief Apply an affine transformation to many 2D points stored as separate coordinates.
+   *
+   * This is the structure-of-arrays version of the transformation. The
+   * computation is vectorized when possible. The results can be the same
+   * spans as the coordinates.
+   *
+   * @param mat The transformation matrix
+   * @param x The x coordinates of the points to transform
+   * @param y The y coordinates of the points to transform, as many as the x coordinates
+   * @param resultX The x coordinates of the transformed points, at least as many as the points
+   * @param resultY The y coordinates of the transformed points, at least as many as the points
+   */
+  GF_CORE_API void transform(const Matrix3f& mat, Span<const float> x, Span<const float> y, Span<float> resultX, Span<float> resultY);
+
 
   /**
    * @ingroup core_geometry
@@ -21,9 +21,12 @@
 #ifndef GF_TRIANGULATION_H
 #define GF_TRIANGULATION_H
 
+#include <array>
 #include <vector>
 
+#include "BlockAllocator.h"
 #include "CoreApi.h"
+#include "Rect.h"
 #include "Span.h"
 #include "Vector.h"
 
@@ -110,16 +113,178 @@ inline namespace v1 {
     T *m_points[3];
   };
 
+  /**
+   * @ingroup core_geometry
+   * @brief An incremental constrained Delaunay triangulation
+   *
+   * Points can be inserted and removed at any time. Edges between two
+   * vertices can be constrained: they are kept in the triangulation even if
+   * they do not satisfy the Delaunay criterion.
+   *
+   * The triangle containing a point is found by walking through the
+   * triangulation from the last modified triangle, so inserting points that
+   * are close to each other is fast.
+   *
+   * The triangulation is built inside a large super triangle that surrounds
+   * the bounds given at construction. All the points must lie in these
+   * bounds.
+   *
+   * @sa gf::triangulation(), gf::triangulationConstrained()
+   */
+  class GF_CORE_API DelaunayTriangulation {
+  public:
+    /**
+     * @brief Constructor
+     *
+     * @param bounds The bounds of the points of the triangulation
+     */
+    explicit DelaunayTriangulation(const RectF& bounds);
+
+    /**
+     * @brief Insert a point in the triangulation
+     *
+     * If the point is already in the triangulation, the vertex of the
+     * existing point is returned.
+     *
+     * @param point The point to insert
+     * @returns The vertex of the point
+     */
+    std::size_t insertPoint(Vector2f point);
+
+    /**
+     * @brief Remove a point from the triangulation
+     *
+     * The constrained edges that end at the vertex are removed too. The
+     * vertex is not reused for another point.
+     *
+     * @param vertex The vertex of the point
+     */
+    void removePoint(std::size_t vertex);
+
+    /**
+     * @brief Insert a constrained edge between two vertices
+     *
+     * If a vertex lies on the edge, the edge is split at this vertex.
+     * Constrained edges can not cross each other: if the edge crosses an
+     * existing constrained edge, it is inserted up to this edge only.
+     *
+     * @param vertex0 The first vertex of the edge
+     * @param vertex1 The second vertex of the edge
+     * @returns True if the edge has been fully inserted
+     */
+    bool insertConstrainedEdge(std::size_t vertex0, std::size_t vertex1);
+
+    /**
+     * @brief Check if an edge is constrained
+     *
+     * @param vertex0 The first vertex of the edge
+     * @param vertex1 The second vertex of the edge
+     * @returns True if the edge exists and is constrained
+     */
+    bool isConstrainedEdge(std::size_t vertex0, std::size_t vertex1) const;
+
+    /**
+     * @brief Get the point of a vertex
+     *
+     * @param vertex The vertex
+     * @returns The point of the vertex
+     */
+    Vector2f getPoint(std::size_t vertex) const;
+
+    /**
+     * @brief Find the triangle that contains a point
+     *
+     * @param point The point to locate
+     * @returns The triangle that contains the point or gf::NullIndex if the point is outside the convex hull of the points
+     */
+    std::size_t locate(Vector2f point) const;
+
+    /**
+     * @brief Get the vertices of a triangle
+     *
+     * @param triangle A triangle given by locate()
+     * @returns The vertices of the triangle
+     */
+    std::array<std::size_t, 3> getTriangle(std::size_t triangle) const;
+
+    /**
+     * @brief Get all the triangles of the triangulation
+     *
+     * The vertices of each triangle have the same orientation.
+     *
+     * @returns The vertices of the triangles
+     */
+    std::vector<std::array<std::size_t, 3>> getTriangles() const;
+
+  private:
+    struct Triangle {
+      std::size_t vertices[3];
+      std::size_t neighbors[3]; // neighbors[i] is on the other side of the edge opposite to vertices[i]
+      bool constrained[3];
+    };
+
+    enum class Location {
+      Inside,
+      OnEdge,
+      OnVertex,
+    };
+
+    struct Position {
+      std::size_t triangle;
+      Location location;
+      std::size_t index;
+    };
+
+    struct Edge {
+      std::size_t triangle;
+      std::size_t index;
+    };
+
+    Position walk(Vector2f point) const;
+    Edge findEdge(std::size_t vertex0, std::size_t vertex1) const;
+    std::size_t findEdgeIndex(std::size_t triangle, std::size_t vertex0, std::size_t vertex1) const;
+    bool isFinite(std::size_t triangle) const;
+
+    std::size_t allocateTriangle();
+    void disposeTriangle(std::size_t triangle);
+    void setTriangle(std::size_t triangle, std::size_t vertex0, std::size_t vertex1, std::size_t vertex2);
+    void link(std::size_t triangle, std::size_t index, std::size_t neighbor, bool constrained);
+
+    bool shouldFlip(std::size_t triangle, std::size_t index) const;
+    void flip(std::size_t triangle, std::size_t index);
+    void legalize(std::vector<std::size_t>& triangles);
+    void restoreDelaunay(std::vector<std::array<std::size_t, 2>>& edges);
+
+  private:
+    std::vector<Vector2f> m_points;
+    std::vector<std::size_t> m_pointTriangles; // one triangle around each vertex, NullIndex for removed vertices
+    std::vector<Triangle> m_triangles;
+    std::vector<std::size_t> m_freeTriangles;
+    std::size_t m_lastTriangle;
+  };
+
   /**
    * @ingroup core_geometry
    * @brief Compute a Delaunay triangulation of a set of points
    *
    * @param points The set of points
    * @returns A set of triangles refering to the original points
+   *
+   * @sa gf::DelaunayTriangulation
    */
   GF_CORE_API std::vector<TriangleRef<const Vector2f>> triangulation(Span<const Vector2f> points);
 
-//   GF_CORE_API std::vector<TriangleRef<const Vector2f>> triangulationConstrained(Span<const Vector2f> points, Span<const EdgeRef<Vector2f>> contrainedEdges);
+  /**
+   * @ingroup core_geometry
+   * @brief Compute a constrained Delaunay triangulation of a set of points
+   *
+   * @param points The set of points
+   * @param constrainedEdges The edges that must be in the triangulation, refering to the original points
+   * @returns A set of triangles refering to the original points
+   *
+   * @sa gf::DelaunayTriangulation
+   */
+  GF_CORE_API std::vector<TriangleRef<const Vector2f>> triangulationConstrained(Span<const Vector2f> points, Span<const EdgeRef<Vector2f>> constrainedEdges);
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 }
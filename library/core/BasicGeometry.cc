@@ -20,6 +20,7 @@
  */
 #include <gfpriv/BasicGeometry.h>
 
+#include <algorithm>
 #include <cassert>
 
 #include <gf/VectorOps.h>
@@ -68,5 +69,51 @@ namespace priv {
     return area;
   }
 
+  float computeSquareDistance(Vector2f point, const RectF& rect) {
+    float distance = 0.0f;
+
+    for (std::size_t i = 0; i < 2; ++i) {
+      if (point[i] < rect.min[i]) {
+        distance += gf::square(rect.min[i] - point[i]);
+      } else if (point[i] > rect.max[i]) {
+        distance += gf::square(point[i] - rect.max[i]);
+      }
+    }
+
+    return distance;
+  }
+
+  // slab test
+  bool computeRayFraction(Vector2f origin, Vector2f displacement, const RectF& rect, float& fraction) {
+    float min = 0.0f;
+    float max = 1.0f;
+
+    for (std::size_t i = 0; i < 2; ++i) {
+      if (displacement[i] == 0.0f) {
+        if (origin[i] < rect.min[i] || origin[i] > rect.max[i]) {
+          return false;
+        }
+      } else {
+        float inverse = 1.0f / displacement[i];
+        float t1 = (rect.min[i] - origin[i]) * inverse;
+        float t2 = (rect.max[i] - origin[i]) * inverse;
+
+        if (t1 > t2) {
+          std::swap(t1, t2);
+        }
+
+        min = std::max(min, t1);
+        max = std::min(max, t2);
+
+        if (min > max) {
+          return false;
+        }
+      }
+    }
+
+    fraction = min;
+    return true;
+  }
+
 }
 }
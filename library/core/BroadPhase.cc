@@ -0,0 +1,140 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/BroadPhase.h>
+
+#include <algorithm>
+#include <cassert>
+
+#include <gf/Clock.h>
+
+namespace gf {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+inline namespace v1 {
+#endif
+
+  BroadPhase::BroadPhase(float margin)
+  : m_tree(margin)
+  {
+  }
+
+  SpatialId BroadPhase::insert(Handle handle, const RectF& bounds) {
+    std::size_t index = m_proxies.allocate();
+    Proxy& proxy = m_proxies[index];
+    proxy.handle = handle;
+    proxy.bounds = bounds;
+    proxy.id = m_tree.insert(Handle(static_cast<Id>(index)), bounds);
+    proxy.moved = false;
+    bufferMove(index);
+    return static_cast<SpatialId>(index);
+  }
+
+  void BroadPhase::modify(SpatialId id, RectF bounds, Vector2f displacement) {
+    std::size_t index = static_cast<std::size_t>(id);
+    Proxy& proxy = m_proxies[index];
+    proxy.bounds = bounds;
+    m_tree.modify(proxy.id, bounds, displacement);
+    bufferMove(index);
+  }
+
+  void BroadPhase::remove(SpatialId id) {
+    std::size_t index = static_cast<std::size_t>(id);
+    Proxy& proxy = m_proxies[index];
+
+    if (proxy.moved) {
+      std::replace(m_moveBuffer.begin(), m_moveBuffer.end(), index, NullIndex);
+    }
+
+    m_tree.remove(proxy.id);
+    m_proxies.dispose(index);
+  }
+
+  void BroadPhase::clear() {
+    m_tree.clear();
+    m_proxies.clear();
+    m_moveBuffer.clear();
+    m_pairs.clear();
+  }
+
+  Handle BroadPhase::operator[](SpatialId id) {
+    std::size_t index = static_cast<std::size_t>(id);
+    return m_proxies[index].handle;
+  }
+
+  const std::vector<BroadPhasePair>& BroadPhase::updatePairs() {
+    Clock clock;
+
+    m_pairs.clear();
+    m_statistics.queries = 0;
+
+    for (auto index : m_moveBuffer) {
+      if (index == NullIndex) {
+        continue;
+      }
+
+      ++m_statistics.queries;
+
+      m_tree.query(m_proxies[index].bounds, [this,index](Handle handle) {
+        auto other = static_cast<std::size_t>(handle.asId());
+
+        if (other == index) {
+          return;
+        }
+
+        // if both objects moved, the pair is only reported by the object with the lowest index
+        if (m_proxies[other].moved && other < index) {
+          return;
+        }
+
+        m_pairs.push_back({ static_cast<SpatialId>(std::min(index, other)), static_cast<SpatialId>(std::max(index, other)) });
+      });
+    }
+
+    for (auto index : m_moveBuffer) {
+      if (index != NullIndex) {
+        m_proxies[index].moved = false;
+      }
+    }
+
+    m_moveBuffer.clear();
+
+    std::sort(m_pairs.begin(), m_pairs.end());
+    assert(std::adjacent_find(m_pairs.begin(), m_pairs.end()) == m_pairs.end());
+
+    m_statistics.pairs = m_pairs.size();
+    m_statistics.time = clock.getElapsedTime();
+    return m_pairs;
+  }
+
+  void BroadPhase::bufferMove(std::size_t index) {
+    Proxy& proxy = m_proxies[index];
+
+    if (proxy.moved) {
+      return;
+    }
+
+    proxy.moved = true;
+    m_moveBuffer.push_back(index);
+  }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+}
+#endif
+}
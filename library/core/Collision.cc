@@ -22,11 +22,14 @@
 
 #include <cassert>
 
-#include <queue>
+#include <algorithm>
+#include <limits>
 
 #include <gf/Log.h>
 #include <gf/Transform.h>
 
+#include <gfpriv/Parallel.h>
+
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
@@ -160,7 +163,7 @@ inline namespace v1 {
       float distance;
     };
 
-    struct EdgeCompare { // for priority_queue
+    struct EdgeCompare { // for the heap of the expanding simplex
       bool operator()(const Edge& lhs, const Edge& rhs) {
         return lhs.distance > rhs.distance;
       }
@@ -322,30 +325,39 @@ inline namespace v1 {
 
     class ExpandingSimplex {
     public:
-      ExpandingSimplex(const Simplex& simplex)
-      : m_winding(getWinding(simplex))
+      // the edges are stored in a binary heap in the given buffer, so that the buffer can be reused
+      ExpandingSimplex(const Simplex& simplex, std::vector<Edge>& edges)
+      : m_edges(edges)
+      , m_winding(getWinding(simplex))
       {
+        m_edges.clear();
         unsigned size = simplex.getSize();
 
         for (unsigned i = 0; i < size; ++i) {
           unsigned j = (i + 1) % size;
-          m_queue.push(getEdge(simplex[i], simplex[j], m_winding));
+          push(getEdge(simplex[i], simplex[j], m_winding));
         }
       }
 
       Edge getClosestEdge() const {
-        return m_queue.top();
+        return m_edges.front();
       }
 
       void expand(Vector2f point) {
-        Edge edge = m_queue.top();
-        m_queue.pop();
+        std::pop_heap(m_edges.begin(), m_edges.end(), EdgeCompare());
+        Edge edge = m_edges.back();
+        m_edges.pop_back();
 
-        m_queue.push(getEdge(edge.p1, point, m_winding));
-        m_queue.push(getEdge(point, edge.p2, m_winding));
+        push(getEdge(edge.p1, point, m_winding));
+        push(getEdge(point, edge.p2, m_winding));
       }
 
     private:
+      void push(const Edge& edge) {
+        m_edges.push_back(edge);
+        std::push_heap(m_edges.begin(), m_edges.end(), EdgeCompare());
+      }
+
       static Winding getWinding(const Simplex& simplex) {
         unsigned size = simplex.getSize();
 
@@ -367,15 +379,32 @@ inline namespace v1 {
       }
 
     private:
-      std::priority_queue<Edge, std::vector<Edge>, EdgeCompare> m_queue;
+      std::vector<Edge>& m_edges;
       Winding m_winding;
     };
 
 
-    static Vector2f getSupport(const Polygon& lhs, const Transform& lhsTrans, const Polygon& rhs, const Transform& rhsTrans, Vector2f direction) {
+    Vector2f getSupport(const Polygon& lhs, const Transform& lhsTrans, const Polygon& rhs, const Transform& rhsTrans, Vector2f direction) {
       return lhs.getSupport(direction, lhsTrans) - rhs.getSupport(-direction, rhsTrans);
     }
 
+    Vector2f getSupport(const Vector2f *vertices, std::size_t count, Vector2f direction) {
+      assert(count > 0);
+      std::size_t best = 0;
+      float bestDistance = gf::dot(direction, vertices[0]);
+
+      for (std::size_t i = 1; i < count; ++i) {
+        float distance = gf::dot(direction, vertices[i]);
+
+        if (distance > bestDistance) {
+          best = i;
+          bestDistance = distance;
+        }
+      }
+
+      return vertices[best];
+    }
+
     bool checkSimplex(Simplex& simplex, Vector2f& direction) {
       Vector2f a = simplex.getLast();
       Vector2f ao = -a;
@@ -418,69 +447,582 @@ inline namespace v1 {
   } // anonymous namespace
 
 
-  static constexpr unsigned MaxIterations = 100;
+  namespace {
+
+    constexpr unsigned MaxIterations = 100;
+
+    template<typename Support>
+    bool computePolygonCollision(Support support, std::vector<Edge>& edges, Penetration& p) {
+      /*
+       * Gilbert-Johnson-Keerthi (GJK) algorithm
+       * adapted from http://www.dyn4j.org/2010/04/gjk-gilbert-johnson-keerthi/
+       */
+
+      // Vector2f direction = gf::transform(rhsTrans, rhs.getCenter()) - gf::transform(lhsTrans, lhs.getCenter());
+      Vector2f direction(1,0);
+
+      Simplex simplex;
+      simplex.add(support(direction));
+
+      if (gf::dot(simplex.getLast(), direction) <= 0.0f) {
+        return false;
+      }
+
+      direction = -direction;
+
+      for (;;) {
+        simplex.add(support(direction));
+
+        if (gf::dot(simplex.getLast(), direction) <= 0.0f) {
+          return false;
+        }
+
+        if (checkSimplex(simplex, direction)) {
+          // there is a collision, we do not return yet
+          break;
+        }
+      }
+
+      /*
+       * Expanding Polytope Algorithm (EPA)
+       * adapted from http://www.dyn4j.org/2010/05/epa-expanding-polytope-algorithm/
+       */
+
+      ExpandingSimplex expandingSimplex(simplex, edges);
+      Edge edge;
+      Vector2f point;
+
+      for (unsigned i = 0; i < MaxIterations; ++i) {
+        edge = expandingSimplex.getClosestEdge();
+        point = support(edge.normal);
+        float distance = gf::dot(point, edge.normal);
+
+        if (distance - edge.distance < Skin) {
+          p.normal = edge.normal;
+          p.depth = distance;
+          return true;
+        }
+
+        expandingSimplex.expand(point);
+      }
+
+      p.normal = edge.normal;
+      p.depth = gf::dot(point, edge.normal);
+      return true;
+    }
+
+  } // anonymous namespace
 
   bool collides(const Polygon& lhs, const Transform& lhsTrans, const Polygon& rhs, const Transform& rhsTrans, Penetration& p) {
-    /*
-     * Gilbert-Johnson-Keerthi (GJK) algorithm
-     * adapted from http://www.dyn4j.org/2010/04/gjk-gilbert-johnson-keerthi/
-     */
+    std::vector<Edge> edges;
 
-    // Vector2f direction = gf::transform(rhsTrans, rhs.getCenter()) - gf::transform(lhsTrans, lhs.getCenter());
-    Vector2f direction(1,0);
+    auto support = [&](Vector2f direction) {
+      return getSupport(lhs, lhsTrans, rhs, rhsTrans, direction);
+    };
 
-    Simplex simplex;
-    simplex.add(getSupport(lhs, lhsTrans, rhs, rhsTrans, direction));
+    return computePolygonCollision(support, edges, p);
+  }
 
-    if (gf::dot(simplex.getLast(), direction) <= 0.0f) {
-      return false;
+  bool collides(const Polygon& lhs, const Polygon& rhs, Penetration& p) {
+    return collides(lhs, Transform(), rhs, Transform(), p);
+  }
+
+  /*
+   * PolygonCollisionBatch
+   */
+
+  struct PolygonCollisionBatch::Scratch {
+    std::vector<Edge> edges;
+    std::vector<PolygonCollision> collisions;
+  };
+
+  // the threads are kept from one call to the next
+  struct PolygonCollisionBatch::Team {
+    explicit Team(std::size_t count)
+    : threads(count)
+    , count(count)
+    {
     }
 
-    direction = -direction;
+    priv::ParallelTeam threads;
+    std::size_t count;
+  };
 
-    for (;;) {
-      simplex.add(getSupport(lhs, lhsTrans, rhs, rhsTrans, direction));
+  PolygonCollisionBatch::PolygonCollisionBatch() = default;
 
-      if (gf::dot(simplex.getLast(), direction) <= 0.0f) {
+  PolygonCollisionBatch::~PolygonCollisionBatch() = default;
+
+  void PolygonCollisionBatch::clear() {
+    m_vertices.clear();
+    m_polygons.clear();
+    m_pairs.clear();
+    m_collisions.clear();
+  }
+
+  std::size_t PolygonCollisionBatch::addPolygon(const Polygon& polygon, const Transform& transform) {
+    assert(!polygon.isEmpty());
+    std::size_t index = m_polygons.size();
+    std::size_t offset = m_vertices.size();
+    std::size_t count = polygon.getPointCount();
+    m_polygons.push_back({ offset, count });
+
+    m_vertices.resize(offset + count);
+    gf::transform(transform, Span<const Vector2f>(polygon.begin(), count), Span<Vector2f>(m_vertices.data() + offset, count));
+
+    return index;
+  }
+
+  void PolygonCollisionBatch::addPair(std::size_t first, std::size_t second) {
+    assert(first < m_polygons.size());
+    assert(second < m_polygons.size());
+    m_pairs.push_back({ first, second });
+  }
+
+  const std::vector<PolygonCollision>& PolygonCollisionBatch::computeCollisions(std::size_t threadCount) {
+    m_collisions.clear();
+
+    if (m_pairs.empty()) {
+      return m_collisions;
+    }
+
+    // each chunk is a contiguous range of pairs, with its own scratch buffers
+
+    std::size_t chunkCount = (threadCount == 0) ? priv::computeThreadCount(m_pairs.size()) : std::min(threadCount, m_pairs.size());
+    chunkCount = std::max(chunkCount, std::size_t(1));
+
+    if (m_scratches.size() < chunkCount) {
+      m_scratches.resize(chunkCount);
+    }
+
+    auto computeChunk = [this, chunkCount](std::size_t chunk) {
+      Scratch& scratch = m_scratches[chunk];
+      scratch.collisions.clear();
+
+      std::size_t begin = m_pairs.size() * chunk / chunkCount;
+      std::size_t end = m_pairs.size() * (chunk + 1) / chunkCount;
+
+      for (std::size_t i = begin; i < end; ++i) {
+        const Pair& pair = m_pairs[i];
+        const Range& lhs = m_polygons[pair.first];
+        const Range& rhs = m_polygons[pair.second];
+        const Vector2f *lhsVertices = m_vertices.data() + lhs.offset;
+        const Vector2f *rhsVertices = m_vertices.data() + rhs.offset;
+
+        auto support = [&](Vector2f direction) {
+          return getSupport(lhsVertices, lhs.count, direction) - getSupport(rhsVertices, rhs.count, -direction);
+        };
+
+        PolygonCollision collision;
+
+        if (computePolygonCollision(support, scratch.edges, collision.penetration)) {
+          collision.first = pair.first;
+          collision.second = pair.second;
+          scratch.collisions.push_back(collision);
+        }
+      }
+    };
+
+    if (chunkCount == 1) {
+      computeChunk(0);
+    } else {
+      if (!m_team || m_team->count < chunkCount) {
+        m_team = std::make_unique<Team>(chunkCount);
+      }
+
+      m_team->threads.parallelFor(chunkCount, computeChunk);
+    }
+
+    for (std::size_t chunk = 0; chunk < chunkCount; ++chunk) {
+      const auto& collisions = m_scratches[chunk].collisions;
+      m_collisions.insert(m_collisions.end(), collisions.begin(), collisions.end());
+    }
+
+    return m_collisions;
+  }
+
+  /*
+   * Continuous collision
+   */
+
+  namespace {
+
+    constexpr float ImpactTolerance = 0.01f;
+    constexpr unsigned MaxAdvancementIterations = 32;
+
+    // first time in [0, 1] when the moving origin hits the circle, the origin being outside the circle
+    bool computeRayCircleImpact(Vector2f origin, Vector2f motion, Vector2f center, float radius, float& time) {
+      Vector2f relative = origin - center;
+      float a = gf::dot(motion, motion);
+      float b = gf::dot(relative, motion);
+      float c = gf::dot(relative, relative) - gf::square(radius);
+
+      if (a == 0.0f || b >= 0.0f) {
         return false;
       }
 
-      if (checkSimplex(simplex, direction)) {
-        // there is a collision, we do not return yet
-        break;
+      float discriminant = b * b - a * c;
+
+      if (discriminant < 0.0f) {
+        return false;
       }
+
+      time = std::max((-b - std::sqrt(discriminant)) / a, 0.0f);
+      return time <= 1.0f;
     }
 
-    /*
-     * Expanding Polytope Algorithm (EPA)
-     * adapted from http://www.dyn4j.org/2010/05/epa-expanding-polytope-algorithm/
-     */
+    Vector2f computeClosestPoint(Vector2f point, Vector2f p1, Vector2f p2) {
+      Vector2f edge = p2 - p1;
+      float length = gf::squareLength(edge);
+
+      if (length == 0.0f) {
+        return p1;
+      }
+
+      float t = gf::clamp(gf::dot(point - p1, edge) / length, 0.0f, 1.0f);
+      return p1 + t * edge;
+    }
+
+    std::vector<Vector2f> computeWorldPoints(const Polygon& polygon, const Transform& transform) {
+      std::vector<Vector2f> points(polygon.getPointCount());
+      gf::transform(transform, Span<const Vector2f>(polygon.begin(), points.size()), points);
+      return points;
+    }
+
+    // greatest separation of the points along the outward normals of the polygon, negative if they overlap
+    float computeSeparation(const std::vector<Vector2f>& polygon, Winding winding, const std::vector<Vector2f>& points, Vector2f& axis) {
+      float best = std::numeric_limits<float>::lowest();
+      std::size_t sz = polygon.size();
 
-    ExpandingSimplex expandingSimplex(simplex);
-    Edge edge;
-    Vector2f point;
+      for (std::size_t i = 0; i < sz; ++i) {
+        Vector2f p1 = polygon[i];
+        Vector2f p2 = polygon[(i + 1) % sz];
+        Vector2f normal = getNormal(p1, p2, winding);
+        float separation = std::numeric_limits<float>::max();
 
-    for (unsigned i = 0; i < MaxIterations; ++i) {
-      edge = expandingSimplex.getClosestEdge();
-      point = getSupport(lhs, lhsTrans, rhs, rhsTrans, edge.normal);
-      float distance = gf::dot(point, edge.normal);
+        for (auto point : points) {
+          separation = std::min(separation, gf::dot(normal, point - p1));
+        }
 
-      if (distance - edge.distance < Skin) {
-        p.normal = edge.normal;
-        p.depth = distance;
-        return true;
+        if (separation > best) {
+          best = separation;
+          axis = normal;
+        }
       }
 
-      expandingSimplex.expand(point);
+      return best;
     }
 
-    p.normal = edge.normal;
-    p.depth = gf::dot(point, edge.normal);
+    // distance between two separated convex polygons, the first one being moved by an offset
+    float computeDistance(const std::vector<Vector2f>& lhs, Vector2f offset, const std::vector<Vector2f>& rhs, Vector2f& normal) {
+      float best = std::numeric_limits<float>::max();
+      Vector2f lhsBest = lhs[0] + offset;
+      Vector2f rhsBest = rhs[0];
+
+      for (std::size_t i = 0; i < lhs.size(); ++i) {
+        Vector2f lhsPoint = lhs[i] + offset;
+
+        for (std::size_t j = 0; j < rhs.size(); ++j) {
+          Vector2f closest = computeClosestPoint(lhsPoint, rhs[j], rhs[(j + 1) % rhs.size()]);
+          float distance = gf::squareDistance(lhsPoint, closest);
+
+          if (distance < best) {
+            best = distance;
+            lhsBest = lhsPoint;
+            rhsBest = closest;
+          }
+        }
+      }
+
+      for (std::size_t j = 0; j < rhs.size(); ++j) {
+        for (std::size_t i = 0; i < lhs.size(); ++i) {
+          Vector2f closest = computeClosestPoint(rhs[j], lhs[i] + offset, lhs[(i + 1) % lhs.size()] + offset);
+          float distance = gf::squareDistance(rhs[j], closest);
+
+          if (distance < best) {
+            best = distance;
+            lhsBest = closest;
+            rhsBest = rhs[j];
+          }
+        }
+      }
+
+      best = std::sqrt(best);
+
+      if (best > 0.0f) {
+        normal = (rhsBest - lhsBest) / best;
+      }
+
+      return best;
+    }
+
+    // the distance can not be computed more precisely than the floats of the
+    // positions along the motion, the tolerance must be above this resolution
+    float computeImpactTolerance(const std::vector<Vector2f>& lhs, const std::vector<Vector2f>& rhs, Vector2f motion) {
+      float magnitude = std::max(std::abs(motion.x), std::abs(motion.y));
+
+      for (auto point : lhs) {
+        magnitude = std::max({ magnitude, std::abs(point.x), std::abs(point.y) });
+      }
+
+      for (auto point : rhs) {
+        magnitude = std::max({ magnitude, std::abs(point.x), std::abs(point.y) });
+      }
+
+      return std::max(ImpactTolerance, 4 * std::numeric_limits<float>::epsilon() * magnitude);
+    }
+
+  } // anonymous namespace
+
+  bool computeImpact(const CircF& lhs, Vector2f lhsMotion, const RectF& rhs, Vector2f rhsMotion, Impact& impact) {
+    // the circle moves relatively to the rectangle
+    Vector2f center = lhs.getCenter();
+    Vector2f motion = lhsMotion - rhsMotion;
+    float radius = lhs.getRadius();
+
+    Vector2f closest = gf::clamp(center, rhs.min, rhs.max);
+
+    if (closest == center) {
+      // the center is inside, the normal is the one of the closest side
+      Vector2f toMin = center - rhs.min;
+      Vector2f toMax = rhs.max - center;
+      float best = std::min({ toMin.x, toMin.y, toMax.x, toMax.y });
+
+      if (best == toMin.x) {
+        impact.normal = { 1.0f, 0.0f };
+      } else if (best == toMax.x) {
+        impact.normal = { -1.0f, 0.0f };
+      } else if (best == toMin.y) {
+        impact.normal = { 0.0f, 1.0f };
+      } else {
+        impact.normal = { 0.0f, -1.0f };
+      }
+
+      impact.time = 0.0f;
+      return true;
+    }
+
+    if (gf::squareDistance(center, closest) <= gf::square(radius)) {
+      impact.time = 0.0f;
+      impact.normal = gf::normalize(closest - center);
+      return true;
+    }
+
+    // the center against the rectangle extended by the radius (slab method)
+
+    float enter = 0.0f;
+    float exit = 1.0f;
+    std::size_t axis = 2;
+
+    for (std::size_t j = 0; j < 2; ++j) {
+      float min = rhs.min[j] - radius;
+      float max = rhs.max[j] + radius;
+
+      if (motion[j] == 0.0f) {
+        if (center[j] < min || center[j] > max) {
+          return false;
+        }
+
+        continue;
+      }
+
+      float t0 = (min - center[j]) / motion[j];
+      float t1 = (max - center[j]) / motion[j];
+
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+
+      if (t0 > enter) {
+        enter = t0;
+        axis = j;
+      }
+
+      exit = std::min(exit, t1);
+
+      if (enter > exit) {
+        return false;
+      }
+    }
+
+    // the corners of the extended rectangle are rounded
+
+    Vector2f hit = center + enter * motion;
+    bool outsideX = hit.x < rhs.min.x || hit.x > rhs.max.x;
+    bool outsideY = hit.y < rhs.min.y || hit.y > rhs.max.y;
+
+    if ((outsideX && outsideY) || axis == 2) {
+      Vector2f corner = gf::clamp(hit, rhs.min, rhs.max);
+      float time;
+
+      if (!computeRayCircleImpact(center, motion, corner, radius, time)) {
+        return false;
+      }
+
+      impact.time = time;
+      impact.normal = gf::normalize(corner - (center + time * motion));
+      return true;
+    }
+
+    impact.time = enter;
+    impact.normal = { 0.0f, 0.0f };
+    impact.normal[axis] = motion[axis] > 0 ? 1.0f : -1.0f;
     return true;
   }
 
-  bool collides(const Polygon& lhs, const Polygon& rhs, Penetration& p) {
-    return collides(lhs, Transform(), rhs, Transform(), p);
+  bool computeImpact(const RectF& lhs, Vector2f lhsMotion, const CircF& rhs, Vector2f rhsMotion, Impact& impact) {
+    bool ret = computeImpact(rhs, rhsMotion, lhs, lhsMotion, impact);
+    impact.normal = -impact.normal;
+    return ret;
+  }
+
+  bool computeImpact(const CircF& lhs, const Transform& lhsTrans, Vector2f lhsMotion, const Polygon& rhs, const Transform& rhsTrans, Vector2f rhsMotion, Impact& impact) {
+    // the circle moves relatively to the polygon, in the local coordinates of the polygon
+    Vector2f center = gf::inverseTransform(rhsTrans, gf::transform(lhsTrans, lhs.getCenter()));
+    Vector2f motion = gf::inverseTransform(rhsTrans.rotation, lhsMotion - rhsMotion);
+    float radius = lhs.getRadius();
+
+    std::size_t sz = rhs.getPointCount();
+    Winding winding = rhs.getWinding();
+
+    float bestDistance = std::numeric_limits<float>::lowest();
+    Vector2f bestNormal = { 0.0f, 0.0f };
+    Vector2f closest = rhs.getPoint(0);
+
+    for (std::size_t i = 0; i < sz; ++i) {
+      Vector2f p1 = rhs.getPoint(i);
+      Vector2f p2 = rhs.getPoint((i + 1) % sz);
+      Vector2f normal = getNormal(p1, p2, winding);
+      float distance = gf::dot(normal, center - p1);
+
+      if (distance > bestDistance) {
+        bestDistance = distance;
+        bestNormal = normal;
+      }
+
+      Vector2f point = computeClosestPoint(center, p1, p2);
+
+      if (gf::squareDistance(center, point) < gf::squareDistance(center, closest)) {
+        closest = point;
+      }
+    }
+
+    if (bestDistance <= 0.0f) {
+      impact.time = 0.0f;
+      impact.normal = gf::transform(rhsTrans.rotation, -bestNormal);
+      return true;
+    }
+
+    if (gf::squareDistance(center, closest) <= gf::square(radius)) {
+      impact.time = 0.0f;
+      impact.normal = gf::transform(rhsTrans.rotation, gf::normalize(closest - center));
+      return true;
+    }
+
+    // the center against the polygon extended by the radius: shifted edges and rounded vertices
+
+    float bestTime = std::numeric_limits<float>::max();
+
+    for (std::size_t i = 0; i < sz; ++i) {
+      Vector2f p1 = rhs.getPoint(i);
+      Vector2f p2 = rhs.getPoint((i + 1) % sz);
+      Vector2f normal = getNormal(p1, p2, winding);
+      float distance = gf::dot(normal, center - p1);
+      float speed = gf::dot(normal, motion);
+
+      if (speed < 0.0f && distance > radius) {
+        float time = (radius - distance) / speed;
+
+        if (time <= 1.0f && time < bestTime) {
+          Vector2f contact = center + time * motion - radius * normal;
+          float s = gf::dot(contact - p1, p2 - p1);
+
+          if (s >= 0.0f && s <= gf::squareLength(p2 - p1)) {
+            bestTime = time;
+            bestNormal = -normal;
+          }
+        }
+      }
+
+      float time;
+
+      if (computeRayCircleImpact(center, motion, p1, radius, time) && time < bestTime) {
+        bestTime = time;
+        bestNormal = gf::normalize(p1 - (center + time * motion));
+      }
+    }
+
+    if (bestTime > 1.0f) {
+      return false;
+    }
+
+    impact.time = bestTime;
+    impact.normal = gf::transform(rhsTrans.rotation, bestNormal);
+    return true;
+  }
+
+  bool computeImpact(const Polygon& lhs, const Transform& lhsTrans, Vector2f lhsMotion, const CircF& rhs, const Transform& rhsTrans, Vector2f rhsMotion, Impact& impact) {
+    bool ret = computeImpact(rhs, rhsTrans, rhsMotion, lhs, lhsTrans, lhsMotion, impact);
+    impact.normal = -impact.normal;
+    return ret;
+  }
+
+  bool computeImpact(const Polygon& lhs, const Transform& lhsTrans, Vector2f lhsMotion, const Polygon& rhs, const Transform& rhsTrans, Vector2f rhsMotion, Impact& impact) {
+    // the first polygon moves relatively to the second one
+    std::vector<Vector2f> lhsPoints = computeWorldPoints(lhs, lhsTrans);
+    std::vector<Vector2f> rhsPoints = computeWorldPoints(rhs, rhsTrans);
+    Vector2f motion = lhsMotion - rhsMotion;
+
+    Vector2f lhsAxis;
+    float lhsSeparation = computeSeparation(lhsPoints, lhs.getWinding(), rhsPoints, lhsAxis);
+    Vector2f rhsAxis;
+    float rhsSeparation = computeSeparation(rhsPoints, rhs.getWinding(), lhsPoints, rhsAxis);
+
+    if (lhsSeparation <= 0.0f && rhsSeparation <= 0.0f) {
+      impact.time = 0.0f;
+      impact.normal = (lhsSeparation > rhsSeparation) ? lhsAxis : -rhsAxis;
+      return true;
+    }
+
+    /*
+     * Conservative advancement
+     * The distance can not decrease faster than the motion along the normal
+     * so advancing by the distance divided by this speed is safe.
+     */
+
+    float time = 0.0f;
+    Vector2f normal = lhsSeparation > rhsSeparation ? lhsAxis : -rhsAxis;
+    float tolerance = computeImpactTolerance(lhsPoints, rhsPoints, motion);
+    bool converged = false;
+
+    for (unsigned i = 0; i < MaxAdvancementIterations; ++i) {
+      float distance = computeDistance(lhsPoints, time * motion, rhsPoints, normal);
+
+      if (distance < tolerance) {
+        converged = true;
+        break;
+      }
+
+      float speed = gf::dot(motion, normal);
+
+      if (speed <= 0.0f) {
+        return false;
+      }
+
+      time += (distance - tolerance / 2) / speed;
+
+      if (time > 1.0f) {
+        return false;
+      }
+    }
+
+    if (!converged) {
+      // e.g. the polygons graze each other, the distance never goes below the tolerance
+      return false;
+    }
+
+    impact.time = time;
+    impact.normal = normal;
+    return true;
   }
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -20,29 +20,220 @@
  */
 #include <gf/Heightmap.h>
 
+#include <cmath>
 #include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
 
 #include <gf/Color.h>
 #include <gf/VectorOps.h>
 
+#include <gfpriv/Parallel.h>
+
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
 #endif
 
-  Heightmap::Heightmap(Vector2i size)
-  : m_data(size, 0.0)
+  namespace {
+
+    constexpr double QuantizedLevels = 65535.0;
+
+    template<typename T>
+    void quantize(const Array2D<T, int>& values, Array2D<uint16_t, int>& codes, double& min, double& step) {
+      if (values.isEmpty()) {
+        min = step = 0.0;
+        return;
+      }
+
+      auto p = std::minmax_element(values.begin(), values.end());
+      min = *p.first;
+      step = (*p.second - min) / QuantizedLevels;
+
+      if (!(step > 0.0)) {
+        step = 0.0;
+        std::fill(codes.begin(), codes.end(), uint16_t(0));
+        return;
+      }
+
+      const double inverse = 1.0 / step;
+
+      std::transform(values.begin(), values.end(), codes.begin(), [min, inverse](T value) {
+        return static_cast<uint16_t>(std::clamp(std::lround((value - min) * inverse), 0L, 65535L));
+      });
+    }
+
+    template<typename T>
+    Array2D<T, int> dequantize(const Array2D<uint16_t, int>& codes, double min, double step) {
+      Array2D<T, int> values(codes.getSize());
+
+      std::transform(codes.begin(), codes.end(), values.begin(), [min, step](uint16_t code) {
+        return static_cast<T>(min + code * step);
+      });
+
+      return values;
+    }
+
+  } // anonymous namespace
+
+  // the function receives the heights as an array of double or float, the
+  // quantized heights are expanded to doubles and quantized again afterwards,
+  // floats could not represent all the levels when the minimum is large
+  // compared to the range
+  template<typename Function>
+  void Heightmap::modify(Function function) {
+    switch (m_storage) {
+      case Storage::Double:
+        function(m_data);
+        break;
+
+      case Storage::Float:
+        function(m_floatData);
+        break;
+
+      case Storage::Quantized: {
+        Array2D<double, int> values = dequantize<double>(m_quantizedData, m_quantizedMin, m_quantizedStep);
+        function(values);
+        quantize(values, m_quantizedData, m_quantizedMin, m_quantizedStep);
+        break;
+      }
+    }
+  }
+
+  Heightmap::Heightmap(Vector2i size, Storage storage)
+  : m_storage(storage)
   {
+    switch (m_storage) {
+      case Storage::Double:
+        m_data = Array2D<double, int>(size, 0.0);
+        break;
+
+      case Storage::Float:
+        m_floatData = Array2D<float, int>(size, 0.0f);
+        break;
+
+      case Storage::Quantized:
+        m_quantizedData = Array2D<uint16_t, int>(size, uint16_t(0));
+        break;
+    }
+  }
+
+  std::size_t Heightmap::getByteSize() const {
+    return m_data.getDataSize() * sizeof(double) + m_floatData.getDataSize() * sizeof(float) + m_quantizedData.getDataSize() * sizeof(uint16_t);
+  }
+
+  Heightmap Heightmap::convertTo(Storage storage) const {
+    if (storage == m_storage) {
+      return *this;
+    }
+
+    Heightmap out(getSize(), storage);
 
+    auto convert = [&](const auto& values) {
+      switch (storage) {
+        case Storage::Double:
+          std::copy(values.begin(), values.end(), out.m_data.begin());
+          break;
+
+        case Storage::Float:
+          std::transform(values.begin(), values.end(), out.m_floatData.begin(), [](double value) { return static_cast<float>(value); });
+          break;
+
+        case Storage::Quantized:
+          quantize(values, out.m_quantizedData, out.m_quantizedMin, out.m_quantizedStep);
+          break;
+      }
+    };
+
+    switch (m_storage) {
+      case Storage::Double:
+        convert(m_data);
+        break;
+
+      case Storage::Float:
+        convert(m_floatData);
+        break;
+
+      case Storage::Quantized:
+        convert(dequantize<double>(m_quantizedData, m_quantizedMin, m_quantizedStep));
+        break;
+    }
+
+    return out;
+  }
+
+  void Heightmap::setQuantizedValue(Vector2i position, double value) {
+    double code = m_quantizedStep > 0.0 ? (value - m_quantizedMin) / m_quantizedStep : 0.0;
+
+    if (0.0 <= code && code <= QuantizedLevels && (m_quantizedStep > 0.0 || value == m_quantizedMin)) {
+      m_quantizedData(position) = static_cast<uint16_t>(std::lround(code));
+      return;
+    }
+
+    // the value is out of the current range, the range is extended towards
+    // the value and at least doubled so that a sequence of writes only
+    // quantizes the heights again a logarithmic number of times, and the
+    // rounding errors stay below the final step
+    double lo = m_quantizedMin;
+    double hi = m_quantizedMin + QuantizedLevels * m_quantizedStep;
+
+    double min = lo;
+    double step = 0.0;
+
+    if (value > hi) {
+      step = std::max(2.0 * m_quantizedStep, (value - lo) / QuantizedLevels);
+    } else {
+      step = std::max(2.0 * m_quantizedStep, (hi - value) / QuantizedLevels);
+      min = hi - QuantizedLevels * step;
+    }
+
+    const double inverse = 1.0 / step;
+
+    for (auto& code : m_quantizedData) {
+      double height = m_quantizedMin + code * m_quantizedStep;
+      code = static_cast<uint16_t>(std::clamp(std::lround((height - min) * inverse), 0L, 65535L));
+    }
+
+    m_quantizedMin = min;
+    m_quantizedStep = step;
+    m_quantizedData(position) = static_cast<uint16_t>(std::clamp(std::lround((value - min) * inverse), 0L, 65535L));
   }
 
   void Heightmap::reset() {
-    std::fill(m_data.begin(), m_data.end(), 0.0);
+    if (m_storage == Storage::Quantized) {
+      std::fill(m_quantizedData.begin(), m_quantizedData.end(), uint16_t(0));
+      m_quantizedMin = m_quantizedStep = 0.0;
+      return;
+    }
+
+    modify([](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+      std::fill(heights.begin(), heights.end(), T(0));
+    });
   }
 
   std::tuple<double, double> Heightmap::getMinMax() const {
-    auto p = std::minmax_element(m_data.begin(), m_data.end());
-    return std::make_tuple(*p.first, *p.second);
+    switch (m_storage) {
+      case Storage::Double: {
+        auto p = std::minmax_element(m_data.begin(), m_data.end());
+        return std::make_tuple(*p.first, *p.second);
+      }
+
+      case Storage::Float: {
+        auto p = std::minmax_element(m_floatData.begin(), m_floatData.end());
+        return std::make_tuple(static_cast<double>(*p.first), static_cast<double>(*p.second));
+      }
+
+      case Storage::Quantized: {
+        auto p = std::minmax_element(m_quantizedData.begin(), m_quantizedData.end());
+        double lo = m_quantizedMin + *p.first * m_quantizedStep;
+        double hi = m_quantizedMin + *p.second * m_quantizedStep;
+        return std::make_tuple(std::min(lo, hi), std::max(lo, hi));
+      }
+    }
+
+    return std::make_tuple(0.0, 0.0);
   }
 
   void Heightmap::normalize(double min, double max) {
@@ -59,103 +250,157 @@ inline namespace v1 {
       factor = (max - min) / (currMax - currMin);
     }
 
-    for (auto& value : m_data) {
-      value = min + (value - currMin) * factor;
+    if (m_storage == Storage::Quantized) {
+      // an affine transformation only changes the quantization
+      m_quantizedMin = min + (m_quantizedMin - currMin) * factor;
+      m_quantizedStep *= factor;
+      return;
     }
+
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+
+      for (auto& value : heights) {
+        value = static_cast<T>(min + (value - currMin) * factor);
+      }
+    });
   }
 
   void Heightmap::addHill(Vector2d center, double radius, double height) {
-    Vector2i size = m_data.getSize();
-    double radiusSquare = gf::square(radius);
-    double coeff = height / radiusSquare;
-    int minX = std::max(0, static_cast<int>(center.x - radius));
-    int maxX = std::min(size.width, static_cast<int>(center.x + radius));
-    int minY = std::max(0, static_cast<int>(center.y - radius));
-    int maxY = std::min(size.height, static_cast<int>(center.y + radius));
-
-    for (int y = minY; y < maxY; ++y) {
-      double yDistSquare = gf::square(y - center.y);
-
-      for (int x = minX; x < maxX; ++x) {
-        double xDistSquare = gf::square(x - center.x);
-        double z = radiusSquare - (yDistSquare + xDistSquare);
-
-        if (z > 0.0) {
-          m_data({ x, y }) += z * coeff;
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+
+      Vector2i size = heights.getSize();
+      double radiusSquare = gf::square(radius);
+      double coeff = height / radiusSquare;
+      int minX = std::max(0, static_cast<int>(center.x - radius));
+      int maxX = std::min(size.width, static_cast<int>(center.x + radius));
+      int minY = std::max(0, static_cast<int>(center.y - radius));
+      int maxY = std::min(size.height, static_cast<int>(center.y + radius));
+
+      for (int y = minY; y < maxY; ++y) {
+        double yDistSquare = gf::square(y - center.y);
+
+        for (int x = minX; x < maxX; ++x) {
+          double xDistSquare = gf::square(x - center.x);
+          double z = radiusSquare - (yDistSquare + xDistSquare);
+
+          if (z > 0.0) {
+            heights({ x, y }) += static_cast<T>(z * coeff);
+          }
         }
       }
-    }
+    });
   }
 
   void Heightmap::digHill(Vector2d center, double radius, double height) {
-    Vector2i size = m_data.getSize();
-    double radiusSquare = gf::square(radius);
-    double coeff = height / radiusSquare;
-    int minX = std::max(0, static_cast<int>(center.x - radius));
-    int maxX = std::min(size.width, static_cast<int>(center.x + radius));
-    int minY = std::max(0, static_cast<int>(center.y - radius));
-    int maxY = std::min(size.height, static_cast<int>(center.y + radius));
-
-    for (int y = minY; y < maxY; ++y) {
-      double yDistSquare = gf::square(y - center.y);
-
-      for (int x = minX; x < maxX; ++x) {
-        double xDistSquare = gf::square(x - center.x);
-        double distSquare = yDistSquare + xDistSquare;
-
-        if (distSquare < radiusSquare) {
-          double z = (radiusSquare - distSquare) * coeff;
-
-          if (height > 0.0) {
-            if (m_data( { x, y }) < z) {
-              m_data( { x, y }) = z;
-            }
-          } else {
-            if (m_data( { x, y }) > z) {
-              m_data( { x, y }) = z;
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+
+      Vector2i size = heights.getSize();
+      double radiusSquare = gf::square(radius);
+      double coeff = height / radiusSquare;
+      int minX = std::max(0, static_cast<int>(center.x - radius));
+      int maxX = std::min(size.width, static_cast<int>(center.x + radius));
+      int minY = std::max(0, static_cast<int>(center.y - radius));
+      int maxY = std::min(size.height, static_cast<int>(center.y + radius));
+
+      for (int y = minY; y < maxY; ++y) {
+        double yDistSquare = gf::square(y - center.y);
+
+        for (int x = minX; x < maxX; ++x) {
+          double xDistSquare = gf::square(x - center.x);
+          double distSquare = yDistSquare + xDistSquare;
+
+          if (distSquare < radiusSquare) {
+            T z = static_cast<T>((radiusSquare - distSquare) * coeff);
+
+            if (height > 0.0) {
+              if (heights( { x, y }) < z) {
+                heights( { x, y }) = z;
+              }
+            } else {
+              if (heights( { x, y }) > z) {
+                heights( { x, y }) = z;
+              }
             }
           }
-        }
 
+        }
       }
-    }
+    });
   }
 
   void Heightmap::addNoise(Noise2D& noise, double scale)  {
-    for (auto row : m_data.getRowRange()) {
-      double y = static_cast<double>(row) / m_data.getRows() * scale;
+    Vector2i size = getSize();
+    addNoise(noise, { 0.0, 0.0 }, { scale / size.width, scale / size.height });
+  }
+
+  void Heightmap::addNoise(Noise2D& noise, Vector2d origin, Vector2d step)  {
+    Vector2i size = getSize();
+    // the noise is sampled row by row in order to keep the temporary memory small
+    std::vector<double> row(static_cast<std::size_t>(size.width));
 
-      for (auto col : m_data.getColRange()) {
-        double x = static_cast<double>(col) / m_data.getCols() * scale;
-        m_data({ col, row }) += noise(x, y);
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+
+      for (int j = 0; j < size.height; ++j) {
+        noise.fillGrid({ origin.x, origin.y + j * step.y }, step, { size.width, 1 }, row);
+
+        for (int i = 0; i < size.width; ++i) {
+          heights({ i, j }) += static_cast<T>(row[i]);
+        }
       }
-    }
+    });
   }
 
   void Heightmap::addValue(double value) {
-    for (auto& currentValue : m_data) {
-      currentValue += value;
+    if (m_storage == Storage::Quantized) {
+      m_quantizedMin += value;
+      return;
     }
+
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+
+      for (auto& currentValue : heights) {
+        currentValue += static_cast<T>(value);
+      }
+    });
   }
 
   void Heightmap::scale(double value) {
-    for (auto& currentValue : m_data) {
-      currentValue *= value;
+    if (m_storage == Storage::Quantized) {
+      m_quantizedMin *= value;
+      m_quantizedStep *= value;
+      return;
     }
+
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+
+      for (auto& currentValue : heights) {
+        currentValue *= static_cast<T>(value);
+      }
+    });
   }
 
   void Heightmap::clamp(double min, double max) {
-    for (auto& value : m_data) {
-      value = gf::clamp(value, min, max);
-    }
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+
+      for (auto& value : heights) {
+        value = gf::clamp(value, static_cast<T>(min), static_cast<T>(max));
+      }
+    });
   }
 
   double Heightmap::getSlope(Vector2i position) const {
-    const double altitude = m_data(position);
+    const double altitude = getValue(position);
     double altitudeDifferenceMax = 0.0;
 
-    for (auto positionThere : m_data.get4NeighborsRange(position)) {
-      double altitudeThere = m_data(positionThere);
+    for (auto positionThere : Index2D<int>(getSize()).get4NeighborsRange(position)) {
+      double altitudeThere = getValue(positionThere);
       double altitudeDifference = std::abs(altitude - altitudeThere);
 
       if (altitudeDifference > altitudeDifferenceMax) {
@@ -166,191 +411,611 @@ inline namespace v1 {
     return altitudeDifferenceMax;
   }
 
-  void Heightmap::thermalErosion(unsigned iterations, double talus, double fraction) {
-    double d[3][3];
+  namespace {
 
-    Array2D<double, int> material(m_data.getSize());
+    template<typename T>
+    void computeSerialThermalErosion(Array2D<T, int>& heights, unsigned iterations, T talus, T fraction) {
+      T d[3][3];
 
-    for (unsigned k = 0; k < iterations; ++k) {
+      Array2D<T, int> material(heights.getSize());
 
-      // initialize material map
-      std::fill(material.begin(), material.end(), 0.0);
+      for (unsigned k = 0; k < iterations; ++k) {
 
-      // compute material map
-      for (int y = 1; y < m_data.getRows() - 1; ++y) {
-        for (int x = 1; x < m_data.getCols() - 1; ++x) {
-          double diffTotal = 0.0;
-          double diffMax = 0.0;
+        // initialize material map
+        std::fill(material.begin(), material.end(), T(0));
 
-          for (int i = -1; i <= 1; ++i) {
-            for (int j = -1; j <= 1; ++j) {
-              double diff = m_data({ x, y }) - m_data({ x+i, y+j });
-              d[1+i][1+j] = diff;
+        // compute material map
+        for (int y = 1; y < heights.getRows() - 1; ++y) {
+          for (int x = 1; x < heights.getCols() - 1; ++x) {
+            T diffTotal = T(0);
+            T diffMax = T(0);
+
+            for (int i = -1; i <= 1; ++i) {
+              for (int j = -1; j <= 1; ++j) {
+                T diff = heights({ x, y }) - heights({ x+i, y+j });
+                d[1+i][1+j] = diff;
 
-              if (diff > talus) {
-                diffTotal += diff;
+                if (diff > talus) {
+                  diffTotal += diff;
 
-                if (diff > diffMax) {
-                  diffMax = diff;
+                  if (diff > diffMax) {
+                    diffMax = diff;
+                  }
+                }
+              }
+            }
+
+            for (int i = -1; i <= 1; ++i) {
+              for (int j = -1; j <= 1; ++j) {
+                T diff = d[1+i][1+j];
+
+                if (diff > talus) {
+                  material({ x+i, y+j }) += fraction * (diffMax - talus) * (diff / diffTotal);
                 }
               }
             }
           }
+        }
 
-          for (int i = -1; i <= 1; ++i) {
-            for (int j = -1; j <= 1; ++j) {
-              double diff = d[1+i][1+j];
+        // add material map to the heightmap
+        for (int y = 1; y < heights.getRows() - 1; ++y) {
+          for (int x = 1; x < heights.getCols() - 1; ++x) {
+            heights({ x, y }) += material({ x, y });
+          }
+        }
+      }
+    }
+
+    template<typename T>
+    void computeSerialHydraulicErosion(Array2D<T, int>& heights, unsigned iterations, T rainAmount, T solubility, T evaporation, T capacity) {
+      Array2D<T, int> waterMap(heights.getSize(), T(0));
+      Array2D<T, int> waterDiff(heights.getSize(), T(0));
+
+      Array2D<T, int> materialMap(heights.getSize(), T(0));
+      Array2D<T, int> materialDiff(heights.getSize(), T(0));
+
+      T d[3][3];
+
+      for (unsigned k = 0; k < iterations; ++k) {
 
-              if (diff > talus) {
-                material({ x+i, y+j }) += fraction * (diffMax - talus) * (diff / diffTotal);
+        // 1. appearance of new water
+        for (auto& water : waterMap) {
+          water += rainAmount;
+        }
+
+        // 2. water erosion of the terrain
+        for (auto pos : waterMap.getPositionRange()) {
+          T material = solubility * waterMap(pos);
+          heights(pos) -= material;
+          materialMap(pos) += material;
+        }
+
+        // 3. transportation of water
+        std::fill(waterDiff.begin(), waterDiff.end(), T(0));
+        std::fill(materialDiff.begin(), materialDiff.end(), T(0));
+
+        for (int y = 1; y < heights.getRows() - 1; ++y) {
+          for (int x = 1; x < heights.getCols() - 1; ++x) {
+            T diffTotal = T(0);
+            T altitudeTotal = T(0);
+            T altitude = heights({ x, y }) + waterMap({ x, y });
+            int n = 0;
+
+            for (int i = -1; i <= 1; ++i) {
+              for (int j = -1; j <= 1; ++j) {
+                T altitudeLocal = heights({ x+i, y+j }) + waterMap({ x+i, y+j });
+                T diff = altitude - altitudeLocal;
+                d[1+i][1+j] = diff;
+
+                if (diff > T(0)) {
+                  diffTotal += diff;
+                  altitudeTotal += altitudeLocal;
+                  n++;
+                }
+              }
+            }
+
+            if (n == 0) {
+              continue;
+            }
+
+            T altitudeAverage = altitudeTotal / n;
+            T diffAltitude = std::min(waterMap({ x, y }), altitude - altitudeAverage);
+
+            for (int i = -1; i <= 1; ++i) {
+              for (int j = -1; j <= 1; ++j) {
+                T diff = d[1+i][1+j];
+
+                if (diff > T(0)) {
+                  T diffWater = diffAltitude * (diff / diffTotal);
+                  waterDiff({ x + i, y + j }) += diffWater;
+                  waterDiff({ x, y }) -= diffWater;
+
+                  T diffMaterial = materialMap({ x, y }) * (diffWater / waterMap({ x, y }));
+                  materialDiff({ x + i, y + j }) += diffMaterial;
+                  materialDiff({ x, y }) -= diffMaterial;
+                }
               }
             }
           }
         }
+
+        for (auto pos : waterMap.getPositionRange()) {
+          waterMap(pos) += waterDiff(pos);
+        }
+
+        for (auto pos : materialMap.getPositionRange()) {
+          materialMap(pos) += materialDiff(pos);
+        }
+
+        // 4. evaporation of water
+        for (auto pos : waterMap.getPositionRange()) {
+          T water = waterMap(pos) * (1 - evaporation);
+
+          waterMap(pos) = water;
+
+          T materialMax = capacity * water;
+          T diffMaterial = std::max(T(0), materialMap(pos) - materialMax);
+          materialMap(pos) -= diffMaterial;
+          heights(pos) += diffMaterial;
+        }
+
       }
+    }
+
+    template<typename T>
+    void computeSerialFastErosion(Array2D<T, int>& heights, unsigned iterations, T talus, T fraction) {
+      Array2D<T, int> material(heights.getSize());
+
+      for (unsigned k = 0; k < iterations; ++k) {
+
+        // initialize material map
+        std::fill(material.begin(), material.end(), T(0));
+
+        // compute material map
+        for (auto position : heights.getPositionRange()) {
+          T altitudeDifferenceMax = T(0);
+          Vector2i positionMax = position;
+
+          const T altitude = heights(position);
 
-      // add material map to the heightmap
-      for (int y = 1; y < m_data.getRows() - 1; ++y) {
-        for (int x = 1; x < m_data.getCols() - 1; ++x) {
-          m_data({ x, y }) += material({ x, y });
+          for (auto positionThere : heights.get8NeighborsRange(position)) {
+            T altitudeThere = heights(positionThere);
+
+            T altitudeDifference = altitude - altitudeThere;
+            if (altitudeDifference > altitudeDifferenceMax) {
+              altitudeDifferenceMax = altitudeDifference;
+              positionMax = positionThere;
+            }
+          }
+
+          if (0 < altitudeDifferenceMax && altitudeDifferenceMax <= talus) {
+            material(position) -= fraction * altitudeDifferenceMax;
+            material(positionMax) += fraction * altitudeDifferenceMax;
+          }
+        }
+
+        // add material map to the map
+        for (auto position : heights.getPositionRange()) {
+          heights(position) += material(position);
         }
       }
     }
+
+  } // anonymous namespace
+
+  void Heightmap::thermalErosion(unsigned iterations, double talus, double fraction) {
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+      computeSerialThermalErosion(heights, iterations, static_cast<T>(talus), static_cast<T>(fraction));
+    });
   }
 
   void Heightmap::hydraulicErosion(unsigned iterations, double rainAmount, double solubility, double evaporation, double capacity) {
-    Array2D<double, int> waterMap(m_data.getSize(), 0.0);
-    Array2D<double, int> waterDiff(m_data.getSize(), 0.0);
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+      computeSerialHydraulicErosion(heights, iterations, static_cast<T>(rainAmount), static_cast<T>(solubility), static_cast<T>(evaporation), static_cast<T>(capacity));
+    });
+  }
+
+  void Heightmap::fastErosion(unsigned iterations, double talus, double fraction) {
+    modify([&](auto& heights) {
+      using T = std::decay_t<decltype(*heights.begin())>;
+      computeSerialFastErosion(heights, iterations, static_cast<T>(talus), static_cast<T>(fraction));
+    });
+  }
 
-    Array2D<double, int> materialMap(m_data.getSize(), 0.0);
-    Array2D<double, int> materialDiff(m_data.getSize(), 0.0);
+  namespace {
 
-    double d[3][3];
+    // the parallel erosions are computed on bands of rows (the tiles). Each
+    // pass reads the previous state and only writes the cells of its tile, so
+    // the result does not depend on the scheduling of the tiles. The material
+    // that moves between two cells is gathered by the receiving cell instead
+    // of being scattered by the sending cell. The threads are kept in a team
+    // for all the passes of all the iterations.
 
-    for (unsigned k = 0; k < iterations; ++k) {
+    constexpr int TileRows = 32;
 
-      // 1. appearance of new water
-      for (auto& water : waterMap) {
-        water += rainAmount;
+    std::size_t computeTileCount(int rowMin, int rowMax) {
+      if (rowMin >= rowMax) {
+        return 0;
       }
 
-      // 2. water erosion of the terrain
-      for (auto pos : waterMap.getPositionRange()) {
-        double material = solubility * waterMap(pos);
-        m_data(pos) -= material;
-        materialMap(pos) += material;
+      return static_cast<std::size_t>((rowMax - rowMin + TileRows - 1) / TileRows);
+    }
+
+    template<typename Function>
+    void parallelRows(priv::ParallelTeam& team, int rowMin, int rowMax, Function function) {
+      team.parallelFor(computeTileCount(rowMin, rowMax), [&](std::size_t tile) {
+        const int yMin = rowMin + static_cast<int>(tile) * TileRows;
+        const int yMax = std::min(yMin + TileRows, rowMax);
+
+        for (int y = yMin; y < yMax; ++y) {
+          function(y);
+        }
+      });
+    }
+
+    // the kernels compute with values of type T while the heights are stored
+    // with values of type S. When the types differ, the first iteration reads
+    // the stored heights and the last one writes them back, so the conversion
+    // does not cost a pass of its own.
+
+    template<typename T, typename S, typename Step>
+    void iterateErosion(Array2D<S, int>& heights, unsigned iterations, Step step) {
+      if (iterations == 0) {
+        return;
       }
 
-      // 3. transportation of water
-      std::fill(waterDiff.begin(), waterDiff.end(), 0.0);
-      std::fill(materialDiff.begin(), materialDiff.end(), 0.0);
+      Array2D<T, int> next(heights.getSize(), T(0));
 
-      for (int y = 1; y < m_data.getRows() - 1; ++y) {
-        for (int x = 1; x < m_data.getCols() - 1; ++x) {
-          double diffTotal = 0.0;
-          double altitudeTotal = 0.0;
-          double altitude = m_data({ x, y }) + waterMap({ x, y });
-          int n = 0;
+      if constexpr (std::is_same_v<S, T>) {
+        for (unsigned k = 0; k < iterations; ++k) {
+          step(heights, next);
+          std::swap(heights, next);
+        }
+      } else {
+        Array2D<T, int> current(heights.getSize(), T(0));
+        step(heights, current);
 
-          for (int i = -1; i <= 1; ++i) {
-            for (int j = -1; j <= 1; ++j) {
-              double altitudeLocal = m_data({ x+i, y+j }) + waterMap({ x+i, y+j });
-              double diff = altitude - altitudeLocal;
-              d[1+i][1+j] = diff;
-
-              if (diff > 0.0) {
-                diffTotal += diff;
-                altitudeTotal += altitudeLocal;
-                n++;
+        for (unsigned k = 1; k + 1 < iterations; ++k) {
+          step(current, next);
+          std::swap(current, next);
+        }
+
+        if (iterations > 1) {
+          step(current, heights);
+        } else {
+          std::transform(current.begin(), current.end(), heights.begin(), [](T value) { return static_cast<S>(value); });
+        }
+      }
+    }
+
+    template<typename T, typename S>
+    void computeThermalErosion(Array2D<S, int>& heights, unsigned iterations, T talus, T fraction) {
+      const int cols = heights.getCols();
+      const int rows = heights.getRows();
+
+      // the coefficients of the borders stay null as they do not send any material
+      Array2D<T, int> coefficients(heights.getSize(), T(0));
+      priv::ParallelTeam team(computeTileCount(0, rows));
+
+      iterateErosion<T>(heights, iterations, [&](const auto& in, auto& out) {
+        using In = std::decay_t<decltype(*in.begin())>;
+        using Out = std::decay_t<decltype(*out.begin())>;
+
+        // compute the material that leaves each cell, per unit of difference
+        parallelRows(team, 1, rows - 1, [&](int y) {
+          const In *lines[3] = { &in({ 0, y - 1 }), &in({ 0, y }), &in({ 0, y + 1 }) };
+          T *coefficientLine = &coefficients({ 0, y });
+
+          for (int x = 1; x < cols - 1; ++x) {
+            const T altitude = static_cast<T>(lines[1][x]);
+            T diffTotal = T(0);
+            T diffMax = T(0);
+
+            for (auto line : lines) {
+              for (int i = x - 1; i <= x + 1; ++i) {
+                T diff = altitude - static_cast<T>(line[i]);
+
+                if (diff > talus) {
+                  diffTotal += diff;
+
+                  if (diff > diffMax) {
+                    diffMax = diff;
+                  }
+                }
               }
             }
+
+            coefficientLine[x] = (diffTotal > T(0)) ? fraction * (diffMax - talus) / diffTotal : T(0);
           }
+        });
+
+        // gather the material that comes from the neighbors, the borders never change
+        parallelRows(team, 0, rows, [&](int y) {
+          const In *line = &in({ 0, y });
+          Out *resultLine = &out({ 0, y });
 
-          if (n == 0) {
-            continue;
+          if (y == 0 || y == rows - 1) {
+            std::transform(line, line + cols, resultLine, [](In value) { return static_cast<Out>(value); });
+            return;
           }
 
-          double altitudeAverage = altitudeTotal / n;
-          double diffAltitude = std::min(waterMap({ x, y }), altitude - altitudeAverage);
+          resultLine[0] = static_cast<Out>(line[0]);
+          resultLine[cols - 1] = static_cast<Out>(line[cols - 1]);
 
-          for (int i = -1; i <= 1; ++i) {
-            for (int j = -1; j <= 1; ++j) {
-              double diff = d[1+i][1+j];
+          const In *lines[3] = { &in({ 0, y - 1 }), line, &in({ 0, y + 1 }) };
+          const T *coefficientLines[3] = { &coefficients({ 0, y - 1 }), &coefficients({ 0, y }), &coefficients({ 0, y + 1 }) };
 
-              if (diff > 0.0) {
-                double diffWater = diffAltitude * (diff / diffTotal);
-                waterDiff({ x + i, y + j }) += diffWater;
-                waterDiff({ x, y }) -= diffWater;
+          for (int x = 1; x < cols - 1; ++x) {
+            const T altitude = static_cast<T>(lines[1][x]);
+            T material = T(0);
 
-                double diffMaterial = materialMap({ x, y }) * (diffWater / waterMap({ x, y }));
-                materialDiff({ x + i, y + j }) += diffMaterial;
-                materialDiff({ x, y }) -= diffMaterial;
+            for (int j = 0; j < 3; ++j) {
+              for (int i = x - 1; i <= x + 1; ++i) {
+                T diff = static_cast<T>(lines[j][i]) - altitude;
+
+                if (diff > talus) {
+                  material += coefficientLines[j][i] * diff;
+                }
               }
             }
+
+            resultLine[x] = static_cast<Out>(altitude + material);
           }
-        }
-      }
+        });
+      });
+    }
 
-      for (auto pos : waterMap.getPositionRange()) {
-        waterMap(pos) += waterDiff(pos);
-      }
+    template<typename T, typename S>
+    void computeHydraulicErosion(Array2D<S, int>& heights, unsigned iterations, T rainAmount, T solubility, T evaporation, T capacity) {
+      const int cols = heights.getCols();
+      const int rows = heights.getRows();
+
+      // the terrain is computed in the heights when the types are the same
+      Array2D<T, int> converted;
 
-      for (auto pos : materialMap.getPositionRange()) {
-        materialMap(pos) += materialDiff(pos);
+      if constexpr (!std::is_same_v<S, T>) {
+        converted = Array2D<T, int>(heights.getSize(), T(0));
       }
 
-      // 4. evaporation of water
-      for (auto pos : waterMap.getPositionRange()) {
-        double water = waterMap(pos) * (1 - evaporation);
+      auto terrainAt = [&](Vector2i position) -> T& {
+        if constexpr (std::is_same_v<S, T>) {
+          return heights(position);
+        } else {
+          return converted(position);
+        }
+      };
+
+      Array2D<T, int> waterMap(heights.getSize(), T(0));
+      Array2D<T, int> materialMap(heights.getSize(), T(0));
+      Array2D<T, int> altitudes(heights.getSize(), T(0));
+      Array2D<T, int> flows(heights.getSize(), T(0));
+      Array2D<T, int> outflows(heights.getSize(), T(0));
+      Array2D<T, int> nextWaterMap(heights.getSize(), T(0));
+      Array2D<T, int> nextMaterialMap(heights.getSize(), T(0));
+      priv::ParallelTeam team(computeTileCount(0, rows));
+
+      for (unsigned k = 0; k < iterations; ++k) {
+        const bool first = (k == 0);
+        const bool last = (k + 1 == iterations);
+
+        // 1. appearance of new water and 2. water erosion of the terrain
+        parallelRows(team, 0, rows, [&](int y) {
+          for (int x = 0; x < cols; ++x) {
+            T water = waterMap({ x, y }) + rainAmount;
+            waterMap({ x, y }) = water;
+
+            T material = solubility * water;
+            T& terrain = terrainAt({ x, y });
+
+            if (first) {
+              terrain = static_cast<T>(heights({ x, y }));
+            }
 
-        waterMap(pos) = water;
+            terrain -= material;
+            materialMap({ x, y }) += material;
 
-        double materialMax = capacity * water;
-        double diffMaterial = std::max(double(0), materialMap(pos) - materialMax);
-        materialMap(pos) -= diffMaterial;
-        m_data(pos) += diffMaterial;
-      }
+            altitudes({ x, y }) = terrain + water;
+          }
+        });
 
-    }
+        // 3. transportation of water, first the water that leaves each cell
+        parallelRows(team, 1, rows - 1, [&](int y) {
+          for (int x = 1; x < cols - 1; ++x) {
+            const T altitude = altitudes({ x, y });
+            T diffTotal = T(0);
+            T altitudeTotal = T(0);
+            int n = 0;
 
-  }
+            for (int j = -1; j <= 1; ++j) {
+              for (int i = -1; i <= 1; ++i) {
+                T altitudeLocal = altitudes({ x + i, y + j });
+                T diff = altitude - altitudeLocal;
+
+                if (diff > T(0)) {
+                  diffTotal += diff;
+                  altitudeTotal += altitudeLocal;
+                  n++;
+                }
+              }
+            }
 
-  void Heightmap::fastErosion(unsigned iterations, double talus, double fraction) {
-    Array2D<double, int> material(m_data.getSize());
+            if (n == 0) {
+              flows({ x, y }) = outflows({ x, y }) = T(0);
+              continue;
+            }
+
+            T altitudeAverage = altitudeTotal / n;
+            T diffAltitude = std::min(waterMap({ x, y }), altitude - altitudeAverage);
+            flows({ x, y }) = diffAltitude / diffTotal;
+            outflows({ x, y }) = diffAltitude;
+          }
+        });
+
+        // then the water that comes from the neighbors, and 4. evaporation of water
+        parallelRows(team, 0, rows, [&](int y) {
+          for (int x = 0; x < cols; ++x) {
+            const T altitude = altitudes({ x, y });
+            T water = waterMap({ x, y });
+            T material = materialMap({ x, y });
+
+            if (outflows({ x, y }) > T(0)) {
+              water -= outflows({ x, y });
+              material -= materialMap({ x, y }) * (outflows({ x, y }) / waterMap({ x, y }));
+            }
 
-    for (unsigned k = 0; k < iterations; ++k) {
+            for (int j = std::max(y - 1, 1); j <= std::min(y + 1, rows - 2); ++j) {
+              for (int i = std::max(x - 1, 1); i <= std::min(x + 1, cols - 2); ++i) {
+                T diff = altitudes({ i, j }) - altitude;
 
-      // initialize material map
-      std::fill(material.begin(), material.end(), 0.0);
+                if (diff > T(0)) {
+                  T diffWater = flows({ i, j }) * diff;
+                  water += diffWater;
+                  material += materialMap({ i, j }) * (diffWater / waterMap({ i, j }));
+                }
+              }
+            }
 
-      // compute material map
-      for (auto position : m_data.getPositionRange()) {
-        double altitudeDifferenceMax = 0.0;
-        Vector2i positionMax = position;
+            water *= (1 - evaporation);
 
-        const double altitude = m_data(position);
+            T materialMax = capacity * water;
+            T diffMaterial = std::max(T(0), material - materialMax);
+            material -= diffMaterial;
 
-        for (auto positionThere : m_data.get8NeighborsRange(position)) {
-          double altitudeThere = m_data(positionThere);
+            T& terrain = terrainAt({ x, y });
+            terrain += diffMaterial;
 
-          double altitudeDifference = altitude - altitudeThere;
-          if (altitudeDifference > altitudeDifferenceMax) {
-            altitudeDifferenceMax = altitudeDifference;
-            positionMax = positionThere;
+            if constexpr (!std::is_same_v<S, T>) {
+              if (last) {
+                heights({ x, y }) = static_cast<S>(terrain);
+              }
+            }
+
+            nextWaterMap({ x, y }) = water;
+            nextMaterialMap({ x, y }) = material;
           }
-        }
+        });
 
-        if (0 < altitudeDifferenceMax && altitudeDifferenceMax <= talus) {
-          material(position) -= fraction * altitudeDifferenceMax;
-          material(positionMax) += fraction * altitudeDifferenceMax;
-        }
+        std::swap(waterMap, nextWaterMap);
+        std::swap(materialMap, nextMaterialMap);
       }
+    }
 
-      // add material map to the map
-      for (auto position : m_data.getPositionRange()) {
-        m_data(position) += material(position);
-      }
+    constexpr uint8_t NoDirection = 4;
+
+    template<typename T, typename S>
+    void computeFastErosion(Array2D<S, int>& heights, unsigned iterations, T talus, T fraction) {
+      const int cols = heights.getCols();
+      const int rows = heights.getRows();
+
+      Array2D<T, int> amounts(heights.getSize(), T(0));
+      Array2D<uint8_t, int> directions(heights.getSize(), NoDirection);
+      priv::ParallelTeam team(computeTileCount(0, rows));
+
+      iterateErosion<T>(heights, iterations, [&](const auto& in, auto& out) {
+        using In = std::decay_t<decltype(*in.begin())>;
+        using Out = std::decay_t<decltype(*out.begin())>;
+
+        // find where the material of each cell goes, in the same order as the serial version
+        parallelRows(team, 0, rows, [&](int y) {
+          const int jMin = std::max(y - 1, 0);
+          const int jMax = std::min(y + 1, rows - 1);
+          const In *line = &in({ 0, y });
+          T *amountLine = &amounts({ 0, y });
+          uint8_t *directionLine = &directions({ 0, y });
+
+          for (int x = 0; x < cols; ++x) {
+            const T altitude = static_cast<T>(line[x]);
+            const int iMin = std::max(x - 1, 0);
+            const int iMax = std::min(x + 1, cols - 1);
+            T altitudeDifferenceMax = T(0);
+            uint8_t direction = NoDirection;
+
+            for (int j = jMin; j <= jMax; ++j) {
+              const In *neighborLine = &in({ 0, j });
+
+              for (int i = iMin; i <= iMax; ++i) {
+                T altitudeDifference = altitude - static_cast<T>(neighborLine[i]);
+
+                if (altitudeDifference > altitudeDifferenceMax) {
+                  altitudeDifferenceMax = altitudeDifference;
+                  direction = static_cast<uint8_t>((j - y + 1) * 3 + (i - x + 1));
+                }
+              }
+            }
+
+            if (T(0) < altitudeDifferenceMax && altitudeDifferenceMax <= talus) {
+              amountLine[x] = fraction * altitudeDifferenceMax;
+              directionLine[x] = direction;
+            } else {
+              amountLine[x] = T(0);
+              directionLine[x] = NoDirection;
+            }
+          }
+        });
+
+        // gather the material that comes from the neighbors
+        parallelRows(team, 0, rows, [&](int y) {
+          const int jMin = std::max(y - 1, 0);
+          const int jMax = std::min(y + 1, rows - 1);
+          const In *line = &in({ 0, y });
+          Out *resultLine = &out({ 0, y });
+
+          for (int x = 0; x < cols; ++x) {
+            const int iMin = std::max(x - 1, 0);
+            const int iMax = std::min(x + 1, cols - 1);
+            T material = -amounts({ x, y });
+
+            for (int j = jMin; j <= jMax; ++j) {
+              const T *amountLine = &amounts({ 0, j });
+              const uint8_t *directionLine = &directions({ 0, j });
+
+              for (int i = iMin; i <= iMax; ++i) {
+                // the direction from the neighbor to this cell
+                if (directionLine[i] == (y - j + 1) * 3 + (x - i + 1)) {
+                  material += amountLine[i];
+                }
+              }
+            }
+
+            resultLine[x] = static_cast<Out>(static_cast<T>(line[x]) + material);
+          }
+        });
+      });
     }
+
+  } // anonymous namespace
+
+  void Heightmap::parallelThermalErosion(unsigned iterations, double talus, double fraction, Precision precision) {
+    modify([&](auto& heights) {
+      if (precision == Precision::Double) {
+        computeThermalErosion(heights, iterations, talus, fraction);
+      } else {
+        computeThermalErosion(heights, iterations, static_cast<float>(talus), static_cast<float>(fraction));
+      }
+    });
+  }
+
+  void Heightmap::parallelHydraulicErosion(unsigned iterations, double rainAmount, double solubility, double evaporation, double capacity, Precision precision) {
+    modify([&](auto& heights) {
+      if (precision == Precision::Double) {
+        computeHydraulicErosion(heights, iterations, rainAmount, solubility, evaporation, capacity);
+      } else {
+        computeHydraulicErosion(heights, iterations, static_cast<float>(rainAmount), static_cast<float>(solubility), static_cast<float>(evaporation), static_cast<float>(capacity));
+      }
+    });
+  }
+
+  void Heightmap::parallelFastErosion(unsigned iterations, double talus, double fraction, Precision precision) {
+    modify([&](auto& heights) {
+      if (precision == Precision::Double) {
+        computeFastErosion(heights, iterations, talus, fraction);
+      } else {
+        computeFastErosion(heights, iterations, static_cast<float>(talus), static_cast<float>(fraction));
+      }
+    });
   }
 
   double Heightmap::getErosionScore() const {
@@ -358,7 +1023,7 @@ inline namespace v1 {
     double totalSquare = 0.0;
     int n = 0;
 
-    for (auto position : m_data.getPositionRange()) {
+    for (auto position : Index2D<int>(getSize()).getPositionRange()) {
       double value = getSlope(position);
       total += value;
       totalSquare += gf::square(value);
@@ -380,30 +1045,50 @@ inline namespace v1 {
       area.min.y = 0;
     }
 
-    if (area.max.x > m_data.getCols()) {
-      area.max.x = m_data.getCols();
+    Vector2i size = getSize();
+
+    if (area.max.x > size.width) {
+      area.max.x = size.width;
     }
 
-    if (area.max.y > m_data.getRows()) {
-      area.max.y = m_data.getRows();
+    if (area.max.y > size.height) {
+      area.max.y = size.height;
     }
 
-    Heightmap out(area.getSize());
+    Heightmap out(area.getSize(), m_storage);
 
-    for (int j = area.min.y; j < area.max.y; ++j) {
-      for (int i = area.min.x; i < area.max.x; ++i) {
-        out.m_data({ i - area.min.x, j - area.min.y }) = m_data({ i, j });
+    auto copy = [&area](const auto& from, auto& to) {
+      for (int j = area.min.y; j < area.max.y; ++j) {
+        for (int i = area.min.x; i < area.max.x; ++i) {
+          to({ i - area.min.x, j - area.min.y }) = from({ i, j });
+        }
       }
+    };
+
+    switch (m_storage) {
+      case Storage::Double:
+        copy(m_data, out.m_data);
+        break;
+
+      case Storage::Float:
+        copy(m_floatData, out.m_floatData);
+        break;
+
+      case Storage::Quantized:
+        copy(m_quantizedData, out.m_quantizedData);
+        out.m_quantizedMin = m_quantizedMin;
+        out.m_quantizedStep = m_quantizedStep;
+        break;
     }
 
     return out;
   }
 
   Image Heightmap::copyToGrayscaleImage() const {
-    Image image(m_data.getSize());
+    Image image(getSize());
 
-    for (auto pos : m_data.getPositionRange()) {
-      uint8_t value = static_cast<uint8_t>(m_data(pos) * 255);
+    for (auto pos : Index2D<int>(getSize()).getPositionRange()) {
+      uint8_t value = static_cast<uint8_t>(getValue(pos) * 255);
       image.setPixel(pos, { value, value, value, 0xFF });
     }
 
@@ -423,10 +1108,11 @@ inline namespace v1 {
   } // anonymous namespace
 
   Image Heightmap::copyToColoredImage(const ColorRampD& ramp, double waterLevel, Render render) const {
-    Image image(m_data.getSize());
+    const Index2D<int> index(getSize());
+    Image image(index.getSize());
 
-    for (auto pos : m_data.getPositionRange()) {
-      double value = valueWithWaterLevel(m_data(pos), waterLevel);
+    for (auto pos : index.getPositionRange()) {
+      double value = valueWithWaterLevel(getValue(pos), waterLevel);
       Color4d color = ramp.computeColor(value);
       image.setPixel(pos, ColorD::toRgba32(color));
     }
@@ -434,8 +1120,8 @@ inline namespace v1 {
     if (render == Render::Shaded) {
       static constexpr Vector3d Light = { -1, -1, 0 };
 
-      for (auto pos : m_data.getPositionRange()) {
-        if (m_data(pos) < waterLevel) {
+      for (auto pos : index.getPositionRange()) {
+        if (getValue(pos) < waterLevel) {
           continue;
         }
 
@@ -446,11 +1132,11 @@ inline namespace v1 {
         Vector3d normal(0, 0, 0);
         unsigned count = 0;
 
-        Vector3d p{x, y, m_data(pos)};
+        Vector3d p{x, y, getValue(pos)};
 
         if (pos.col > 0 && pos.row > 0) {
-          Vector3d pn{x    , y - 1, m_data({ pos.col    , pos.row - 1 })};
-          Vector3d pw{x - 1, y    , m_data({ pos.col - 1, pos.row     })};
+          Vector3d pn{x    , y - 1, getValue({ pos.col    , pos.row - 1 })};
+          Vector3d pw{x - 1, y    , getValue({ pos.col - 1, pos.row     })};
 
           Vector3d v3 = cross(p - pw, p - pn);
           assert(v3.z > 0);
@@ -459,9 +1145,9 @@ inline namespace v1 {
           count += 1;
         }
 
-        if (pos.col > 0 && pos.row < m_data.getRows() - 1) {
-          Vector3d pw{x - 1, y    , m_data({ pos.col - 1, pos.row     })};
-          Vector3d ps{x    , y + 1, m_data({ pos.col    , pos.row + 1 })};
+        if (pos.col > 0 && pos.row < index.getRows() - 1) {
+          Vector3d pw{x - 1, y    , getValue({ pos.col - 1, pos.row     })};
+          Vector3d ps{x    , y + 1, getValue({ pos.col    , pos.row + 1 })};
 
           Vector3d v3 = cross(p - ps, p - pw);
           assert(v3.z > 0);
@@ -470,9 +1156,9 @@ inline namespace v1 {
           count += 1;
         }
 
-        if (pos.col < m_data.getCols() - 1 && pos.row > 0) {
-          Vector3d pe{x + 1, y    , m_data({ pos.col + 1, pos.row     })};
-          Vector3d pn{x    , y - 1, m_data({ pos.col    , pos.row - 1 })};
+        if (pos.col < index.getCols() - 1 && pos.row > 0) {
+          Vector3d pe{x + 1, y    , getValue({ pos.col + 1, pos.row     })};
+          Vector3d pn{x    , y - 1, getValue({ pos.col    , pos.row - 1 })};
 
           Vector3d v3 = cross(p - pn, p - pe);
           assert(v3.z > 0);
@@ -481,9 +1167,9 @@ inline namespace v1 {
           count += 1;
         }
 
-        if (pos.col < m_data.getCols() - 1 && pos.row < m_data.getRows() - 1) {
-          Vector3d pe{x + 1, y    , m_data({ pos.col + 1, pos.row     })};
-          Vector3d ps{x    , y + 1, m_data({ pos.col    , pos.row + 1 })};
+        if (pos.col < index.getCols() - 1 && pos.row < index.getRows() - 1) {
+          Vector3d pe{x + 1, y    , getValue({ pos.col + 1, pos.row     })};
+          Vector3d ps{x    , y + 1, getValue({ pos.col    , pos.row + 1 })};
 
           Vector3d v3 = cross(p - pe, p - ps);
           assert(v3.z > 0);
@@ -0,0 +1,247 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/HeightmapChunkGenerator.h>
+
+#include <cassert>
+#include <algorithm>
+
+#include <gf/Rect.h>
+#include <gf/VectorOps.h>
+
+#include <gfpriv/Parallel.h>
+
+namespace gf {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+inline namespace v1 {
+#endif
+
+  HeightmapChunkGenerator::HeightmapChunkGenerator(Noise2D& noise, Vector2i chunkSize, double scale, std::size_t capacity, Process process, int apron, std::size_t threadCount)
+  : m_noise(noise)
+  , m_chunkSize(chunkSize)
+  , m_scale(scale)
+  , m_capacity(std::max(capacity, std::size_t(1)))
+  , m_process(std::move(process))
+  , m_apron(std::max(apron, 0))
+  , m_stopped(false)
+  {
+    if (threadCount == 0) {
+      threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (std::size_t i = 0; i < threadCount; ++i) {
+      m_threads.emplace_back([this]() { run(); });
+    }
+  }
+
+  HeightmapChunkGenerator::~HeightmapChunkGenerator() {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopped = true;
+      m_requests.clear();
+    }
+
+    m_requestCondition.notify_all();
+
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  void HeightmapChunkGenerator::request(Vector2i chunk) {
+    Key key = computeKey(chunk);
+
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+
+      if (m_cache.count(key) > 0 || m_pending.count(key) > 0) {
+        return;
+      }
+
+      // a new request retries a chunk that failed
+      m_errors.erase(key);
+      m_requests.push_back(chunk);
+    }
+
+    m_requestCondition.notify_one();
+  }
+
+  std::shared_ptr<const Heightmap> HeightmapChunkGenerator::findChunk(Vector2i chunk) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return lookup(computeKey(chunk));
+  }
+
+  std::shared_ptr<const Heightmap> HeightmapChunkGenerator::getChunk(Vector2i chunk) {
+    Key key = computeKey(chunk);
+
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      for (;;) {
+        if (auto heightmap = lookup(key)) {
+          return heightmap;
+        }
+
+        if (auto it = m_errors.find(key); it != m_errors.end()) {
+          // the worker failed, the error is reported once
+          std::exception_ptr error = it->second;
+          m_errors.erase(it);
+          std::rethrow_exception(error);
+        }
+
+        if (m_pending.count(key) == 0) {
+          break;
+        }
+
+        // a worker is generating the chunk
+        m_chunkCondition.wait(lock);
+      }
+
+      m_pending.insert(key);
+    }
+
+    std::shared_ptr<const Heightmap> heightmap;
+
+    try {
+      heightmap = std::make_shared<const Heightmap>(generate(chunk));
+    } catch (...) {
+      abandon(key, nullptr);
+      throw;
+    }
+
+    store(key, heightmap);
+    return heightmap;
+  }
+
+  std::size_t HeightmapChunkGenerator::getCachedChunkCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_cache.size();
+  }
+
+  HeightmapChunkGenerator::Key HeightmapChunkGenerator::computeKey(Vector2i chunk) {
+    return static_cast<Key>(static_cast<uint32_t>(chunk.x)) << 32 | static_cast<uint32_t>(chunk.y);
+  }
+
+  Heightmap HeightmapChunkGenerator::generate(Vector2i chunk) const {
+    // the first sample of the chunk, including the apron, in world
+    // coordinates, computed with doubles as it may not fit in an int
+    Vector2d first = gf::vec(static_cast<double>(chunk.x) * m_chunkSize.width, static_cast<double>(chunk.y) * m_chunkSize.height) - static_cast<double>(m_apron);
+
+    Heightmap heightmap(m_chunkSize + 2 * m_apron);
+    heightmap.addNoise(m_noise, first * m_scale, gf::vec(m_scale, m_scale));
+
+    if (m_process) {
+      m_process(heightmap);
+    }
+
+    if (m_apron > 0) {
+      return heightmap.subMap(RectI::fromPositionSize({ m_apron, m_apron }, m_chunkSize));
+    }
+
+    return heightmap;
+  }
+
+  // must be called with the mutex locked
+  std::shared_ptr<const Heightmap> HeightmapChunkGenerator::lookup(Key key) {
+    auto it = m_cache.find(key);
+
+    if (it == m_cache.end()) {
+      return nullptr;
+    }
+
+    m_usage.splice(m_usage.begin(), m_usage, it->second.usage);
+    return it->second.heightmap;
+  }
+
+  void HeightmapChunkGenerator::store(Key key, std::shared_ptr<const Heightmap> heightmap) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pending.erase(key);
+
+      m_usage.push_front(key);
+      m_cache.emplace(key, Entry{ std::move(heightmap), m_usage.begin() });
+
+      while (m_cache.size() > m_capacity) {
+        m_cache.erase(m_usage.back());
+        m_usage.pop_back();
+      }
+    }
+
+    m_chunkCondition.notify_all();
+  }
+
+  // the generation failed, the waiters get the error if there is one
+  void HeightmapChunkGenerator::abandon(Key key, std::exception_ptr error) {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_pending.erase(key);
+
+      if (error) {
+        m_errors[key] = std::move(error);
+      }
+    }
+
+    m_chunkCondition.notify_all();
+  }
+
+  void HeightmapChunkGenerator::run() {
+    // the computations on a chunk stay on this thread
+    priv::serialOnly = true;
+
+    for (;;) {
+      Vector2i chunk;
+      Key key;
+
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_requestCondition.wait(lock, [this]() { return m_stopped || !m_requests.empty(); });
+
+        if (m_stopped) {
+          return;
+        }
+
+        chunk = m_requests.front();
+        m_requests.pop_front();
+        key = computeKey(chunk);
+
+        if (m_cache.count(key) > 0 || m_pending.count(key) > 0) {
+          continue;
+        }
+
+        m_pending.insert(key);
+      }
+
+      std::shared_ptr<const Heightmap> heightmap;
+
+      try {
+        heightmap = std::make_shared<const Heightmap>(generate(chunk));
+      } catch (...) {
+        abandon(key, std::current_exception());
+        continue;
+      }
+
+      store(key, std::move(heightmap));
+    }
+  }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+}
+#endif
+}
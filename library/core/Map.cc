@@ -20,69 +20,180 @@
  */
 #include <gf/Map.h>
 
-#include <iostream>
+#include <algorithm>
+#include <cassert>
+#include <functional>
 #include <limits>
+#include <mutex>
+#include <queue>
+#include <tuple>
 
 #include <gf/Geometry.h>
+#include <gf/Math.h>
 #include <gf/VectorOps.h>
 
-#include <boost/heap/binomial_heap.hpp>
+#include <gfpriv/Parallel.h>
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
 #endif
 
-  SquareMap::SquareMap(Vector2i size)
-  : m_cells(size, None)
+  namespace {
+
+    std::size_t toPlane(CellProperty property) {
+      switch (property) {
+        case CellProperty::Transparent:
+          return 0;
+        case CellProperty::Walkable:
+          return 1;
+        case CellProperty::Visible:
+          return 2;
+        case CellProperty::Explored:
+          return 3;
+      }
+
+      assert(false);
+      return 0;
+    }
+
+    constexpr CellProperty AllProperties[] = { CellProperty::Transparent, CellProperty::Walkable, CellProperty::Visible, CellProperty::Explored };
+
+  } // anonymous namespace
+
+  SquareMap::SquareMap(Vector2i size, SquareMapLayout layout)
+  : m_index(size)
+  , m_layout(layout)
+  , m_wordsPerRow(0)
+  , m_visitedCells(0)
   {
+    switch (m_layout) {
+      case SquareMapLayout::Cells:
+        m_cells = Array2D<Flags<CellProperty>, int>(size, None);
+        break;
+
+      case SquareMapLayout::BitPlanes:
+        m_wordsPerRow = (size.width + WordSize - 1) / WordSize;
 
+        for (auto& plane : m_planes) {
+          plane.resize(static_cast<std::size_t>(m_wordsPerRow) * static_cast<std::size_t>(size.height), 0);
+        }
+        break;
+    }
   }
 
   Vector2i SquareMap::getSize() const {
-    return m_cells.getSize();
+    return m_index.getSize();
   }
 
   PositionRange<int> SquareMap::getRange() const {
-    return m_cells.getPositionRange();
+    return m_index.getPositionRange();
+  }
+
+  SquareMapLayout SquareMap::getLayout() const {
+    return m_layout;
   }
 
   void SquareMap::setCell(Vector2i pos, Flags<CellProperty> flags) {
-    m_cells(pos) = flags;
+    if (isWalkable(pos) != flags.test(CellProperty::Walkable)) {
+      m_hierarchy.invalidate(pos);
+    }
+
+    if (m_layout == SquareMapLayout::Cells) {
+      m_cells(pos) = flags;
+      return;
+    }
+
+    for (auto property : AllProperties) {
+      changeCell(pos, property, flags.test(property));
+    }
   }
 
   void SquareMap::reset(Flags<CellProperty> flags) {
-    for (auto& cell : m_cells) {
-      cell = flags;
+    if (m_layout == SquareMapLayout::Cells) {
+      for (auto& cell : m_cells) {
+        cell = flags;
+      }
+    } else {
+      for (auto property : AllProperties) {
+        fillPlane(property, flags.test(property));
+      }
     }
+
+    m_hierarchy.invalidateAll();
   }
 
   void SquareMap::setTransparent(Vector2i pos, bool transparent) {
-    if (transparent) {
-      m_cells(pos).set(CellProperty::Transparent);
-    } else {
-      m_cells(pos).reset(CellProperty::Transparent);
-    }
+    changeCell(pos, CellProperty::Transparent, transparent);
   }
 
   bool SquareMap::isTransparent(Vector2i pos) const {
-    return m_cells(pos).test(CellProperty::Transparent);
+    return testCell(pos, CellProperty::Transparent);
   }
 
   void SquareMap::setWalkable(Vector2i pos, bool walkable) {
-    if (walkable) {
-      m_cells(pos).set(CellProperty::Walkable);
-    } else {
-      m_cells(pos).reset(CellProperty::Walkable);
+    if (isWalkable(pos) != walkable) {
+      m_hierarchy.invalidate(pos);
     }
+
+    changeCell(pos, CellProperty::Walkable, walkable);
   }
 
   bool SquareMap::isWalkable(Vector2i pos) const {
-    return m_cells(pos).test(CellProperty::Walkable);
+    return testCell(pos, CellProperty::Walkable);
   }
 
   void SquareMap::setEmpty(Vector2i pos) {
-    m_cells(pos) = EmptyCell;
+    setCell(pos, EmptyCell);
+  }
+
+  bool SquareMap::testCell(Vector2i pos, CellProperty property) const {
+    if (m_layout == SquareMapLayout::Cells) {
+      return m_cells(pos).test(property);
+    }
+
+    assert(m_index.isValid(pos));
+    uint64_t word = m_planes[toPlane(property)][pos.y * m_wordsPerRow + pos.x / WordSize];
+    return ((word >> (pos.x % WordSize)) & 1) != 0;
+  }
+
+  void SquareMap::changeCell(Vector2i pos, CellProperty property, bool value) {
+    if (m_layout == SquareMapLayout::Cells) {
+      if (value) {
+        m_cells(pos).set(property);
+      } else {
+        m_cells(pos).reset(property);
+      }
+
+      return;
+    }
+
+    assert(m_index.isValid(pos));
+    uint64_t& word = m_planes[toPlane(property)][pos.y * m_wordsPerRow + pos.x / WordSize];
+    uint64_t mask = uint64_t(1) << (pos.x % WordSize);
+
+    if (value) {
+      word |= mask;
+    } else {
+      word &= ~mask;
+    }
+  }
+
+  void SquareMap::fillPlane(CellProperty property, bool value) {
+    if (m_layout == SquareMapLayout::Cells) {
+      for (auto& cell : m_cells) {
+        if (value) {
+          cell.set(property);
+        } else {
+          cell.reset(property);
+        }
+      }
+
+      return;
+    }
+
+    auto& plane = m_planes[toPlane(property)];
+    std::fill(plane.begin(), plane.end(), value ? ~uint64_t(0) : uint64_t(0));
   }
 
   /*
@@ -90,31 +201,164 @@ inline namespace v1 {
    */
 
   void SquareMap::clearFieldOfVision() {
-    for (auto& cell : m_cells) {
-      cell.reset(CellProperty::Visible);
-    }
+    fillPlane(CellProperty::Visible, false);
   }
 
   void SquareMap::clearExplored() {
-    for (auto& cell : m_cells) {
-      cell.reset(CellProperty::Explored);
-    }
+    fillPlane(CellProperty::Explored, false);
   }
 
   namespace {
 
-    void postProcessMap(Array2D<Flags<CellProperty>, int>& cells, Vector2i q0, Vector2i q1, Vector2i step) {
+    // a field of vision is computed on a target that gives the transparency of
+    // the cells and keeps the visible cells, the algorithms report each cell
+    // they examine with visit()
+
+    class CellsFovTarget {
+    public:
+      CellsFovTarget(Array2D<Flags<CellProperty>, int>& cells, Flags<CellProperty> modification, std::size_t& visited)
+      : m_cells(cells)
+      , m_modification(modification)
+      , m_visited(visited)
+      {
+      }
+
+      void visit() {
+        ++m_visited;
+      }
+
+      bool isValid(Vector2i position) const {
+        return m_cells.isValid(position);
+      }
+
+      bool isTransparent(Vector2i position) const {
+        return m_cells(position).test(CellProperty::Transparent);
+      }
+
+      bool isVisible(Vector2i position) const {
+        return m_cells(position).test(CellProperty::Visible);
+      }
+
+      void setVisible(Vector2i position) {
+        m_cells(position) |= m_modification;
+      }
+
+      Vector2i getSize() const {
+        return m_cells.getSize();
+      }
+
+      RangeI getColRange() const {
+        return m_cells.getColRange();
+      }
+
+      RangeI getRowRange() const {
+        return m_cells.getRowRange();
+      }
+
+    private:
+      Array2D<Flags<CellProperty>, int>& m_cells;
+      Flags<CellProperty> m_modification;
+      std::size_t& m_visited;
+    };
+
+    // a bit plane of the map, for the gf::SquareMapLayout::BitPlanes layout
+
+    template<typename Word>
+    class PlaneView {
+    public:
+      static constexpr int WordSize = 64;
+
+      PlaneView(Word *words, int wordsPerRow)
+      : m_words(words)
+      , m_wordsPerRow(wordsPerRow)
+      {
+      }
+
+      bool test(Vector2i position) const {
+        return ((m_words[position.y * m_wordsPerRow + position.x / WordSize] >> (position.x % WordSize)) & 1) != 0;
+      }
+
+      void set(Vector2i position) {
+        m_words[position.y * m_wordsPerRow + position.x / WordSize] |= uint64_t(1) << (position.x % WordSize);
+      }
+
+    private:
+      Word *m_words;
+      int m_wordsPerRow;
+    };
+
+    class PlanesFovTarget {
+    public:
+      PlanesFovTarget(Vector2i size, std::vector<uint64_t> *planes, int wordsPerRow, bool exploring, std::size_t& visited)
+      : m_index(size)
+      , m_transparent(planes[toPlane(CellProperty::Transparent)].data(), wordsPerRow)
+      , m_visible(planes[toPlane(CellProperty::Visible)].data(), wordsPerRow)
+      , m_explored(planes[toPlane(CellProperty::Explored)].data(), wordsPerRow)
+      , m_exploring(exploring)
+      , m_visited(visited)
+      {
+      }
+
+      void visit() {
+        ++m_visited;
+      }
+
+      bool isValid(Vector2i position) const {
+        return m_index.isValid(position);
+      }
+
+      bool isTransparent(Vector2i position) const {
+        return m_transparent.test(position);
+      }
+
+      bool isVisible(Vector2i position) const {
+        return m_visible.test(position);
+      }
+
+      void setVisible(Vector2i position) {
+        m_visible.set(position);
+
+        if (m_exploring) {
+          m_explored.set(position);
+        }
+      }
+
+      Vector2i getSize() const {
+        return m_index.getSize();
+      }
+
+      RangeI getColRange() const {
+        return m_index.getColRange();
+      }
+
+      RangeI getRowRange() const {
+        return m_index.getRowRange();
+      }
+
+    private:
+      Index2D<int> m_index;
+      PlaneView<const uint64_t> m_transparent;
+      PlaneView<uint64_t> m_visible;
+      PlaneView<uint64_t> m_explored;
+      bool m_exploring;
+      std::size_t& m_visited;
+    };
+
+    template<typename Target>
+    void postProcessMap(Target& target, Vector2i q0, Vector2i q1, Vector2i step) {
       int xLo, xHi, yLo, yHi;
       std::tie(xLo, xHi) = std::minmax(q0.x, q1.x);
       std::tie(yLo, yHi) = std::minmax(q0.y, q1.y);
 
       for (int y = yLo; y <= yHi; ++y) {
         for (int x = xLo; x <= xHi; ++x) {
-          if (!cells.isValid({ x, y })) {
+          if (!target.isValid({ x, y })) {
             continue;
           }
 
-          if (!cells({ x, y }).test(CellProperty::Visible) || !cells({ x, y }).test(CellProperty::Transparent)) {
+          target.visit();
+
+          if (!target.isVisible({ x, y }) || !target.isTransparent({ x, y })) {
             continue;
           }
 
@@ -122,39 +366,40 @@ inline namespace v1 {
           int y2 = y + step.y;
 
           if (xLo <= x2 && x2 <= xHi) {
-            gf::Vector2i target = { x2, y };
+            gf::Vector2i other = { x2, y };
 
-            if (cells.isValid(target) && !cells(target).test(CellProperty::Transparent)) {
-              cells(target).set(CellProperty::Visible);
+            if (target.isValid(other) && !target.isTransparent(other)) {
+              target.setVisible(other);
             }
           }
 
           if (yLo <= y2 && y2 <= yHi) {
-            gf::Vector2i target = { x, y2 };
+            gf::Vector2i other = { x, y2 };
 
-            if (cells.isValid(target) && !cells(target).test(CellProperty::Transparent)) {
-              cells(target).set(CellProperty::Visible);
+            if (target.isValid(other) && !target.isTransparent(other)) {
+              target.setVisible(other);
             }
           }
 
           if (xLo <= x2 && x2 <= xHi && yLo <= y2 && y2 <= yHi) {
-            gf::Vector2i target = { x2, y2 };
+            gf::Vector2i other = { x2, y2 };
 
-            if (cells.isValid(target) && !cells(target).test(CellProperty::Transparent)) {
-              cells(target).set(CellProperty::Visible);
+            if (target.isValid(other) && !target.isTransparent(other)) {
+              target.setVisible(other);
             }
           }
         }
       }
     }
 
-    void castRay(Array2D<Flags<CellProperty>, int>& cells, Vector2i p0, Vector2i p1, int maxRadius2, FieldOfVisionLimit limit, Flags<CellProperty> modification) {
+    template<typename Target>
+    void castRay(Target& target, Vector2i p0, Vector2i p1, int maxRadius2, FieldOfVisionLimit limit) {
       Bresenham bresenham(p0, p1);
       Vector2i curr;
       bool blocked = false;
 
       while (!bresenham.step(curr)) {
-        if (!cells.isValid(curr)) {
+        if (!target.isValid(curr)) {
           return;
         }
 
@@ -166,21 +411,24 @@ inline namespace v1 {
           }
         }
 
-        if (!blocked && !cells(curr).test(CellProperty::Transparent)) {
+        target.visit();
+
+        if (!blocked && !target.isTransparent(curr)) {
           blocked = true;
         } else if (blocked) {
           return; // wall
         }
 
         if (limit == FieldOfVisionLimit::Included || !blocked) {
-          cells(curr) |= modification;
+          target.setVisible(curr);
         }
       }
     }
 
-    void computeBasicFov(Array2D<Flags<CellProperty>, int>& cells, Vector2i pos, int maxRadius, FieldOfVisionLimit limit, Flags<CellProperty> modification) {
-      RangeI xRange = cells.getColRange();
-      RangeI yRange = cells.getRowRange();
+    template<typename Target>
+    void computeBasicFov(Target& target, Vector2i pos, int maxRadius, FieldOfVisionLimit limit) {
+      RangeI xRange = target.getColRange();
+      RangeI yRange = target.getRowRange();
 
       int maxRadius2 = maxRadius * maxRadius;
 
@@ -193,299 +441,1515 @@ inline namespace v1 {
         maxRadius2 = 0;
       }
 
-      cells(pos) |= modification;
+      target.setVisible(pos);
 
       for (auto x : xRange) {
-        castRay(cells, pos, { x, yRange.lo }, maxRadius2, limit, modification);
-        castRay(cells, pos, { x, yRange.hi }, maxRadius2, limit, modification);
+        castRay(target, pos, { x, yRange.lo }, maxRadius2, limit);
+        castRay(target, pos, { x, yRange.hi }, maxRadius2, limit);
       }
 
       for (auto y : yRange) {
-        castRay(cells, pos, { xRange.lo, y }, maxRadius2, limit, modification);
-        castRay(cells, pos, { xRange.hi, y }, maxRadius2, limit, modification);
+        castRay(target, pos, { xRange.lo, y }, maxRadius2, limit);
+        castRay(target, pos, { xRange.hi, y }, maxRadius2, limit);
       }
 
       if (limit == FieldOfVisionLimit::Included) {
-        postProcessMap(cells, pos, { xRange.lo, yRange.lo }, { -1, -1 });
-        postProcessMap(cells, pos, { xRange.hi, yRange.lo }, {  1, -1 });
-        postProcessMap(cells, pos, { xRange.lo, yRange.hi }, { -1,  1 });
-        postProcessMap(cells, pos, { xRange.hi, yRange.hi }, {  1,  1 });
+        postProcessMap(target, pos, { xRange.lo, yRange.lo }, { -1, -1 });
+        postProcessMap(target, pos, { xRange.hi, yRange.lo }, {  1, -1 });
+        postProcessMap(target, pos, { xRange.lo, yRange.hi }, { -1,  1 });
+        postProcessMap(target, pos, { xRange.hi, yRange.hi }, {  1,  1 });
       }
     }
 
-    void computeGenericFieldOfVision(Array2D<Flags<CellProperty>, int>& cells, Vector2i pos, int maxRadius, FieldOfVisionLimit limit, FieldOfVision algorithm, Flags<CellProperty> modification) {
-      switch (algorithm) {
-        case FieldOfVision::Basic:
-          computeBasicFov(cells, pos, maxRadius, limit, modification);
-          break;
+    template<typename Target>
+    bool isTransparentAt(const Target& target, Vector2i position) {
+      return target.isValid(position) && target.isTransparent(position);
+    }
 
-        default:
-          break;
+    template<typename Target>
+    void markVisible(Target& target, Vector2i position, FieldOfVisionLimit limit) {
+      if (!target.isValid(position)) {
+        return;
+      }
+
+      if (limit == FieldOfVisionLimit::Included || target.isTransparent(position)) {
+        target.setVisible(position);
       }
     }
 
-  } // anonymous namespace
+    // Recursive shadowcasting
+    // see http://www.roguebasin.com/index.php/FOV_using_recursive_shadowcasting
 
-  void SquareMap::computeFieldOfVision(Vector2i pos, int maxRadius, FieldOfVisionLimit limit, FieldOfVision algorithm) {
-    computeGenericFieldOfVision(m_cells, pos, maxRadius, limit, algorithm, CellProperty::Visible | CellProperty::Explored);
-  }
+    struct Octant {
+      int xx, xy, yx, yy;
+    };
 
-  void SquareMap::computeLocalFieldOfVision(Vector2i pos, int maxRadius, FieldOfVisionLimit limit, FieldOfVision algorithm) {
-    computeGenericFieldOfVision(m_cells, pos, maxRadius, limit, algorithm, CellProperty::Visible);
-  }
+    constexpr Octant ShadowcastingOctants[] = {
+      {  1,  0,  0,  1 },
+      {  0,  1,  1,  0 },
+      {  0, -1,  1,  0 },
+      { -1,  0,  0,  1 },
+      { -1,  0,  0, -1 },
+      {  0, -1, -1,  0 },
+      {  0,  1, -1,  0 },
+      {  1,  0,  0, -1 },
+    };
 
-  bool SquareMap::isInFieldOfVision(Vector2i pos) const {
-    return m_cells(pos).test(CellProperty::Visible);
-  }
+    template<typename Target>
+    void castLight(Target& target, Vector2i pos, int row, float start, float end, int radius, int maxRadius2, const Octant& octant, FieldOfVisionLimit limit) {
+      if (start < end) {
+        return;
+      }
 
-  bool SquareMap::isExplored(Vector2i pos) const {
-    return m_cells(pos).test(CellProperty::Explored);
-  }
+      float newStart = 0.0f;
 
-  /*
-   * Route
-   */
+      for (int j = row; j <= radius; ++j) {
+        int dy = -j;
+        bool blocked = false;
 
-  namespace {
+        for (int dx = -j; dx <= 0; ++dx) {
+          Vector2i current = { pos.x + dx * octant.xx + dy * octant.xy, pos.y + dx * octant.yx + dy * octant.yy };
+          float leftSlope = (dx - 0.5f) / (dy + 0.5f);
+          float rightSlope = (dx + 0.5f) / (dy - 0.5f);
 
-    // Dijkstra
+          if (start < rightSlope) {
+            continue;
+          }
 
-    struct DijkstraHeapData {
-      Vector2i position;
-      float distance;
-    };
+          if (end > leftSlope) {
+            break;
+          }
+
+          target.visit();
+
+          if (maxRadius2 == 0 || dx * dx + dy * dy <= maxRadius2) {
+            markVisible(target, current, limit);
+          }
 
-    bool operator<(const DijkstraHeapData& lhs, const DijkstraHeapData& rhs) {
-      return lhs.distance > rhs.distance;
+          bool opaque = !isTransparentAt(target, current);
+
+          if (blocked) {
+            if (opaque) {
+              newStart = rightSlope;
+            } else {
+              blocked = false;
+              start = newStart;
+            }
+          } else if (opaque && j < radius) {
+            blocked = true;
+            castLight(target, pos, j + 1, start, leftSlope, radius, maxRadius2, octant, limit);
+            newStart = rightSlope;
+          }
+        }
+
+        if (blocked) {
+          break;
+        }
+      }
     }
 
-    using DijkstraHeap = boost::heap::binomial_heap<DijkstraHeapData>;
+    template<typename Target>
+    void computeRecursiveShadowcastingFov(Target& target, Vector2i pos, int maxRadius, FieldOfVisionLimit limit) {
+      int radius = (maxRadius > 0) ? maxRadius : std::max(target.getSize().width, target.getSize().height);
+      int maxRadius2 = (maxRadius > 0) ? maxRadius * maxRadius : 0;
 
-    struct DijkstraResultData {
-      float distance;
-      Vector2i previous;
-      DijkstraHeap::handle_type handle;
-    };
+      target.setVisible(pos);
 
-    std::vector<Vector2i> computeDijkstra(const Array2D<Flags<CellProperty>, int>& cells, Vector2i origin, Vector2i target, float diagonalCost) {
-      DijkstraResultData defaultResult;
-      defaultResult.distance = std::numeric_limits<float>::infinity();
-      defaultResult.previous = { -1, -1 };
+      for (auto& octant : ShadowcastingOctants) {
+        castLight(target, pos, 1, 1.0f, 0.0f, radius, maxRadius2, octant, limit);
+      }
+    }
 
-      Array2D<DijkstraResultData, int> results(cells.getSize(), defaultResult);
+    // Symmetric shadowcasting
+    // see https://www.albertford.com/shadowcasting/
 
-      results(origin).distance = 0.0f;
+    int floorDiv(int num, int den) {
+      assert(den > 0);
+      return (num >= 0) ? num / den : -((-num + den - 1) / den);
+    }
 
-      DijkstraHeap heap;
+    struct Slope {
+      int num;
+      int den;
+    };
 
-      for (auto position : cells.getPositionRange()) {
-        const auto& cell = cells(position);
+    struct ShadowcastingRow {
+      int depth;
+      Slope start;
+      Slope end;
 
-        if (!cell.test(CellProperty::Walkable)) {
-          continue;
-        }
+      int getMinCol() const {
+        // round half up of depth * start
+        return floorDiv(2 * depth * start.num + start.den, 2 * start.den);
+      }
 
-        DijkstraHeapData data;
-        data.position = position;
-        data.distance = results(position).distance;
+      int getMaxCol() const {
+        // round half down of depth * end
+        return -floorDiv(-(2 * depth * end.num - end.den), 2 * end.den);
+      }
 
-        results(position).handle = heap.push(data);
+      bool isSymmetric(int col) const {
+        return col * start.den >= depth * start.num && col * end.den <= depth * end.num;
       }
+    };
 
-      while (!heap.empty()) {
-        DijkstraHeapData data = heap.top();
-        heap.pop();
+    Slope computeSlope(int depth, int col) {
+      return { 2 * col - 1, 2 * depth };
+    }
 
-        for (auto position : cells.get8NeighborsRange(data.position)) {
-          assert(position != data.position);
+    template<typename Target>
+    void computeSymmetricShadowcastingFov(Target& target, Vector2i pos, int maxRadius, FieldOfVisionLimit limit) {
+      int radius = (maxRadius > 0) ? maxRadius : std::max(target.getSize().width, target.getSize().height);
+      int maxRadius2 = (maxRadius > 0) ? maxRadius * maxRadius : 0;
 
-          const Flags<CellProperty>& value = cells(position);
+      target.setVisible(pos);
 
-          if (!value.test(CellProperty::Walkable)) {
-            continue;
-          }
+      // north, east, south, west
+      static constexpr Vector2i QuadrantDepths[] = { { 0, -1 }, { 1, 0 }, { 0, 1 }, { -1, 0 } };
+      static constexpr Vector2i QuadrantCols[] = { { 1, 0 }, { 0, 1 }, { 1, 0 }, { 0, 1 } };
+
+      std::vector<ShadowcastingRow> rows;
 
-          bool isDiagonal = (gf::manhattanDistance(data.position, position) == 2);
+      for (std::size_t quadrant = 0; quadrant < 4; ++quadrant) {
+        auto transform = [&](int depth, int col) {
+          return pos + depth * QuadrantDepths[quadrant] + col * QuadrantCols[quadrant];
+        };
 
-          if (isDiagonal && diagonalCost == 0) {
+        rows.push_back({ 1, { -1, 1 }, { 1, 1 } });
+
+        while (!rows.empty()) {
+          ShadowcastingRow row = rows.back();
+          rows.pop_back();
+
+          if (row.depth > radius) {
             continue;
           }
 
-          float newDistance = results(data.position).distance + (isDiagonal ? diagonalCost : 1.0f);
+          enum class Tile { None, Wall, Floor };
+          Tile previous = Tile::None;
+
+          int minCol = row.getMinCol();
+          int maxCol = row.getMaxCol();
+
+          for (int col = minCol; col <= maxCol; ++col) {
+            Vector2i current = transform(row.depth, col);
+            target.visit();
+            Tile tile = isTransparentAt(target, current) ? Tile::Floor : Tile::Wall;
+
+            if ((tile == Tile::Wall || row.isSymmetric(col)) && (maxRadius2 == 0 || row.depth * row.depth + col * col <= maxRadius2)) {
+              markVisible(target, current, limit);
+            }
+
+            if (previous == Tile::Wall && tile == Tile::Floor) {
+              row.start = computeSlope(row.depth, col);
+            }
+
+            if (previous == Tile::Floor && tile == Tile::Wall) {
+              ShadowcastingRow next = { row.depth + 1, row.start, computeSlope(row.depth, col) };
+              rows.push_back(next);
+            }
 
-          if (newDistance < results(position).distance) {
-            auto& result = results(position);
-            result.distance = newDistance;
-            result.previous = data.position;
+            previous = tile;
+          }
 
-            assert((*result.handle).position == position);
-            (*result.handle).distance = newDistance;
-            heap.increase(result.handle);
+          if (previous == Tile::Floor) {
+            rows.push_back({ row.depth + 1, row.start, row.end });
           }
         }
       }
+    }
 
-      std::vector<Vector2i> route;
-      Vector2i curr = target;
+    template<typename Target>
+    void computeGenericFieldOfVision(Target& target, Vector2i pos, int maxRadius, FieldOfVisionLimit limit, FieldOfVision algorithm) {
+      switch (algorithm) {
+        case FieldOfVision::Basic:
+          computeBasicFov(target, pos, maxRadius, limit);
+          break;
 
-      while (curr != origin) {
-        if (curr.x == -1 || curr.y == -1) {
-          return {};
-        }
-        route.push_back(curr);
-        curr = results(curr).previous;
+        case FieldOfVision::RecursiveShadowcasting:
+          computeRecursiveShadowcastingFov(target, pos, maxRadius, limit);
+          break;
+
+        case FieldOfVision::SymmetricShadowcasting:
+          computeSymmetricShadowcastingFov(target, pos, maxRadius, limit);
+          break;
+
+        default:
+          break;
       }
+    }
 
-      route.push_back(origin);
-      std::reverse(route.begin(), route.end());
+  } // anonymous namespace
 
-      assert(!route.empty());
+  void SquareMap::computeFieldOfVision(Vector2i pos, int maxRadius, FieldOfVisionLimit limit, FieldOfVision algorithm) {
+    m_visitedCells = 0;
 
-      return route;
+    if (m_layout == SquareMapLayout::Cells) {
+      CellsFovTarget target(m_cells, CellProperty::Visible | CellProperty::Explored, m_visitedCells);
+      computeGenericFieldOfVision(target, pos, maxRadius, limit, algorithm);
+    } else {
+      PlanesFovTarget target(getSize(), m_planes, m_wordsPerRow, true, m_visitedCells);
+      computeGenericFieldOfVision(target, pos, maxRadius, limit, algorithm);
     }
+  }
 
+  void SquareMap::computeLocalFieldOfVision(Vector2i pos, int maxRadius, FieldOfVisionLimit limit, FieldOfVision algorithm) {
+    m_visitedCells = 0;
 
-    // AStar
+    if (m_layout == SquareMapLayout::Cells) {
+      CellsFovTarget target(m_cells, CellProperty::Visible, m_visitedCells);
+      computeGenericFieldOfVision(target, pos, maxRadius, limit, algorithm);
+    } else {
+      PlanesFovTarget target(getSize(), m_planes, m_wordsPerRow, false, m_visitedCells);
+      computeGenericFieldOfVision(target, pos, maxRadius, limit, algorithm);
+    }
+  }
 
-    struct AStarHeapData {
-      Vector2i position;
-      float priority;
-    };
+  namespace {
 
-    bool operator<(const AStarHeapData& lhs, const AStarHeapData& rhs) {
-      return lhs.priority > rhs.priority;
-    }
+    // the visible cells of an observer are kept in words aligned with the
+    // words of the layer, so that they can be merged word by word
 
-    using AStarHeap = boost::heap::binomial_heap<AStarHeapData>;
+    class CellsView {
+    public:
+      CellsView(const Array2D<Flags<CellProperty>, int>& cells, CellProperty property)
+      : m_cells(cells)
+      , m_property(property)
+      {
+      }
 
-    enum class AStarState {
-      None,
-      Open,
-      Closed,
-    };
+      bool test(Vector2i position) const {
+        return m_cells(position).test(m_property);
+      }
 
-    struct AStarResultData {
-      float distance;
-      Vector2i previous;
-      AStarState state;
-      AStarHeap::handle_type handle;
+    private:
+      const Array2D<Flags<CellProperty>, int>& m_cells;
+      CellProperty m_property;
     };
 
-    std::vector<Vector2i> computeAStar(const Array2D<Flags<CellProperty>, int>& cells, Vector2i origin, Vector2i target, float diagonalCost) {
-      AStarResultData defaultResult;
-      defaultResult.distance = std::numeric_limits<float>::infinity();
-      defaultResult.previous = { -1, -1 };
-      defaultResult.state = AStarState::None;
+    template<typename View>
+    class LocalFovTarget {
+    public:
+      static constexpr int WordSize = 64;
+
+      LocalFovTarget(Vector2i size, View transparent, RectI area)
+      : m_index(size)
+      , m_transparent(transparent)
+      , m_area(area)
+      , m_firstWord(area.min.x / WordSize)
+      , m_wordCount((area.max.x - 1) / WordSize - m_firstWord + 1)
+      , m_bits(static_cast<std::size_t>(m_wordCount * area.getHeight()), 0)
+      {
+      }
 
-      Array2D<AStarResultData, int> results(cells.getSize(), defaultResult);
+      void visit() {
+      }
 
-      results(origin).distance = 0.0f;
-      results(origin).state = AStarState::Open;
+      bool isValid(Vector2i position) const {
+        return m_area.contains(position);
+      }
 
-      AStarHeap heap;
-      results(origin).handle = heap.push({ origin, 0.0f });
+      bool isTransparent(Vector2i position) const {
+        return m_transparent.test(position);
+      }
 
-      // see http://theory.stanford.edu/~amitp/GameProgramming/Heuristics.html#heuristics-for-grid-maps
-      auto heuristic = [diagonalCost](Vector2i p0, Vector2i p1) {
-        if (diagonalCost == 0) {
-          return 1.0f * gf::manhattanDistance(p0, p1);
-        }
+      bool isVisible(Vector2i position) const {
+        int bit = position.x - m_firstWord * WordSize;
+        return ((m_bits[toWordIndex(position.y, bit / WordSize)] >> (bit % WordSize)) & 1) != 0;
+      }
 
-        Vector2i d = gf::abs(p0 - p1);
-        return 1.0f * (d.x + d.y) + (diagonalCost - 2.0f) * std::min(d.x, d.y);
-      };
+      void setVisible(Vector2i position) {
+        int bit = position.x - m_firstWord * WordSize;
+        m_bits[toWordIndex(position.y, bit / WordSize)] |= uint64_t(1) << (bit % WordSize);
+      }
 
-      while (!heap.empty()) {
-        AStarHeapData data = heap.top();
-        heap.pop();
+      Vector2i getSize() const {
+        return m_index.getSize();
+      }
 
-        assert(results(data.position).state == AStarState::Open);
+      RangeI getColRange() const {
+        return m_index.getColRange();
+      }
 
-        if (data.position == target) {
-          break;
-        }
+      RangeI getRowRange() const {
+        return m_index.getRowRange();
+      }
 
-        results(data.position).state = AStarState::Closed;
+      const RectI& getArea() const {
+        return m_area;
+      }
 
-        for (auto position : cells.get8NeighborsRange(data.position)) {
-          assert(position != data.position);
+      int getFirstWord() const {
+        return m_firstWord;
+      }
 
-          const Flags<CellProperty>& value = cells(position);
+      int getWordCount() const {
+        return m_wordCount;
+      }
 
-          if (!value.test(CellProperty::Walkable)) {
-            continue;
-          }
+      uint64_t getWord(int y, int word) const {
+        return m_bits[toWordIndex(y, word)];
+      }
 
-          if (results(position).state == AStarState::Closed) {
-            continue;
-          }
+    private:
+      std::size_t toWordIndex(int y, int word) const {
+        assert(m_area.min.y <= y && y < m_area.max.y);
+        assert(0 <= word && word < m_wordCount);
+        return static_cast<std::size_t>((y - m_area.min.y) * m_wordCount + word);
+      }
 
-          bool isDiagonal = (gf::manhattanDistance(data.position, position) == 2);
+    private:
+      Index2D<int> m_index;
+      View m_transparent;
+      RectI m_area;
+      int m_firstWord;
+      int m_wordCount;
+      std::vector<uint64_t> m_bits;
+    };
 
-          if (isDiagonal && diagonalCost == 0) {
-            continue;
-          }
+  } // anonymous namespace
 
-          float newDistance = results(data.position).distance + (isDiagonal ? diagonalCost : 1.0f);
+  void SquareMap::computeFieldOfVisionLayers(Span<const FieldOfVisionObserver> observers, Span<VisibilityLayer> layers, FieldOfVisionLimit limit, FieldOfVision algorithm) const {
+    static_assert(LocalFovTarget<CellsView>::WordSize == VisibilityLayer::WordSize, "Words of the layers and of the observers must have the same size.");
 
-          if (newDistance < results(position).distance) {
-            auto& result = results(position);
-            result.distance = newDistance;
-            result.previous = data.position;
+    std::vector<std::mutex> mutexes(layers.getSize());
 
-            float priority = newDistance + heuristic(position, target) * 1.001f;
+    priv::parallelFor(observers.getSize(), [&](std::size_t i) {
+      const FieldOfVisionObserver& observer = observers[i];
+      assert(observer.layer < layers.getSize());
+      assert(layers[observer.layer].getSize() == getSize());
 
-            if (result.state == AStarState::Open) {
-              assert((*result.handle).position == position);
+      RectI area = RectI::fromSize(getSize());
 
-              if ((*result.handle).priority != priority) {
-                (*result.handle).priority = priority;
-                heap.update(result.handle);
-              }
-            } else {
-              assert(result.state == AStarState::None);
-              result.handle = heap.push({ position, priority });
-              result.state = AStarState::Open;
-            }
-          }
-        }
+      if (observer.maxRadius > 0) {
+        Vector2i min = gf::max(observer.position - observer.maxRadius, area.min);
+        Vector2i max = gf::min(observer.position + observer.maxRadius + 1, area.max);
+        area = RectI::fromMinMax(min, max);
       }
 
-      std::vector<Vector2i> route;
-      Vector2i curr = target;
+      auto compute = [&](auto& target) {
+        computeGenericFieldOfVision(target, observer.position, observer.maxRadius, limit, algorithm);
+
+        std::lock_guard<std::mutex> lock(mutexes[observer.layer]);
+        VisibilityLayer& layer = layers[observer.layer];
 
-      while (curr != origin) {
-        if (curr.x == -1 || curr.y == -1) {
-          return {};
+        for (int y = area.min.y; y < area.max.y; ++y) {
+          uint64_t *row = layer.m_bits.data() + y * layer.m_wordsPerRow + target.getFirstWord();
+
+          for (int word = 0; word < target.getWordCount(); ++word) {
+            row[word] |= target.getWord(y, word);
+          }
         }
 
-        route.push_back(curr);
-        curr = results(curr).previous;
+        layer.m_dirtyMin = gf::min(layer.m_dirtyMin, area.min);
+        layer.m_dirtyMax = gf::max(layer.m_dirtyMax, area.max - 1);
+      };
+
+      if (m_layout == SquareMapLayout::Cells) {
+        LocalFovTarget<CellsView> target(getSize(), CellsView(m_cells, CellProperty::Transparent), area);
+        compute(target);
+      } else {
+        LocalFovTarget<PlaneView<const uint64_t>> target(getSize(), PlaneView<const uint64_t>(m_planes[toPlane(CellProperty::Transparent)].data(), m_wordsPerRow), area);
+        compute(target);
       }
+    });
+  }
+
+  /*
+   * VisibilityLayer
+   */
 
-      route.push_back(origin);
-      std::reverse(route.begin(), route.end());
+  VisibilityLayer::VisibilityLayer()
+  : m_size(0, 0)
+  , m_wordsPerRow(0)
+  , m_dirtyMin(0, 0)
+  , m_dirtyMax(-1, -1)
+  {
+  }
 
-      assert(!route.empty());
+  VisibilityLayer::VisibilityLayer(Vector2i size)
+  : m_size(size)
+  , m_wordsPerRow((size.width + WordSize - 1) / WordSize)
+  , m_bits(static_cast<std::size_t>(m_wordsPerRow * size.height), 0)
+  , m_dirtyMin(size)
+  , m_dirtyMax(-1, -1)
+  {
+  }
 
-      return route;
-    }
+  Vector2i VisibilityLayer::getSize() const {
+    return m_size;
+  }
 
-  } // anonymous namespace
+  bool VisibilityLayer::isVisible(Vector2i position) const {
+    assert(0 <= position.x && position.x < m_size.width && 0 <= position.y && position.y < m_size.height);
+    uint64_t word = m_bits[position.y * m_wordsPerRow + position.x / WordSize];
+    return ((word >> (position.x % WordSize)) & 1) != 0;
+  }
 
+  void VisibilityLayer::setVisible(Vector2i position) {
+    assert(0 <= position.x && position.x < m_size.width && 0 <= position.y && position.y < m_size.height);
+    m_bits[position.y * m_wordsPerRow + position.x / WordSize] |= uint64_t(1) << (position.x % WordSize);
+    m_dirtyMin = gf::min(m_dirtyMin, position);
+    m_dirtyMax = gf::max(m_dirtyMax, position);
+  }
 
-  std::vector<Vector2i> SquareMap::computeRoute(Vector2i origin, Vector2i target, float diagonalCost, Route algorithm) {
-    switch (algorithm) {
-      case Route::Dijkstra:
-        return computeDijkstra(m_cells, origin, target, diagonalCost);
+  void VisibilityLayer::merge(const VisibilityLayer& other) {
+    assert(other.m_size == m_size);
 
-      case Route::AStar:
-        return computeAStar(m_cells, origin, target, diagonalCost);
+    if (other.m_dirtyMin.x > other.m_dirtyMax.x) {
+      return;
     }
 
-    return { };
+    for (int y = other.m_dirtyMin.y; y <= other.m_dirtyMax.y; ++y) {
+      for (int i = other.m_dirtyMin.x / WordSize; i <= other.m_dirtyMax.x / WordSize; ++i) {
+        m_bits[y * m_wordsPerRow + i] |= other.m_bits[y * m_wordsPerRow + i];
+      }
+    }
+
+    m_dirtyMin = gf::min(m_dirtyMin, other.m_dirtyMin);
+    m_dirtyMax = gf::max(m_dirtyMax, other.m_dirtyMax);
   }
 
+  void VisibilityLayer::clear() {
+    if (m_dirtyMin.x > m_dirtyMax.x) {
+      return;
+    }
+
+    for (int y = m_dirtyMin.y; y <= m_dirtyMax.y; ++y) {
+      auto begin = m_bits.begin() + y * m_wordsPerRow;
+      std::fill(begin + m_dirtyMin.x / WordSize, begin + m_dirtyMax.x / WordSize + 1, 0);
+    }
+
+    m_dirtyMin = m_size;
+    m_dirtyMax = { -1, -1 };
+  }
+
+  bool SquareMap::isInFieldOfVision(Vector2i pos) const {
+    return testCell(pos, CellProperty::Visible);
+  }
+
+  bool SquareMap::isExplored(Vector2i pos) const {
+    return testCell(pos, CellProperty::Explored);
+  }
+
+  /*
+   * Route
+   */
+
+  namespace {
+
+    constexpr Vector2i RouteDirections[] = {
+      { -1, -1 }, {  0, -1 }, {  1, -1 },
+      { -1,  0 },             {  1,  0 },
+      { -1,  1 }, {  0,  1 }, {  1,  1 },
+    };
+
+    // see http://theory.stanford.edu/~amitp/GameProgramming/Heuristics.html#heuristics-for-grid-maps
+    float computeHeuristic(Vector2i p0, Vector2i p1, float diagonalCost) {
+      if (diagonalCost == 0) {
+        return 1.0f * gf::manhattanDistance(p0, p1);
+      }
+
+      Vector2i d = gf::abs(p0 - p1);
+      return 1.0f * (d.x + d.y) + (diagonalCost - 2.0f) * std::min(d.x, d.y);
+    }
+
+    Vector2i computeDirection(Vector2i from, Vector2i to) {
+      return { gf::sign(to.x - from.x), gf::sign(to.y - from.y) };
+    }
+
+    bool isWalkableAt(const SquareMap& map, const RectI& area, Vector2i position) {
+      return area.contains(position) && map.isWalkable(position);
+    }
+
+    bool jumpStraight(const SquareMap& map, const RectI& area, Vector2i position, Vector2i direction, Vector2i target, Vector2i& result) {
+      assert(direction.x == 0 || direction.y == 0);
+      Vector2i side = { direction.y, direction.x };
+
+      for (;;) {
+        position += direction;
+
+        if (!isWalkableAt(map, area, position)) {
+          return false;
+        }
+
+        if (position == target) {
+          result = position;
+          return true;
+        }
+
+        // forced neighbors
+        if ((!isWalkableAt(map, area, position + side) && isWalkableAt(map, area, position + side + direction))
+            || (!isWalkableAt(map, area, position - side) && isWalkableAt(map, area, position - side + direction))) {
+          result = position;
+          return true;
+        }
+      }
+    }
+
+    bool jumpDiagonal(const SquareMap& map, const RectI& area, Vector2i position, Vector2i direction, Vector2i target, Vector2i& result) {
+      assert(direction.x != 0 && direction.y != 0);
+      Vector2i horizontal = { direction.x, 0 };
+      Vector2i vertical = { 0, direction.y };
+
+      for (;;) {
+        position += direction;
+
+        if (!isWalkableAt(map, area, position)) {
+          return false;
+        }
+
+        if (position == target) {
+          result = position;
+          return true;
+        }
+
+        // forced neighbors
+        if ((!isWalkableAt(map, area, position - horizontal) && isWalkableAt(map, area, position - horizontal + vertical))
+            || (!isWalkableAt(map, area, position - vertical) && isWalkableAt(map, area, position - vertical + horizontal))) {
+          result = position;
+          return true;
+        }
+
+        Vector2i unused;
+
+        if (jumpStraight(map, area, position, horizontal, target, unused) || jumpStraight(map, area, position, vertical, target, unused)) {
+          result = position;
+          return true;
+        }
+      }
+    }
+
+  } // anonymous namespace
+
+  RouteContext::RouteContext()
+  : m_generation(0)
+  {
+  }
+
+  void RouteContext::clear() {
+    m_nodes = Array2D<Node, int>();
+    m_heap = std::vector<HeapData>();
+    m_generation = 0;
+  }
+
+  std::vector<Vector2i> RouteContext::computeRoute(const SquareMap& map, Vector2i origin, Vector2i target, float diagonalCost, Route algorithm, const RectI& area) {
+    search(map, origin, target, diagonalCost, algorithm, area);
+    return buildRoute(origin, target);
+  }
+
+  void RouteContext::computeDistances(const SquareMap& map, Vector2i origin, float diagonalCost, const RectI& area) {
+    search(map, origin, { -1, -1 }, diagonalCost, Route::Dijkstra, area);
+  }
+
+  float RouteContext::getDistance(Vector2i position) const {
+    const Node& node = m_nodes(position);
+
+    if (node.generation != m_generation) {
+      return std::numeric_limits<float>::infinity();
+    }
+
+    return node.distance;
+  }
+
+  void RouteContext::search(const SquareMap& map, Vector2i origin, Vector2i target, float diagonalCost, Route algorithm, const RectI& area) {
+    assert(algorithm != Route::Hierarchical);
+
+    if (algorithm == Route::JumpPointSearch && (diagonalCost == 0 || diagonalCost >= 2.0f)) {
+      algorithm = Route::AStar;
+    }
+
+    const float heuristicFactor = (algorithm == Route::Dijkstra) ? 0.0f : 1.0f;
+
+    prepare(map.getSize());
+
+    Node& start = getNode(origin);
+    start.distance = 0.0f;
+    push(origin, 0.0f, 0.0f);
+
+    while (!m_heap.empty()) {
+      HeapData data = pop();
+      Node& node = getNode(data.position);
+
+      if (node.closed) {
+        continue;
+      }
+
+      if (data.position == target) {
+        break;
+      }
+
+      node.closed = true;
+
+      if (algorithm == Route::JumpPointSearch) {
+        expandJumpPoints(map, data.position, target, diagonalCost, area);
+      } else {
+        expandNeighbors(map, data.position, target, diagonalCost, heuristicFactor, area);
+      }
+    }
+  }
+
+  void RouteContext::prepare(Vector2i size) {
+    if (m_nodes.getSize() != size) {
+      m_nodes = Array2D<Node, int>(size, Node{ 0.0f, { -1, -1 }, 0, false });
+      m_generation = 0;
+    }
+
+    ++m_generation;
+
+    if (m_generation == 0) {
+      // the generation wrapped, all the nodes must be reset
+      for (auto& node : m_nodes) {
+        node.generation = 0;
+      }
+
+      m_generation = 1;
+    }
+
+    m_heap.clear();
+  }
+
+  RouteContext::Node& RouteContext::getNode(Vector2i position) {
+    Node& node = m_nodes(position);
+
+    if (node.generation != m_generation) {
+      node.distance = std::numeric_limits<float>::infinity();
+      node.previous = { -1, -1 };
+      node.generation = m_generation;
+      node.closed = false;
+    }
+
+    return node;
+  }
+
+  namespace {
+
+    // the heuristic is admissible, ties are broken in favor of the node
+    // that is the farthest from the origin, i.e. the closest to the target
+    struct RouteHeapComparator {
+      template<typename T>
+      bool operator()(const T& lhs, const T& rhs) const {
+        if (lhs.priority != rhs.priority) {
+          return lhs.priority > rhs.priority;
+        }
+
+        return lhs.distance < rhs.distance;
+      }
+    };
+
+  } // anonymous namespace
+
+  void RouteContext::push(Vector2i position, float priority, float distance) {
+    m_heap.push_back({ position, priority, distance });
+    std::push_heap(m_heap.begin(), m_heap.end(), RouteHeapComparator());
+  }
+
+  RouteContext::HeapData RouteContext::pop() {
+    std::pop_heap(m_heap.begin(), m_heap.end(), RouteHeapComparator());
+    HeapData data = m_heap.back();
+    m_heap.pop_back();
+    return data;
+  }
+
+  void RouteContext::relax(Vector2i position, Vector2i previous, float distance, Vector2i target, float diagonalCost, float heuristicFactor) {
+    Node& node = getNode(position);
+
+    if (node.closed || distance >= node.distance) {
+      return;
+    }
+
+    node.distance = distance;
+    node.previous = previous;
+    push(position, distance + computeHeuristic(position, target, diagonalCost) * heuristicFactor, distance);
+  }
+
+  void RouteContext::expandNeighbors(const SquareMap& map, Vector2i position, Vector2i target, float diagonalCost, float heuristicFactor, const RectI& area) {
+    const float distance = getNode(position).distance;
+
+    for (auto direction : RouteDirections) {
+      bool isDiagonal = (direction.x != 0 && direction.y != 0);
+
+      if (isDiagonal && diagonalCost == 0) {
+        continue;
+      }
+
+      Vector2i neighbor = position + direction;
+
+      if (!isWalkableAt(map, area, neighbor)) {
+        continue;
+      }
+
+      relax(neighbor, position, distance + (isDiagonal ? diagonalCost : 1.0f), target, diagonalCost, heuristicFactor);
+    }
+  }
+
+  void RouteContext::expandJumpPoints(const SquareMap& map, Vector2i position, Vector2i target, float diagonalCost, const RectI& area) {
+    const Node& node = getNode(position);
+    const float distance = node.distance;
+
+    auto explore = [&](Vector2i direction) {
+      Vector2i result;
+
+      if (direction.x != 0 && direction.y != 0) {
+        if (jumpDiagonal(map, area, position, direction, target, result)) {
+          relax(result, position, distance + gf::chebyshevDistance(position, result) * diagonalCost, target, diagonalCost, 1.0f);
+        }
+      } else {
+        if (jumpStraight(map, area, position, direction, target, result)) {
+          relax(result, position, distance + gf::chebyshevDistance(position, result), target, diagonalCost, 1.0f);
+        }
+      }
+    };
+
+    if (node.previous.x == -1) {
+      // the origin has no parent, all the directions are explored
+      for (auto direction : RouteDirections) {
+        explore(direction);
+      }
+
+      return;
+    }
+
+    // pruned neighbors, see "Online Graph Pruning for Pathfinding on Grid Maps" (Harabor and Grastien, 2011)
+    Vector2i direction = computeDirection(node.previous, position);
+
+    if (direction.x != 0 && direction.y != 0) {
+      Vector2i horizontal = { direction.x, 0 };
+      Vector2i vertical = { 0, direction.y };
+
+      explore(horizontal);
+      explore(vertical);
+      explore(direction);
+
+      if (!isWalkableAt(map, area, position - horizontal)) {
+        explore(vertical - horizontal);
+      }
+
+      if (!isWalkableAt(map, area, position - vertical)) {
+        explore(horizontal - vertical);
+      }
+    } else {
+      Vector2i side = { direction.y, direction.x };
+
+      explore(direction);
+
+      if (!isWalkableAt(map, area, position + side)) {
+        explore(direction + side);
+      }
+
+      if (!isWalkableAt(map, area, position - side)) {
+        explore(direction - side);
+      }
+    }
+  }
+
+  std::vector<Vector2i> RouteContext::buildRoute(Vector2i origin, Vector2i target) {
+    std::vector<Vector2i> route;
+    Vector2i curr = target;
+
+    while (curr != origin) {
+      Vector2i previous = getNode(curr).previous;
+
+      if (previous.x == -1 || previous.y == -1) {
+        return {};
+      }
+
+      // jump points are linked by straight or diagonal segments
+      Vector2i direction = computeDirection(curr, previous);
+
+      while (curr != previous) {
+        route.push_back(curr);
+        curr += direction;
+      }
+    }
+
+    route.push_back(origin);
+    std::reverse(route.begin(), route.end());
+
+    assert(!route.empty());
+
+    return route;
+  }
+
+  /*
+   * Flow field
+   */
+
+  namespace {
+
+    // a direction is encoded in a 3x3 square, the center means no direction
+    constexpr uint8_t NoDirection = 4;
+
+    uint8_t encodeDirection(Vector2i direction) {
+      return static_cast<uint8_t>((direction.y + 1) * 3 + (direction.x + 1));
+    }
+
+    Vector2i decodeDirection(uint8_t code) {
+      return { code % 3 - 1, code / 3 - 1 };
+    }
+
+  } // anonymous namespace
+
+  FlowField::FlowField()
+  : m_diagonalCost(0.0f)
+  , m_bucketWidth(1.0f)
+  , m_currentBucket(0)
+  {
+  }
+
+  Vector2i FlowField::getSize() const {
+    return m_distances.getSize();
+  }
+
+  bool FlowField::isReachable(Vector2i position) const {
+    return m_distances(position) < std::numeric_limits<float>::infinity();
+  }
+
+  float FlowField::getDistance(Vector2i position) const {
+    return m_distances(position);
+  }
+
+  Vector2i FlowField::getNextStep(Vector2i position) const {
+    return position + decodeDirection(m_directions(position));
+  }
+
+  void FlowField::compute(const SquareMap& map, Span<const Vector2i> goals, float diagonalCost) {
+    Vector2i size = map.getSize();
+
+    if (m_distances.getSize() != size) {
+      m_distances = Array2D<float, int>(size);
+      m_directions = Array2D<uint8_t, int>(size);
+    }
+
+    std::fill(m_distances.begin(), m_distances.end(), std::numeric_limits<float>::infinity());
+    std::fill(m_directions.begin(), m_directions.end(), NoDirection);
+
+    m_goals.assign(goals.begin(), goals.end());
+    m_diagonalCost = diagonalCost;
+
+    // with buckets narrower than the cheapest move, the cells of a bucket
+    // can not improve each other, so a bucket is processed in any order
+    m_bucketWidth = (diagonalCost == 0) ? 1.0f : std::min(1.0f, diagonalCost);
+
+    for (auto goal : m_goals) {
+      if (map.isWalkable(goal)) {
+        relax(goal, goal, 0.0f);
+      }
+    }
+
+    propagate(map);
+  }
+
+  void FlowField::update(const SquareMap& map, Span<const Vector2i> cells) {
+    assert(m_distances.getSize() == map.getSize());
+
+    // invalidate the cells that are not walkable anymore and the cells whose
+    // route goes through them
+
+    std::vector<Vector2i> invalidated;
+
+    for (auto position : cells) {
+      if (!map.isWalkable(position) && isReachable(position)) {
+        m_distances(position) = std::numeric_limits<float>::infinity();
+        m_directions(position) = NoDirection;
+        invalidated.push_back(position);
+      }
+    }
+
+    for (std::size_t i = 0; i < invalidated.size(); ++i) {
+      Vector2i position = invalidated[i];
+
+      for (auto direction : RouteDirections) {
+        Vector2i neighbor = position + direction;
+
+        if (!m_distances.isValid(neighbor) || !isReachable(neighbor) || getNextStep(neighbor) != position) {
+          continue;
+        }
+
+        m_distances(neighbor) = std::numeric_limits<float>::infinity();
+        m_directions(neighbor) = NoDirection;
+        invalidated.push_back(neighbor);
+      }
+    }
+
+    // compute the changed cells and the invalidated cells again from their
+    // neighbors, then propagate the new distances
+
+    for (auto position : cells) {
+      seed(map, position);
+    }
+
+    for (auto position : invalidated) {
+      seed(map, position);
+    }
+
+    propagate(map);
+  }
+
+  void FlowField::seed(const SquareMap& map, Vector2i position) {
+    if (!map.isWalkable(position)) {
+      return;
+    }
+
+    if (std::find(m_goals.begin(), m_goals.end(), position) != m_goals.end()) {
+      relax(position, position, 0.0f);
+      return;
+    }
+
+    for (auto direction : RouteDirections) {
+      bool isDiagonal = (direction.x != 0 && direction.y != 0);
+
+      if (isDiagonal && m_diagonalCost == 0) {
+        continue;
+      }
+
+      Vector2i neighbor = position + direction;
+
+      if (!m_distances.isValid(neighbor) || !isReachable(neighbor)) {
+        continue;
+      }
+
+      relax(position, neighbor, m_distances(neighbor) + (isDiagonal ? m_diagonalCost : 1.0f));
+    }
+  }
+
+  void FlowField::relax(Vector2i position, Vector2i next, float distance) {
+    if (distance >= m_distances(position)) {
+      return;
+    }
+
+    m_distances(position) = distance;
+    m_directions(position) = encodeDirection(next - position);
+    push(position, distance);
+  }
+
+  void FlowField::push(Vector2i position, float distance) {
+    // rounding errors must not put a cell in a bucket that was already processed
+    std::size_t index = std::max(static_cast<std::size_t>(distance / m_bucketWidth), m_currentBucket);
+
+    if (index >= m_buckets.size()) {
+      m_buckets.resize(index + 1);
+    }
+
+    m_buckets[index].push_back({ position, distance });
+  }
+
+  void FlowField::propagate(const SquareMap& map) {
+    for (m_currentBucket = 0; m_currentBucket < m_buckets.size(); ++m_currentBucket) {
+      // the buckets may be reallocated in the loop, no reference is kept
+      for (std::size_t i = 0; i < m_buckets[m_currentBucket].size(); ++i) {
+        Entry entry = m_buckets[m_currentBucket][i];
+
+        if (entry.distance != m_distances(entry.position)) {
+          continue; // outdated entry
+        }
+
+        for (auto direction : RouteDirections) {
+          bool isDiagonal = (direction.x != 0 && direction.y != 0);
+
+          if (isDiagonal && m_diagonalCost == 0) {
+            continue;
+          }
+
+          Vector2i neighbor = entry.position + direction;
+
+          if (!m_distances.isValid(neighbor) || !map.isWalkable(neighbor)) {
+            continue;
+          }
+
+          relax(neighbor, entry.position, entry.distance + (isDiagonal ? m_diagonalCost : 1.0f));
+        }
+      }
+
+      m_buckets[m_currentBucket].clear();
+    }
+
+    m_currentBucket = 0;
+  }
+
+  FlowField SquareMap::computeFlowField(Span<const Vector2i> goals, float diagonalCost) const {
+    FlowField field;
+    field.compute(*this, goals, diagonalCost);
+    return field;
+  }
+
+  FlowField SquareMap::computeFlowField(Vector2i goal, float diagonalCost) const {
+    return computeFlowField(Span<const Vector2i>(&goal, 1), diagonalCost);
+  }
+
+  void SquareMap::updateFlowField(FlowField& field, Span<const Vector2i> cells) const {
+    field.update(*this, cells);
+  }
+
+  /*
+   * Hierarchical route
+   *
+   * see "Near Optimal Hierarchical Path-Finding" (Botea, Müller and Schaeffer, 2004)
+   */
+
+  namespace {
+
+    constexpr int DefaultClusterSize = 16;
+    constexpr int EntranceMaxLength = 6;
+
+    enum BorderKind : int {
+      HorizontalBorder,   // between (x, y) and (x + 1, y)
+      VerticalBorder,     // between (x, y) and (x, y + 1)
+      DiagonalBorder,     // between (x, y) and (x + 1, y + 1)
+      AntiDiagonalBorder, // between (x + 1, y) and (x, y + 1)
+    };
+
+    constexpr Vector2i BorderClusters[][2] = {
+      { { 0, 0 }, { 1, 0 } },
+      { { 0, 0 }, { 0, 1 } },
+      { { 0, 0 }, { 1, 1 } },
+      { { 1, 0 }, { 0, 1 } },
+    };
+
+  } // anonymous namespace
+
+  SquareMap::RouteHierarchy::RouteHierarchy()
+  : m_clusterSize(DefaultClusterSize)
+  , m_mapSize(0, 0)
+  , m_diagonalCost(0.0f)
+  , m_dirty(true)
+  , m_nodeBound(0)
+  {
+  }
+
+  void SquareMap::RouteHierarchy::setClusterSize(int clusterSize) {
+    assert(clusterSize > 1);
+    m_clusterSize = clusterSize;
+    invalidateAll();
+  }
+
+  void SquareMap::RouteHierarchy::invalidate(Vector2i position) {
+    if (m_clusters.isEmpty()) {
+      return;
+    }
+
+    m_clusters(getCluster(position)).dirty = true;
+    m_dirty = true;
+  }
+
+  void SquareMap::RouteHierarchy::invalidateAll() {
+    // the hierarchy is rebuilt on the next route
+    m_clusters = Array2D<Cluster, int>();
+  }
+
+  std::vector<Vector2i> SquareMap::RouteHierarchy::computeRoute(const SquareMap& map, Vector2i origin, Vector2i target, RouteContext& context, float diagonalCost) {
+    update(map, context, diagonalCost);
+
+    const Vector2i originCluster = getCluster(origin);
+    const Vector2i targetCluster = getCluster(target);
+
+    if (originCluster == targetCluster) {
+      auto route = context.computeRoute(map, origin, target, diagonalCost, Route::AStar, getClusterArea(originCluster));
+
+      if (!route.empty()) {
+        return route;
+      }
+    }
+
+    // connect the origin and the target to the nodes of their clusters
+
+    auto computeEdges = [&](Vector2i position, Vector2i cluster) {
+      std::vector<Edge> edges;
+      context.computeDistances(map, position, diagonalCost, getClusterArea(cluster));
+
+      for (auto index : m_clusters(cluster).nodes) {
+        float distance = context.getDistance(m_nodes[index].position);
+
+        if (distance < std::numeric_limits<float>::infinity()) {
+          edges.push_back({ index, distance, false });
+        }
+      }
+
+      return edges;
+    };
+
+    std::vector<Edge> originEdges = computeEdges(origin, originCluster);
+    std::vector<Edge> targetEdges = computeEdges(target, targetCluster);
+
+    // A* on the abstract graph, with two virtual nodes for the origin and the target
+
+    const std::size_t originNode = m_nodeBound;
+    const std::size_t targetNode = m_nodeBound + 1;
+
+    auto getPosition = [&](std::size_t index) {
+      if (index == originNode) {
+        return origin;
+      }
+
+      if (index == targetNode) {
+        return target;
+      }
+
+      return m_nodes[index].position;
+    };
+
+    struct AbstractData {
+      float distance;
+      std::size_t previous;
+      bool closed;
+    };
+
+    std::vector<AbstractData> results(m_nodeBound + 2, { std::numeric_limits<float>::infinity(), NullIndex, false });
+
+    struct AbstractHeapData {
+      std::size_t index;
+      float priority;
+      float distance;
+    };
+
+    std::priority_queue<AbstractHeapData, std::vector<AbstractHeapData>, RouteHeapComparator> heap;
+
+    auto relax = [&](std::size_t index, std::size_t previous, float distance) {
+      AbstractData& result = results[index];
+
+      if (result.closed || distance >= result.distance) {
+        return;
+      }
+
+      result.distance = distance;
+      result.previous = previous;
+      heap.push({ index, distance + computeHeuristic(getPosition(index), target, diagonalCost), distance });
+    };
+
+    results[originNode].distance = 0.0f;
+    heap.push({ originNode, 0.0f, 0.0f });
+
+    while (!heap.empty()) {
+      std::size_t current = heap.top().index;
+      heap.pop();
+
+      AbstractData& result = results[current];
+
+      if (result.closed) {
+        continue;
+      }
+
+      if (current == targetNode) {
+        break;
+      }
+
+      result.closed = true;
+
+      const std::vector<Edge>& edges = (current == originNode) ? originEdges : m_nodes[current].edges;
+
+      for (auto& edge : edges) {
+        relax(edge.node, current, result.distance + edge.cost);
+      }
+
+      if (current != originNode && getCluster(m_nodes[current].position) == targetCluster) {
+        for (auto& edge : targetEdges) {
+          if (edge.node == current) {
+            relax(targetNode, current, result.distance + edge.cost);
+          }
+        }
+      }
+    }
+
+    if (results[targetNode].previous == NullIndex) {
+      // every move across a border is in the abstract graph, so the target is not reachable
+      return {};
+    }
+
+    // refine the abstract route
+
+    std::vector<Vector2i> abstractRoute;
+
+    for (std::size_t index = targetNode; index != originNode; index = results[index].previous) {
+      abstractRoute.push_back(getPosition(index));
+    }
+
+    abstractRoute.push_back(origin);
+    std::reverse(abstractRoute.begin(), abstractRoute.end());
+
+    std::vector<Vector2i> route = { origin };
+
+    for (std::size_t i = 1; i < abstractRoute.size(); ++i) {
+      Vector2i from = abstractRoute[i - 1];
+      Vector2i to = abstractRoute[i];
+
+      if (getCluster(from) != getCluster(to)) {
+        // a transition between two clusters
+        route.push_back(to);
+        continue;
+      }
+
+      auto segment = context.computeRoute(map, from, to, diagonalCost, Route::AStar, getClusterArea(getCluster(from)));
+
+      if (segment.empty()) {
+        // the hierarchy is not consistent with the map
+        return {};
+      }
+
+      route.insert(route.end(), segment.begin() + 1, segment.end());
+    }
+
+    return route;
+  }
+
+  Vector2i SquareMap::RouteHierarchy::getCluster(Vector2i position) const {
+    return position / m_clusterSize;
+  }
+
+  RectI SquareMap::RouteHierarchy::getClusterArea(Vector2i cluster) const {
+    Vector2i min = cluster * m_clusterSize;
+    Vector2i max = gf::min(min + m_clusterSize, m_mapSize);
+    return RectI::fromMinMax(min, max);
+  }
+
+  void SquareMap::RouteHierarchy::update(const SquareMap& map, RouteContext& context, float diagonalCost) {
+    if (m_clusters.isEmpty() || m_mapSize != map.getSize() || m_diagonalCost != diagonalCost) {
+      m_mapSize = map.getSize();
+      m_diagonalCost = diagonalCost;
+
+      Vector2i clusterCount = (m_mapSize + m_clusterSize - 1) / m_clusterSize;
+      m_clusters = Array2D<Cluster, int>(clusterCount);
+
+      for (auto& borders : m_borders) {
+        borders = Array2D<std::vector<Transition>, int>(clusterCount);
+      }
+
+      m_nodes.clear();
+      m_nodeBound = 0;
+      m_dirty = true;
+    }
+
+    if (!m_dirty) {
+      return;
+    }
+
+    for (int kind = 0; kind < BorderKindCount; ++kind) {
+      for (auto position : m_borders[kind].getPositionRange()) {
+        Vector2i first = position + BorderClusters[kind][0];
+        Vector2i second = position + BorderClusters[kind][1];
+
+        if (!m_clusters.isValid(first) || !m_clusters.isValid(second)) {
+          continue;
+        }
+
+        if (m_clusters(first).dirty || m_clusters(second).dirty) {
+          updateBorder(map, kind, position, diagonalCost);
+        }
+      }
+    }
+
+    for (auto position : m_clusters.getPositionRange()) {
+      Cluster& cluster = m_clusters(position);
+
+      if (cluster.dirty || cluster.modified) {
+        updateCluster(map, position, context, diagonalCost);
+        cluster.dirty = false;
+        cluster.modified = false;
+      }
+    }
+
+    m_dirty = false;
+  }
+
+  void SquareMap::RouteHierarchy::updateBorder(const SquareMap& map, int kind, Vector2i cluster, float diagonalCost) {
+    // the new transitions are added before the old ones are removed so that
+    // the nodes that do not change are kept
+    std::vector<Transition> previous;
+    std::swap(previous, m_borders[kind](cluster));
+    std::vector<Transition>& transitions = m_borders[kind](cluster);
+
+    const Vector2i min = cluster * m_clusterSize;
+
+    switch (kind) {
+      case HorizontalBorder:
+      case VerticalBorder: {
+        const Vector2i across = (kind == HorizontalBorder) ? gf::vec(1, 0) : gf::vec(0, 1);
+        const Vector2i along = { across.y, across.x };
+        const Vector2i start = min + across * (m_clusterSize - 1);
+        const int length = std::min(m_clusterSize, (kind == HorizontalBorder) ? m_mapSize.height - min.y : m_mapSize.width - min.x);
+
+        int entranceStart = -1;
+
+        for (int i = 0; i <= length; ++i) {
+          bool open = i < length && map.isWalkable(start + along * i) && map.isWalkable(start + along * i + across);
+
+          if (open) {
+            if (entranceStart == -1) {
+              entranceStart = i;
+            }
+
+            continue;
+          }
+
+          if (entranceStart == -1) {
+            continue;
+          }
+
+          int entranceEnd = i - 1;
+
+          if (entranceEnd - entranceStart + 1 < EntranceMaxLength) {
+            int middle = (entranceStart + entranceEnd) / 2;
+            addTransition(transitions, start + along * middle, start + along * middle + across, 1.0f);
+          } else {
+            addTransition(transitions, start + along * entranceStart, start + along * entranceStart + across, 1.0f);
+            addTransition(transitions, start + along * entranceEnd, start + along * entranceEnd + across, 1.0f);
+          }
+
+          entranceStart = -1;
+        }
+
+        if (diagonalCost == 0) {
+          break;
+        }
+
+        // diagonal moves across the border that are not covered by an entrance
+
+        auto isOpen = [&](int i) {
+          return map.isWalkable(start + along * i) && map.isWalkable(start + along * i + across);
+        };
+
+        for (int i = 0; i < length; ++i) {
+          if (isOpen(i) || !map.isWalkable(start + along * i)) {
+            continue;
+          }
+
+          for (int j : { i - 1, i + 1 }) {
+            if (j < 0 || j >= length || isOpen(j)) {
+              continue;
+            }
+
+            if (map.isWalkable(start + along * j + across)) {
+              addTransition(transitions, start + along * i, start + along * j + across, diagonalCost);
+            }
+          }
+        }
+
+        break;
+      }
+
+      case DiagonalBorder:
+      case AntiDiagonalBorder: {
+        if (diagonalCost == 0) {
+          break;
+        }
+
+        const Vector2i corner = min + m_clusterSize;
+        const Vector2i first = (kind == DiagonalBorder) ? corner - 1 : corner - gf::vec(0, 1);
+        const Vector2i second = (kind == DiagonalBorder) ? corner : corner - gf::vec(1, 0);
+
+        if (map.isWalkable(first) && map.isWalkable(second)) {
+          addTransition(transitions, first, second, diagonalCost);
+        }
+
+        break;
+      }
+    }
+
+    for (auto& transition : previous) {
+      removeInterEdge(transition.first, transition.second);
+      removeInterEdge(transition.second, transition.first);
+      releaseNode(transition.first);
+      releaseNode(transition.second);
+    }
+  }
+
+  void SquareMap::RouteHierarchy::updateCluster(const SquareMap& map, Vector2i cluster, RouteContext& context, float diagonalCost) {
+    const std::vector<std::size_t>& nodes = m_clusters(cluster).nodes;
+    const RectI area = getClusterArea(cluster);
+
+    for (auto index : nodes) {
+      auto& edges = m_nodes[index].edges;
+      edges.erase(std::remove_if(edges.begin(), edges.end(), [](const Edge& edge) { return !edge.inter; }), edges.end());
+    }
+
+    for (auto index : nodes) {
+      context.computeDistances(map, m_nodes[index].position, diagonalCost, area);
+
+      for (auto other : nodes) {
+        if (other == index) {
+          continue;
+        }
+
+        float distance = context.getDistance(m_nodes[other].position);
+
+        if (distance < std::numeric_limits<float>::infinity()) {
+          m_nodes[index].edges.push_back({ other, distance, false });
+        }
+      }
+    }
+  }
+
+  std::size_t SquareMap::RouteHierarchy::acquireNode(Vector2i position) {
+    Cluster& cluster = m_clusters(getCluster(position));
+
+    for (auto index : cluster.nodes) {
+      if (m_nodes[index].position == position) {
+        ++m_nodes[index].references;
+        return index;
+      }
+    }
+
+    std::size_t index = m_nodes.allocate();
+    m_nodeBound = std::max(m_nodeBound, index + 1);
+
+    Node& node = m_nodes[index];
+    node.position = position;
+    node.references = 1;
+    node.edges.clear();
+
+    cluster.nodes.push_back(index);
+    cluster.modified = true;
+    return index;
+  }
+
+  void SquareMap::RouteHierarchy::releaseNode(std::size_t index) {
+    Node& node = m_nodes[index];
+    assert(node.references > 0);
+
+    if (--node.references > 0) {
+      return;
+    }
+
+    Cluster& cluster = m_clusters(getCluster(node.position));
+    auto it = std::find(cluster.nodes.begin(), cluster.nodes.end(), index);
+    assert(it != cluster.nodes.end());
+    cluster.nodes.erase(it);
+    cluster.modified = true;
+
+    node.edges.clear();
+    m_nodes.dispose(index);
+  }
+
+  void SquareMap::RouteHierarchy::addTransition(std::vector<Transition>& transitions, Vector2i first, Vector2i second, float cost) {
+    std::size_t firstIndex = acquireNode(first);
+    std::size_t secondIndex = acquireNode(second);
+    m_nodes[firstIndex].edges.push_back({ secondIndex, cost, true });
+    m_nodes[secondIndex].edges.push_back({ firstIndex, cost, true });
+    transitions.push_back({ firstIndex, secondIndex });
+  }
+
+  void SquareMap::RouteHierarchy::removeInterEdge(std::size_t index, std::size_t other) {
+    auto& edges = m_nodes[index].edges;
+    auto it = std::find_if(edges.begin(), edges.end(), [other](const Edge& edge) { return edge.inter && edge.node == other; });
+    assert(it != edges.end());
+    edges.erase(it);
+  }
+
+  std::vector<Vector2i> SquareMap::computeRoute(Vector2i origin, Vector2i target, float diagonalCost, Route algorithm) {
+    RouteContext context;
+    return computeRoute(origin, target, context, diagonalCost, algorithm);
+  }
+
+  std::vector<Vector2i> SquareMap::computeRoute(Vector2i origin, Vector2i target, RouteContext& context, float diagonalCost, Route algorithm) {
+    if (algorithm == Route::Hierarchical) {
+      return m_hierarchy.computeRoute(*this, origin, target, context, diagonalCost);
+    }
+
+    return context.computeRoute(*this, origin, target, diagonalCost, algorithm, RectI::fromSize(getSize()));
+  }
+
+  void SquareMap::setRouteClusterSize(int clusterSize) {
+    m_hierarchy.setClusterSize(clusterSize);
+  }
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 }
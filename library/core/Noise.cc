@@ -20,6 +20,10 @@
  */
 #include <gf/Noise.h>
 
+#include <cassert>
+#include <algorithm>
+#include <vector>
+
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
@@ -27,8 +31,60 @@ inline namespace v1 {
 
   Noise2D::~Noise2D() = default;
 
+  void Noise2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    assert(values.getSize() >= static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height));
+    double *value = values.getData();
+
+    for (int j = 0; j < size.height; ++j) {
+      const double y = origin.y + j * step.y;
+
+      for (int i = 0; i < size.width; ++i) {
+        *value++ = getValue(origin.x + i * step.x, y);
+      }
+    }
+  }
+
+  void Noise2D::fillFloatGrid(Vector2d origin, Vector2d step, Vector2i size, Span<float> values) {
+    assert(values.getSize() >= static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height));
+    float *value = values.getData();
+    std::vector<double> row(static_cast<std::size_t>(size.width));
+
+    for (int j = 0; j < size.height; ++j) {
+      fillGrid({ origin.x, origin.y + j * step.y }, step, { size.width, 1 }, row);
+      value = std::transform(row.begin(), row.end(), value, [](double x) { return static_cast<float>(x); });
+    }
+  }
+
   Noise3D::~Noise3D() = default;
 
+  void Noise3D::fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) {
+    assert(values.getSize() >= static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y) * static_cast<std::size_t>(size.z));
+    double *value = values.getData();
+
+    for (int k = 0; k < size.z; ++k) {
+      const double z = origin.z + k * step.z;
+
+      for (int j = 0; j < size.y; ++j) {
+        const double y = origin.y + j * step.y;
+
+        for (int i = 0; i < size.x; ++i) {
+          *value++ = getValue(origin.x + i * step.x, y, z);
+        }
+      }
+    }
+  }
+
+  void Noise3D::fillFloatGrid(Vector3d origin, Vector3d step, Vector3i size, Span<float> values) {
+    assert(values.getSize() >= static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y) * static_cast<std::size_t>(size.z));
+    float *value = values.getData();
+    std::vector<double> slice(static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y));
+
+    for (int k = 0; k < size.z; ++k) {
+      fillGrid({ origin.x, origin.y, origin.z + k * step.z }, step, { size.x, size.y, 1 }, slice);
+      value = std::transform(slice.begin(), slice.end(), value, [](double x) { return static_cast<float>(x); });
+    }
+  }
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 }
 #endif
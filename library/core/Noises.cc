@@ -22,6 +22,7 @@
 
 #include <cassert>
 #include <cmath>
+#include <cstdlib>
 #include <algorithm>
 #include <numeric>
 #include <random>
@@ -30,7 +31,21 @@
 #include <gf/Random.h>
 #include <gf/VectorOps.h>
 
+#include <gfpriv/NoiseKernels.h>
+
 namespace gf {
+#ifdef GF_NOISE_AVX2
+  namespace priv {
+
+    bool isAvx2Available() {
+      // GF_NOISE_NO_AVX2 forces the SSE2 kernels, so that they can be tested on an AVX2 host
+      static const bool available = __builtin_cpu_supports("avx2") && std::getenv("GF_NOISE_NO_AVX2") == nullptr; // Flawfinder: ignore
+      return available;
+    }
+
+  }
+#endif
+
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
 #endif
@@ -42,6 +57,52 @@ inline namespace v1 {
       std::shuffle(perm.begin(), perm.end(), random.getEngine());
     }
 
+    // the coordinates of a grid along an axis, shared by all the points of
+    // a row (or a column, or a slice)
+
+    struct GridCoordinate {
+      uint8_t q;
+      double r;
+      double t;
+    };
+
+    std::vector<GridCoordinate> computeGridCoordinates(double origin, double step, int count, Step<double> stepFunction) {
+      std::vector<GridCoordinate> coordinates(static_cast<std::size_t>(count));
+
+      for (int i = 0; i < count; ++i) {
+        double x = origin + i * step;
+        GridCoordinate& coordinate = coordinates[i];
+        coordinate.q = static_cast<uint8_t>(std::fmod(x, 256));
+        coordinate.r = std::fmod(x, 1);
+        assert(coordinate.r >= 0.0 && coordinate.r <= 1.0);
+        coordinate.t = stepFunction(coordinate.r);
+      }
+
+      return coordinates;
+    }
+
+    std::size_t computeGridCount(Vector2i size) {
+      return static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height);
+    }
+
+    std::size_t computeGridCount(Vector3i size) {
+      return static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y) * static_cast<std::size_t>(size.z);
+    }
+
+    // the weights of the octaves do not depend on the coordinates
+
+    std::vector<double> computeOctaveWeights(std::size_t octaves, double persistence, double dimension) {
+      std::vector<double> weights;
+      double amplitude = 1.0;
+
+      for (std::size_t k = 0; k < octaves; ++k) {
+        weights.push_back(std::pow(amplitude, dimension));
+        amplitude *= persistence;
+      }
+
+      return weights;
+    }
+
   } // anonymous namespace
 
   /*
@@ -138,6 +199,48 @@ inline namespace v1 {
     return gf::lerp(p0, p1, v);
   }
 
+  void GradientNoise2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    assert(values.getSize() >= computeGridCount(size));
+
+    const auto cols = computeGridCoordinates(origin.x, step.x, size.width, m_step);
+    const auto rows = computeGridCoordinates(origin.y, step.y, size.height, m_step);
+
+    std::vector<uint8_t> perm0(cols.size());
+    std::vector<uint8_t> perm1(cols.size());
+
+    for (std::size_t i = 0; i < cols.size(); ++i) {
+      perm0[i] = m_perm[cols[i].q];
+      perm1[i] = m_perm[static_cast<uint8_t>(cols[i].q + 1)];
+    }
+
+    double *value = values.getData();
+
+    for (auto& row : rows) {
+      const uint8_t qy0 = row.q;
+      const uint8_t qy1 = static_cast<uint8_t>(row.q + 1);
+      const double ry = row.r;
+
+      for (std::size_t i = 0; i < cols.size(); ++i) {
+        const double rx = cols[i].r;
+
+        const Vector2d& g00 = m_gradients2D[m_perm[static_cast<uint8_t>(perm0[i] + qy0)]];
+        const Vector2d& g10 = m_gradients2D[m_perm[static_cast<uint8_t>(perm1[i] + qy0)]];
+        const Vector2d& g01 = m_gradients2D[m_perm[static_cast<uint8_t>(perm0[i] + qy1)]];
+        const Vector2d& g11 = m_gradients2D[m_perm[static_cast<uint8_t>(perm1[i] + qy1)]];
+
+        double p00 = g00.x * rx         + g00.y * ry;
+        double p10 = g10.x * (rx - 1.0) + g10.y * ry;
+        double p01 = g01.x * rx         + g01.y * (ry - 1.0);
+        double p11 = g11.x * (rx - 1.0) + g11.y * (ry - 1.0);
+
+        double p0 = gf::lerp(p00, p10, cols[i].t);
+        double p1 = gf::lerp(p01, p11, cols[i].t);
+
+        *value++ = gf::lerp(p0, p1, row.t);
+      }
+    }
+  }
+
   const Vector2d& GradientNoise2D::at(uint8_t i, uint8_t j) const {
     uint8_t index = i;
     index = m_perm.at(index) + j;
@@ -205,6 +308,66 @@ inline namespace v1 {
     return gf::lerp(p0, p1, w);
   }
 
+  void GradientNoise3D::fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) {
+    assert(values.getSize() >= computeGridCount(size));
+
+    const auto cols = computeGridCoordinates(origin.x, step.x, size.x, m_step);
+    const auto rows = computeGridCoordinates(origin.y, step.y, size.y, m_step);
+    const auto slices = computeGridCoordinates(origin.z, step.z, size.z, m_step);
+
+    std::vector<uint8_t> perm0(cols.size());
+    std::vector<uint8_t> perm1(cols.size());
+
+    for (std::size_t i = 0; i < cols.size(); ++i) {
+      perm0[i] = m_perm[cols[i].q];
+      perm1[i] = m_perm[static_cast<uint8_t>(cols[i].q + 1)];
+    }
+
+    double *value = values.getData();
+
+    for (auto& slice : slices) {
+      const uint8_t qz0 = slice.q;
+      const uint8_t qz1 = static_cast<uint8_t>(slice.q + 1);
+      const double rz = slice.r;
+
+      for (auto& row : rows) {
+        const uint8_t qy0 = row.q;
+        const uint8_t qy1 = static_cast<uint8_t>(row.q + 1);
+        const double ry = row.r;
+
+        for (std::size_t i = 0; i < cols.size(); ++i) {
+          const double rx = cols[i].r;
+
+          const uint8_t i00 = m_perm[static_cast<uint8_t>(perm0[i] + qy0)];
+          const uint8_t i10 = m_perm[static_cast<uint8_t>(perm1[i] + qy0)];
+          const uint8_t i01 = m_perm[static_cast<uint8_t>(perm0[i] + qy1)];
+          const uint8_t i11 = m_perm[static_cast<uint8_t>(perm1[i] + qy1)];
+
+          double p000 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i00 + qz0)]], { rx      , ry      , rz       });
+          double p100 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i10 + qz0)]], { rx - 1.0, ry      , rz       });
+          double p010 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i01 + qz0)]], { rx      , ry - 1.0, rz       });
+          double p110 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i11 + qz0)]], { rx - 1.0, ry - 1.0, rz       });
+          double p001 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i00 + qz1)]], { rx      , ry      , rz - 1.0 });
+          double p101 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i10 + qz1)]], { rx - 1.0, ry      , rz - 1.0 });
+          double p011 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i01 + qz1)]], { rx      , ry - 1.0, rz - 1.0 });
+          double p111 = dot(m_gradients3D[m_perm[static_cast<uint8_t>(i11 + qz1)]], { rx - 1.0, ry - 1.0, rz - 1.0 });
+
+          double u = cols[i].t;
+
+          double p00 = gf::lerp(p000, p100, u);
+          double p10 = gf::lerp(p010, p110, u);
+          double p01 = gf::lerp(p001, p101, u);
+          double p11 = gf::lerp(p011, p111, u);
+
+          double p0 = gf::lerp(p00, p10, row.t);
+          double p1 = gf::lerp(p01, p11, row.t);
+
+          *value++ = gf::lerp(p0, p1, slice.t);
+        }
+      }
+    }
+  }
+
   const Vector3d& GradientNoise3D::at(uint8_t i, uint8_t j, uint8_t k) const {
     uint8_t index = i;
     index = m_perm.at(index) + j;
@@ -280,6 +443,7 @@ inline namespace v1 {
   , m_lacunarity(lacunarity)
   , m_persistence(persistence)
   , m_dimension(dimension)
+  , m_weights(computeOctaveWeights(octaves, persistence, dimension))
   {
 
   }
@@ -287,21 +451,37 @@ inline namespace v1 {
   double FractalNoise2D::getValue(double x, double y) {
     double value = 0.0;
     double frequency = 1.0;
-    double amplitude = 1.0;
 
     x *= m_scale;
     y *= m_scale;
 
     for (std::size_t k = 0; k < m_octaves; ++k) {
-      value += m_noise.getValue(x * frequency, y * frequency) * std::pow(amplitude, m_dimension);
-
+      value += m_noise.getValue(x * frequency, y * frequency) * m_weights[k];
       frequency *= m_lacunarity;
-      amplitude *= m_persistence;
     }
 
     return value;
   }
 
+  void FractalNoise2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    const std::size_t count = computeGridCount(size);
+    assert(values.getSize() >= count);
+
+    std::fill_n(values.getData(), count, 0.0);
+    std::vector<double> octave(count);
+    double frequency = m_scale;
+
+    for (std::size_t k = 0; k < m_octaves; ++k) {
+      m_noise.fillGrid(origin * frequency, step * frequency, size, octave);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        values[i] += octave[i] * m_weights[k];
+      }
+
+      frequency *= m_lacunarity;
+    }
+  }
+
   FractalNoise3D::FractalNoise3D(Noise3D& noise, double scale, std::size_t octaves, double lacunarity, double persistence, double dimension)
   : m_noise(noise)
   , m_scale(scale)
@@ -309,6 +489,7 @@ inline namespace v1 {
   , m_lacunarity(lacunarity)
   , m_persistence(persistence)
   , m_dimension(dimension)
+  , m_weights(computeOctaveWeights(octaves, persistence, dimension))
   {
 
   }
@@ -316,22 +497,38 @@ inline namespace v1 {
   double FractalNoise3D::getValue(double x, double y, double z) {
     double value = 0.0;
     double frequency = 1.0;
-    double amplitude = 1.0;
 
     x *= m_scale;
     y *= m_scale;
     z *= m_scale;
 
     for (std::size_t k = 0; k < m_octaves; ++k) {
-      value += m_noise.getValue(x * frequency, y * frequency, z * frequency) * std::pow(amplitude, m_dimension);
-
+      value += m_noise.getValue(x * frequency, y * frequency, z * frequency) * m_weights[k];
       frequency *= m_lacunarity;
-      amplitude *= m_persistence;
     }
 
     return value;
   }
 
+  void FractalNoise3D::fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) {
+    const std::size_t count = computeGridCount(size);
+    assert(values.getSize() >= count);
+
+    std::fill_n(values.getData(), count, 0.0);
+    std::vector<double> octave(count);
+    double frequency = m_scale;
+
+    for (std::size_t k = 0; k < m_octaves; ++k) {
+      m_noise.fillGrid(origin * frequency, step * frequency, size, octave);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        values[i] += octave[i] * m_weights[k];
+      }
+
+      frequency *= m_lacunarity;
+    }
+  }
+
 
   /*
    * Perlin
@@ -348,6 +545,10 @@ inline namespace v1 {
     return m_fractal(x, y);
   }
 
+  void PerlinNoise2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    m_fractal.fillGrid(origin, step, size, values);
+  }
+
   PerlinNoise3D::PerlinNoise3D(Random& random, double scale, std::size_t octaves)
   : m_gradient(random, gf::quinticStep)
   , m_fractal(m_gradient, scale, octaves)
@@ -359,6 +560,10 @@ inline namespace v1 {
     return m_fractal(x, y, z);
   }
 
+  void PerlinNoise3D::fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) {
+    m_fractal.fillGrid(origin, step, size, values);
+  }
+
 
   /*
    * Simplex
@@ -431,6 +636,41 @@ inline namespace v1 {
     return 45.23065 * res;
   }
 
+  namespace {
+
+    int fillSimplexNoise2DRow(const uint8_t *perm, double originX, double stepX, double y, int width, double *values) {
+#ifdef GF_NOISE_AVX2
+      if (priv::isAvx2Available()) {
+        return priv::fillSimplexNoise2DRowAvx2(perm, originX, stepX, y, width, values);
+      }
+#endif
+
+#ifdef GF_NOISE_SSE2
+      return priv::fillSimplexNoise2DRow<priv::Sse2Pack>(perm, originX, stepX, y, width, values);
+#else
+      return 0;
+#endif
+    }
+
+  }
+
+  void SimplexNoise2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    assert(values.getSize() >= computeGridCount(size));
+    double *value = values.getData();
+
+    for (int j = 0; j < size.height; ++j) {
+      const double y = origin.y + j * step.y;
+
+      // the vectorized kernel computes as many samples as possible, the rest is done here
+      int i = fillSimplexNoise2DRow(m_perm.data(), origin.x, step.x, y, size.width, value);
+      value += i;
+
+      for (; i < size.width; ++i) {
+        *value++ = SimplexNoise2D::getValue(origin.x + i * step.x, y);
+      }
+    }
+  }
+
   /*
    *         |
    *      1  -  0
@@ -446,20 +686,9 @@ inline namespace v1 {
    */
 
   const Vector2d& SimplexNoise2D::at(uint8_t i, uint8_t j) const {
-    static constexpr Vector2d gradients[8] = {
-      {  1.0,  2.0 },
-      { -1.0,  2.0 },
-      {  1.0, -2.0 },
-      { -1.0, -2.0 },
-      {  2.0,  1.0 },
-      {  2.0, -1.0 },
-      { -2.0,  1.0 },
-      { -2.0, -1.0 }
-    };
-
     uint8_t index = i;
-    index = m_perm.at(index) + j;
-    return gradients[m_perm.at(index) % 8];
+    index = m_perm[index] + j;
+    return priv::SimplexGradients2D[m_perm[index] % 8];
   }
 
 
@@ -690,24 +919,175 @@ inline namespace v1 {
       m_coeffs.resize(m_cells.size());
     }
 
+    // put the cells in buckets, with two cells per bucket on average
+
+    m_bucketCount = std::max(static_cast<int>(std::sqrt(m_cells.size() / 2.0)), 1);
+    m_origin = { 0.0, 0.0 };
+    m_bucketSize = 1.0;
+
+    if (!m_cells.empty()) {
+      Vector2d min = m_cells.front();
+      Vector2d max = m_cells.front();
+
+      for (auto& cell : m_cells) {
+        min = gf::min(min, cell);
+        max = gf::max(max, cell);
+      }
+
+      double extent = std::max(max.x - min.x, max.y - min.y);
+      m_origin = min;
+
+      if (extent > 0.0) {
+        m_bucketSize = extent / m_bucketCount;
+      }
+    }
+
+    auto computeBucket = [this](Vector2d cell) {
+      int i = std::clamp(static_cast<int>((cell.x - m_origin.x) / m_bucketSize), 0, m_bucketCount - 1);
+      int j = std::clamp(static_cast<int>((cell.y - m_origin.y) / m_bucketSize), 0, m_bucketCount - 1);
+      return static_cast<std::size_t>(j) * m_bucketCount + i;
+    };
+
+    m_buckets.assign(static_cast<std::size_t>(m_bucketCount) * m_bucketCount + 1, 0);
+
+    for (auto& cell : m_cells) {
+      ++m_buckets[computeBucket(cell) + 1];
+    }
+
+    std::partial_sum(m_buckets.begin(), m_buckets.end(), m_buckets.begin());
+
+    std::vector<Vector2d> cells(m_cells.size());
+    std::vector<std::size_t> next(m_buckets.begin(), m_buckets.end() - 1);
+
+    for (auto& cell : m_cells) {
+      cells[next[computeBucket(cell)]++] = cell;
+    }
+
+    m_cells = std::move(cells);
   }
 
   double WorleyNoise2D::getValue(double x, double y) {
+    static constexpr std::size_t LocalSize = 16;
+
+    if (m_coeffs.size() <= LocalSize) {
+      std::array<double, LocalSize> nearest;
+      return computeValue(x, y, nearest.data());
+    }
+
+    std::vector<double> nearest(m_coeffs.size());
+    return computeValue(x, y, nearest.data());
+  }
+
+  void WorleyNoise2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    assert(values.getSize() >= computeGridCount(size));
+    double *value = values.getData();
+    std::vector<double> nearest(m_coeffs.size());
+
+    for (int j = 0; j < size.height; ++j) {
+      const double y = origin.y + j * step.y;
+
+      for (int i = 0; i < size.width; ++i) {
+        *value++ = computeValue(origin.x + i * step.x, y, nearest.data());
+      }
+    }
+  }
+
+  double WorleyNoise2D::computeValue(double x, double y, double *nearest) const {
     double rx = std::fmod(x, 1);
     double ry = std::fmod(y, 1);
 
     auto size = m_coeffs.size();
 
+    if (size == 0) {
+      return 0.0;
+    }
+
     Vector2d here{rx, ry};
 
-    std::partial_sort(m_cells.begin(), m_cells.begin() + size, m_cells.end(), [&here, this](const Vector2d& lhs, const Vector2d& rhs) {
-      return m_distance(here, lhs) < m_distance(here, rhs);
-    });
+    // the bucket of the point, that may be outside the grid
+
+    const double bx = (rx - m_origin.x) / m_bucketSize;
+    const double by = (ry - m_origin.y) / m_bucketSize;
+    const int cx = static_cast<int>(std::floor(bx));
+    const int cy = static_cast<int>(std::floor(by));
+
+    // the distance between the point and the sides of its bucket
+    const double gap = std::max(std::min({ bx - cx, cx + 1 - bx, by - cy, cy + 1 - by }) * m_bucketSize, 0.0);
+
+    // the minimal distance of a cell that is at least delta away on one axis
+    auto computeLowerBound = [&here, this](double delta) {
+      return std::min({
+        m_distance(here, here + gf::vec(delta, 0.0)),
+        m_distance(here, here - gf::vec(delta, 0.0)),
+        m_distance(here, here + gf::vec(0.0, delta)),
+        m_distance(here, here - gf::vec(0.0, delta))
+      });
+    };
+
+    // keep the nearest cells sorted by distance
+    std::size_t found = 0;
+
+    auto visit = [&](int i, int j) {
+      std::size_t bucket = static_cast<std::size_t>(j) * m_bucketCount + i;
+
+      for (std::size_t c = m_buckets[bucket]; c < m_buckets[bucket + 1]; ++c) {
+        double distance = m_distance(here, m_cells[c]);
+
+        if (found == size) {
+          if (!(distance < nearest[size - 1])) {
+            continue;
+          }
+        } else {
+          ++found;
+        }
+
+        std::size_t k = found - 1;
+
+        while (k > 0 && distance < nearest[k - 1]) {
+          nearest[k] = nearest[k - 1];
+          --k;
+        }
+
+        nearest[k] = distance;
+      }
+    };
+
+    // look at the buckets ring by ring around the bucket of the point
+
+    for (int r = 0; ; ++r) {
+      if (r > 0 && found == size && computeLowerBound((r - 1) * m_bucketSize + gap) > nearest[size - 1]) {
+        break;
+      }
+
+      const int imin = std::max(cx - r, 0);
+      const int imax = std::min(cx + r, m_bucketCount - 1);
+
+      for (int j = std::max(cy - r, 0); j <= std::min(cy + r, m_bucketCount - 1); ++j) {
+        if (j == cy - r || j == cy + r) {
+          for (int i = imin; i <= imax; ++i) {
+            visit(i, j);
+          }
+        } else {
+          if (cx - r >= 0 && cx - r < m_bucketCount) {
+            visit(cx - r, j);
+          }
+
+          if (cx + r >= 0 && cx + r < m_bucketCount) {
+            visit(cx + r, j);
+          }
+        }
+      }
+
+      if (cx - r <= 0 && cy - r <= 0 && cx + r >= m_bucketCount - 1 && cy + r >= m_bucketCount - 1) {
+        break;
+      }
+    }
 
+    assert(found == size);
     double value = 0.0;
 
     for (decltype(size) i = 0; i < size; ++i) {
-      value += m_coeffs[i] * m_distance(here, m_cells[i]);
+      value += m_coeffs[i] * nearest[i];
     }
 
     return value;
@@ -724,6 +1104,7 @@ inline namespace v1 {
   , m_lacunarity(lacunarity)
   , m_persistence(persistence)
   , m_dimension(dimension)
+  , m_weights(computeOctaveWeights(octaves, persistence, dimension))
   {
 
   }
@@ -731,7 +1112,6 @@ inline namespace v1 {
   double Multifractal2D::getValue(double x, double y) {
     double value = 1.0;
     double frequency = 1.0;
-    double amplitude = 1.0;
 
     x *= m_scale;
     y *= m_scale;
@@ -746,15 +1126,32 @@ inline namespace v1 {
      */
 
     for (std::size_t k = 0; k < m_octaves; ++k) {
-      value *= m_noise.getValue(x * frequency, y * frequency) * std::pow(amplitude, m_dimension) + 1.0;
-
+      value *= m_noise.getValue(x * frequency, y * frequency) * m_weights[k] + 1.0;
       frequency *= m_lacunarity;
-      amplitude *= m_persistence;
     }
 
     return value;
   }
 
+  void Multifractal2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    const std::size_t count = computeGridCount(size);
+    assert(values.getSize() >= count);
+
+    std::fill_n(values.getData(), count, 1.0);
+    std::vector<double> octave(count);
+    double frequency = m_scale;
+
+    for (std::size_t k = 0; k < m_octaves; ++k) {
+      m_noise.fillGrid(origin * frequency, step * frequency, size, octave);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        values[i] *= octave[i] * m_weights[k] + 1.0;
+      }
+
+      frequency *= m_lacunarity;
+    }
+  }
+
   /*
    * Hetero Terrain
    */
@@ -767,13 +1164,13 @@ inline namespace v1 {
   , m_lacunarity(lacunarity)
   , m_persistence(persistence)
   , m_dimension(dimension)
+  , m_weights(computeOctaveWeights(octaves, persistence, dimension))
   {
 
   }
 
   double HeteroTerrain2D::getValue(double x, double y) {
     double frequency = 1.0;
-    double amplitude = 1.0;
 
     x *= m_scale;
     y *= m_scale;
@@ -781,21 +1178,44 @@ inline namespace v1 {
     double value = m_offset + m_noise(x, y);
 
     frequency *= m_lacunarity;
-    amplitude *= m_persistence;
 
     for (std::size_t k = 1; k < m_octaves; ++k) {
       auto increment = m_noise.getValue(x * frequency, y * frequency) + m_offset;
-      increment *= std::pow(amplitude, m_dimension);
+      increment *= m_weights[k];
       increment *= value;
       value += increment;
 
       frequency *= m_lacunarity;
-      amplitude *= m_persistence;
     }
 
     return value;
   }
 
+  void HeteroTerrain2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    const std::size_t count = computeGridCount(size);
+    assert(values.getSize() >= count);
+
+    double frequency = m_scale;
+    m_noise.fillGrid(origin * frequency, step * frequency, size, values);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      values[i] += m_offset;
+    }
+
+    std::vector<double> octave(count);
+    frequency *= m_lacunarity;
+
+    for (std::size_t k = 1; k < m_octaves; ++k) {
+      m_noise.fillGrid(origin * frequency, step * frequency, size, octave);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        values[i] += (octave[i] + m_offset) * m_weights[k] * values[i];
+      }
+
+      frequency *= m_lacunarity;
+    }
+  }
+
   /*
    * Hybrid Multifractal
    */
@@ -808,13 +1228,13 @@ inline namespace v1 {
   , m_lacunarity(lacunarity)
   , m_persistence(persistence)
   , m_dimension(dimension)
+  , m_weights(computeOctaveWeights(octaves, persistence, dimension))
   {
 
   }
 
   double HybridMultifractal2D::getValue(double x, double y) {
     double frequency = 1.0;
-    double amplitude = 1.0;
 
     x *= m_scale;
     y *= m_scale;
@@ -823,24 +1243,51 @@ inline namespace v1 {
     double weight = value;
 
     frequency *= m_lacunarity;
-    amplitude *= m_persistence;
 
     for (std::size_t k = 1; k < m_octaves; ++k) {
       if (weight > 1.0) {
         weight = 1.0;
       }
 
-      double signal = (m_noise.getValue(x * frequency, y * frequency) + m_offset) * std::pow(amplitude, m_dimension);
+      double signal = (m_noise.getValue(x * frequency, y * frequency) + m_offset) * m_weights[k];
       value += weight * signal;
       weight *= signal;
 
       frequency *= m_lacunarity;
-      amplitude *= m_persistence;
     }
 
     return value;
   }
 
+  void HybridMultifractal2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    const std::size_t count = computeGridCount(size);
+    assert(values.getSize() >= count);
+
+    double frequency = m_scale;
+    m_noise.fillGrid(origin * frequency, step * frequency, size, values);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      values[i] += m_offset;
+    }
+
+    std::vector<double> weights(values.getData(), values.getData() + count);
+    std::vector<double> octave(count);
+    frequency *= m_lacunarity;
+
+    for (std::size_t k = 1; k < m_octaves; ++k) {
+      m_noise.fillGrid(origin * frequency, step * frequency, size, octave);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        double weight = std::min(weights[i], 1.0);
+        double signal = (octave[i] + m_offset) * m_weights[k];
+        values[i] += weight * signal;
+        weights[i] = weight * signal;
+      }
+
+      frequency *= m_lacunarity;
+    }
+  }
+
 
   /*
    * Ridged Multifractal
@@ -855,6 +1302,7 @@ inline namespace v1 {
   , m_lacunarity(lacunarity)
   , m_persistence(persistence)
   , m_dimension(dimension)
+  , m_weights(computeOctaveWeights(octaves, persistence, dimension))
   {
 
   }
@@ -862,7 +1310,6 @@ inline namespace v1 {
   double RidgedMultifractal2D::getValue(double x, double y) {
     double value;
     double frequency = 1.0;
-    double amplitude = 1.0;
 
     x *= m_scale;
     y *= m_scale;
@@ -875,7 +1322,6 @@ inline namespace v1 {
     value = signal;
 
     frequency *= m_lacunarity;
-    amplitude *= m_persistence;
 
     for (std::size_t k = 1; k < m_octaves; ++k) {
       double weight = signal * m_gain;
@@ -887,15 +1333,45 @@ inline namespace v1 {
       signal *= signal;
 
       signal *= weight;
-      value += signal * std::pow(amplitude, m_dimension);
+      value += signal * m_weights[k];
 
       frequency *= m_lacunarity;
-      amplitude *= m_persistence;
     }
 
     return value;
   }
 
+  void RidgedMultifractal2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    const std::size_t count = computeGridCount(size);
+    assert(values.getSize() >= count);
+
+    double frequency = m_scale;
+    std::vector<double> signals(count);
+    m_noise.fillGrid(origin * frequency, step * frequency, size, signals);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      double signal = m_offset - std::abs(signals[i]);
+      signals[i] = values[i] = signal * signal;
+    }
+
+    std::vector<double> octave(count);
+    frequency *= m_lacunarity;
+
+    for (std::size_t k = 1; k < m_octaves; ++k) {
+      m_noise.fillGrid(origin * frequency, step * frequency, size, octave);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        double weight = gf::clamp(signals[i] * m_gain, 0.0, 1.0);
+        double signal = m_offset - std::abs(octave[i]);
+        signal = signal * signal * weight;
+        signals[i] = signal;
+        values[i] += signal * m_weights[k];
+      }
+
+      frequency *= m_lacunarity;
+    }
+  }
+
 
   Noise3DTo2DAdapter::Noise3DTo2DAdapter(Noise3D& noise, Vector3d normal, Vector3d point)
   : m_noise(noise)
@@ -0,0 +1,80 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+
+/*
+ * This file is compiled for AVX2 and its functions must only be called after
+ * a check with gf::priv::isAvx2Available(). Only the AVX2 pack is
+ * instantiated here so that no code with AVX2 instructions can be chosen by
+ * the linker for the other translation units.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#ifdef __clang__
+#pragma clang attribute push (__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC target("avx2")
+#endif
+
+#include <gfpriv/NoiseKernels.h>
+
+#include <immintrin.h>
+
+namespace gf {
+namespace priv {
+
+  namespace {
+
+    struct Avx2Pack {
+      using Type = __m256d;
+      static constexpr int Size = 4;
+
+      static Type broadcast(double value) { return _mm256_set1_pd(value); }
+      static Type load(const double *values) { return _mm256_loadu_pd(values); }
+      static void store(double *values, Type a) { _mm256_storeu_pd(values, a); }
+
+      static Type add(Type a, Type b) { return _mm256_add_pd(a, b); }
+      static Type sub(Type a, Type b) { return _mm256_sub_pd(a, b); }
+      static Type mul(Type a, Type b) { return _mm256_mul_pd(a, b); }
+
+      static Type greater(Type a, Type b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+      // keep a where mask is set, zero elsewhere
+      static Type select(Type mask, Type a) { return _mm256_and_pd(mask, a); }
+
+      static Type floor(Type a) { return _mm256_floor_pd(a); }
+    };
+
+  }
+
+  int fillSimplexNoise2DRowAvx2(const uint8_t *perm, double originX, double stepX, double y, int width, double *values) {
+    return fillSimplexNoise2DRow<Avx2Pack>(perm, originX, stepX, y, width, values);
+  }
+
+  int fillOpenSimplexNoise2DRowAvx2(const OpenSimplex2DKernelData& data, double originX, double stepX, double y, int width, double *values) {
+    return fillOpenSimplexNoise2DRow<Avx2Pack>(data, originX, stepX, y, width, values);
+  }
+
+}
+}
+
+#ifdef __clang__
+#pragma clang attribute pop
+#endif
+#endif
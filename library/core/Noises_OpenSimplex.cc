@@ -29,6 +29,8 @@
 #include <gf/Span.h>
 #include <gf/VectorOps.h>
 
+#include <gfpriv/NoiseKernels.h>
+
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
@@ -60,21 +62,8 @@ inline namespace v1 {
 
   namespace {
 
-    struct LatticePoint2D {
-      constexpr LatticePoint2D(int x, int y)
-      : xsv(x)
-      , ysv(y)
-      , dx(0.0)
-      , dy(0.0)
-      {
-        double ssv = (xsv + ysv) * -0.211324865405187;
-        dx = -xsv - ssv;
-        dy = -ysv - ssv;
-      }
-
-      int xsv, ysv;
-      double dx, dy;
-    };
+    // shared with the vectorized kernels
+    using LatticePoint2D = priv::OpenSimplexLatticePoint2D;
 
     constexpr std::array<LatticePoint2D, 8 * 4> computeLookup2D_S() {
       std::array<LatticePoint2D, 8 * 4> result = {
@@ -223,6 +212,44 @@ inline namespace v1 {
     return 0.0;
   }
 
+  namespace {
+
+    int fillOpenSimplexNoise2DRow(const priv::OpenSimplex2DKernelData& data, double originX, double stepX, double y, int width, double *values) {
+#ifdef GF_NOISE_AVX2
+      if (priv::isAvx2Available()) {
+        return priv::fillOpenSimplexNoise2DRowAvx2(data, originX, stepX, y, width, values);
+      }
+#endif
+
+#ifdef GF_NOISE_SSE2
+      return priv::fillOpenSimplexNoise2DRow<priv::Sse2Pack>(data, originX, stepX, y, width, values);
+#else
+      return 0;
+#endif
+    }
+
+  }
+
+  void OpenSimplexNoise2D::fillGrid(Vector2d origin, Vector2d step, Vector2i size, Span<double> values) {
+    assert(values.getSize() >= static_cast<std::size_t>(size.width) * static_cast<std::size_t>(size.height));
+    double *value = values.getData();
+
+    auto config = getConfig2D(m_type);
+    priv::OpenSimplex2DKernelData data = { m_perm.data(), m_gradients2D.data(), config.lookup.getData(), config.points, config.attn, m_type, m_variant };
+
+    for (int j = 0; j < size.height; ++j) {
+      const double y = origin.y + j * step.y;
+
+      // the vectorized kernel computes as many samples as possible, the rest is done here
+      int i = fillOpenSimplexNoise2DRow(data, origin.x, step.x, y, size.width, value);
+      value += i;
+
+      for (; i < size.width; ++i) {
+        *value++ = OpenSimplexNoise2D::getValue(origin.x + i * step.x, y);
+      }
+    }
+  }
+
   double OpenSimplexNoise2D::getValueBase(double xs, double ys) const {
     auto config = getConfig2D(m_type);
     double value = 0;
@@ -586,6 +613,53 @@ inline namespace v1 {
     return 0.0;
   }
 
+  void OpenSimplexNoise3D::fillGrid(Vector3d origin, Vector3d step, Vector3i size, Span<double> values) {
+    assert(values.getSize() >= static_cast<std::size_t>(size.x) * static_cast<std::size_t>(size.y) * static_cast<std::size_t>(size.z));
+    double *value = values.getData();
+
+    // the variant is chosen once for the whole grid
+    auto fill = [&](auto transform) {
+      for (int k = 0; k < size.z; ++k) {
+        const double z = origin.z + k * step.z;
+
+        for (int j = 0; j < size.y; ++j) {
+          const double y = origin.y + j * step.y;
+
+          for (int i = 0; i < size.x; ++i) {
+            *value++ = transform(origin.x + i * step.x, y, z);
+          }
+        }
+      }
+    };
+
+    switch (m_variant) {
+      case OpenSimplex3DVariant::Classic:
+        fill([this](double x, double y, double z) {
+          double r = (2.0 / 3.0) * (x + y + z);
+          return getValueBase(r - x, r - y, r - z);
+        });
+        break;
+
+      case OpenSimplex3DVariant::XYBeforeZ:
+        fill([this](double x, double y, double z) {
+          double xy = x + y;
+          double s2 = xy * -0.211324865405187;
+          double zz = z * 0.577350269189626;
+          return getValueBase(x + s2 - zz, y + s2 - zz, xy * 0.577350269189626 + zz);
+        });
+        break;
+
+      case OpenSimplex3DVariant::XZBeforeY:
+        fill([this](double x, double y, double z) {
+          double xz = x + z;
+          double s2 = xz * -0.211324865405187;
+          double yy = y * 0.577350269189626;
+          return getValueBase(x + s2 - yy, xz * 0.577350269189626 + yy, z + s2 - yy);
+        });
+        break;
+    }
+  }
+
   double OpenSimplexNoise3D::getValueBase(double xr, double yr, double zr) const {
     auto config = getConfig3D(m_type);
 
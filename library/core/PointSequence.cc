@@ -71,12 +71,7 @@ inline namespace v1 {
   Serializer& operator|(Serializer& ar, const PointSequence& sequence) {
     uint64_t size = sequence.getPointCount();
     ar | size;
-
-    for (uint64_t i = 0; i < size; ++i) {
-      Vector2f point = sequence.getPoint(i);
-      ar | point;
-    }
-
+    writeElements(ar, sequence.begin(), sequence.getPointCount());
     return ar;
   }
 
@@ -86,12 +81,13 @@ inline namespace v1 {
     uint64_t size = 0;
     ar | size;
 
-    for (uint64_t i = 0; i < size; ++i) {
-      Vector2f point;
-      ar | point;
-      sequence.addPoint(point);
+    std::vector<Vector2f> points;
+
+    if (static_cast<uint64_t>(static_cast<std::size_t>(size)) != size || !readElements(ar, points, static_cast<std::size_t>(size))) {
+      return ar;
     }
 
+    sequence = PointSequence(points);
     return ar;
   }
 
@@ -24,6 +24,7 @@
 #include <cinttypes>
 #include <cstring>
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 
@@ -37,6 +38,10 @@ inline namespace v1 {
   namespace {
 
     constexpr uint8_t Magic[2] = { 'g', 'f' };
+    constexpr uint8_t CompactMagic[2] = { 'g', 'v' };
+
+    // initial capacity of the buffer in buffered mode
+    constexpr std::size_t BufferCapacity = 64 * 1024;
 
 
     template<bool IsSigned>
@@ -88,20 +93,39 @@ inline namespace v1 {
       }
     };
 
+
+    constexpr uint64_t encodeZigZag(int64_t data) {
+      return (static_cast<uint64_t>(data) << 1) ^ static_cast<uint64_t>(data >> 63);
+    }
+
+    constexpr int64_t decodeZigZag(uint64_t data) {
+      return static_cast<int64_t>((data >> 1) ^ (~(data & 1) + 1));
+    }
+
   }
 
   /*
    * Serializer
    */
 
-  Serializer::Serializer(OutputStream& stream, uint16_t version)
+  Serializer::Serializer(OutputStream& stream, uint16_t version, Mode mode, Encoding encoding)
   : m_stream(&stream)
   , m_version(version)
+  , m_mode(mode)
+  , m_encoding(encoding)
   {
-    m_stream->write(Magic);
+    if (m_mode == Mode::Buffered) {
+      m_buffer.reserve(BufferCapacity);
+    }
+
+    writeBytes(m_encoding == Encoding::Compact ? CompactMagic : Magic);
     writeBigEndian16(version);
   }
 
+  Serializer::~Serializer() {
+    flush();
+  }
+
   void Serializer::writeBoolean(bool data) {
     writeUnsigned8(static_cast<uint8_t>(data));
   }
@@ -116,14 +140,29 @@ inline namespace v1 {
   }
 
   void Serializer::writeSigned16(int16_t data) {
+    if (m_encoding == Encoding::Compact) {
+      writeVarint(encodeZigZag(data));
+      return;
+    }
+
     writeBigEndian16(data);
   }
 
   void Serializer::writeSigned32(int32_t data) {
+    if (m_encoding == Encoding::Compact) {
+      writeVarint(encodeZigZag(data));
+      return;
+    }
+
     writeBigEndian32(data);
   }
 
   void Serializer::writeSigned64(int64_t data) {
+    if (m_encoding == Encoding::Compact) {
+      writeVarint(encodeZigZag(data));
+      return;
+    }
+
     writeBigEndian64(data);
   }
 
@@ -132,14 +171,29 @@ inline namespace v1 {
   }
 
   void Serializer::writeUnsigned16(uint16_t data) {
+    if (m_encoding == Encoding::Compact) {
+      writeVarint(data);
+      return;
+    }
+
     writeBigEndian16(data);
   }
 
   void Serializer::writeUnsigned32(uint32_t data) {
+    if (m_encoding == Encoding::Compact) {
+      writeVarint(data);
+      return;
+    }
+
     writeBigEndian32(data);
   }
 
   void Serializer::writeUnsigned64(uint64_t data) {
+    if (m_encoding == Encoding::Compact) {
+      writeVarint(data);
+      return;
+    }
+
     writeBigEndian64(data);
   }
 
@@ -161,7 +215,7 @@ inline namespace v1 {
     writeSizeHeader(size);
 
     if (size > 0) {
-      m_stream->write(gf::span(reinterpret_cast<const uint8_t *>(data), size));
+      writeBytes(gf::span(reinterpret_cast<const uint8_t *>(data), size));
     }
   }
 
@@ -177,11 +231,16 @@ inline namespace v1 {
   }
 
   void Serializer::writeSizeHeader(std::size_t size) {
+    if (m_encoding == Encoding::Compact) {
+      writeVarint(size);
+      return;
+    }
+
     if (size < 0xFF) {
       uint8_t buf[1];
       writeInteger(size, buf);
       assert(buf[0] != 0xFF);
-      m_stream->write(buf);
+      writeBytes(buf);
       return;
     }
 
@@ -193,7 +252,7 @@ inline namespace v1 {
       uint8_t buf[2];
       writeInteger(size, buf);
       assert(buf[0] != 0xFF);
-      m_stream->write(buf);
+      writeBytes(buf);
       return;
     }
 
@@ -205,7 +264,7 @@ inline namespace v1 {
       uint8_t buf[3];
       writeInteger(size, buf);
       assert(buf[0] != 0xFF);
-      m_stream->write(buf);
+      writeBytes(buf);
       return;
     }
 
@@ -217,7 +276,7 @@ inline namespace v1 {
       uint8_t buf[4];
       writeInteger(size, buf);
       assert(buf[0] != 0xFF);
-      m_stream->write(buf);
+      writeBytes(buf);
       return;
     }
 
@@ -229,7 +288,7 @@ inline namespace v1 {
       uint8_t buf[5];
       writeInteger(size, buf);
       assert(buf[0] != 0xFF);
-      m_stream->write(buf);
+      writeBytes(buf);
       return;
     }
 
@@ -241,7 +300,7 @@ inline namespace v1 {
       uint8_t buf[6];
       writeInteger(size, buf);
       assert(buf[0] != 0xFF);
-      m_stream->write(buf);
+      writeBytes(buf);
       return;
     }
 
@@ -253,7 +312,7 @@ inline namespace v1 {
       uint8_t buf[7];
       writeInteger(size, buf);
       assert(buf[0] != 0xFF);
-      m_stream->write(buf);
+      writeBytes(buf);
       return;
     }
 
@@ -262,16 +321,101 @@ inline namespace v1 {
     size -= 0xFFFFFFFFFFFFFF;
     uint8_t buf[8];
     writeInteger(size, buf);
-    m_stream->write(buf);
+    writeBytes(buf);
   }
 
 
+  namespace {
+
+    // chunk used to swap the scalars before sending them to the stream in direct mode
+    constexpr std::size_t DirectChunkSize = 16 * 1024;
+
+    template<typename U>
+    void swapToBigEndian(const uint8_t *in, uint8_t *out, std::size_t count) {
+      static constexpr std::size_t Size = sizeof(U);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        U value;
+        std::memcpy(&value, in + i * Size, Size);
+        uint8_t buf[Size];
+        writeInteger(value, buf);
+        std::memcpy(out + i * Size, buf, Size);
+      }
+    }
+
+    void swapToBigEndian(const uint8_t *in, uint8_t *out, std::size_t count, std::size_t size) {
+      switch (size) {
+        case 1: std::copy_n(in, count, out); break;
+        case 2: swapToBigEndian<uint16_t>(in, out, count); break;
+        case 4: swapToBigEndian<uint32_t>(in, out, count); break;
+        case 8: swapToBigEndian<uint64_t>(in, out, count); break;
+        default:
+          assert(false);
+          break;
+      }
+    }
+
+  }
+
+  void Serializer::writeBigEndianArray(const void *data, std::size_t count, std::size_t size) {
+    assert(size == 1 || size == 2 || size == 4 || size == 8);
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+
+    if (m_mode == Mode::Buffered) {
+      std::size_t offset = m_buffer.size();
+      m_buffer.resize(offset + count * size);
+      swapToBigEndian(bytes, m_buffer.data() + offset, count, size);
+      return;
+    }
+
+    uint8_t buf[DirectChunkSize];
+    const std::size_t chunk = DirectChunkSize / size;
+
+    while (count > 0) {
+      std::size_t n = std::min(count, chunk);
+      swapToBigEndian(bytes, buf, n, size);
+      m_stream->write(Span<const uint8_t>(buf, n * size));
+      bytes += n * size;
+      count -= n;
+    }
+  }
+
+  void Serializer::flush() {
+    if (m_buffer.empty()) {
+      return;
+    }
+
+    m_stream->write(m_buffer);
+    m_buffer.clear();
+  }
+
+  void Serializer::writeBytes(Span<const uint8_t> bytes) {
+    if (m_mode == Mode::Buffered) {
+      m_buffer.insert(m_buffer.end(), bytes.begin(), bytes.end());
+    } else {
+      m_stream->write(bytes);
+    }
+  }
+
+  void Serializer::writeVarint(uint64_t data) {
+    uint8_t buf[10];
+    std::size_t size = 0;
+
+    while (data >= 0x80) {
+      buf[size++] = static_cast<uint8_t>(data | 0x80);
+      data >>= 7;
+    }
+
+    buf[size++] = static_cast<uint8_t>(data);
+    writeBytes(Span<const uint8_t>(buf, size));
+  }
+
   void Serializer::writeBigEndian64(uint64_t data) {
     static constexpr std::size_t Size = sizeof(data);
 
     uint8_t buf[Size];
     writeInteger(data, buf);
-    m_stream->write(buf);
+    writeBytes(buf);
   }
 
   void Serializer::writeBigEndian32(uint32_t data) {
@@ -279,7 +423,7 @@ inline namespace v1 {
 
     uint8_t buf[Size];
     writeInteger(data, buf);
-    m_stream->write(buf);
+    writeBytes(buf);
   }
 
   void Serializer::writeBigEndian16(uint16_t data) {
@@ -287,11 +431,11 @@ inline namespace v1 {
 
     uint8_t buf[Size];
     writeInteger(data, buf);
-    m_stream->write(buf);
+    writeBytes(buf);
   }
 
   void Serializer::writeBigEndian8(uint8_t data) {
-    m_stream->write(data);
+    writeBytes(Span<const uint8_t>(&data, 1));
   }
 
   /*
@@ -301,11 +445,14 @@ inline namespace v1 {
   Deserializer::Deserializer(InputStream& stream)
   : m_stream(&stream)
   , m_version(0)
+  , m_encoding(Serializer::Encoding::Fixed)
   {
     uint8_t magic[2] = { 0u, 0u };
     m_stream->read(magic); // Flawfinder: ignore
 
-    if (magic[0] != Magic[0] || magic[1] != Magic[1]) {
+    if (magic[0] == CompactMagic[0] && magic[1] == CompactMagic[1]) {
+      m_encoding = Serializer::Encoding::Compact;
+    } else if (magic[0] != Magic[0] || magic[1] != Magic[1]) {
       Log::error("The stream is not a gf archive.\n"); // throw?
       return;
     }
@@ -313,6 +460,46 @@ inline namespace v1 {
     readBigEndian16(m_version);
   }
 
+  template<typename T>
+  bool Deserializer::readCompactSigned(T& data) {
+    uint64_t u64;
+
+    if (!readVarint(u64, "signed")) {
+      return false;
+    }
+
+    int64_t i64 = decodeZigZag(u64);
+
+    if constexpr (sizeof(T) < sizeof(int64_t)) {
+      if (i64 < std::numeric_limits<T>::min() || i64 > std::numeric_limits<T>::max()) {
+        Log::error("Asking for signed but the value is out of range: %" PRIi64 "\n", i64);
+        return false;
+      }
+    }
+
+    data = static_cast<T>(i64);
+    return true;
+  }
+
+  template<typename T>
+  bool Deserializer::readCompactUnsigned(T& data) {
+    uint64_t u64;
+
+    if (!readVarint(u64, "unsigned")) {
+      return false;
+    }
+
+    if constexpr (sizeof(T) < sizeof(uint64_t)) {
+      if (u64 > std::numeric_limits<T>::max()) {
+        Log::error("Asking for unsigned but the value is out of range: %" PRIu64 "\n", u64);
+        return false;
+      }
+    }
+
+    data = static_cast<T>(u64);
+    return true;
+  }
+
   bool Deserializer::readBoolean(bool& data) {
     uint8_t x;
 
@@ -343,6 +530,10 @@ inline namespace v1 {
   }
 
   bool Deserializer::readSigned16(int16_t& data) {
+    if (m_encoding == Serializer::Encoding::Compact) {
+      return readCompactSigned(data);
+    }
+
     uint16_t u16;
 
     if (!readBigEndian16(u16)) {
@@ -355,6 +546,10 @@ inline namespace v1 {
   }
 
   bool Deserializer::readSigned32(int32_t& data) {
+    if (m_encoding == Serializer::Encoding::Compact) {
+      return readCompactSigned(data);
+    }
+
     uint32_t u32;
 
     if (!readBigEndian32(u32)) {
@@ -367,6 +562,10 @@ inline namespace v1 {
   }
 
   bool Deserializer::readSigned64(int64_t& data) {
+    if (m_encoding == Serializer::Encoding::Compact) {
+      return readCompactSigned(data);
+    }
+
     uint64_t u64;
 
     if (!readBigEndian64(u64)) {
@@ -388,6 +587,10 @@ inline namespace v1 {
   }
 
   bool Deserializer::readUnsigned16(uint16_t& data) {
+    if (m_encoding == Serializer::Encoding::Compact) {
+      return readCompactUnsigned(data);
+    }
+
     if (!readBigEndian16(data)) {
       Log::error("Asking for unsigned but the file is at the end.\n");
       return false;
@@ -397,6 +600,10 @@ inline namespace v1 {
   }
 
   bool Deserializer::readUnsigned32(uint32_t& data) {
+    if (m_encoding == Serializer::Encoding::Compact) {
+      return readCompactUnsigned(data);
+    }
+
     if (!readBigEndian32(data)) {
       Log::error("Asking for unsigned but the file is at the end.\n");
       return false;
@@ -406,6 +613,10 @@ inline namespace v1 {
   }
 
   bool Deserializer::readUnsigned64(uint64_t& data) {
+    if (m_encoding == Serializer::Encoding::Compact) {
+      return readCompactUnsigned(data);
+    }
+
     if (!readBigEndian64(data)) {
       Log::error("Asking for unsigned but the file is at the end.\n");
       return false;
@@ -463,6 +674,10 @@ inline namespace v1 {
   }
 
   bool Deserializer::readSizeHeader(std::size_t& size) {
+    if (m_encoding == Serializer::Encoding::Compact) {
+      return readCompactUnsigned(size);
+    }
+
     static constexpr std::size_t Size = sizeof(std::size_t);
 
     uint8_t data;
@@ -521,6 +736,71 @@ inline namespace v1 {
     return true;
   }
 
+  namespace {
+
+    template<typename U>
+    void swapFromBigEndian(uint8_t *bytes, std::size_t count) {
+      static constexpr std::size_t Size = sizeof(U);
+
+      for (std::size_t i = 0; i < count; ++i) {
+        uint8_t buf[Size];
+        std::memcpy(buf, bytes + i * Size, Size);
+        U value = readInteger<U>(buf);
+        std::memcpy(bytes + i * Size, &value, Size);
+      }
+    }
+
+  }
+
+  bool Deserializer::readBigEndianArray(void *data, std::size_t count, std::size_t size) {
+    assert(size == 1 || size == 2 || size == 4 || size == 8);
+    uint8_t *bytes = static_cast<uint8_t *>(data);
+
+    if (m_stream->read(Span<uint8_t>(bytes, count * size)) != count * size) { // Flawfinder: ignore
+      Log::error("Asking for an array but the file is at the end.\n");
+      return false;
+    }
+
+    switch (size) {
+      case 1: break;
+      case 2: swapFromBigEndian<uint16_t>(bytes, count); break;
+      case 4: swapFromBigEndian<uint32_t>(bytes, count); break;
+      case 8: swapFromBigEndian<uint64_t>(bytes, count); break;
+      default:
+        assert(false);
+        break;
+    }
+
+    return true;
+  }
+
+  bool Deserializer::readVarint(uint64_t& data, const char *kind) {
+    data = 0;
+
+    for (unsigned shift = 0; shift < 64; shift += 7) {
+      uint8_t byte;
+
+      if (!readBigEndian8(byte)) {
+        Log::error("Asking for %s but the file is at the end.\n", kind);
+        return false;
+      }
+
+      if (shift == 63 && byte > 0x01) {
+        Log::error("Asking for %s but the varint is too long for 64 bits.\n", kind);
+        return false;
+      }
+
+      data |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+      if ((byte & 0x80) == 0) {
+        return true;
+      }
+    }
+
+    Log::error("Asking for %s but the varint is too long for 64 bits.\n", kind);
+    return false;
+  }
+
   bool Deserializer::readBigEndian64(uint64_t& data) {
     static constexpr std::size_t Size = sizeof(data);
 
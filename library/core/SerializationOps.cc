@@ -20,6 +20,7 @@
  */
 #include <gf/SerializationOps.h>
 
+#include <algorithm>
 #include <cinttypes>
 #include <memory>
 
@@ -173,10 +174,19 @@ inline namespace v1 {
       return ar;
     }
 
-    str.resize(size);
+    // the size comes from the stream, grow the string while the reads succeed
+    static constexpr std::size_t ChunkSize = 65536;
 
-    if (!ar.readString(str.data(), str.size())) {
-      return ar;
+    str.clear();
+
+    while (str.size() < size) {
+      std::size_t offset = str.size();
+      str.resize(offset + std::min(size - offset, ChunkSize));
+
+      if (!ar.readString(str.data() + offset, str.size() - offset)) {
+        str.clear();
+        return ar;
+      }
     }
 
     return ar;
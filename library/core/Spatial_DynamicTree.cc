@@ -20,15 +20,31 @@
  */
 #include <gf/Spatial_DynamicTree.h>
 
-#include <stack>
+#include <cmath>
+#include <queue>
+
+#include <gfpriv/BasicGeometry.h>
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
 #endif
 
+  namespace {
+    constexpr float DefaultDisplacementMultiplier = 2.0f;
+  }
+
   DynamicTree::DynamicTree()
   : m_root(NullIndex)
+  , m_margin(0.0f)
+  , m_displacementMultiplier(DefaultDisplacementMultiplier)
+  {
+  }
+
+  DynamicTree::DynamicTree(float margin)
+  : m_root(NullIndex)
+  , m_margin(margin)
+  , m_displacementMultiplier(DefaultDisplacementMultiplier)
   {
   }
 
@@ -36,60 +52,126 @@ inline namespace v1 {
     std::size_t index = allocateNode();
     Node& node = m_nodes[index];
     node.handle = handle;
-    node.bounds = bounds;
+    node.bounds = computeFatBounds(bounds, { 0.0f, 0.0f });
+    node.objectBounds = bounds;
     node.height = 0;
     doInsert(index);
     return static_cast<SpatialId>(index);
   }
 
   void DynamicTree::modify(SpatialId id, RectF bounds) {
+    modify(id, bounds, { 0.0f, 0.0f });
+  }
+
+  void DynamicTree::modify(SpatialId id, RectF bounds, Vector2f displacement) {
     std::size_t index = static_cast<std::size_t>(id);
+    assert(m_nodes[index].isLeaf());
+    ++m_statistics.modifications;
+
+    m_nodes[index].objectBounds = bounds;
+
+    RectF fat = computeFatBounds(bounds, displacement);
+
+    if (m_nodes[index].bounds.contains(bounds)) {
+      // the fat bounds may still be too large, e.g. if the object was moving
+      // fast and has slowed down, and they would be found by many queries
+      RectF huge = fat.grow(4.0f * m_margin);
+
+      for (std::size_t i = 0; i < 2; ++i) {
+        float extension = std::abs(displacement[i] * m_displacementMultiplier);
+        huge.min[i] -= extension;
+        huge.max[i] += extension;
+      }
+
+      if (huge.contains(m_nodes[index].bounds)) {
+        return;
+      }
+    }
+
+    ++m_statistics.reinsertions;
+
     doRemove(index);
-    m_nodes[index].bounds = bounds;
+    m_nodes[index].bounds = fat;
     doInsert(index);
   }
 
   std::size_t DynamicTree::query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind) {
+    return doQuery(bounds, callback, kind);
+  }
+
+  std::size_t DynamicTree::query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind) {
+    auto callback = [&handles](Handle handle) { handles.push_back(handle); };
+    return doQuery(bounds, callback, kind);
+  }
+
+  std::size_t DynamicTree::queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance) {
+    struct Candidate {
+      float distance;
+      std::size_t index;
+      bool isObject;
+
+      bool operator<(const Candidate& other) const {
+        return distance > other.distance;
+      }
+    };
+
+    if (m_root == NullIndex) {
+      return 0;
+    }
+
+    const float maxSquareDistance = (maxDistance == std::numeric_limits<float>::max()) ? maxDistance : gf::square(maxDistance);
     std::size_t found = 0;
 
-    std::stack<std::size_t> stack;
-    stack.push(m_root);
+    std::priority_queue<Candidate> queue;
+    queue.push({ priv::computeSquareDistance(point, m_nodes[m_root].bounds), m_root, false });
+
+    while (!queue.empty() && found < count) {
+      Candidate candidate = queue.top();
+      queue.pop();
 
-    while (!stack.empty()) {
-      std::size_t index = stack.top();
-      stack.pop();
+      if (candidate.distance > maxSquareDistance) {
+        break;
+      }
+
+      const Node& node = m_nodes[candidate.index];
+
+      if (candidate.isObject) {
+        callback(node.handle);
+        ++found;
+        continue;
+      }
+
+      if (node.isLeaf()) {
+        // the fat bounds were a lower bound, now check the object bounds
+        float distance = priv::computeSquareDistance(point, node.objectBounds);
+
+        if (distance <= maxSquareDistance) {
+          queue.push({ distance, candidate.index, true });
+        }
 
-      if (index == NullIndex) {
         continue;
       }
 
-      Node *node = &m_nodes[index];
-
-      if (node->isLeaf()) {
-        switch (kind) {
-          case SpatialQuery::Contain:
-            if (bounds.contains(node->bounds)) {
-              callback(node->handle);
-              ++found;
-            }
-            break;
-
-          case SpatialQuery::Intersect:
-            if (bounds.intersects(node->bounds)) {
-              callback(node->handle);
-              ++found;
-            }
-            break;
+      for (auto childIndex : { node.child1, node.child2 }) {
+        float distance = priv::computeSquareDistance(point, m_nodes[childIndex].bounds);
+
+        if (distance <= maxSquareDistance) {
+          queue.push({ distance, childIndex, false });
         }
-      } else if (bounds.intersects(node->bounds)) {
-        stack.push(node->child1);
-        stack.push(node->child2);
       }
     }
 
     return found;
   }
 
+  std::size_t DynamicTree::queryRaycast(Vector2f origin, Vector2f displacement, SpatialRaycastCallback callback) {
+    return doRaycast(origin, displacement, { 0.0f, 0.0f }, callback);
+  }
+
+  std::size_t DynamicTree::querySweep(const RectF& bounds, Vector2f displacement, SpatialRaycastCallback callback) {
+    return doRaycast(bounds.getCenter(), displacement, bounds.getSize() / 2, callback);
+  }
+
   void DynamicTree::remove(SpatialId id) {
     std::size_t index = static_cast<std::size_t>(id);
     doRemove(index);
@@ -99,6 +181,7 @@ inline namespace v1 {
   void DynamicTree::clear() {
     m_nodes.clear();
     m_root = NullIndex;
+    m_statistics = Statistics();
   }
 
   Handle DynamicTree::operator[](SpatialId id) {
@@ -122,6 +205,22 @@ inline namespace v1 {
     m_nodes.dispose(index);
   }
 
+  RectF DynamicTree::computeFatBounds(const RectF& bounds, Vector2f displacement) const {
+    RectF fat = bounds.grow(m_margin);
+
+    for (std::size_t i = 0; i < 2; ++i) {
+      float extension = displacement[i] * m_displacementMultiplier;
+
+      if (extension < 0.0f) {
+        fat.min[i] += extension;
+      } else {
+        fat.max[i] += extension;
+      }
+    }
+
+    return fat;
+  }
+
   void DynamicTree::doInsert(std::size_t leaf) {
     if (m_root == NullIndex) {
       m_root = leaf;
@@ -216,7 +315,7 @@ inline namespace v1 {
       std::size_t child2 = m_nodes[index].child2;
       assert(child2 != NullIndex);
 
-      m_nodes[index].height = std::max(m_nodes[child1].height, m_nodes[child2].height);
+      m_nodes[index].height = 1 + std::max(m_nodes[child1].height, m_nodes[child2].height);
       m_nodes[index].bounds = m_nodes[child1].bounds.getExtended(m_nodes[child2].bounds);
 
       index = m_nodes[index].parent;
@@ -270,6 +369,62 @@ inline namespace v1 {
     }
   }
 
+  std::size_t DynamicTree::doRaycast(Vector2f origin, Vector2f displacement, Vector2f halfSize, SpatialRaycastCallback& callback) {
+    struct Candidate {
+      float fraction;
+      std::size_t index;
+      bool isObject;
+
+      bool operator<(const Candidate& other) const {
+        return fraction > other.fraction;
+      }
+    };
+
+    std::size_t found = 0;
+    std::priority_queue<Candidate> queue;
+
+    auto push = [&](std::size_t index, const RectF& pushedBounds, bool isObject) {
+      RectF bounds = RectF::fromMinMax(pushedBounds.min - halfSize, pushedBounds.max + halfSize);
+      float fraction;
+
+      if (priv::computeRayFraction(origin, displacement, bounds, fraction)) {
+        queue.push({ fraction, index, isObject });
+      }
+    };
+
+    if (m_root != NullIndex) {
+      push(m_root, m_nodes[m_root].bounds, false);
+    }
+
+    while (!queue.empty()) {
+      Candidate candidate = queue.top();
+      queue.pop();
+
+      const Node& node = m_nodes[candidate.index];
+
+      if (candidate.isObject) {
+        ++found;
+
+        if (!callback(node.handle, candidate.fraction)) {
+          break;
+        }
+
+        continue;
+      }
+
+      if (node.isLeaf()) {
+        // the fat bounds were a lower bound, now check the object bounds
+        push(candidate.index, node.objectBounds, true);
+        continue;
+      }
+
+      push(node.child1, m_nodes[node.child1].bounds, false);
+      push(node.child2, m_nodes[node.child2].bounds, false);
+    }
+
+    return found;
+  }
+
   std::size_t DynamicTree::balance(std::size_t iA) {
     assert(iA != NullIndex);
 
@@ -21,6 +21,9 @@
 #include <gf/Spatial_Quadtree.h>
 
 #include <algorithm>
+#include <queue>
+
+#include <gfpriv/BasicGeometry.h>
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -59,6 +62,62 @@ inline namespace v1 {
     return doQuery(m_root, bounds, callback, kind);
   }
 
+  std::size_t Quadtree::query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind) {
+    auto callback = [&handles](Handle handle) { handles.push_back(handle); };
+    return doQuery(m_root, bounds, callback, kind);
+  }
+
+  std::size_t Quadtree::queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance) {
+    struct Candidate {
+      float distance;
+      std::size_t index;
+      bool isEntry;
+
+      bool operator<(const Candidate& other) const {
+        return distance > other.distance;
+      }
+    };
+
+    const float maxSquareDistance = (maxDistance == std::numeric_limits<float>::max()) ? maxDistance : gf::square(maxDistance);
+    std::size_t found = 0;
+
+    std::priority_queue<Candidate> queue;
+    queue.push({ 0.0f, m_root, false });
+
+    while (!queue.empty() && found < count) {
+      Candidate candidate = queue.top();
+      queue.pop();
+
+      if (candidate.isEntry) {
+        callback(m_entries[candidate.index].handle);
+        ++found;
+        continue;
+      }
+
+      const Node& node = m_nodes[candidate.index];
+
+      for (auto entryIndex : node.entries) {
+        float distance = priv::computeSquareDistance(point, m_entries[entryIndex].bounds);
+
+        if (distance <= maxSquareDistance) {
+          queue.push({ distance, entryIndex, true });
+        }
+      }
+
+      if (!node.isLeaf()) {
+        for (auto childIndex : node.children) {
+          float distance = priv::computeSquareDistance(point, m_nodes[childIndex].bounds);
+
+          if (distance <= maxSquareDistance) {
+            queue.push({ distance, childIndex, false });
+          }
+        }
+      }
+    }
+
+    return found;
+  }
+
   void Quadtree::remove(SpatialId id) {
     std::size_t entryIndex = static_cast<std::size_t>(id);
     doRemove(entryIndex);
@@ -140,48 +199,6 @@ inline namespace v1 {
     return true;
   }
 
-  std::size_t Quadtree::doQuery(std::size_t nodeIndex, const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind) {
-    if (nodeIndex == Null) {
-      return 0;
-    }
-
-    Node& node = m_nodes[nodeIndex];
-
-    if (!node.bounds.intersects(bounds)) {
-      return 0;
-    }
-
-    std::size_t found = 0;
-
-    for (auto entryIndex : node.entries) {
-      Entry& entry = m_entries[entryIndex];
-
-      switch (kind) {
-        case SpatialQuery::Contain:
-          if (bounds.contains(entry.bounds)) {
-            callback(entry.handle);
-            ++found;
-          }
-          break;
-
-        case SpatialQuery::Intersect:
-          if (bounds.intersects(entry.bounds)) {
-            callback(entry.handle);
-            ++found;
-          }
-          break;
-      }
-    }
-
-    if (!node.isLeaf()) {
-      for (auto childIndex : node.children) {
-        found += doQuery(childIndex, bounds, callback, kind);
-      }
-    }
-
-    return found;
-  }
-
   void Quadtree::doRemove(std::size_t entryIndex) {
     Entry& entry = m_entries[entryIndex];
 
@@ -192,7 +209,7 @@ inline namespace v1 {
     assert(it != node.entries.end());
     node.entries.erase(it);
 
-    if (node.entries.empty()) {
+    if (node.entries.empty() && node.isLeaf() && node.parent != Null) {
       sanitize(node.parent);
     }
   }
@@ -247,7 +264,7 @@ inline namespace v1 {
       for (auto childIndex : node.children) {
         Node& child = m_nodes[childIndex];
 
-        if (!child.entries.empty()) {
+        if (!child.entries.empty() || !child.isLeaf()) {
           return;
         }
       }
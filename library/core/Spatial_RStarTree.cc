@@ -20,8 +20,12 @@
  */
 #include <gf/Spatial_RStarTree.h>
 
+#include <cmath>
 #include <iterator>
 #include <numeric>
+#include <queue>
+
+#include <gfpriv/BasicGeometry.h>
 
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -96,6 +100,22 @@ inline namespace v1 {
     };
 
 
+    template<typename Member>
+    class MemberCenterAxisComparator {
+    public:
+      MemberCenterAxisComparator(std::size_t axis)
+      : m_axis(axis)
+      {
+      }
+
+      bool operator()(const Member& lhs, const Member& rhs) {
+        return lhs.bounds.min[m_axis] + lhs.bounds.max[m_axis] < rhs.bounds.min[m_axis] + rhs.bounds.max[m_axis];
+      }
+
+    private:
+      std::size_t m_axis;
+    };
+
     template<typename Member>
     class ExtentLengthEnlargement {
     public:
@@ -456,6 +476,50 @@ inline namespace v1 {
       return split;
     }
 
+
+    /*
+     * Functions for bulk loading
+     */
+
+    // number of members in a packed node, some room is kept for future insertions
+    constexpr std::size_t LoadSize = RStarTree::MaxSize * 3 / 4;
+
+    static_assert(LoadSize / 2 >= RStarTree::MinSize, "Packed nodes must have at least MinSize members.");
+
+    // Sort-Tile-Recursive: the members are sorted in vertical slices, then
+    // each slice is sorted and cut in groups. The sizes of the slices (and of
+    // the groups in a slice) differ by at most one, so that every group has
+    // at least MinSize members. The function returns the end of each group.
+    template<typename Member>
+    std::vector<std::size_t> computeLoadGroups(std::vector<Member>& members) {
+      const std::size_t count = members.size();
+      const std::size_t nodeCount = (count + LoadSize - 1) / LoadSize;
+      const auto sliceCount = static_cast<std::size_t>(std::ceil(std::sqrt(static_cast<double>(nodeCount))));
+      assert(sliceCount <= nodeCount);
+
+      std::sort(members.begin(), members.end(), MemberCenterAxisComparator<Member>(0));
+
+      std::vector<std::size_t> groups;
+      std::size_t sliceBegin = 0;
+
+      for (std::size_t i = 0; i < sliceCount; ++i) {
+        const std::size_t sliceEnd = count * (i + 1) / sliceCount;
+        std::sort(std::next(members.begin(), sliceBegin), std::next(members.begin(), sliceEnd), MemberCenterAxisComparator<Member>(1));
+
+        const std::size_t sliceSize = sliceEnd - sliceBegin;
+        const std::size_t groupCount = (sliceSize + LoadSize - 1) / LoadSize;
+
+        for (std::size_t j = 0; j < groupCount; ++j) {
+          groups.push_back(sliceBegin + sliceSize * (j + 1) / groupCount);
+        }
+
+        sliceBegin = sliceEnd;
+      }
+
+      assert(sliceBegin == count);
+      return groups;
+    }
+
   }
 
 
@@ -468,6 +532,82 @@ inline namespace v1 {
     node.type = Node::Leaf;
   }
 
+  RStarTree::RStarTree(Span<const SpatialObject> objects)
+  : m_root(NullIndex)
+  {
+    load(objects);
+  }
+
+  std::vector<SpatialId> RStarTree::load(Span<const SpatialObject> objects) {
+    m_entries.clear();
+    m_nodes.clear();
+
+    std::vector<SpatialId> ids;
+    ids.reserve(objects.getSize());
+
+    std::vector<Member> members;
+    members.reserve(objects.getSize());
+
+    for (auto& object : objects) {
+      std::size_t entryIndex = allocateEntry();
+      m_entries[entryIndex].handle = object.handle;
+      m_entries[entryIndex].bounds = object.bounds;
+      members.push_back({ object.bounds, entryIndex });
+      ids.push_back(static_cast<SpatialId>(entryIndex));
+    }
+
+    auto createNode = [this](Node::NodeType type, auto begin, auto end) {
+      std::size_t nodeIndex = allocateNode();
+      Node& node = m_nodes[nodeIndex];
+      node.parent = NullIndex;
+      node.type = type;
+      node.members.assign(begin, end);
+
+      for (auto& member : node.members) {
+        if (type == Node::Leaf) {
+          m_entries[member.index].node = nodeIndex;
+        } else {
+          m_nodes[member.index].parent = nodeIndex;
+        }
+      }
+
+      return nodeIndex;
+    };
+
+    Node::NodeType type = Node::Leaf;
+
+    // build the tree bottom-up, one level at a time
+
+    while (members.size() > MaxSize) {
+      auto groups = computeLoadGroups(members);
+
+      std::vector<Member> parents;
+      parents.reserve(groups.size());
+
+      auto begin = members.begin();
+
+      for (auto group : groups) {
+        auto end = std::next(members.begin(), group);
+        std::size_t nodeIndex = createNode(type, begin, end);
+        parents.push_back({ computeBounds(nodeIndex), nodeIndex });
+        begin = end;
+      }
+
+      members = std::move(parents);
+      type = Node::Branch;
+    }
+
+    m_root = createNode(type, members.begin(), members.end());
+
+    if (!members.empty()) {
+      computeBounds(m_root);
+    }
+
+//     validate();
+
+    return ids;
+  }
+
   SpatialId RStarTree::insert(Handle handle, const RectF& bounds) {
     std::size_t entryIndex = allocateEntry();
     m_entries[entryIndex].handle = handle;
@@ -492,6 +632,61 @@ inline namespace v1 {
     return doQuery(m_root, bounds, callback, kind);
   }
 
+  std::size_t RStarTree::query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind) {
+    auto callback = [&handles](Handle handle) { handles.push_back(handle); };
+    return doQuery(m_root, bounds, callback, kind);
+  }
+
+  std::size_t RStarTree::queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance) {
+    struct Candidate {
+      float distance;
+      std::size_t index;
+      bool isEntry;
+
+      bool operator<(const Candidate& other) const {
+        return distance > other.distance;
+      }
+    };
+
+    const float maxSquareDistance = (maxDistance == std::numeric_limits<float>::max()) ? maxDistance : gf::square(maxDistance);
+    std::size_t found = 0;
+
+    std::priority_queue<Candidate> queue;
+    queue.push({ 0.0f, m_root, false });
+
+    while (!queue.empty() && found < count) {
+      Candidate candidate = queue.top();
+      queue.pop();
+
+      if (candidate.isEntry) {
+        callback(m_entries[candidate.index].handle);
+        ++found;
+        continue;
+      }
+
+      const Node& node = m_nodes[candidate.index];
+      const bool isLeaf = (node.type == Node::Leaf);
+
+      for (auto& member : node.members) {
+        float distance = priv::computeSquareDistance(point, member.bounds);
+
+        if (distance <= maxSquareDistance) {
+          queue.push({ distance, member.index, isLeaf });
+        }
+      }
+    }
+
+    return found;
+  }
+
+  std::size_t RStarTree::queryRaycast(Vector2f origin, Vector2f displacement, SpatialRaycastCallback callback) {
+    return doRaycast(origin, displacement, { 0.0f, 0.0f }, callback);
+  }
+
+  std::size_t RStarTree::querySweep(const RectF& bounds, Vector2f displacement, SpatialRaycastCallback callback) {
+    return doRaycast(bounds.getCenter(), displacement, bounds.getSize() / 2, callback);
+  }
+
   void RStarTree::remove(SpatialId id) {
     std::size_t entryIndex = static_cast<std::size_t>(id);
     doRemove(entryIndex);
@@ -503,7 +698,11 @@ inline namespace v1 {
   void RStarTree::clear() {
     m_entries.clear();
     m_nodes.clear();
-    m_root = NullIndex;
+
+    m_root = allocateNode();
+    Node& node = m_nodes[m_root];
+    node.parent = NullIndex;
+    node.type = Node::Leaf;
   }
 
   Handle RStarTree::operator[](SpatialId id) {
@@ -511,6 +710,10 @@ inline namespace v1 {
     return m_entries[index].handle;
   }
 
+  void RStarTree::queryStructure(SpatialStructureCallback callback) const {
+    doQueryStructure(m_root, 0, callback);
+  }
+
 
   std::size_t RStarTree::allocateEntry() {
     return m_entries.allocate();
@@ -851,44 +1054,67 @@ inline namespace v1 {
   }
 
 
-  std::size_t RStarTree::doQuery(std::size_t nodeIndex, const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind) {
+  std::size_t RStarTree::doRaycast(Vector2f origin, Vector2f displacement, Vector2f halfSize, SpatialRaycastCallback& callback) {
+    struct Candidate {
+      float fraction;
+      std::size_t index;
+      bool isEntry;
+
+      bool operator<(const Candidate& other) const {
+        return fraction > other.fraction;
+      }
+    };
+
     std::size_t found = 0;
-    Node& node = m_nodes[nodeIndex];
 
-    switch (node.type) {
-      case Node::Leaf:
-        switch (kind) {
-          case SpatialQuery::Contain:
-            for (auto& member : node.members) {
-              if (bounds.contains(member.bounds)) {
-                callback(m_entries[member.index].handle);
-                ++found;
-              }
-            }
-            break;
-
-          case SpatialQuery::Intersect:
-            for (auto& member : node.members) {
-              if (bounds.intersects(member.bounds)) {
-                callback(m_entries[member.index].handle);
-                ++found;
-              }
-            }
-            break;
+    std::priority_queue<Candidate> queue;
+    queue.push({ 0.0f, m_root, false });
+
+    while (!queue.empty()) {
+      Candidate candidate = queue.top();
+      queue.pop();
+
+      if (candidate.isEntry) {
+        ++found;
+
+        if (!callback(m_entries[candidate.index].handle, candidate.fraction)) {
+          break;
         }
-        break;
-      case Node::Branch:
-        for (auto& member : node.members) {
-          if (bounds.intersects(member.bounds)) {
-            found += doQuery(member.index, bounds, callback, kind);
-          }
+
+        continue;
+      }
+
+      const Node& node = m_nodes[candidate.index];
+      const bool isLeaf = (node.type == Node::Leaf);
+
+      for (auto& member : node.members) {
+        RectF bounds = RectF::fromMinMax(member.bounds.min - halfSize, member.bounds.max + halfSize);
+        float fraction;
+
+        if (priv::computeRayFraction(origin, displacement, bounds, fraction)) {
+          queue.push({ fraction, member.index, isLeaf });
         }
-        break;
+      }
     }
 
     return found;
   }
 
+  void RStarTree::doQueryStructure(std::size_t nodeIndex, int level, SpatialStructureCallback& callback) const {
+    const Node& node = m_nodes[nodeIndex];
+    callback({ node.bounds, SpatialStructureType::Node, level });
+
+    if (node.type == Node::Leaf) {
+      for (auto& member : node.members) {
+        callback({ member.bounds, SpatialStructureType::Object, level + 1 });
+      }
+    } else {
+      for (auto& member : node.members) {
+        doQueryStructure(member.index, level + 1, callback);
+      }
+    }
+  }
+
   void RStarTree::getEntriesAndDispose(std::size_t nodeIndex, std::vector<std::size_t>& eliminated) {
     Node& node = m_nodes[nodeIndex];
 
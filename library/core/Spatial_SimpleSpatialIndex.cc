@@ -20,8 +20,11 @@
  */
 #include <gf/Spatial_SimpleSpatialIndex.h>
 
+#include <algorithm>
 #include <cassert>
 
+#include <gfpriv/BasicGeometry.h>
+
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
@@ -59,31 +62,41 @@ inline namespace v1 {
   }
 
   std::size_t SimpleSpatialIndex::query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind) {
-    std::size_t found = 0;
+    return doQuery(bounds, callback, kind);
+  }
+
+  std::size_t SimpleSpatialIndex::query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind) {
+    auto callback = [&handles](Handle handle) { handles.push_back(handle); };
+    return doQuery(bounds, callback, kind);
+  }
+
+  std::size_t SimpleSpatialIndex::queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance) {
+    const float maxSquareDistance = (maxDistance == std::numeric_limits<float>::max()) ? maxDistance : gf::square(maxDistance);
+
+    std::vector<std::pair<float, std::size_t>> candidates;
+
+    for (std::size_t index = 0; index < m_entries.size(); ++index) {
+      const Entry& entry = m_entries[index];
 
-    for (auto& entry : m_entries) {
       if (entry.next != Occupied) {
         continue;
       }
 
-      switch (kind) {
-        case SpatialQuery::Contain:
-          if (bounds.contains(entry.bounds)) {
-            callback(entry.handle);
-            ++found;
-          }
-          break;
-
-        case SpatialQuery::Intersect:
-          if (bounds.intersects(entry.bounds)) {
-            callback(entry.handle);
-            ++found;
-          }
-          break;
+      float distance = priv::computeSquareDistance(point, entry.bounds);
+
+      if (distance <= maxSquareDistance) {
+        candidates.emplace_back(distance, index);
       }
     }
 
-    return found;
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      callback(m_entries[candidates[i].second].handle);
+    }
+
+    return count;
   }
 
   void SimpleSpatialIndex::remove(SpatialId id) {
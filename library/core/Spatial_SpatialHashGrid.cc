@@ -0,0 +1,288 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/Spatial_SpatialHashGrid.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include <gfpriv/BasicGeometry.h>
+
+namespace gf {
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+inline namespace v1 {
+#endif
+
+  namespace {
+
+    // cell coordinates are clamped so that the cell counts never overflow
+    constexpr float CellLimit = static_cast<float>(1 << 29);
+
+    // objects covering more cells are kept out of the buckets
+    constexpr std::size_t OversizedCellCount = 64;
+
+  }
+
+  SpatialHashGrid::SpatialHashGrid(Vector2f cellSize, std::size_t bucketCount)
+  : m_cellSize(cellSize)
+  , m_buckets(bucketCount)
+  , m_stamp(0)
+  {
+    assert(cellSize.width > 0.0f && cellSize.height > 0.0f);
+    assert(bucketCount > 0);
+  }
+
+  SpatialId SpatialHashGrid::insert(Handle handle, const RectF& bounds) {
+    std::size_t index = m_entries.allocate();
+    Entry& entry = m_entries[index];
+    entry.handle = handle;
+    entry.bounds = bounds;
+    entry.range = computeCellRange(bounds);
+    entry.position = m_entryIndices.size();
+    entry.stamp = m_stamp;
+
+    m_entryIndices.push_back(index);
+    addToBuckets(index, entry.range);
+
+    return static_cast<SpatialId>(index);
+  }
+
+  void SpatialHashGrid::modify(SpatialId id, RectF bounds) {
+    std::size_t index = static_cast<std::size_t>(id);
+    Entry& entry = m_entries[index];
+    entry.bounds = bounds;
+
+    CellRange range = computeCellRange(bounds);
+
+    if (range.min == entry.range.min && range.max == entry.range.max) {
+      return;
+    }
+
+    removeFromBuckets(index, entry.range);
+    entry.range = range;
+    addToBuckets(index, range);
+  }
+
+  std::size_t SpatialHashGrid::query(const RectF& bounds, SpatialQueryCallback callback, SpatialQuery kind) {
+    return doQuery(bounds, callback, kind);
+  }
+
+  std::size_t SpatialHashGrid::query(const RectF& bounds, std::vector<Handle>& handles, SpatialQuery kind) {
+    auto callback = [&handles](Handle handle) { handles.push_back(handle); };
+    return doQuery(bounds, callback, kind);
+  }
+
+  std::size_t SpatialHashGrid::queryNearest(Vector2f point, std::size_t count, SpatialQueryCallback callback, float maxDistance) {
+    if (count == 0) {
+      return 0;
+    }
+
+    const float maxSquareDistance = (maxDistance == std::numeric_limits<float>::max()) ? maxDistance : gf::square(maxDistance);
+    const float minCellSize = std::min(m_cellSize.width, m_cellSize.height);
+    const std::size_t total = m_entryIndices.size();
+
+    std::vector<std::pair<float, std::size_t>> candidates;
+    std::size_t seen = 0;
+    ++m_stamp;
+
+    auto visit = [&](std::size_t entryIndex) {
+      Entry& entry = m_entries[entryIndex];
+
+      if (entry.stamp == m_stamp) {
+        return;
+      }
+
+      entry.stamp = m_stamp;
+      ++seen;
+
+      float distance = priv::computeSquareDistance(point, entry.bounds);
+
+      if (distance <= maxSquareDistance) {
+        candidates.emplace_back(distance, entryIndex);
+      }
+    };
+
+    auto visitCell = [&](Vector2i cell) {
+      for (auto entryIndex : m_buckets[computeBucket(cell)]) {
+        visit(entryIndex);
+      }
+    };
+
+    // search in rings of cells around the cell of the point: before the ring r,
+    // every object closer than r - 1 cells has been seen
+
+    const Vector2i center = computeCellRange(RectF::fromMinMax(point, point)).min;
+    std::size_t visitedCells = 0;
+
+    for (int r = 0; seen < total; ++r) {
+      if (r > 0) {
+        const float bound = gf::square((r - 1) * minCellSize);
+
+        if (bound > maxSquareDistance) {
+          break;
+        }
+
+        if (candidates.size() >= count) {
+          auto kth = std::next(candidates.begin(), count - 1);
+          std::nth_element(candidates.begin(), kth, candidates.end());
+
+          if (kth->first <= bound) {
+            break;
+          }
+        }
+      }
+
+      if (r == 0) {
+        for (auto entryIndex : m_oversized) {
+          visit(entryIndex);
+        }
+      }
+
+      if (visitedCells > total) {
+        // the objects are sparse, it's faster to check every object
+        for (auto entryIndex : m_entryIndices) {
+          visit(entryIndex);
+        }
+
+        break;
+      }
+
+      if (r == 0) {
+        visitCell(center);
+        ++visitedCells;
+        continue;
+      }
+
+      for (int i = -r; i <= r; ++i) {
+        visitCell({ center.x + i, center.y - r });
+        visitCell({ center.x + i, center.y + r });
+      }
+
+      for (int i = -r + 1; i <= r - 1; ++i) {
+        visitCell({ center.x - r, center.y + i });
+        visitCell({ center.x + r, center.y + i });
+      }
+
+      visitedCells += 8 * r;
+    }
+
+    count = std::min(count, candidates.size());
+    std::partial_sort(candidates.begin(), std::next(candidates.begin(), count), candidates.end());
+
+    for (std::size_t i = 0; i < count; ++i) {
+      callback(m_entries[candidates[i].second].handle);
+    }
+
+    return count;
+  }
+
+  void SpatialHashGrid::remove(SpatialId id) {
+    std::size_t index = static_cast<std::size_t>(id);
+    Entry& entry = m_entries[index];
+
+    removeFromBuckets(index, entry.range);
+
+    std::size_t last = m_entryIndices.back();
+    m_entryIndices[entry.position] = last;
+    m_entries[last].position = entry.position;
+    m_entryIndices.pop_back();
+
+    m_entries.dispose(index);
+  }
+
+  void SpatialHashGrid::clear() {
+    for (auto& bucket : m_buckets) {
+      bucket.clear();
+    }
+
+    m_entries.clear();
+    m_entryIndices.clear();
+    m_oversized.clear();
+  }
+
+  Handle SpatialHashGrid::operator[](SpatialId id) {
+    std::size_t index = static_cast<std::size_t>(id);
+    return m_entries[index].handle;
+  }
+
+  bool SpatialHashGrid::isOversized(const CellRange& range) {
+    return range.getCellCount() > OversizedCellCount;
+  }
+
+  SpatialHashGrid::CellRange SpatialHashGrid::computeCellRange(const RectF& bounds) const {
+    // std::min and std::max are in this order so that NaN is clamped too
+    auto computeCell = [](float coordinate, float size) {
+      float cell = std::floor(coordinate / size);
+      return static_cast<int>(std::max(-CellLimit, std::min(CellLimit, cell)));
+    };
+
+    CellRange range;
+
+    for (std::size_t i = 0; i < 2; ++i) {
+      range.min[i] = computeCell(bounds.min[i], m_cellSize[i]);
+      range.max[i] = std::max(range.min[i], computeCell(bounds.max[i], m_cellSize[i]));
+    }
+
+    return range;
+  }
+
+  std::size_t SpatialHashGrid::computeBucket(Vector2i cell) const {
+    // Teschner et al., Optimized Spatial Hashing for Collision Detection of Deformable Objects
+    auto hash = (static_cast<uint32_t>(cell.x) * UINT32_C(73856093)) ^ (static_cast<uint32_t>(cell.y) * UINT32_C(19349663));
+    return hash % m_buckets.size();
+  }
+
+  void SpatialHashGrid::addToBuckets(std::size_t entryIndex, const CellRange& range) {
+    if (isOversized(range)) {
+      m_oversized.push_back(entryIndex);
+      return;
+    }
+
+    for (int y = range.min.y; y <= range.max.y; ++y) {
+      for (int x = range.min.x; x <= range.max.x; ++x) {
+        m_buckets[computeBucket({ x, y })].push_back(entryIndex);
+      }
+    }
+  }
+
+  void SpatialHashGrid::removeFromBuckets(std::size_t entryIndex, const CellRange& range) {
+    if (isOversized(range)) {
+      auto it = std::find(m_oversized.begin(), m_oversized.end(), entryIndex);
+      assert(it != m_oversized.end());
+      *it = m_oversized.back();
+      m_oversized.pop_back();
+      return;
+    }
+
+    for (int y = range.min.y; y <= range.max.y; ++y) {
+      for (int x = range.min.x; x <= range.max.x; ++x) {
+        auto& bucket = m_buckets[computeBucket({ x, y })];
+        auto it = std::find(bucket.begin(), bucket.end(), entryIndex);
+        assert(it != bucket.end());
+        *it = bucket.back();
+        bucket.pop_back();
+      }
+    }
+  }
+
+#ifndef DOXYGEN_SHOULD_SKIP_THIS
+}
+#endif
+}
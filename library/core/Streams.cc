@@ -420,7 +420,7 @@ inline namespace v1 {
   }
 
   std::size_t BufferOutputStream::write(Span<const uint8_t> buffer) {
-    std::copy_n(buffer.getData(), buffer.getSize(), std::back_inserter(*m_bytes));
+    m_bytes->insert(m_bytes->end(), buffer.begin(), buffer.end());
     return buffer.getSize();
   }
 
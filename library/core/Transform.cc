@@ -21,12 +21,22 @@
 #include <gf/Transform.h>
 
 #include <algorithm>
+#include <cassert>
+#include <cstddef>
 #include <tuple>
 
 #include <gf/Matrix.h>
 #include <gf/Rect.h>
 #include <gf/VectorOps.h>
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define GF_TRANSFORM_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define GF_TRANSFORM_NEON 1
+#include <arm_neon.h>
+#endif
+
 namespace gf {
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
 inline namespace v1 {
@@ -47,6 +57,184 @@ inline namespace v1 {
     return RectF::fromMinMax(min, max);
   }
 
+  /*
+   * Batch transformations
+   *
+   * The vectorized kernels compute (a * x + b * y) + c like the scalar
+   * functions, so that the results are the same in both cases.
+   */
+
+  namespace {
+
+    // x' = xx * x + xy * y + xz ; y' = yx * x + yy * y + yz
+    struct Affine {
+      float xx, xy, xz;
+      float yx, yy, yz;
+    };
+
+    Affine toAffine(const Matrix3f& mat) {
+      return { mat.xx, mat.xy, mat.xz, mat.yx, mat.yy, mat.yz };
+    }
+
+    Affine toAffine(const Transform& trans) {
+      return { trans.rotation.cos, -trans.rotation.sin, trans.translation.offset.x, trans.rotation.sin, trans.rotation.cos, trans.translation.offset.y };
+    }
+
+    Vector2f transformPoint(const Affine& affine, Vector2f point) {
+      return { affine.xx * point.x + affine.xy * point.y + affine.xz, affine.yx * point.x + affine.yy * point.y + affine.yz };
+    }
+
+    static_assert(sizeof(Vector2f) == 2 * sizeof(float), "Vector2f must be packed");
+    static_assert(sizeof(Transform) == 4 * sizeof(float), "Transform must be packed");
+    static_assert(offsetof(Transform, translation) == 2 * sizeof(float), "Transform must be packed");
+
+    void transformPoints(const Affine& affine, const Vector2f *points, Vector2f *result, std::size_t count) {
+      std::size_t i = 0;
+
+#if defined(GF_TRANSFORM_SSE)
+      // four points deinterleaved in two registers
+      const __m128 xx = _mm_set1_ps(affine.xx);
+      const __m128 xy = _mm_set1_ps(affine.xy);
+      const __m128 xz = _mm_set1_ps(affine.xz);
+      const __m128 yx = _mm_set1_ps(affine.yx);
+      const __m128 yy = _mm_set1_ps(affine.yy);
+      const __m128 yz = _mm_set1_ps(affine.yz);
+
+      for (; i + 4 <= count; i += 4) {
+        __m128 lo = _mm_loadu_ps(&points[i].x);
+        __m128 hi = _mm_loadu_ps(&points[i + 2].x);
+        __m128 vx = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 vy = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 rx = _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, vx), _mm_mul_ps(xy, vy)), xz);
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(yx, vx), _mm_mul_ps(yy, vy)), yz);
+        _mm_storeu_ps(&result[i].x, _mm_unpacklo_ps(rx, ry));
+        _mm_storeu_ps(&result[i + 2].x, _mm_unpackhi_ps(rx, ry));
+      }
+#elif defined(GF_TRANSFORM_NEON)
+      // four deinterleaved points per register pair
+      const float32x4_t xx = vdupq_n_f32(affine.xx);
+      const float32x4_t xy = vdupq_n_f32(affine.xy);
+      const float32x4_t xz = vdupq_n_f32(affine.xz);
+      const float32x4_t yx = vdupq_n_f32(affine.yx);
+      const float32x4_t yy = vdupq_n_f32(affine.yy);
+      const float32x4_t yz = vdupq_n_f32(affine.yz);
+
+      for (; i + 4 <= count; i += 4) {
+        float32x4x2_t in = vld2q_f32(&points[i].x);
+        float32x4x2_t out;
+        out.val[0] = vaddq_f32(vaddq_f32(vmulq_f32(xx, in.val[0]), vmulq_f32(xy, in.val[1])), xz);
+        out.val[1] = vaddq_f32(vaddq_f32(vmulq_f32(yx, in.val[0]), vmulq_f32(yy, in.val[1])), yz);
+        vst2q_f32(&result[i].x, out);
+      }
+#endif
+
+      for (; i < count; ++i) {
+        result[i] = transformPoint(affine, points[i]);
+      }
+    }
+
+    void transformCoordinates(const Affine& affine, const float *x, const float *y, float *resultX, float *resultY, std::size_t count) {
+      std::size_t i = 0;
+
+#if defined(GF_TRANSFORM_SSE)
+      const __m128 xx = _mm_set1_ps(affine.xx);
+      const __m128 xy = _mm_set1_ps(affine.xy);
+      const __m128 xz = _mm_set1_ps(affine.xz);
+      const __m128 yx = _mm_set1_ps(affine.yx);
+      const __m128 yy = _mm_set1_ps(affine.yy);
+      const __m128 yz = _mm_set1_ps(affine.yz);
+
+      for (; i + 4 <= count; i += 4) {
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 vy = _mm_loadu_ps(y + i);
+        _mm_storeu_ps(resultX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(xx, vx), _mm_mul_ps(xy, vy)), xz));
+        _mm_storeu_ps(resultY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(yx, vx), _mm_mul_ps(yy, vy)), yz));
+      }
+#elif defined(GF_TRANSFORM_NEON)
+      const float32x4_t xx = vdupq_n_f32(affine.xx);
+      const float32x4_t xy = vdupq_n_f32(affine.xy);
+      const float32x4_t xz = vdupq_n_f32(affine.xz);
+      const float32x4_t yx = vdupq_n_f32(affine.yx);
+      const float32x4_t yy = vdupq_n_f32(affine.yy);
+      const float32x4_t yz = vdupq_n_f32(affine.yz);
+
+      for (; i + 4 <= count; i += 4) {
+        float32x4_t vx = vld1q_f32(x + i);
+        float32x4_t vy = vld1q_f32(y + i);
+        vst1q_f32(resultX + i, vaddq_f32(vaddq_f32(vmulq_f32(xx, vx), vmulq_f32(xy, vy)), xz));
+        vst1q_f32(resultY + i, vaddq_f32(vaddq_f32(vmulq_f32(yx, vx), vmulq_f32(yy, vy)), yz));
+      }
+#endif
+
+      for (; i < count; ++i) {
+        Vector2f point = transformPoint(affine, { x[i], y[i] });
+        resultX[i] = point.x;
+        resultY[i] = point.y;
+      }
+    }
+
+    void transformPointsEach(const Transform *transforms, const Vector2f *points, Vector2f *result, std::size_t count) {
+      std::size_t i = 0;
+
+#if defined(GF_TRANSFORM_SSE)
+      // a transform is (cos, sin, x, y) in a register, four transforms are transposed
+      for (; i + 4 <= count; i += 4) {
+        __m128 vc = _mm_loadu_ps(&transforms[i].rotation.cos);
+        __m128 vs = _mm_loadu_ps(&transforms[i + 1].rotation.cos);
+        __m128 ox = _mm_loadu_ps(&transforms[i + 2].rotation.cos);
+        __m128 oy = _mm_loadu_ps(&transforms[i + 3].rotation.cos);
+        _MM_TRANSPOSE4_PS(vc, vs, ox, oy);
+
+        __m128 lo = _mm_loadu_ps(&points[i].x);
+        __m128 hi = _mm_loadu_ps(&points[i + 2].x);
+        __m128 vx = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 vy = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 rx = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(vc, vx), _mm_mul_ps(vs, vy)), ox);
+        __m128 ry = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vs, vx), _mm_mul_ps(vc, vy)), oy);
+        _mm_storeu_ps(&result[i].x, _mm_unpacklo_ps(rx, ry));
+        _mm_storeu_ps(&result[i + 2].x, _mm_unpackhi_ps(rx, ry));
+      }
+#elif defined(GF_TRANSFORM_NEON)
+      for (; i + 4 <= count; i += 4) {
+        float32x4x4_t t = vld4q_f32(&transforms[i].rotation.cos); // cos, sin, x, y
+        float32x4x2_t in = vld2q_f32(&points[i].x);
+        float32x4x2_t out;
+        out.val[0] = vaddq_f32(vsubq_f32(vmulq_f32(t.val[0], in.val[0]), vmulq_f32(t.val[1], in.val[1])), t.val[2]);
+        out.val[1] = vaddq_f32(vaddq_f32(vmulq_f32(t.val[1], in.val[0]), vmulq_f32(t.val[0], in.val[1])), t.val[3]);
+        vst2q_f32(&result[i].x, out);
+      }
+#endif
+
+      for (; i < count; ++i) {
+        result[i] = transformPoint(toAffine(transforms[i]), points[i]);
+      }
+    }
+
+  } // anonymous namespace
+
+  void transform(const Transform& trans, Span<const Vector2f> points, Span<Vector2f> result) {
+    assert(result.getSize() >= points.getSize());
+    transformPoints(toAffine(trans), points.getData(), result.getData(), points.getSize());
+  }
+
+  void transform(Span<const Transform> transforms, Span<const Vector2f> points, Span<Vector2f> result) {
+    assert(transforms.getSize() >= points.getSize());
+    assert(result.getSize() >= points.getSize());
+    transformPointsEach(transforms.getData(), points.getData(), result.getData(), points.getSize());
+  }
+
+  void transform(const Matrix3f& mat, Span<const Vector2f> points, Span<Vector2f> result) {
+    assert(result.getSize() >= points.getSize());
+    transformPoints(toAffine(mat), points.getData(), result.getData(), points.getSize());
+  }
+
+  void transform(const Matrix3f& mat, Span<const float> x, Span<const float> y, Span<float> resultX, Span<float> resultY) {
+    assert(y.getSize() == x.getSize());
+    assert(resultX.getSize() >= x.getSize());
+    assert(resultY.getSize() >= x.getSize());
+    transformCoordinates(toAffine(mat), x.getData(), y.getData(), resultX.getData(), resultY.getData(), x.getSize());
+  }
+
   void translate(Matrix3f& mat, Vector2f offset) {
     mat *= translation(offset);
   }
@@ -20,14 +20,13 @@
  */
 #include <gf/Triangulation.h>
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <deque>
-#include <list>
-#include <set>
-#include <tuple>
+#include <vector>
 
-#include <gf/Circ.h>
-#include <gf/Log.h>
 #include <gf/VectorOps.h>
 
 namespace gf {
@@ -37,204 +36,894 @@ inline namespace v1 {
 
   namespace {
 
-    struct ExtendedVertex {
-      explicit ExtendedVertex(const Vector2f& p)
-      : origin(&p)
-      , position(p)
-      {
+    constexpr std::size_t SuperVertexCount = 3;
+    constexpr float SuperTriangleFactor = 1048576.0f;
 
+    constexpr std::size_t next(std::size_t index) {
+      return (index + 1) % 3;
+    }
+
+    constexpr std::size_t prev(std::size_t index) {
+      return (index + 2) % 3;
+    }
+
+    // The predicates must have the exact sign: the super vertices are about
+    // 2^20 times farther than the points, so the products of the differences
+    // need more bits than a double has. The predicates are first computed
+    // with doubles and a bound of the rounding error. When the result is
+    // within the bound, it is computed again exactly with expansions (sums of
+    // non-overlapping doubles, in increasing magnitude).
+    // see Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast
+    // Robust Geometric Predicates"
+
+    constexpr double Epsilon = 1.1102230246251565e-16; // 2^-53
+    constexpr double OrientationErrorBound = (3.0 + 16.0 * Epsilon) * Epsilon;
+    constexpr double InCircleErrorBound = (10.0 + 96.0 * Epsilon) * Epsilon;
+
+    using Expansion = std::vector<double>;
+
+    // x + y == a + b exactly
+    void computeTwoSum(double a, double b, double& x, double& y) {
+      x = a + b;
+      double bVirtual = x - a;
+      double aVirtual = x - bVirtual;
+      y = (a - aVirtual) + (b - bVirtual);
+    }
+
+    // x + y == a * b exactly
+    void computeTwoProduct(double a, double b, double& x, double& y) {
+      x = a * b;
+      y = std::fma(a, b, -x);
+    }
+
+    void growExpansion(Expansion& expansion, double value) {
+      std::size_t count = 0;
+
+      for (double component : expansion) {
+        double sum, error;
+        computeTwoSum(value, component, sum, error);
+        value = sum;
+
+        if (error != 0.0) {
+          expansion[count++] = error;
+        }
       }
 
-      const Vector2f *origin;
-      Vector2f position;
-    };
+      expansion.resize(count);
 
-    bool operator<(const ExtendedVertex& lhs, const ExtendedVertex& rhs) {
-      return lhs.origin < rhs.origin;
+      if (value != 0.0) {
+        expansion.push_back(value);
+      }
     }
 
-    bool operator!=(const ExtendedVertex& lhs, const ExtendedVertex& rhs) {
-      return lhs.origin != rhs.origin;
+    Expansion computeSum(Expansion lhs, const Expansion& rhs) {
+      for (double component : rhs) {
+        growExpansion(lhs, component);
+      }
+
+      return lhs;
     }
 
-    class ExtendedEdge : public EdgeRef<ExtendedVertex> {
-    public:
-      ExtendedEdge(const ExtendedVertex& p0, const ExtendedVertex& p1)
-      : EdgeRef(p0, p1)
-      , m_mark(false)
-      {
-        assert(p0 != p1);
+    Expansion computeProduct(const Expansion& lhs, const Expansion& rhs) {
+      Expansion result;
 
-        if (p1 < p0) {
-          std::swap(m_points[0], m_points[1]);
+      for (double factor : rhs) {
+        for (double component : lhs) {
+          double product, error;
+          computeTwoProduct(component, factor, product, error);
+          growExpansion(result, error);
+          growExpansion(result, product);
         }
       }
 
-      void setMarked() const {
-        m_mark = true;
+      return result;
+    }
+
+    Expansion computeNegation(Expansion expansion) {
+      for (double& component : expansion) {
+        component = -component;
       }
 
-      bool isMarked() const {
-        return m_mark;
+      return expansion;
+    }
+
+    // a difference of floats is not always a double (e.g. 1e20 - 1e-20)
+    Expansion computeDifference(float a, float b) {
+      double difference, error;
+      computeTwoSum(static_cast<double>(a), -static_cast<double>(b), difference, error);
+      Expansion result;
+      growExpansion(result, error);
+      growExpansion(result, difference);
+      return result;
+    }
+
+    double computeSign(const Expansion& expansion) {
+      // the largest component gives the sign
+      return expansion.empty() ? 0.0 : expansion.back();
+    }
+
+    // positive if c is on the left of (a, b)
+    double computeOrientation(Vector2f a, Vector2f b, Vector2f c) {
+      const double acx = static_cast<double>(a.x) - static_cast<double>(c.x);
+      const double acy = static_cast<double>(a.y) - static_cast<double>(c.y);
+      const double bcx = static_cast<double>(b.x) - static_cast<double>(c.x);
+      const double bcy = static_cast<double>(b.y) - static_cast<double>(c.y);
+
+      const double left = acx * bcy;
+      const double right = acy * bcx;
+      const double determinant = left - right;
+      const double bound = OrientationErrorBound * (std::abs(left) + std::abs(right));
+
+      if (determinant > bound || -determinant > bound) {
+        return determinant;
       }
 
-    private:
-      mutable bool m_mark;
-    };
+      Expansion exactLeft = computeProduct(computeDifference(a.x, c.x), computeDifference(b.y, c.y));
+      Expansion exactRight = computeProduct(computeDifference(a.y, c.y), computeDifference(b.x, c.x));
+      return computeSign(computeSum(exactLeft, computeNegation(exactRight)));
+    }
+
+    // positive if d is inside the circumcircle of (a, b, c) with a positive orientation
+    double computeInCircle(Vector2f a, Vector2f b, Vector2f c, Vector2f d) {
+      const double adx = static_cast<double>(a.x) - static_cast<double>(d.x);
+      const double ady = static_cast<double>(a.y) - static_cast<double>(d.y);
+      const double bdx = static_cast<double>(b.x) - static_cast<double>(d.x);
+      const double bdy = static_cast<double>(b.y) - static_cast<double>(d.y);
+      const double cdx = static_cast<double>(c.x) - static_cast<double>(d.x);
+      const double cdy = static_cast<double>(c.y) - static_cast<double>(d.y);
+
+      const double bdxcdy = bdx * cdy;
+      const double cdxbdy = cdx * bdy;
+      const double aLift = adx * adx + ady * ady;
+
+      const double cdxady = cdx * ady;
+      const double adxcdy = adx * cdy;
+      const double bLift = bdx * bdx + bdy * bdy;
+
+      const double adxbdy = adx * bdy;
+      const double bdxady = bdx * ady;
+      const double cLift = cdx * cdx + cdy * cdy;
+
+      const double determinant = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+      const double permanent = (std::abs(bdxcdy) + std::abs(cdxbdy)) * aLift + (std::abs(cdxady) + std::abs(adxcdy)) * bLift + (std::abs(adxbdy) + std::abs(bdxady)) * cLift;
+      const double bound = InCircleErrorBound * permanent;
+
+      if (determinant > bound || -determinant > bound) {
+        return determinant;
+      }
+
+      const Expansion exactAdx = computeDifference(a.x, d.x);
+      const Expansion exactAdy = computeDifference(a.y, d.y);
+      const Expansion exactBdx = computeDifference(b.x, d.x);
+      const Expansion exactBdy = computeDifference(b.y, d.y);
+      const Expansion exactCdx = computeDifference(c.x, d.x);
+      const Expansion exactCdy = computeDifference(c.y, d.y);
+
+      auto computeLift = [](const Expansion& x, const Expansion& y) {
+        return computeSum(computeProduct(x, x), computeProduct(y, y));
+      };
+
+      auto computeCross = [](const Expansion& x0, const Expansion& y0, const Expansion& x1, const Expansion& y1) {
+        return computeSum(computeProduct(x0, y1), computeNegation(computeProduct(y0, x1)));
+      };
+
+      Expansion result = computeProduct(computeLift(exactAdx, exactAdy), computeCross(exactBdx, exactBdy, exactCdx, exactCdy));
+      result = computeSum(result, computeProduct(computeLift(exactBdx, exactBdy), computeCross(exactCdx, exactCdy, exactAdx, exactAdy)));
+      result = computeSum(result, computeProduct(computeLift(exactCdx, exactCdy), computeCross(exactAdx, exactAdy, exactBdx, exactBdy)));
+      return computeSign(result);
+    }
+
+    // https://en.wikipedia.org/wiki/Hilbert_curve
+    uint64_t computeHilbertIndex(uint32_t x, uint32_t y) {
+      static constexpr uint32_t Size = 1 << 16;
+      uint64_t index = 0;
+
+      for (uint32_t s = Size / 2; s > 0; s /= 2) {
+        uint32_t rx = (x & s) != 0 ? 1 : 0;
+        uint32_t ry = (y & s) != 0 ? 1 : 0;
+        index += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+        if (ry == 0) {
+          if (rx == 1) {
+            x = Size - 1 - x;
+            y = Size - 1 - y;
+          }
+
+          std::swap(x, y);
+        }
+      }
 
-    bool operator<(const ExtendedEdge& lhs, const ExtendedEdge& rhs) {
-      return std::make_tuple(lhs[0], lhs[1]) < std::make_tuple(rhs[0], rhs[1]);
+      return index;
     }
 
-    class ExtendedTriangle : public TriangleRef<const ExtendedVertex> {
-    public:
-      ExtendedTriangle(const ExtendedVertex& p0, const ExtendedVertex& p1, const ExtendedVertex& p2)
-      : TriangleRef(p0, p1, p2)
-      , m_mark(false)
-      {
-        // https://en.wikipedia.org/wiki/Circumscribed_circle
+  } // anonymous namespace
+
+  /*
+   * DelaunayTriangulation
+   */
+
+  DelaunayTriangulation::DelaunayTriangulation(const RectF& bounds)
+  : m_lastTriangle(0)
+  {
+    Vector2f center = bounds.getCenter();
+    Vector2f size = bounds.getSize();
+    float radius = SuperTriangleFactor * std::max({ size.width, size.height, 1.0f });
+
+    // this triangle contains the circle of center `center` and radius `radius`
+    m_points.push_back(center + gf::vec(-2.0f * radius, -radius));
+    m_points.push_back(center + gf::vec(2.0f * radius, -radius));
+    m_points.push_back(center + gf::vec(0.0f, 2.0f * radius));
+    m_pointTriangles.resize(SuperVertexCount, NullIndex);
+
+    std::size_t triangle = allocateTriangle();
+    assert(triangle == 0);
+    setTriangle(triangle, 0, 1, 2);
+  }
+
+  std::size_t DelaunayTriangulation::insertPoint(Vector2f point) {
+    Position position = walk(point);
+
+    if (position.location == Location::OnVertex) {
+      return m_triangles[position.triangle].vertices[position.index] - SuperVertexCount;
+    }
+
+    std::size_t vertex = m_points.size();
+    m_points.push_back(point);
+    m_pointTriangles.push_back(NullIndex);
+
+    std::vector<std::size_t> triangles;
+
+    if (position.location == Location::Inside) {
+      // split the triangle in three triangles
+      std::size_t t0 = position.triangle;
+      const Triangle old = m_triangles[t0];
+      std::size_t t1 = allocateTriangle();
+      std::size_t t2 = allocateTriangle();
+
+      setTriangle(t0, vertex, old.vertices[1], old.vertices[2]);
+      setTriangle(t1, vertex, old.vertices[2], old.vertices[0]);
+      setTriangle(t2, vertex, old.vertices[0], old.vertices[1]);
+
+      link(t0, 0, old.neighbors[0], old.constrained[0]);
+      link(t1, 0, old.neighbors[1], old.constrained[1]);
+      link(t2, 0, old.neighbors[2], old.constrained[2]);
+      link(t0, 1, t1, false);
+      link(t1, 1, t2, false);
+      link(t2, 1, t0, false);
+
+      triangles = { t0, t1, t2 };
+    } else {
+      // split the edge and the two triangles on each side of the edge
+      assert(position.location == Location::OnEdge);
+      std::size_t t0 = position.triangle;
+      std::size_t i = position.index;
+      const Triangle old0 = m_triangles[t0];
+
+      std::size_t t2 = old0.neighbors[i];
+      assert(t2 != NullIndex);
+      std::size_t j = findEdgeIndex(t2, old0.vertices[prev(i)], old0.vertices[next(i)]);
+      const Triangle old2 = m_triangles[t2];
+
+      std::size_t a = old0.vertices[i];
+      std::size_t b = old0.vertices[next(i)];
+      std::size_t c = old0.vertices[prev(i)];
+      std::size_t d = old2.vertices[j];
+      bool constrained = old0.constrained[i];
+
+      std::size_t t1 = allocateTriangle();
+      std::size_t t3 = allocateTriangle();
+
+      setTriangle(t0, vertex, a, b);
+      setTriangle(t1, vertex, b, d);
+      setTriangle(t2, vertex, d, c);
+      setTriangle(t3, vertex, c, a);
+
+      link(t0, 0, old0.neighbors[prev(i)], old0.constrained[prev(i)]);
+      link(t1, 0, old2.neighbors[next(j)], old2.constrained[next(j)]);
+      link(t2, 0, old2.neighbors[prev(j)], old2.constrained[prev(j)]);
+      link(t3, 0, old0.neighbors[next(i)], old0.constrained[next(i)]);
+      link(t0, 1, t1, constrained);
+      link(t1, 1, t2, false);
+      link(t2, 1, t3, constrained);
+      link(t3, 1, t0, false);
+
+      triangles = { t0, t1, t2, t3 };
+    }
+
+    m_lastTriangle = triangles.front();
+    legalize(triangles);
+    return vertex - SuperVertexCount;
+  }
+
+  void DelaunayTriangulation::removePoint(std::size_t vertex) {
+    vertex += SuperVertexCount;
+    assert(vertex < m_points.size());
+    assert(m_pointTriangles[vertex] != NullIndex);
+
+    struct RingEdge {
+      std::size_t vertex; // the edge goes from this vertex to the next one in the ring
+      std::size_t neighbor;
+      bool constrained;
+    };
+
+    // gather the polygon around the vertex
 
-        Vector2f d01 = p0.position - p1.position;
-        Vector2f d12 = p1.position - p2.position;
-        Vector2f d20 = p2.position - p0.position;
+    std::vector<RingEdge> ring;
+    std::size_t start = m_pointTriangles[vertex];
+    std::size_t current = start;
 
-        float d = 2 * (p0.position.x * d12.y + p1.position.x * d20.y + p2.position.x * d01.y);
-//         assert(d > gf::Epsilon);
+    do {
+      const Triangle& triangle = m_triangles[current];
+      std::size_t i = std::find(std::begin(triangle.vertices), std::end(triangle.vertices), vertex) - std::begin(triangle.vertices);
+      assert(i < 3);
+      ring.push_back({ triangle.vertices[next(i)], triangle.neighbors[i], triangle.constrained[i] });
+      std::size_t following = triangle.neighbors[next(i)];
+      disposeTriangle(current);
+      current = following;
+      assert(current != NullIndex);
+    } while (current != start);
 
-        float l0 = gf::squareLength(p0.position);
-        float l1 = gf::squareLength(p1.position);
-        float l2 = gf::squareLength(p2.position);
+    m_pointTriangles[vertex] = NullIndex;
 
-        m_circumcircle.center.x = (l0 * d12.y + l1 * d20.y + l2 * d01.y) / d;
-        m_circumcircle.center.y = (- l0 * d12.x - l1 * d20.x - l2 * d01.x) / d;
-        m_circumcircle.radius = gf::squareDistance(m_circumcircle.center, p0.position); // save the square distance instead of distance
+    // triangulate the polygon by cutting ears
+
+    std::vector<std::array<std::size_t, 2>> edges;
+
+    auto isEar = [&](std::size_t k, bool delaunay) {
+      std::size_t count = ring.size();
+      Vector2f p0 = m_points[ring[(k + count - 1) % count].vertex];
+      Vector2f p1 = m_points[ring[k].vertex];
+      Vector2f p2 = m_points[ring[(k + 1) % count].vertex];
+
+      if (computeOrientation(p0, p1, p2) <= 0) {
+        return false;
       }
 
-      ExtendedEdge getEdge(std::size_t i) const {
-        switch (i) {
-          case 0:
-            return ExtendedEdge(*m_points[1], *m_points[2]);
-          case 1:
-            return ExtendedEdge(*m_points[2], *m_points[0]);
-          case 2:
-            return ExtendedEdge(*m_points[0], *m_points[1]);
-          default:
-            break;
+      for (std::size_t m = 0; m < count; ++m) {
+        if (m == k || m == (k + 1) % count || m == (k + count - 1) % count) {
+          continue;
         }
 
-        assert(false);
-        return ExtendedEdge(*m_points[0], *m_points[0]);
+        Vector2f q = m_points[ring[m].vertex];
+
+        if (delaunay) {
+          if (computeInCircle(p0, p1, p2, q) > 0) {
+            return false;
+          }
+        } else if (computeOrientation(p0, p1, q) >= 0 && computeOrientation(p1, p2, q) >= 0 && computeOrientation(p2, p0, q) >= 0) {
+          return false;
+        }
       }
 
-      bool hasInCircumcircle(const ExtendedVertex& v) const {
-        return gf::squareLength(v.position - m_circumcircle.center) <= m_circumcircle.radius;
+      return true;
+    };
+
+    while (ring.size() > 3) {
+      std::size_t count = ring.size();
+      std::size_t ear = NullIndex;
+
+      // an ear with an empty circumcircle is a Delaunay triangle, otherwise take any ear and flip later
+
+      for (std::size_t k = 0; k < count && ear == NullIndex; ++k) {
+        if (isEar(k, true)) {
+          ear = k;
+        }
       }
 
-      void setMarked() {
-        m_mark = true;
+      for (std::size_t k = 0; k < count && ear == NullIndex; ++k) {
+        if (isEar(k, false)) {
+          ear = k;
+        }
       }
 
-      bool isMarked() const {
-        return m_mark;
+      assert(ear != NullIndex);
+
+      RingEdge& before = ring[(ear + count - 1) % count];
+      const RingEdge& after = ring[ear];
+      std::size_t v0 = before.vertex;
+      std::size_t v2 = ring[(ear + 1) % count].vertex;
+
+      std::size_t triangle = allocateTriangle();
+      setTriangle(triangle, v0, after.vertex, v2);
+      link(triangle, 0, after.neighbor, after.constrained);
+      link(triangle, 2, before.neighbor, before.constrained);
+      edges.push_back({ v2, v0 });
+
+      before.neighbor = triangle;
+      before.constrained = false;
+      ring.erase(ring.begin() + ear);
+    }
+
+    assert(ring.size() == 3);
+    std::size_t triangle = allocateTriangle();
+    setTriangle(triangle, ring[0].vertex, ring[1].vertex, ring[2].vertex);
+    link(triangle, 0, ring[1].neighbor, ring[1].constrained);
+    link(triangle, 1, ring[2].neighbor, ring[2].constrained);
+    link(triangle, 2, ring[0].neighbor, ring[0].constrained);
+
+    m_lastTriangle = triangle;
+    restoreDelaunay(edges);
+  }
+
+  bool DelaunayTriangulation::insertConstrainedEdge(std::size_t vertex0, std::size_t vertex1) {
+    std::size_t origin = vertex0 + SuperVertexCount;
+    std::size_t target = vertex1 + SuperVertexCount;
+    assert(origin < m_points.size() && m_pointTriangles[origin] != NullIndex);
+    assert(target < m_points.size() && m_pointTriangles[target] != NullIndex);
+
+    auto constrain = [this](std::size_t triangle, std::size_t index) {
+      Triangle& current = m_triangles[triangle];
+      current.constrained[index] = true;
+
+      if (std::size_t neighbor = current.neighbors[index]; neighbor != NullIndex) {
+        std::size_t j = findEdgeIndex(neighbor, current.vertices[prev(index)], current.vertices[next(index)]);
+        m_triangles[neighbor].constrained[j] = true;
       }
+    };
 
-      bool contains(const ExtendedVertex& v) {
-        return m_points[0] == &v || m_points[1] == &v || m_points[2] == &v;
+    while (origin != target) {
+      if (Edge edge = findEdge(origin, target); edge.triangle != NullIndex) {
+        constrain(edge.triangle, edge.index);
+        return true;
       }
 
-    private:
-      CircF m_circumcircle;
-      bool m_mark;
-    };
+      Vector2f a = m_points[origin];
+      Vector2f b = m_points[target];
 
+      // find the first edge crossed by the segment around the origin
 
+      std::size_t triangle = m_pointTriangles[origin];
+      std::size_t collinear = NullIndex;
+      std::size_t crossed = NullIndex;
 
-  } // anonymous namespace
+      for (;;) {
+        const Triangle& current = m_triangles[triangle];
+        std::size_t i = std::find(std::begin(current.vertices), std::end(current.vertices), origin) - std::begin(current.vertices);
+        assert(i < 3);
+        std::size_t x = current.vertices[next(i)];
+        std::size_t y = current.vertices[prev(i)];
+        double ox = computeOrientation(a, b, m_points[x]);
+        double oy = computeOrientation(a, b, m_points[y]);
 
-  std::vector<TriangleRef<const Vector2f>> triangulation(Span<const Vector2f> points) {
-    std::vector<TriangleRef<const Vector2f>> out;
+        if (ox == 0 && gf::dot(m_points[x] - a, b - a) > 0) {
+          constrain(triangle, prev(i));
+          collinear = x;
+          break;
+        }
 
-    if (points.isEmpty()) {
-      return out;
+        if (ox < 0 && oy > 0) {
+          crossed = i;
+          break;
+        }
+
+        triangle = current.neighbors[next(i)];
+        assert(triangle != m_pointTriangles[origin]);
+      }
+
+      if (collinear != NullIndex) {
+        origin = collinear;
+        continue;
+      }
+
+      // gather the edges crossed by the segment until a vertex on the segment
+
+      std::deque<std::array<std::size_t, 2>> crossing;
+      std::size_t stop = NullIndex;
+
+      while (stop == NullIndex) {
+        const Triangle& current = m_triangles[triangle];
+
+        if (current.constrained[crossed]) {
+          return false;
+        }
+
+        std::size_t x = current.vertices[next(crossed)];
+        std::size_t y = current.vertices[prev(crossed)];
+        crossing.push_back({ x, y });
+
+        std::size_t neighbor = current.neighbors[crossed];
+        std::size_t j = findEdgeIndex(neighbor, y, x);
+        std::size_t z = m_triangles[neighbor].vertices[j];
+
+        double oz = computeOrientation(a, b, m_points[z]);
+
+        if (z == target || oz == 0) {
+          stop = z;
+        } else if (oz < 0) {
+          crossed = prev(j);
+        } else {
+          crossed = next(j);
+        }
+
+        triangle = neighbor;
+      }
+
+      // flip the crossing edges until none remains (Sloan's method)
+
+      Vector2f s = m_points[stop];
+      std::vector<std::array<std::size_t, 2>> edges;
+
+      while (!crossing.empty()) {
+        auto [ x, y ] = crossing.front();
+        crossing.pop_front();
+
+        Edge edge = findEdge(x, y);
+        assert(edge.triangle != NullIndex);
+        const Triangle& current = m_triangles[edge.triangle];
+        std::size_t p = current.vertices[edge.index];
+        std::size_t neighbor = current.neighbors[edge.index];
+        std::size_t q = m_triangles[neighbor].vertices[findEdgeIndex(neighbor, y, x)];
+
+        if (computeOrientation(m_points[p], m_points[x], m_points[q]) <= 0 || computeOrientation(m_points[p], m_points[q], m_points[y]) <= 0) {
+          crossing.push_back({ x, y });
+          continue;
+        }
+
+        flip(edge.triangle, edge.index);
+
+        double op = computeOrientation(a, s, m_points[p]);
+        double oq = computeOrientation(a, s, m_points[q]);
+
+        if (p != origin && q != origin && p != stop && q != stop && ((op < 0 && oq > 0) || (op > 0 && oq < 0))) {
+          crossing.push_back({ p, q });
+        } else {
+          edges.push_back({ p, q });
+        }
+      }
+
+      Edge edge = findEdge(origin, stop);
+      assert(edge.triangle != NullIndex);
+      constrain(edge.triangle, edge.index);
+
+      restoreDelaunay(edges);
+      origin = stop;
     }
 
-    std::vector<ExtendedVertex> vertices;
+    return true;
+  }
+
+  bool DelaunayTriangulation::isConstrainedEdge(std::size_t vertex0, std::size_t vertex1) const {
+    Edge edge = findEdge(vertex0 + SuperVertexCount, vertex1 + SuperVertexCount);
+
+    if (edge.triangle == NullIndex) {
+      return false;
+    }
 
-    // transform the input and find the surrounding triangles
+    return m_triangles[edge.triangle].constrained[edge.index];
+  }
 
-    Vector2f cornerNorthWest = points[0];
-    Vector2f cornerSouthEast = points[1];
+  Vector2f DelaunayTriangulation::getPoint(std::size_t vertex) const {
+    assert(vertex + SuperVertexCount < m_points.size());
+    return m_points[vertex + SuperVertexCount];
+  }
 
-    for (auto& p : points) {
-      vertices.push_back(ExtendedVertex(p));
+  std::size_t DelaunayTriangulation::locate(Vector2f point) const {
+    Position position = walk(point);
 
-      cornerNorthWest = gf::min(cornerNorthWest, p);
-      cornerSouthEast = gf::max(cornerSouthEast, p);
+    if (!isFinite(position.triangle)) {
+      return NullIndex;
     }
 
-    static constexpr float PaddingFactor = 10.0f;
+    return position.triangle;
+  }
 
-    auto diagonal = cornerSouthEast - cornerNorthWest;
+  std::array<std::size_t, 3> DelaunayTriangulation::getTriangle(std::size_t triangle) const {
+    assert(triangle < m_triangles.size());
+    assert(isFinite(triangle));
+    const Triangle& current = m_triangles[triangle];
+    return { current.vertices[0] - SuperVertexCount, current.vertices[1] - SuperVertexCount, current.vertices[2] - SuperVertexCount };
+  }
 
-    cornerNorthWest -= PaddingFactor * diagonal;
-    cornerSouthEast += PaddingFactor * diagonal;
+  std::vector<std::array<std::size_t, 3>> DelaunayTriangulation::getTriangles() const {
+    std::vector<std::array<std::size_t, 3>> triangles;
 
-    Vector2f cornerNorthEast(cornerSouthEast.x, cornerNorthWest.y);
-    Vector2f cornerSouthWest(cornerNorthWest.x, cornerSouthEast.y);
+    for (std::size_t i = 0; i < m_triangles.size(); ++i) {
+      if (m_triangles[i].vertices[0] != NullIndex && isFinite(i)) {
+        triangles.push_back(getTriangle(i));
+      }
+    }
 
-    ExtendedVertex extendedNorthWest(cornerNorthWest);
-    ExtendedVertex extendedNorthEast(cornerNorthEast);
-    ExtendedVertex extendedSouthWest(cornerSouthWest);
-    ExtendedVertex extendedSouthEast(cornerSouthEast);
+    return triangles;
+  }
 
-    std::vector<ExtendedTriangle> triangles;
-    triangles.push_back(ExtendedTriangle(extendedNorthWest, extendedNorthEast, extendedSouthWest));
-    triangles.push_back(ExtendedTriangle(extendedSouthWest, extendedNorthEast, extendedSouthEast));
+  DelaunayTriangulation::Position DelaunayTriangulation::walk(Vector2f point) const {
+    std::size_t triangle = m_lastTriangle;
+    uint32_t state = static_cast<uint32_t>(triangle);
 
-    // add all points to the triangulation
+    // visibility walk, the first edge to test is chosen randomly so that the walk can not loop
 
-    for (const auto& v : vertices) {
-      std::set<ExtendedEdge> polygon;
+    for (;;) {
+      const Triangle& current = m_triangles[triangle];
+      state = state * 1103515245 + 12345;
+      std::size_t first = (state >> 16) % 3;
+      std::size_t following = NullIndex;
 
-      auto updatePolygon = [&polygon](const ExtendedEdge& e) {
-        auto res = polygon.insert(e);
+      for (std::size_t k = 0; k < 3; ++k) {
+        std::size_t i = (first + k) % 3;
 
-        if (!res.second) {
-          res.first->setMarked();
+        if (computeOrientation(m_points[current.vertices[next(i)]], m_points[current.vertices[prev(i)]], point) < 0) {
+          following = current.neighbors[i];
+          break;
         }
-      };
+      }
 
-      for (auto& t : triangles) {
-        if (t.hasInCircumcircle(v)) {
-          t.setMarked();
-          updatePolygon(t.getEdge(0));
-          updatePolygon(t.getEdge(1));
-          updatePolygon(t.getEdge(2));
-        }
+      if (following == NullIndex) {
+        break;
+      }
+
+      triangle = following;
+    }
+
+    const Triangle& current = m_triangles[triangle];
+    std::size_t zeroCount = 0;
+    std::size_t zeroIndex = 0;
+    std::size_t otherIndex = 0;
+
+    for (std::size_t i = 0; i < 3; ++i) {
+      if (computeOrientation(m_points[current.vertices[next(i)]], m_points[current.vertices[prev(i)]], point) == 0) {
+        ++zeroCount;
+        zeroIndex = i;
+      } else {
+        otherIndex = i;
       }
+    }
+
+    switch (zeroCount) {
+      case 0:
+        return { triangle, Location::Inside, 0 };
+      case 1:
+        return { triangle, Location::OnEdge, zeroIndex };
+      default:
+        break;
+    }
 
-      triangles.erase(std::remove_if(triangles.begin(), triangles.end(), [](const ExtendedTriangle& t) {
-        return t.isMarked();
-      }), triangles.end());
+    return { triangle, Location::OnVertex, otherIndex };
+  }
+
+  DelaunayTriangulation::Edge DelaunayTriangulation::findEdge(std::size_t vertex0, std::size_t vertex1) const {
+    std::size_t start = m_pointTriangles[vertex0];
+
+    if (start == NullIndex) {
+      return { NullIndex, 0 };
+    }
 
-      for (auto& e : polygon) {
-        if (!e.isMarked()) {
-          triangles.push_back(ExtendedTriangle(v, e[0], e[1]));
+    // turn around the vertex in both directions as a super vertex is on the border
+
+    for (bool forward : { true, false }) {
+      std::size_t triangle = start;
+
+      do {
+        const Triangle& current = m_triangles[triangle];
+        std::size_t i = std::find(std::begin(current.vertices), std::end(current.vertices), vertex0) - std::begin(current.vertices);
+        assert(i < 3);
+
+        if (current.vertices[next(i)] == vertex1) {
+          return { triangle, prev(i) };
         }
+
+        triangle = forward ? current.neighbors[next(i)] : current.neighbors[prev(i)];
+      } while (triangle != NullIndex && triangle != start);
+
+      if (triangle == start) {
+        break;
+      }
+    }
+
+    return { NullIndex, 0 };
+  }
+
+  std::size_t DelaunayTriangulation::findEdgeIndex(std::size_t triangle, std::size_t vertex0, std::size_t vertex1) const {
+    const Triangle& current = m_triangles[triangle];
+
+    for (std::size_t i = 0; i < 3; ++i) {
+      if (current.vertices[next(i)] == vertex0 && current.vertices[prev(i)] == vertex1) {
+        return i;
+      }
+    }
+
+    assert(false);
+    return NullIndex;
+  }
+
+  bool DelaunayTriangulation::isFinite(std::size_t triangle) const {
+    const Triangle& current = m_triangles[triangle];
+    return current.vertices[0] >= SuperVertexCount && current.vertices[1] >= SuperVertexCount && current.vertices[2] >= SuperVertexCount;
+  }
+
+  std::size_t DelaunayTriangulation::allocateTriangle() {
+    if (!m_freeTriangles.empty()) {
+      std::size_t triangle = m_freeTriangles.back();
+      m_freeTriangles.pop_back();
+      return triangle;
+    }
+
+    m_triangles.push_back(Triangle());
+    return m_triangles.size() - 1;
+  }
+
+  void DelaunayTriangulation::disposeTriangle(std::size_t triangle) {
+    m_triangles[triangle].vertices[0] = NullIndex;
+    m_freeTriangles.push_back(triangle);
+  }
+
+  void DelaunayTriangulation::setTriangle(std::size_t triangle, std::size_t vertex0, std::size_t vertex1, std::size_t vertex2) {
+    Triangle& current = m_triangles[triangle];
+    current.vertices[0] = vertex0;
+    current.vertices[1] = vertex1;
+    current.vertices[2] = vertex2;
+
+    for (std::size_t i = 0; i < 3; ++i) {
+      current.neighbors[i] = NullIndex;
+      current.constrained[i] = false;
+      m_pointTriangles[current.vertices[i]] = triangle;
+    }
+  }
+
+  void DelaunayTriangulation::link(std::size_t triangle, std::size_t index, std::size_t neighbor, bool constrained) {
+    Triangle& current = m_triangles[triangle];
+    current.neighbors[index] = neighbor;
+    current.constrained[index] = constrained;
+
+    if (neighbor != NullIndex) {
+      std::size_t j = findEdgeIndex(neighbor, current.vertices[prev(index)], current.vertices[next(index)]);
+      m_triangles[neighbor].neighbors[j] = triangle;
+      m_triangles[neighbor].constrained[j] = constrained;
+    }
+  }
+
+  bool DelaunayTriangulation::shouldFlip(std::size_t triangle, std::size_t index) const {
+    const Triangle& current = m_triangles[triangle];
+    std::size_t neighbor = current.neighbors[index];
+
+    if (neighbor == NullIndex || current.constrained[index]) {
+      return false;
+    }
+
+    Vector2f p = m_points[current.vertices[index]];
+    Vector2f a = m_points[current.vertices[next(index)]];
+    Vector2f b = m_points[current.vertices[prev(index)]];
+    Vector2f q = m_points[m_triangles[neighbor].vertices[findEdgeIndex(neighbor, current.vertices[prev(index)], current.vertices[next(index)])]];
+
+    if (computeOrientation(p, a, q) <= 0 || computeOrientation(p, q, b) <= 0) {
+      return false;
+    }
+
+    return computeInCircle(p, a, b, q) > 0;
+  }
+
+  void DelaunayTriangulation::flip(std::size_t triangle, std::size_t index) {
+    // (p, a, b) + (q, b, a) becomes (p, a, q) + (p, q, b)
+    const Triangle old0 = m_triangles[triangle];
+    std::size_t neighbor = old0.neighbors[index];
+    std::size_t j = findEdgeIndex(neighbor, old0.vertices[prev(index)], old0.vertices[next(index)]);
+    const Triangle old1 = m_triangles[neighbor];
+
+    std::size_t p = old0.vertices[index];
+    std::size_t a = old0.vertices[next(index)];
+    std::size_t b = old0.vertices[prev(index)];
+    std::size_t q = old1.vertices[j];
+
+    setTriangle(triangle, p, a, q);
+    setTriangle(neighbor, p, q, b);
+
+    link(triangle, 0, old1.neighbors[next(j)], old1.constrained[next(j)]);
+    link(triangle, 1, neighbor, false);
+    link(triangle, 2, old0.neighbors[prev(index)], old0.constrained[prev(index)]);
+    link(neighbor, 0, old1.neighbors[prev(j)], old1.constrained[prev(j)]);
+    link(neighbor, 1, old0.neighbors[next(index)], old0.constrained[next(index)]);
+  }
+
+  void DelaunayTriangulation::legalize(std::vector<std::size_t>& triangles) {
+    // the new vertex is the first vertex of each triangle, and stays first after a flip
+    while (!triangles.empty()) {
+      std::size_t triangle = triangles.back();
+      triangles.pop_back();
+
+      if (shouldFlip(triangle, 0)) {
+        std::size_t neighbor = m_triangles[triangle].neighbors[0];
+        flip(triangle, 0);
+        triangles.push_back(triangle);
+        triangles.push_back(neighbor);
       }
     }
+  }
 
-    // create the output
+  void DelaunayTriangulation::restoreDelaunay(std::vector<std::array<std::size_t, 2>>& edges) {
+    while (!edges.empty()) {
+      auto [ a, b ] = edges.back();
+      edges.pop_back();
 
-    for (auto& t : triangles) {
-      if (t.contains(extendedNorthWest) || t.contains(extendedNorthEast) || t.contains(extendedSouthWest) || t.contains(extendedSouthEast)) {
+      Edge edge = findEdge(a, b);
+
+      if (edge.triangle == NullIndex || !shouldFlip(edge.triangle, edge.index)) {
         continue;
       }
 
-      out.push_back(TriangleRef<const Vector2f>(*t[0].origin, *t[1].origin, *t[2].origin));
+      std::size_t neighbor = m_triangles[edge.triangle].neighbors[edge.index];
+      flip(edge.triangle, edge.index);
+
+      for (std::size_t triangle : { edge.triangle, neighbor }) {
+        const Triangle& current = m_triangles[triangle];
+
+        for (std::size_t i = 0; i < 3; ++i) {
+          edges.push_back({ current.vertices[next(i)], current.vertices[prev(i)] });
+        }
+      }
     }
+  }
+
+  /*
+   * triangulation
+   */
+
+  namespace {
+
+    std::vector<TriangleRef<const Vector2f>> computeTriangulation(Span<const Vector2f> points, Span<const EdgeRef<Vector2f>> constrainedEdges) {
+      std::vector<TriangleRef<const Vector2f>> out;
+
+      if (points.isEmpty()) {
+        return out;
+      }
+
+      Vector2f min = points[0];
+      Vector2f max = points[0];
+
+      for (auto& point : points) {
+        min = gf::min(min, point);
+        max = gf::max(max, point);
+      }
+
+      RectF bounds = RectF::fromMinMax(min, max);
+      DelaunayTriangulation delaunay(bounds);
+
+      // insert the points along a Hilbert curve so that the walk is short
+
+      std::vector<std::pair<uint64_t, std::size_t>> order;
+      order.reserve(points.getSize());
+
+      Vector2f size = gf::max(bounds.getSize(), gf::vec(1e-6f, 1e-6f));
+
+      for (std::size_t i = 0; i < points.getSize(); ++i) {
+        Vector2f relative = (points[i] - min) / size * 65535.0f;
+        order.push_back({ computeHilbertIndex(static_cast<uint32_t>(relative.x), static_cast<uint32_t>(relative.y)), i });
+      }
+
+      std::sort(order.begin(), order.end());
+
+      std::vector<std::size_t> vertices(points.getSize());
+      std::vector<std::size_t> origins;
+
+      for (auto& item : order) {
+        std::size_t vertex = delaunay.insertPoint(points[item.second]);
+        vertices[item.second] = vertex;
+
+        if (vertex == origins.size()) {
+          origins.push_back(item.second);
+        }
+      }
+
+      for (auto& edge : constrainedEdges) {
+        std::size_t index0 = static_cast<std::size_t>(&edge[0] - points.getData());
+        std::size_t index1 = static_cast<std::size_t>(&edge[1] - points.getData());
+        assert(index0 < points.getSize() && index1 < points.getSize());
+        delaunay.insertConstrainedEdge(vertices[index0], vertices[index1]);
+      }
+
+      for (auto& triangle : delaunay.getTriangles()) {
+        out.push_back(TriangleRef<const Vector2f>(points[origins[triangle[0]]], points[origins[triangle[1]]], points[origins[triangle[2]]]));
+      }
+
+      return out;
+    }
+
+  } // anonymous namespace
+
+  std::vector<TriangleRef<const Vector2f>> triangulation(Span<const Vector2f> points) {
+    return computeTriangulation(points, nullptr);
+  }
 
-    return out;
+  std::vector<TriangleRef<const Vector2f>> triangulationConstrained(Span<const Vector2f> points, Span<const EdgeRef<Vector2f>> constrainedEdges) {
+    return computeTriangulation(points, constrainedEdges);
   }
 
 #ifndef DOXYGEN_SHOULD_SKIP_THIS
@@ -0,0 +1,140 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/BroadPhase.h>
+
+#include <algorithm>
+
+#include <gf/Random.h>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+  constexpr gf::RectF Bounds = gf::RectF::fromPositionSize({ 0.0f, 0.0f }, { 100.0f, 100.0f });
+  constexpr std::size_t SampleSize = 2000;
+  constexpr std::size_t FrameCount = 10;
+
+  gf::RectF getRandomBox(gf::Random& random) {
+    gf::RectF rect;
+
+    for (std::size_t j = 0; j < 2; ++j) {
+      rect.min[j] = random.computeUniformFloat(0.0f, 95.0f);
+      rect.max[j] = rect.min[j] + random.computeUniformFloat(1.0f, 5.0f);
+    }
+
+    return rect;
+  }
+
+  std::vector<gf::BroadPhasePair> computeNaivePairs(const std::vector<gf::RectF>& boxes, const std::vector<gf::SpatialId>& ids) {
+    std::vector<gf::BroadPhasePair> pairs;
+
+    for (std::size_t i = 0; i < boxes.size(); ++i) {
+      for (std::size_t j = i + 1; j < boxes.size(); ++j) {
+        if (boxes[i].intersects(boxes[j])) {
+          pairs.push_back({ std::min(ids[i], ids[j]), std::max(ids[i], ids[j]) });
+        }
+      }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+  }
+
+}
+
+TEST(BroadPhaseTest, Simple) {
+  gf::BroadPhase broadPhase;
+
+  auto id0 = broadPhase.insert(gf::Handle(0), gf::RectF::fromPositionSize({ 0.0f, 0.0f }, { 10.0f, 10.0f }));
+  auto id1 = broadPhase.insert(gf::Handle(1), gf::RectF::fromPositionSize({ 5.0f, 5.0f }, { 10.0f, 10.0f }));
+  auto id2 = broadPhase.insert(gf::Handle(2), gf::RectF::fromPositionSize({ 50.0f, 50.0f }, { 10.0f, 10.0f }));
+
+  EXPECT_EQ(broadPhase[id2].asId(), 2u);
+
+  auto pairs = broadPhase.updatePairs();
+  ASSERT_EQ(pairs.size(), 1u);
+  EXPECT_EQ(pairs[0].first, std::min(id0, id1));
+  EXPECT_EQ(pairs[0].second, std::max(id0, id1));
+
+  // nothing moved
+  EXPECT_TRUE(broadPhase.updatePairs().empty());
+
+  broadPhase.modify(id2, gf::RectF::fromPositionSize({ 8.0f, 8.0f }, { 10.0f, 10.0f }));
+  pairs = broadPhase.updatePairs();
+  EXPECT_EQ(pairs.size(), 2u);
+  EXPECT_EQ(broadPhase.getStatistics().queries, 1u);
+
+  broadPhase.modify(id1, gf::RectF::fromPositionSize({ 80.0f, 80.0f }, { 10.0f, 10.0f }));
+  broadPhase.remove(id1);
+  pairs = broadPhase.updatePairs();
+  EXPECT_TRUE(pairs.empty());
+  EXPECT_EQ(broadPhase.getStatistics().queries, 0u);
+}
+
+TEST(BroadPhaseTest, RandomAgainstNaive) {
+  gf::Random random(42);
+  gf::BroadPhase broadPhase(0.5f);
+
+  std::vector<gf::RectF> boxes;
+  std::vector<gf::SpatialId> ids;
+
+  for (std::size_t i = 0; i < SampleSize; ++i) {
+    boxes.push_back(getRandomBox(random));
+    ids.push_back(broadPhase.insert(gf::Handle(i), boxes.back()));
+  }
+
+  for (std::size_t frame = 0; frame < FrameCount; ++frame) {
+    // every object moves, so every pair must be found
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      gf::Vector2f displacement = random.computePosition(gf::RectF::fromMinMax({ -0.5f, -0.5f }, { 0.5f, 0.5f }));
+      boxes[i] = gf::RectF::fromPositionSize(boxes[i].getPosition() + displacement, boxes[i].getSize());
+      broadPhase.modify(ids[i], boxes[i], displacement);
+    }
+
+    auto pairs = broadPhase.updatePairs();
+    auto reference = computeNaivePairs(boxes, ids);
+
+    EXPECT_EQ(pairs, reference);
+    EXPECT_EQ(broadPhase.getStatistics().pairs, reference.size());
+    EXPECT_EQ(broadPhase.getStatistics().queries, SampleSize);
+  }
+
+  // only some objects move, only their pairs are found
+  std::vector<bool> moved(SampleSize, false);
+
+  for (std::size_t i = 0; i < SampleSize; i += 7) {
+    boxes[i] = getRandomBox(random);
+    broadPhase.modify(ids[i], boxes[i]);
+    moved[i] = true;
+  }
+
+  auto pairs = broadPhase.updatePairs();
+  auto reference = computeNaivePairs(boxes, ids);
+
+  reference.erase(std::remove_if(reference.begin(), reference.end(), [&](const gf::BroadPhasePair& pair) {
+    auto first = std::find(ids.begin(), ids.end(), pair.first) - ids.begin();
+    auto second = std::find(ids.begin(), ids.end(), pair.second) - ids.begin();
+    return !moved[first] && !moved[second];
+  }), reference.end());
+
+  EXPECT_EQ(pairs, reference);
+  EXPECT_EQ(broadPhase.getStatistics().queries, (SampleSize + 6) / 7);
+}
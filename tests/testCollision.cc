@@ -0,0 +1,313 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/Collision.h>
+
+#include <iostream>
+
+#include <gf/Clock.h>
+#include <gf/Math.h>
+#include <gf/Random.h>
+#include <gf/Transform.h>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+  constexpr std::size_t PolygonCount = 2000;
+  constexpr std::size_t PairCount = 20000;
+
+  struct Body {
+    gf::Polygon polygon;
+    gf::Transform transform;
+  };
+
+  gf::Polygon getRandomPolygon(gf::Random& random) {
+    gf::Polygon polygon;
+    int count = random.computeUniformInteger(3, 8);
+    float radius = random.computeUniformFloat(1.0f, 5.0f);
+
+    for (int i = 0; i < count; ++i) {
+      float angle = (i + random.computeUniformFloat(0.0f, 0.5f)) * 2.0f * gf::Pi / count;
+      polygon.addPoint(radius * gf::unit(angle));
+    }
+
+    return polygon;
+  }
+
+  std::vector<Body> getRandomBodies(gf::Random& random) {
+    std::vector<Body> bodies;
+
+    for (std::size_t i = 0; i < PolygonCount; ++i) {
+      gf::Transform transform(random.computeAngle(), random.computePosition(gf::RectF::fromSize({ 100.0f, 100.0f })));
+      bodies.push_back({ getRandomPolygon(random), transform });
+    }
+
+    return bodies;
+  }
+
+  std::vector<std::pair<std::size_t, std::size_t>> getRandomPairs(gf::Random& random, const std::vector<Body>& bodies) {
+    std::vector<std::pair<std::size_t, std::size_t>> pairs;
+
+    // close enough to collide quite often
+    while (pairs.size() < PairCount) {
+      std::size_t first = random.computeUniformInteger<std::size_t>(0, bodies.size() - 1);
+      std::size_t second = random.computeUniformInteger<std::size_t>(0, bodies.size() - 1);
+
+      if (first != second && gf::euclideanDistance(bodies[first].transform.translation.offset, bodies[second].transform.translation.offset) < 15.0f) {
+        pairs.emplace_back(first, second);
+      }
+    }
+
+    return pairs;
+  }
+
+}
+
+TEST(CollisionTest, PolygonBatch) {
+  gf::Random random(42);
+  auto bodies = getRandomBodies(random);
+  auto pairs = getRandomPairs(random, bodies);
+
+  gf::PolygonCollisionBatch batch;
+
+  for (int frame = 0; frame < 2; ++frame) {
+    batch.clear();
+
+    for (auto& body : bodies) {
+      batch.addPolygon(body.polygon, body.transform);
+    }
+
+    for (auto& pair : pairs) {
+      batch.addPair(pair.first, pair.second);
+    }
+
+    std::vector<gf::PolygonCollision> expected;
+
+    for (auto& pair : pairs) {
+      gf::PolygonCollision collision;
+
+      if (gf::collides(bodies[pair.first].polygon, bodies[pair.first].transform, bodies[pair.second].polygon, bodies[pair.second].transform, collision.penetration)) {
+        collision.first = pair.first;
+        collision.second = pair.second;
+        expected.push_back(collision);
+      }
+    }
+
+    EXPECT_GT(expected.size(), 0u);
+
+    for (std::size_t threadCount : { 1, 3, 0 }) {
+      auto& collisions = batch.computeCollisions(threadCount);
+      ASSERT_EQ(collisions.size(), expected.size());
+
+      for (std::size_t i = 0; i < collisions.size(); ++i) {
+        EXPECT_EQ(collisions[i].first, expected[i].first);
+        EXPECT_EQ(collisions[i].second, expected[i].second);
+        EXPECT_NEAR(collisions[i].penetration.depth, expected[i].penetration.depth, 1e-3f);
+        EXPECT_NEAR(collisions[i].penetration.normal.x, expected[i].penetration.normal.x, 1e-3f);
+        EXPECT_NEAR(collisions[i].penetration.normal.y, expected[i].penetration.normal.y, 1e-3f);
+      }
+    }
+  }
+}
+
+TEST(CollisionTest, DISABLED_PolygonBatchBenchmark) {
+  gf::Random random(42);
+  auto bodies = getRandomBodies(random);
+  auto pairs = getRandomPairs(random, bodies);
+
+  gf::Clock clock;
+
+  std::size_t singleFound = 0;
+  gf::Penetration penetration;
+
+  for (auto& pair : pairs) {
+    if (gf::collides(bodies[pair.first].polygon, bodies[pair.first].transform, bodies[pair.second].polygon, bodies[pair.second].transform, penetration)) {
+      ++singleFound;
+    }
+  }
+
+  gf::Time singleTime = clock.restart();
+
+  gf::PolygonCollisionBatch batch;
+  std::size_t batchFound = 0;
+
+  for (int frame = 0; frame < 2; ++frame) {
+    clock.restart(); // the first frame allocates the buffers
+
+    batch.clear();
+
+    for (auto& body : bodies) {
+      batch.addPolygon(body.polygon, body.transform);
+    }
+
+    for (auto& pair : pairs) {
+      batch.addPair(pair.first, pair.second);
+    }
+
+    batchFound = batch.computeCollisions().size();
+  }
+
+  gf::Time batchTime = clock.restart();
+
+  EXPECT_EQ(singleFound, batchFound);
+
+  std::cout << "Polygon pairs: " << pairs.size() << ", collisions: " << batchFound << '\n';
+  std::cout << "Single time: " << singleTime.asMicroseconds() << "us, batch time: " << batchTime.asMicroseconds() << "us\n";
+}
+
+namespace {
+
+  gf::Polygon getBox(gf::Vector2f size) {
+    gf::Polygon polygon;
+    polygon.addPoint({ 0.0f, 0.0f });
+    polygon.addPoint({ size.width, 0.0f });
+    polygon.addPoint({ size.width, size.height });
+    polygon.addPoint({ 0.0f, size.height });
+    return polygon;
+  }
+
+}
+
+TEST(CollisionTest, ImpactCircleRect) {
+  gf::RectF wall = gf::RectF::fromPositionSize({ 50.0f, 0.0f }, { 1.0f, 10.0f });
+  gf::CircF bullet({ 0.0f, 5.0f }, 1.0f);
+  gf::Impact impact;
+
+  // the bullet would tunnel through the wall with a discrete test at the end of the step
+  gf::Penetration penetration;
+  EXPECT_FALSE(gf::collides(gf::CircF({ 100.0f, 5.0f }, 1.0f), wall, penetration));
+
+  ASSERT_TRUE(gf::computeImpact(bullet, { 100.0f, 0.0f }, wall, { 0.0f, 0.0f }, impact));
+  EXPECT_FLOAT_EQ(impact.time, 0.49f);
+  EXPECT_FLOAT_EQ(impact.normal.x, 1.0f);
+  EXPECT_FLOAT_EQ(impact.normal.y, 0.0f);
+
+  // the wall moves too
+  ASSERT_TRUE(gf::computeImpact(bullet, { 50.0f, 0.0f }, wall, { -50.0f, 0.0f }, impact));
+  EXPECT_FLOAT_EQ(impact.time, 0.49f);
+
+  ASSERT_TRUE(gf::computeImpact(wall, { 0.0f, 0.0f }, bullet, { 100.0f, 0.0f }, impact));
+  EXPECT_FLOAT_EQ(impact.time, 0.49f);
+  EXPECT_FLOAT_EQ(impact.normal.x, -1.0f);
+
+  // too short or wrong direction
+  EXPECT_FALSE(gf::computeImpact(bullet, { 40.0f, 0.0f }, wall, { 0.0f, 0.0f }, impact));
+  EXPECT_FALSE(gf::computeImpact(bullet, { -100.0f, 0.0f }, wall, { 0.0f, 0.0f }, impact));
+  EXPECT_FALSE(gf::computeImpact(bullet, { 100.0f, 20.0f }, wall, { 0.0f, 0.0f }, impact));
+
+  // on a corner
+  gf::CircF corner({ 40.0f, -10.0f }, 1.0f);
+  ASSERT_TRUE(gf::computeImpact(corner, { 20.0f, 20.0f }, wall, { 0.0f, 0.0f }, impact));
+  gf::Vector2f center = corner.getCenter() + impact.time * gf::Vector2f(20.0f, 20.0f);
+  EXPECT_NEAR(gf::euclideanDistance(center, { 50.0f, 0.0f }), 1.0f, 1e-4f);
+  EXPECT_NEAR(impact.normal.x, impact.normal.y, 1e-4f);
+
+  // passing near a corner
+  EXPECT_FALSE(gf::computeImpact(gf::CircF({ 45.0f, 3.3f }, 1.0f), { 10.0f, -10.0f }, wall, { 0.0f, 0.0f }, impact));
+
+  // already overlapping
+  ASSERT_TRUE(gf::computeImpact(gf::CircF({ 49.5f, 5.0f }, 1.0f), { 0.0f, 0.0f }, wall, { 0.0f, 0.0f }, impact));
+  EXPECT_FLOAT_EQ(impact.time, 0.0f);
+  EXPECT_FLOAT_EQ(impact.normal.x, 1.0f);
+}
+
+TEST(CollisionTest, ImpactCirclePolygon) {
+  gf::Random random(42);
+  gf::RectF wall = gf::RectF::fromPositionSize({ 50.0f, 0.0f }, { 1.0f, 10.0f });
+  gf::Polygon box = getBox(wall.getSize());
+  gf::Impact impact;
+
+  // same results as the rectangle
+  for (int i = 0; i < 1000; ++i) {
+    gf::CircF circle(random.computePosition(gf::RectF::fromSize({ 100.0f, 20.0f })), 1.0f);
+    gf::Vector2f motion = random.computePosition(gf::RectF::fromPositionSize({ -50.0f, -10.0f }, { 100.0f, 20.0f }));
+
+    gf::Impact expected;
+    bool hit = gf::computeImpact(circle, motion, wall, { 0.0f, 0.0f }, expected);
+    ASSERT_EQ(gf::computeImpact(circle, gf::Transform(), motion, box, gf::Transform(wall.min), { 0.0f, 0.0f }, impact), hit);
+
+    if (hit) {
+      EXPECT_NEAR(impact.time, expected.time, 1e-4f);
+      EXPECT_NEAR(impact.normal.x, expected.normal.x, 1e-3f);
+      EXPECT_NEAR(impact.normal.y, expected.normal.y, 1e-3f);
+    }
+  }
+
+  // rotated polygon
+  gf::Transform transform(gf::Pi / 2, { 51.0f, 0.0f });
+  ASSERT_TRUE(gf::computeImpact(getBox({ 10.0f, 1.0f }), transform, { 0.0f, 0.0f }, gf::CircF({ 0.0f, 5.0f }, 1.0f), gf::Transform(), { 100.0f, 0.0f }, impact));
+  EXPECT_NEAR(impact.time, 0.49f, 1e-5f);
+  EXPECT_NEAR(impact.normal.x, -1.0f, 1e-5f);
+}
+
+TEST(CollisionTest, ImpactPolygonPolygon) {
+  gf::Polygon wall = getBox({ 1.0f, 10.0f });
+  gf::Polygon bullet = getBox({ 1.0f, 1.0f });
+  gf::Transform wallTransform({ 50.0f, 0.0f });
+  gf::Impact impact;
+
+  ASSERT_TRUE(gf::computeImpact(bullet, gf::Transform({ 0.0f, 4.0f }), { 100.0f, 0.0f }, wall, wallTransform, { 0.0f, 0.0f }, impact));
+  EXPECT_NEAR(impact.time, 0.49f, 1e-3f);
+  EXPECT_NEAR(impact.normal.x, 1.0f, 1e-5f);
+  EXPECT_NEAR(impact.normal.y, 0.0f, 1e-5f);
+
+  // rotated bullet, oblique motion
+  ASSERT_TRUE(gf::computeImpact(bullet, gf::Transform(gf::Pi / 4, { 0.0f, 0.0f }), { 100.0f, 10.0f }, wall, wallTransform, { 0.0f, 0.0f }, impact));
+  float expected = (50.0f - std::sqrt(2.0f) / 2) / 100.0f;
+  EXPECT_NEAR(impact.time, expected, 1e-3f);
+  EXPECT_GE(impact.time, expected - 1e-3f);
+
+  EXPECT_FALSE(gf::computeImpact(bullet, gf::Transform({ 0.0f, 4.0f }), { 40.0f, 0.0f }, wall, wallTransform, { 0.0f, 0.0f }, impact));
+  EXPECT_FALSE(gf::computeImpact(bullet, gf::Transform({ 0.0f, 20.0f }), { 100.0f, 0.0f }, wall, wallTransform, { 0.0f, 0.0f }, impact));
+  EXPECT_FALSE(gf::computeImpact(bullet, gf::Transform({ 0.0f, 4.0f }), { -100.0f, 0.0f }, wall, wallTransform, { 0.0f, 0.0f }, impact));
+
+  // already overlapping
+  ASSERT_TRUE(gf::computeImpact(bullet, gf::Transform({ 49.5f, 4.0f }), { 0.0f, 0.0f }, wall, wallTransform, { 0.0f, 0.0f }, impact));
+  EXPECT_FLOAT_EQ(impact.time, 0.0f);
+  EXPECT_FLOAT_EQ(impact.normal.x, 1.0f);
+}
+
+TEST(CollisionTest, ImpactPolygonPolygonGrazing) {
+  gf::Polygon wall = getBox({ 1.0f, 10.0f });
+  gf::Transform wallTransform({ 50.0f, 0.0f });
+  gf::Impact impact;
+
+  // the sharp corner of the triangle passes the corner of the wall at a distance above the tolerance
+  gf::Polygon triangle;
+  triangle.addPoint({ 0.0f, 0.0f });
+  triangle.addPoint({ -1.0f, -2.0f });
+  triangle.addPoint({ -2.0f, -1.0f });
+
+  for (float length : { 100.0f, 1e4f }) {
+    for (float direction : { -0.2f, -gf::Pi / 4, -1.4f }) {
+      gf::Vector2f motion = length * gf::unit(direction);
+      gf::Vector2f position = gf::Vector2f(50.0f, 0.0f) + 0.02f * gf::unit(direction - gf::Pi / 2) - 0.5f * motion;
+      EXPECT_FALSE(gf::computeImpact(triangle, gf::Transform(position), motion, wall, wallTransform, { 0.0f, 0.0f }, impact)) << length << ", " << direction;
+    }
+  }
+
+  // a long motion, the positions along the motion are less precise than the tolerance
+  gf::Polygon bullet = getBox({ 1.0f, 1.0f });
+  gf::Vector2f motion = 8e5f * gf::unit(-0.3f);
+  gf::Vector2f position = gf::Vector2f(50.0f, 0.0f) + 0.04f * gf::unit(-0.3f - gf::Pi / 2) - 0.5f * motion;
+  ASSERT_TRUE(gf::computeImpact(bullet, gf::Transform(2.0f, position), motion, wall, wallTransform, { 0.0f, 0.0f }, impact));
+  EXPECT_NEAR(impact.time, 0.5f, 1e-5f);
+}
@@ -0,0 +1,441 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/Heightmap.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gf/Clock.h>
+#include <gf/HeightmapChunkGenerator.h>
+#include <gf/Noises.h>
+#include <gf/Random.h>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+  gf::Heightmap getRandomHeightmap(gf::Vector2i size) {
+    gf::Random random(42);
+    gf::PerlinNoise2D noise(random, 1.0);
+    gf::Heightmap heightmap(size);
+    heightmap.addNoise(noise, 0.25);
+    heightmap.normalize();
+    return heightmap;
+  }
+
+  double computeMaxDifference(const gf::Heightmap& lhs, const gf::Heightmap& rhs) {
+    double difference = 0.0;
+
+    for (int y = 0; y < lhs.getSize().height; ++y) {
+      for (int x = 0; x < lhs.getSize().width; ++x) {
+        difference = std::max(difference, std::abs(lhs.getValue({ x, y }) - rhs.getValue({ x, y })));
+      }
+    }
+
+    return difference;
+  }
+
+  // with floats, a comparison with the talus can give a different result, so
+  // some cells may differ more than the rounding errors
+  double computeMeanDifference(const gf::Heightmap& lhs, const gf::Heightmap& rhs) {
+    double difference = 0.0;
+
+    for (int y = 0; y < lhs.getSize().height; ++y) {
+      for (int x = 0; x < lhs.getSize().width; ++x) {
+        difference += std::abs(lhs.getValue({ x, y }) - rhs.getValue({ x, y }));
+      }
+    }
+
+    return difference / (lhs.getSize().width * lhs.getSize().height);
+  }
+
+  enum class Erosion {
+    Thermal,
+    Hydraulic,
+    Fast,
+  };
+
+  constexpr const char *ErosionNames[] = { "Thermal", "Hydraulic", "Fast" };
+
+  void applyErosion(gf::Heightmap& heightmap, Erosion erosion, unsigned iterations) {
+    const double talus = 4.0 / heightmap.getSize().width;
+
+    switch (erosion) {
+      case Erosion::Thermal:
+        heightmap.thermalErosion(iterations, talus, 0.5);
+        break;
+      case Erosion::Hydraulic:
+        heightmap.hydraulicErosion(iterations, 0.01, 0.01, 0.5, 0.01);
+        break;
+      case Erosion::Fast:
+        heightmap.fastErosion(iterations, 2 * talus, 0.5);
+        break;
+    }
+  }
+
+  void applyParallelErosion(gf::Heightmap& heightmap, Erosion erosion, unsigned iterations, gf::Heightmap::Precision precision) {
+    const double talus = 4.0 / heightmap.getSize().width;
+
+    switch (erosion) {
+      case Erosion::Thermal:
+        heightmap.parallelThermalErosion(iterations, talus, 0.5, precision);
+        break;
+      case Erosion::Hydraulic:
+        heightmap.parallelHydraulicErosion(iterations, 0.01, 0.01, 0.5, 0.01, precision);
+        break;
+      case Erosion::Fast:
+        heightmap.parallelFastErosion(iterations, 2 * talus, 0.5, precision);
+        break;
+    }
+  }
+
+}
+
+TEST(HeightmapTest, AddNoise) {
+  static constexpr gf::Vector2d Origin = { -3.5, 12.25 };
+  static constexpr gf::Vector2d Step = { 0.125, 0.0625 };
+  const gf::Vector2i Size = { 37, 23 };
+
+  gf::Random random(42);
+  gf::SimplexNoise2D noise(random);
+
+  std::vector<double> expected(static_cast<std::size_t>(Size.width) * static_cast<std::size_t>(Size.height));
+  noise.fillGrid(Origin, Step, Size, expected);
+
+  // the heights get the same samples as a whole grid, whatever the storage
+  for (auto storage : { gf::Heightmap::Storage::Double, gf::Heightmap::Storage::Float }) {
+    gf::Heightmap heightmap(Size, storage);
+    heightmap.addNoise(noise, Origin, Step);
+
+    for (int y = 0; y < Size.height; ++y) {
+      for (int x = 0; x < Size.width; ++x) {
+        double value = expected[static_cast<std::size_t>(y) * Size.width + x];
+
+        if (storage == gf::Heightmap::Storage::Float) {
+          value = static_cast<float>(value);
+        }
+
+        EXPECT_EQ(heightmap.getValue({ x, y }), value);
+      }
+    }
+  }
+}
+
+TEST(HeightmapTest, ParallelErosion) {
+  for (auto erosion : { Erosion::Thermal, Erosion::Hydraulic, Erosion::Fast }) {
+    // the first and the last iterations convert the heights when the precision is not the storage
+    for (unsigned iterations : { 1u, 2u, 20u }) {
+      gf::Heightmap serial = getRandomHeightmap({ 100, 70 });
+      gf::Heightmap parallel = serial;
+      gf::Heightmap parallelFloat = serial;
+      gf::Heightmap parallelFloatStorage = serial.convertTo(gf::Heightmap::Storage::Float);
+
+      applyErosion(serial, erosion, iterations);
+      applyParallelErosion(parallel, erosion, iterations, gf::Heightmap::Precision::Double);
+      applyParallelErosion(parallelFloat, erosion, iterations, gf::Heightmap::Precision::Float);
+      applyParallelErosion(parallelFloatStorage, erosion, iterations, gf::Heightmap::Precision::Float);
+
+      EXPECT_LT(computeMaxDifference(serial, parallel), 1e-9) << ErosionNames[static_cast<int>(erosion)] << ", " << iterations;
+      EXPECT_LT(computeMeanDifference(serial, parallelFloat), 1e-3) << ErosionNames[static_cast<int>(erosion)] << ", " << iterations;
+      EXPECT_EQ(computeMaxDifference(parallelFloat, parallelFloatStorage), 0.0) << ErosionNames[static_cast<int>(erosion)] << ", " << iterations;
+    }
+  }
+}
+
+TEST(HeightmapTest, DISABLED_ParallelErosionBenchmark) {
+  static constexpr unsigned Iterations = 10;
+
+  const gf::Heightmap initial = getRandomHeightmap({ 1024, 1024 });
+
+  for (auto erosion : { Erosion::Thermal, Erosion::Hydraulic, Erosion::Fast }) {
+    const char *name = ErosionNames[static_cast<int>(erosion)];
+
+    gf::Heightmap serial = initial;
+    gf::Clock clock;
+    applyErosion(serial, erosion, Iterations);
+    std::cout << name << " erosion, serial: " << clock.restart().asMilliseconds() << "ms\n";
+
+    gf::Heightmap parallel = initial;
+    applyParallelErosion(parallel, erosion, Iterations, gf::Heightmap::Precision::Double);
+    std::cout << name << " erosion, parallel: " << clock.restart().asMilliseconds() << "ms, max difference " << computeMaxDifference(serial, parallel) << '\n';
+
+    gf::Heightmap parallelFloat = initial;
+    applyParallelErosion(parallelFloat, erosion, Iterations, gf::Heightmap::Precision::Float);
+    std::cout << name << " erosion, parallel with floats: " << clock.restart().asMilliseconds() << "ms, mean difference " << computeMeanDifference(serial, parallelFloat) << '\n';
+
+    EXPECT_LT(computeMaxDifference(serial, parallel), 1e-9);
+    EXPECT_LT(computeMeanDifference(serial, parallelFloat), 1e-3);
+  }
+}
+
+TEST(HeightmapTest, ChunkGeneratorSeamless) {
+  static constexpr gf::Vector2i ChunkSize = { 32, 32 };
+  static constexpr gf::Vector2i ChunkCount = { 3, 2 };
+  static constexpr double Scale = 1.0 / 16;
+  static constexpr unsigned Iterations = 4;
+  static constexpr int Apron = 2 * Iterations;
+
+  gf::Random random(42);
+  gf::OpenSimplexNoise2D noise(random);
+
+  auto process = [](gf::Heightmap& heightmap) {
+    heightmap.parallelFastErosion(Iterations, 0.02, 0.4);
+  };
+
+  // the same region in a single heightmap
+  gf::Heightmap expected(ChunkSize * ChunkCount + 2 * Apron);
+  expected.addNoise(noise, gf::vec(-Apron * Scale, -Apron * Scale), gf::vec(Scale, Scale));
+  process(expected);
+  expected = expected.subMap(gf::RectI::fromPositionSize({ Apron, Apron }, ChunkSize * ChunkCount));
+
+  // the chunks in two different orders, with a cache smaller than the region
+  gf::HeightmapChunkGenerator workers(noise, ChunkSize, Scale, 4, process, Apron, 3);
+  gf::HeightmapChunkGenerator caller(noise, ChunkSize, Scale, 4, process, Apron, 1);
+
+  for (int j = 0; j < ChunkCount.y; ++j) {
+    for (int i = 0; i < ChunkCount.x; ++i) {
+      workers.request({ i, j });
+    }
+  }
+
+  for (int j = 0; j < ChunkCount.y; ++j) {
+    for (int i = 0; i < ChunkCount.x; ++i) {
+      std::shared_ptr<const gf::Heightmap> chunks[] = { workers.getChunk({ i, j }), caller.getChunk({ ChunkCount.x - 1 - i, ChunkCount.y - 1 - j }) };
+      gf::Vector2i offsets[] = { gf::vec(i, j) * ChunkSize, gf::vec(ChunkCount.x - 1 - i, ChunkCount.y - 1 - j) * ChunkSize };
+
+      for (int k = 0; k < 2; ++k) {
+        ASSERT_EQ(chunks[k]->getSize(), ChunkSize);
+
+        for (int y = 0; y < ChunkSize.height; ++y) {
+          for (int x = 0; x < ChunkSize.width; ++x) {
+            EXPECT_EQ(chunks[k]->getValue({ x, y }), expected.getValue(offsets[k] + gf::vec(x, y)));
+          }
+        }
+      }
+    }
+  }
+
+  EXPECT_LE(workers.getCachedChunkCount(), 4u);
+  EXPECT_LE(caller.getCachedChunkCount(), 4u);
+}
+
+TEST(HeightmapTest, ChunkGeneratorCache) {
+  gf::Random random(42);
+  gf::OpenSimplexNoise2D noise(random);
+  gf::HeightmapChunkGenerator generator(noise, { 16, 16 }, 1.0 / 16, 2, nullptr, 0, 1);
+
+  EXPECT_EQ(generator.findChunk({ 0, 0 }), nullptr);
+
+  auto chunk = generator.getChunk({ 0, 0 });
+  EXPECT_EQ(generator.findChunk({ 0, 0 }), chunk);
+  EXPECT_EQ(generator.getChunk({ 0, 0 }), chunk);
+
+  generator.getChunk({ 1, 0 });
+  generator.getChunk({ 0, 0 }); // (1, 0) is now the least recently used
+  generator.getChunk({ -1, 0 });
+
+  EXPECT_EQ(generator.getCachedChunkCount(), 2u);
+  EXPECT_EQ(generator.findChunk({ 0, 0 }), chunk);
+  EXPECT_EQ(generator.findChunk({ 1, 0 }), nullptr);
+  EXPECT_NE(generator.findChunk({ -1, 0 }), nullptr);
+}
+
+TEST(HeightmapTest, ChunkGeneratorError) {
+  gf::Random random(42);
+  gf::OpenSimplexNoise2D noise(random);
+
+  std::atomic<int> calls(0);
+  std::atomic<bool> failing(true);
+
+  auto process = [&](gf::Heightmap&) {
+    ++calls;
+
+    if (failing) {
+      throw std::runtime_error("process");
+    }
+  };
+
+  gf::HeightmapChunkGenerator generator(noise, { 16, 16 }, 1.0 / 16, 4, process, 0, 1);
+
+  // on the calling thread
+  EXPECT_THROW(generator.getChunk({ 0, 0 }), std::runtime_error);
+
+  // on the worker, the caller waits for the worker or gets the kept error
+  generator.request({ 1, 1 });
+
+  while (calls < 2) {
+    std::this_thread::yield();
+  }
+
+  EXPECT_THROW(generator.getChunk({ 1, 1 }), std::runtime_error);
+  EXPECT_EQ(generator.getCachedChunkCount(), 0u);
+
+  // the chunks are not pending anymore
+  failing = false;
+  EXPECT_NE(generator.getChunk({ 0, 0 }), nullptr);
+  EXPECT_NE(generator.getChunk({ 1, 1 }), nullptr);
+  EXPECT_EQ(generator.getCachedChunkCount(), 2u);
+}
+
+TEST(HeightmapTest, ChunkGeneratorFarAway) {
+  gf::Random random(42);
+  gf::OpenSimplexNoise2D noise(random);
+
+  // both chunks start at the sample 2^31, that does not fit in an int
+  gf::HeightmapChunkGenerator small(noise, { 16, 16 }, 1.0 / 16, 1, nullptr, 0, 1);
+  gf::HeightmapChunkGenerator large(noise, { 32, 32 }, 1.0 / 16, 1, nullptr, 0, 1);
+
+  auto smallChunk = small.getChunk({ 1 << 27, -(1 << 27) });
+  auto largeChunk = large.getChunk({ 1 << 26, -(1 << 26) });
+
+  for (int y = 0; y < 16; ++y) {
+    for (int x = 0; x < 16; ++x) {
+      EXPECT_EQ(smallChunk->getValue({ x, y }), largeChunk->getValue({ x, y }));
+    }
+  }
+}
+
+TEST(HeightmapTest, Storage) {
+  const gf::Heightmap initial = getRandomHeightmap({ 100, 70 });
+  const double QuantizedTolerance = 0.5 / 65535 + 1e-9;
+
+  for (auto storage : { gf::Heightmap::Storage::Float, gf::Heightmap::Storage::Quantized }) {
+    const bool quantized = (storage == gf::Heightmap::Storage::Quantized);
+
+    gf::Heightmap converted = initial.convertTo(storage);
+    EXPECT_EQ(converted.getStorage(), storage);
+    EXPECT_EQ(converted.getSize(), initial.getSize());
+    EXPECT_EQ(converted.getByteSize(), initial.getByteSize() / (quantized ? 4 : 2));
+    EXPECT_LT(computeMaxDifference(initial, converted), quantized ? QuantizedTolerance : 1e-7);
+
+    gf::Heightmap back = converted.convertTo(gf::Heightmap::Storage::Double);
+    EXPECT_EQ(back.getStorage(), gf::Heightmap::Storage::Double);
+    EXPECT_EQ(computeMaxDifference(back, converted), 0.0);
+
+    gf::Heightmap sub = converted.subMap(gf::RectI::fromPositionSize({ 10, 20 }, { 30, 40 }));
+    EXPECT_EQ(sub.getStorage(), storage);
+    EXPECT_EQ(sub.getValue({ 5, 7 }), converted.getValue({ 15, 27 }));
+
+    // the same operations give the same heights, up to the precision of the storage
+    gf::Heightmap reference = initial;
+
+    for (auto heightmap : { &reference, &converted }) {
+      heightmap->addHill({ 30.0, 30.0 }, 20.0, 0.3);
+      heightmap->digHill({ 70.0, 40.0 }, 15.0, -0.2);
+      heightmap->addValue(0.5);
+      heightmap->scale(2.0);
+      heightmap->normalize();
+      heightmap->parallelFastErosion(10, 0.08, 0.5);
+      heightmap->thermalErosion(10, 0.04, 0.5);
+      heightmap->clamp(0.1, 0.9);
+    }
+
+    EXPECT_LT(computeMeanDifference(reference, converted), 1e-3);
+  }
+
+  // a value out of the range quantizes the heightmap again
+  gf::Heightmap quantized = initial.convertTo(gf::Heightmap::Storage::Quantized);
+  quantized.setValue({ 3, 4 }, 2.0);
+  EXPECT_NEAR(quantized.getValue({ 3, 4 }), 2.0, 1e-6);
+  EXPECT_NEAR(std::get<1>(quantized.getMinMax()), 2.0, 1e-6);
+  EXPECT_NEAR(quantized.getValue({ 5, 6 }), initial.getValue({ 5, 6 }), 2.0 / 65535);
+}
+
+TEST(HeightmapTest, StorageQuantizedPrecision) {
+  static constexpr int Width = 64;
+  static constexpr int Count = Width * Width;
+  const gf::Vector2i Size = { Width, Width };
+
+  // a large minimum compared to the range must not lose levels in the non affine operations
+  gf::Heightmap initial(Size);
+
+  for (int y = 0; y < Size.height; ++y) {
+    for (int x = 0; x < Size.width; ++x) {
+      initial.setValue({ x, y }, 10000.0 + static_cast<double>(y * Size.width + x) / (Count - 1));
+    }
+  }
+
+  gf::Heightmap quantized = initial.convertTo(gf::Heightmap::Storage::Quantized);
+  quantized.clamp(0.0, 20000.0);
+  EXPECT_LT(computeMaxDifference(initial, quantized), 1.0 / 65535);
+
+  // repeated writes out of the range stay within a step
+  gf::Heightmap filled(Size, gf::Heightmap::Storage::Quantized);
+
+  for (int y = 0; y < Size.height; ++y) {
+    for (int x = 0; x < Size.width; ++x) {
+      filled.setValue({ x, y }, 0.5 * (y * Size.width + x + 1));
+    }
+  }
+
+  double min, max;
+  std::tie(min, max) = filled.getMinMax();
+  const double step = 2.0 * max / 65535;
+  EXPECT_NEAR(min, 0.5, step);
+
+  for (int y = 0; y < Size.height; ++y) {
+    for (int x = 0; x < Size.width; ++x) {
+      EXPECT_NEAR(filled.getValue({ x, y }), 0.5 * (y * Size.width + x + 1), step);
+    }
+  }
+}
+
+TEST(HeightmapTest, DISABLED_StorageBenchmark) {
+  static constexpr gf::Vector2i Size = { 4096, 4096 };
+
+  const gf::Heightmap initial = getRandomHeightmap(Size);
+
+  for (auto storage : { gf::Heightmap::Storage::Double, gf::Heightmap::Storage::Float, gf::Heightmap::Storage::Quantized }) {
+    static constexpr const char *StorageNames[] = { "double", "float", "quantized" };
+    const char *name = StorageNames[static_cast<int>(storage)];
+
+    gf::Heightmap heightmap = initial.convertTo(storage);
+    std::cout << "Storage " << name << ": " << heightmap.getByteSize() / (1024 * 1024) << "MiB\n";
+
+    gf::Clock clock;
+    heightmap.normalize(0.2, 0.8);
+    std::cout << "\tnormalize: " << clock.restart().asMilliseconds() << "ms\n";
+
+    heightmap.addHill({ 2048.0, 2048.0 }, 1024.0, 0.1);
+    std::cout << "\taddHill: " << clock.restart().asMilliseconds() << "ms\n";
+
+    heightmap.parallelFastErosion(2, 8.0 / Size.width, 0.5, gf::Heightmap::Precision::Float);
+    std::cout << "\tparallelFastErosion: " << clock.restart().asMilliseconds() << "ms\n";
+
+    // the access pattern of the image exports
+    double total = 0.0;
+
+    for (int y = 0; y < Size.height; ++y) {
+      for (int x = 0; x < Size.width; ++x) {
+        total += heightmap.getValue({ x, y });
+      }
+    }
+
+    std::cout << "\tread: " << clock.restart().asMilliseconds() << "ms\n";
+    EXPECT_GT(total, 0.0);
+  }
+}
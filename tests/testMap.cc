@@ -0,0 +1,906 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/Map.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+
+#include <gf/Clock.h>
+#include <gf/Random.h>
+#include <gf/VectorOps.h>
+
+#include <boost/heap/binomial_heap.hpp>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+  constexpr gf::Vector2i MapSize = { 512, 512 };
+  constexpr std::size_t ObstacleCount = 1500;
+  constexpr std::size_t RouteCount = 50;
+  constexpr const char *FieldOfVisionNames[] = { "Basic", "RecursiveShadowcasting", "SymmetricShadowcasting" };
+
+  gf::SquareMap getRandomMap(gf::Random& random, gf::Vector2i size = MapSize, gf::SquareMapLayout layout = gf::SquareMapLayout::Cells) {
+    gf::SquareMap map(size, layout);
+    map.reset(gf::EmptyCell);
+
+    for (std::size_t i = 0; i < ObstacleCount * size.width * size.height / (MapSize.width * MapSize.height); ++i) {
+      gf::Vector2i min = random.computePosition(gf::RectI::fromSize(size - 1));
+      gf::Vector2i extent = { random.computeUniformInteger(1, 16), random.computeUniformInteger(1, 16) };
+
+      for (int y = min.y; y < std::min(min.y + extent.y, size.height); ++y) {
+        for (int x = min.x; x < std::min(min.x + extent.x, size.width); ++x) {
+          map.setCell({ x, y }, gf::None);
+        }
+      }
+    }
+
+    return map;
+  }
+
+  gf::Vector2i getRandomWalkablePosition(gf::Random& random, const gf::SquareMap& map) {
+    for (;;) {
+      gf::Vector2i position = random.computePosition(gf::RectI::fromSize(map.getSize() - 1));
+
+      if (map.isWalkable(position)) {
+        return position;
+      }
+    }
+  }
+
+  bool isValidRoute(const gf::SquareMap& map, const std::vector<gf::Vector2i>& route, float diagonalCost = gf::Sqrt2) {
+    for (std::size_t i = 0; i < route.size(); ++i) {
+      if (!map.isWalkable(route[i])) {
+        return false;
+      }
+
+      if (i > 0) {
+        int distance = gf::manhattanDistance(route[i - 1], route[i]);
+
+        if (gf::chebyshevDistance(route[i - 1], route[i]) != 1 || (distance == 2 && diagonalCost == 0)) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  float computeRouteCost(const std::vector<gf::Vector2i>& route, float diagonalCost) {
+    float cost = 0.0f;
+
+    for (std::size_t i = 1; i < route.size(); ++i) {
+      cost += (gf::manhattanDistance(route[i - 1], route[i]) == 2) ? diagonalCost : 1.0f;
+    }
+
+    return cost;
+  }
+
+  bool isOptimalField(const gf::SquareMap& map, const gf::FlowField& field, const std::vector<gf::Vector2i>& goals, float diagonalCost) {
+    for (auto position : map.getRange()) {
+      if (!field.isReachable(position)) {
+        continue;
+      }
+
+      bool isGoal = std::find(goals.begin(), goals.end(), position) != goals.end();
+
+      if (isGoal != (field.getDistance(position) == 0.0f)) {
+        return false;
+      }
+
+      // no neighbor gives a shorter distance, and the next step gives the distance
+      for (int dy = -1; dy <= 1; ++dy) {
+        for (int dx = -1; dx <= 1; ++dx) {
+          gf::Vector2i neighbor = position + gf::vec(dx, dy);
+          bool isDiagonal = dx != 0 && dy != 0;
+
+          if ((dx == 0 && dy == 0) || (isDiagonal && diagonalCost == 0)) {
+            continue;
+          }
+
+          if (neighbor.x < 0 || neighbor.y < 0 || neighbor.x >= map.getSize().width || neighbor.y >= map.getSize().height || !map.isWalkable(neighbor)) {
+            continue;
+          }
+
+          float cost = isDiagonal ? diagonalCost : 1.0f;
+
+          if (field.getDistance(neighbor) > field.getDistance(position) + cost + 1e-3f) {
+            return false;
+          }
+        }
+      }
+
+      if (!isGoal) {
+        gf::Vector2i next = field.getNextStep(position);
+        float cost = (gf::manhattanDistance(position, next) == 2) ? diagonalCost : 1.0f;
+
+        if (gf::chebyshevDistance(position, next) != 1 || std::abs(field.getDistance(next) + cost - field.getDistance(position)) > 1e-3f) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  std::vector<std::pair<gf::Vector2i, gf::Vector2i>> getRandomQueries(gf::Random& random, const gf::SquareMap& map) {
+    std::vector<std::pair<gf::Vector2i, gf::Vector2i>> queries;
+
+    for (std::size_t i = 0; i < RouteCount; ++i) {
+      queries.emplace_back(getRandomWalkablePosition(random, map), getRandomWalkablePosition(random, map));
+    }
+
+    return queries;
+  }
+
+  /*
+   * The A* of gf 1.x, before the route contexts, used as a baseline in the benchmark
+   */
+
+  struct ReferenceHeapData {
+    gf::Vector2i position;
+    float priority;
+  };
+
+  bool operator<(const ReferenceHeapData& lhs, const ReferenceHeapData& rhs) {
+    return lhs.priority > rhs.priority;
+  }
+
+  using ReferenceHeap = boost::heap::binomial_heap<ReferenceHeapData>;
+
+  enum class ReferenceState {
+    None,
+    Open,
+    Closed,
+  };
+
+  struct ReferenceResultData {
+    float distance;
+    gf::Vector2i previous;
+    ReferenceState state;
+    ReferenceHeap::handle_type handle;
+  };
+
+  std::vector<gf::Vector2i> computeReferenceAStar(const gf::SquareMap& map, gf::Vector2i origin, gf::Vector2i target, float diagonalCost) {
+    ReferenceResultData defaultResult;
+    defaultResult.distance = std::numeric_limits<float>::infinity();
+    defaultResult.previous = { -1, -1 };
+    defaultResult.state = ReferenceState::None;
+
+    gf::Array2D<ReferenceResultData, int> results(map.getSize(), defaultResult);
+
+    results(origin).distance = 0.0f;
+    results(origin).state = ReferenceState::Open;
+
+    ReferenceHeap heap;
+    results(origin).handle = heap.push({ origin, 0.0f });
+
+    auto heuristic = [diagonalCost](gf::Vector2i p0, gf::Vector2i p1) {
+      if (diagonalCost == 0) {
+        return 1.0f * gf::manhattanDistance(p0, p1);
+      }
+
+      gf::Vector2i d = gf::abs(p0 - p1);
+      return 1.0f * (d.x + d.y) + (diagonalCost - 2.0f) * std::min(d.x, d.y);
+    };
+
+    while (!heap.empty()) {
+      ReferenceHeapData data = heap.top();
+      heap.pop();
+
+      if (data.position == target) {
+        break;
+      }
+
+      results(data.position).state = ReferenceState::Closed;
+
+      for (auto position : results.get8NeighborsRange(data.position)) {
+        if (!map.isWalkable(position) || results(position).state == ReferenceState::Closed) {
+          continue;
+        }
+
+        bool isDiagonal = (gf::manhattanDistance(data.position, position) == 2);
+
+        if (isDiagonal && diagonalCost == 0) {
+          continue;
+        }
+
+        float newDistance = results(data.position).distance + (isDiagonal ? diagonalCost : 1.0f);
+
+        if (newDistance < results(position).distance) {
+          auto& result = results(position);
+          result.distance = newDistance;
+          result.previous = data.position;
+
+          float priority = newDistance + heuristic(position, target) * 1.001f;
+
+          if (result.state == ReferenceState::Open) {
+            if ((*result.handle).priority != priority) {
+              (*result.handle).priority = priority;
+              heap.update(result.handle);
+            }
+          } else {
+            result.handle = heap.push({ position, priority });
+            result.state = ReferenceState::Open;
+          }
+        }
+      }
+    }
+
+    std::vector<gf::Vector2i> route;
+    gf::Vector2i curr = target;
+
+    while (curr != origin) {
+      if (curr.x == -1 || curr.y == -1) {
+        return {};
+      }
+
+      route.push_back(curr);
+      curr = results(curr).previous;
+    }
+
+    route.push_back(origin);
+    std::reverse(route.begin(), route.end());
+    return route;
+  }
+
+}
+
+TEST(MapTest, FieldOfVisionEmpty) {
+  gf::SquareMap map({ 33, 33 });
+  map.reset(gf::EmptyCell);
+
+  const gf::Vector2i center = { 16, 16 };
+
+  for (auto algorithm : { gf::FieldOfVision::RecursiveShadowcasting, gf::FieldOfVision::SymmetricShadowcasting }) {
+    map.clearFieldOfVision();
+    map.computeFieldOfVision(center, 10, gf::FieldOfVisionLimit::Included, algorithm);
+
+    std::size_t visible = 0;
+
+    for (auto position : map.getRange()) {
+      EXPECT_EQ(map.isInFieldOfVision(position), gf::squareDistance(center, position) <= 100);
+
+      if (map.isInFieldOfVision(position)) {
+        ++visible;
+      }
+    }
+
+    // every visible cell but the center is visited, the cells are in the
+    // square around the radius and the octant or quadrant borders are visited
+    // twice
+    EXPECT_GE(map.getVisitedCellCount() + 1, visible);
+    EXPECT_LE(map.getVisitedCellCount(), 21u * 21u + 8u * 10u);
+  }
+}
+
+TEST(MapTest, FieldOfVisionWall) {
+  gf::SquareMap map({ 11, 11 });
+  map.reset(gf::EmptyCell);
+  map.setCell({ 5, 3 }, gf::None);
+
+  for (auto algorithm : { gf::FieldOfVision::Basic, gf::FieldOfVision::RecursiveShadowcasting, gf::FieldOfVision::SymmetricShadowcasting }) {
+    map.clearFieldOfVision();
+    map.computeFieldOfVision({ 5, 5 }, 0, gf::FieldOfVisionLimit::Included, algorithm);
+
+    EXPECT_TRUE(map.isInFieldOfVision({ 5, 5 }));
+    EXPECT_TRUE(map.isInFieldOfVision({ 5, 4 }));
+    EXPECT_TRUE(map.isInFieldOfVision({ 5, 3 }));
+    EXPECT_FALSE(map.isInFieldOfVision({ 5, 2 }));
+    EXPECT_FALSE(map.isInFieldOfVision({ 5, 1 }));
+    EXPECT_TRUE(map.isInFieldOfVision({ 0, 5 }));
+
+    map.clearFieldOfVision();
+    map.computeFieldOfVision({ 5, 5 }, 0, gf::FieldOfVisionLimit::Excluded, algorithm);
+
+    EXPECT_TRUE(map.isInFieldOfVision({ 5, 4 }));
+    EXPECT_FALSE(map.isInFieldOfVision({ 5, 3 }));
+  }
+}
+
+TEST(MapTest, FieldOfVisionSymmetric) {
+  gf::Random random(23);
+  gf::SquareMap map = getRandomMap(random, { 64, 64 });
+
+  for (std::size_t i = 0; i < 100; ++i) {
+    gf::Vector2i p0 = getRandomWalkablePosition(random, map);
+    gf::Vector2i p1 = getRandomWalkablePosition(random, map);
+
+    map.clearFieldOfVision();
+    map.computeLocalFieldOfVision(p0, 0, gf::FieldOfVisionLimit::Included, gf::FieldOfVision::SymmetricShadowcasting);
+    bool visible0 = map.isInFieldOfVision(p1);
+
+    map.clearFieldOfVision();
+    map.computeLocalFieldOfVision(p1, 0, gf::FieldOfVisionLimit::Included, gf::FieldOfVision::SymmetricShadowcasting);
+    bool visible1 = map.isInFieldOfVision(p0);
+
+    EXPECT_EQ(visible0, visible1);
+  }
+}
+
+TEST(MapTest, VisibilityLayer) {
+  gf::VisibilityLayer layer({ 100, 10 });
+  EXPECT_EQ(layer.getSize(), gf::vec(100, 10));
+  EXPECT_FALSE(layer.isVisible({ 70, 5 }));
+
+  layer.setVisible({ 70, 5 });
+  layer.setVisible({ 2, 3 });
+  EXPECT_TRUE(layer.isVisible({ 70, 5 }));
+  EXPECT_TRUE(layer.isVisible({ 2, 3 }));
+  EXPECT_FALSE(layer.isVisible({ 69, 5 }));
+
+  gf::VisibilityLayer other({ 100, 10 });
+  other.setVisible({ 99, 9 });
+  layer.merge(other);
+  EXPECT_TRUE(layer.isVisible({ 99, 9 }));
+
+  layer.clear();
+
+  for (int y = 0; y < 10; ++y) {
+    for (int x = 0; x < 100; ++x) {
+      EXPECT_FALSE(layer.isVisible({ x, y }));
+    }
+  }
+}
+
+TEST(MapTest, FieldOfVisionLayersRandom) {
+  static constexpr std::size_t LayerCount = 3;
+
+  gf::Random random(23);
+  gf::SquareMap map = getRandomMap(random, { 128, 128 });
+
+  std::vector<gf::FieldOfVisionObserver> observers;
+
+  for (std::size_t i = 0; i < 30; ++i) {
+    observers.push_back({ getRandomWalkablePosition(random, map), (i % 5 == 0) ? 0 : random.computeUniformInteger(4, 20), i % LayerCount });
+  }
+
+  std::vector<gf::VisibilityLayer> layers(LayerCount, gf::VisibilityLayer(map.getSize()));
+
+  for (auto algorithm : { gf::FieldOfVision::Basic, gf::FieldOfVision::RecursiveShadowcasting, gf::FieldOfVision::SymmetricShadowcasting }) {
+    for (auto& layer : layers) {
+      layer.clear();
+    }
+
+    map.computeFieldOfVisionLayers(observers, layers, gf::FieldOfVisionLimit::Included, algorithm);
+
+    // each observer is computed alone because the basic algorithm depends on the visible cells
+    std::vector<gf::Array2D<uint8_t, int>> expected(LayerCount, gf::Array2D<uint8_t, int>(map.getSize(), 0));
+
+    for (auto& observer : observers) {
+      map.clearFieldOfVision();
+      map.computeLocalFieldOfVision(observer.position, observer.maxRadius, gf::FieldOfVisionLimit::Included, algorithm);
+
+      for (auto position : map.getRange()) {
+        if (map.isInFieldOfVision(position)) {
+          expected[observer.layer](position) = 1;
+        }
+      }
+    }
+
+    for (std::size_t i = 0; i < LayerCount; ++i) {
+      for (auto position : map.getRange()) {
+        ASSERT_EQ(layers[i].isVisible(position), expected[i](position) != 0);
+      }
+    }
+  }
+}
+
+TEST(MapTest, DISABLED_FieldOfVisionBenchmark) {
+  static constexpr std::size_t CallCount = 20;
+
+  gf::Random random(42);
+  gf::SquareMap map = getRandomMap(random, { 288, 288 });
+  const gf::Vector2i center = { 144, 144 };
+
+  for (int radius : { 8, 32, 128 }) {
+    for (auto algorithm : { gf::FieldOfVision::Basic, gf::FieldOfVision::RecursiveShadowcasting, gf::FieldOfVision::SymmetricShadowcasting }) {
+      gf::Time time = gf::Time::zero();
+
+      for (std::size_t i = 0; i < CallCount; ++i) {
+        map.clearFieldOfVision();
+        gf::Clock clock;
+        map.computeLocalFieldOfVision(center, radius, gf::FieldOfVisionLimit::Included, algorithm);
+        time += clock.getElapsedTime();
+      }
+
+      std::cout << "FoV (" << FieldOfVisionNames[static_cast<int>(algorithm)] << ", radius " << radius << "): " << time.asMicroseconds() / CallCount << "us per call, " << map.getVisitedCellCount() << " visited cells\n";
+    }
+  }
+}
+
+TEST(MapTest, DISABLED_FieldOfVisionLayersBenchmark) {
+  static constexpr std::size_t LayerCount = 4;
+  static constexpr std::size_t ObserverCount = 64;
+
+  gf::Random random(42);
+  gf::SquareMap map = getRandomMap(random);
+
+  std::vector<gf::FieldOfVisionObserver> observers;
+
+  for (std::size_t i = 0; i < ObserverCount; ++i) {
+    observers.push_back({ getRandomWalkablePosition(random, map), 16, i % LayerCount });
+  }
+
+  std::vector<gf::VisibilityLayer> layers(LayerCount, gf::VisibilityLayer(map.getSize()));
+
+  for (auto algorithm : { gf::FieldOfVision::Basic, gf::FieldOfVision::SymmetricShadowcasting }) {
+    gf::Clock clock;
+
+    for (std::size_t i = 0; i < LayerCount; ++i) {
+      map.clearFieldOfVision();
+
+      for (auto& observer : observers) {
+        if (observer.layer == i) {
+          map.computeLocalFieldOfVision(observer.position, observer.maxRadius, gf::FieldOfVisionLimit::Included, algorithm);
+        }
+      }
+    }
+
+    std::cout << "FoV of " << ObserverCount << " observers in " << LayerCount << " factions (" << FieldOfVisionNames[static_cast<int>(algorithm)] << "), one by one: " << clock.restart().asMicroseconds() << "us\n";
+
+    for (auto& layer : layers) {
+      layer.clear();
+    }
+
+    map.computeFieldOfVisionLayers(observers, layers, gf::FieldOfVisionLimit::Included, algorithm);
+
+    std::cout << "FoV of " << ObserverCount << " observers in " << LayerCount << " factions (" << FieldOfVisionNames[static_cast<int>(algorithm)] << "), with layers: " << clock.restart().asMicroseconds() << "us\n";
+  }
+}
+
+TEST(MapTest, BitPlanes) {
+  gf::Random random(42);
+  gf::SquareMap cells = getRandomMap(random, { 100, 100 });
+  gf::SquareMap planes(cells.getSize(), gf::SquareMapLayout::BitPlanes);
+  EXPECT_EQ(planes.getLayout(), gf::SquareMapLayout::BitPlanes);
+
+  for (auto position : cells.getRange()) {
+    planes.setTransparent(position, cells.isTransparent(position));
+    planes.setWalkable(position, cells.isWalkable(position));
+  }
+
+  for (auto algorithm : { gf::FieldOfVision::Basic, gf::FieldOfVision::RecursiveShadowcasting, gf::FieldOfVision::SymmetricShadowcasting }) {
+    for (gf::SquareMap* map : { &cells, &planes }) {
+      map->clearFieldOfVision();
+      map->clearExplored();
+      map->computeFieldOfVision({ 50, 50 }, 20, gf::FieldOfVisionLimit::Included, algorithm);
+      map->computeLocalFieldOfVision({ 20, 70 }, 10, gf::FieldOfVisionLimit::Included, algorithm);
+    }
+
+    for (auto position : cells.getRange()) {
+      EXPECT_EQ(planes.isTransparent(position), cells.isTransparent(position));
+      EXPECT_EQ(planes.isWalkable(position), cells.isWalkable(position));
+      EXPECT_EQ(planes.isInFieldOfVision(position), cells.isInFieldOfVision(position));
+      EXPECT_EQ(planes.isExplored(position), cells.isExplored(position));
+    }
+  }
+
+  std::vector<gf::FieldOfVisionObserver> observers = { { { 50, 50 }, 20, 0 }, { { 20, 70 }, 0, 0 } };
+  gf::VisibilityLayer cellsLayer(cells.getSize());
+  gf::VisibilityLayer planesLayer(planes.getSize());
+  cells.computeFieldOfVisionLayers(observers, gf::Span<gf::VisibilityLayer>(&cellsLayer, 1));
+  planes.computeFieldOfVisionLayers(observers, gf::Span<gf::VisibilityLayer>(&planesLayer, 1));
+
+  for (auto position : cells.getRange()) {
+    EXPECT_EQ(planesLayer.isVisible(position), cellsLayer.isVisible(position));
+  }
+
+  auto queries = getRandomQueries(random, cells);
+
+  for (auto& query : queries) {
+    EXPECT_EQ(planes.computeRoute(query.first, query.second), cells.computeRoute(query.first, query.second));
+  }
+
+  planes.reset(gf::EmptyCell);
+  planes.setCell({ 10, 10 }, gf::CellProperty::Transparent);
+  planes.setTransparent({ 20, 20 }, false);
+
+  for (auto position : planes.getRange()) {
+    EXPECT_EQ(planes.isWalkable(position), position != gf::Vector2i(10, 10));
+    EXPECT_EQ(planes.isTransparent(position), position != gf::Vector2i(20, 20));
+    EXPECT_FALSE(planes.isInFieldOfVision(position));
+    EXPECT_FALSE(planes.isExplored(position));
+  }
+}
+
+TEST(MapTest, DISABLED_StorageBenchmark) {
+  static constexpr std::size_t CallCount = 10;
+  static constexpr const char *LayoutNames[] = { "Cells", "BitPlanes" };
+
+  for (auto layout : { gf::SquareMapLayout::Cells, gf::SquareMapLayout::BitPlanes }) {
+    const char *name = LayoutNames[static_cast<int>(layout)];
+
+    gf::Random random(42);
+    gf::SquareMap map = getRandomMap(random, { 4096, 4096 }, layout);
+    const gf::Vector2i center = { 2048, 2048 };
+
+    gf::Clock clock;
+
+    for (std::size_t i = 0; i < CallCount; ++i) {
+      map.clearFieldOfVision();
+    }
+
+    std::cout << name << ", clearFieldOfVision: " << clock.restart().asMicroseconds() / CallCount << "us per call\n";
+
+    for (std::size_t i = 0; i < CallCount; ++i) {
+      map.clearExplored();
+    }
+
+    std::cout << name << ", clearExplored: " << clock.restart().asMicroseconds() / CallCount << "us per call\n";
+
+    for (auto algorithm : { gf::FieldOfVision::Basic, gf::FieldOfVision::SymmetricShadowcasting }) {
+      clock.restart();
+
+      for (std::size_t i = 0; i < CallCount; ++i) {
+        map.clearFieldOfVision();
+        map.computeFieldOfVision(center, 64, gf::FieldOfVisionLimit::Included, algorithm);
+      }
+
+      std::cout << name << ", clearFieldOfVision and FoV (" << FieldOfVisionNames[static_cast<int>(algorithm)] << ", radius 64): " << clock.restart().asMicroseconds() / CallCount << "us per call\n";
+    }
+
+    gf::RouteContext context;
+    auto queries = getRandomQueries(random, map);
+    queries.resize(10);
+    clock.restart();
+
+    for (auto& query : queries) {
+      map.computeRoute(query.first, query.second, context, gf::Sqrt2, gf::Route::JumpPointSearch);
+    }
+
+    std::cout << name << ", JPS time for " << queries.size() << " routes: " << clock.restart().asMilliseconds() << "ms\n";
+
+    for (std::size_t i = 0; i < CallCount; ++i) {
+      map.reset(gf::EmptyCell);
+    }
+
+    std::cout << name << ", reset: " << clock.restart().asMicroseconds() / CallCount << "us per call\n";
+  }
+}
+
+TEST(MapTest, RouteSimple) {
+  gf::SquareMap map({ 5, 5 });
+  map.reset(gf::EmptyCell);
+
+  for (int y = 0; y < 4; ++y) {
+    map.setCell({ 2, y }, gf::None);
+  }
+
+  gf::RouteContext context;
+
+  for (auto algorithm : { gf::Route::AStar, gf::Route::Dijkstra, gf::Route::JumpPointSearch }) {
+    auto route = map.computeRoute({ 0, 0 }, { 4, 0 }, context, gf::Sqrt2, algorithm);
+
+    ASSERT_FALSE(route.empty());
+    EXPECT_EQ(route.front(), gf::vec(0, 0));
+    EXPECT_EQ(route.back(), gf::vec(4, 0));
+    EXPECT_TRUE(isValidRoute(map, route));
+    EXPECT_NEAR(computeRouteCost(route, gf::Sqrt2), 4.0f + 4.0f * gf::Sqrt2, 1e-4f);
+  }
+}
+
+TEST(MapTest, RouteNone) {
+  gf::SquareMap map({ 5, 5 });
+  map.reset(gf::EmptyCell);
+
+  for (int i = 0; i < 5; ++i) {
+    map.setCell({ 2, i }, gf::None);
+  }
+
+  gf::RouteContext context;
+
+  map.setRouteClusterSize(2);
+
+  for (auto algorithm : { gf::Route::AStar, gf::Route::Dijkstra, gf::Route::JumpPointSearch, gf::Route::Hierarchical }) {
+    EXPECT_TRUE(map.computeRoute({ 0, 0 }, { 4, 4 }, gf::Sqrt2, algorithm).empty());
+    EXPECT_TRUE(map.computeRoute({ 0, 0 }, { 4, 4 }, context, gf::Sqrt2, algorithm).empty());
+  }
+}
+
+TEST(MapTest, RouteHierarchicalDiagonal) {
+  gf::SquareMap map({ 8, 8 });
+  map.reset(gf::EmptyCell);
+  map.setRouteClusterSize(4);
+
+  // the only way across the border between x = 3 and x = 4 is the diagonal (3, 1) - (4, 2)
+  for (int y = 0; y < 8; ++y) {
+    if (y != 1) {
+      map.setCell({ 3, y }, gf::None);
+    }
+
+    if (y != 2) {
+      map.setCell({ 4, y }, gf::None);
+    }
+  }
+
+  gf::RouteContext context;
+
+  auto route = map.computeRoute({ 0, 0 }, { 7, 7 }, context, gf::Sqrt2, gf::Route::Hierarchical);
+  auto expected = map.computeRoute({ 0, 0 }, { 7, 7 }, context, gf::Sqrt2, gf::Route::AStar);
+
+  ASSERT_FALSE(route.empty());
+  EXPECT_EQ(route.front(), gf::vec(0, 0));
+  EXPECT_EQ(route.back(), gf::vec(7, 7));
+  EXPECT_TRUE(isValidRoute(map, route));
+  EXPECT_LE(computeRouteCost(route, gf::Sqrt2), computeRouteCost(expected, gf::Sqrt2) * 1.5f);
+
+  // without diagonal moves, the target is not reachable
+  EXPECT_TRUE(map.computeRoute({ 0, 0 }, { 7, 7 }, context, 0.0f, gf::Route::Hierarchical).empty());
+}
+
+TEST(MapTest, RouteRandom) {
+  gf::Random random(23);
+  gf::SquareMap map = getRandomMap(random, { 128, 128 });
+  auto queries = getRandomQueries(random, map);
+
+  gf::RouteContext context;
+
+  for (float diagonalCost : { 0.0f, 1.0f, gf::Sqrt2 }) {
+    for (auto& query : queries) {
+      auto expected = map.computeRoute(query.first, query.second, diagonalCost, gf::Route::Dijkstra);
+
+      for (auto algorithm : { gf::Route::AStar, gf::Route::Dijkstra, gf::Route::JumpPointSearch }) {
+        auto route = map.computeRoute(query.first, query.second, context, diagonalCost, algorithm);
+
+        ASSERT_EQ(route.empty(), expected.empty());
+
+        if (route.empty()) {
+          continue;
+        }
+
+        EXPECT_EQ(route.front(), query.first);
+        EXPECT_EQ(route.back(), query.second);
+        EXPECT_TRUE(isValidRoute(map, route, diagonalCost));
+        EXPECT_NEAR(computeRouteCost(route, diagonalCost), computeRouteCost(expected, diagonalCost), 1e-3f);
+      }
+    }
+  }
+}
+
+TEST(MapTest, RouteHierarchicalRandom) {
+  gf::Random random(23);
+  gf::SquareMap map = getRandomMap(random, { 128, 128 });
+  auto queries = getRandomQueries(random, map);
+
+  gf::RouteContext context;
+
+  for (float diagonalCost : { 0.0f, gf::Sqrt2 }) {
+    for (auto& query : queries) {
+      auto expected = map.computeRoute(query.first, query.second, context, diagonalCost, gf::Route::AStar);
+      auto route = map.computeRoute(query.first, query.second, context, diagonalCost, gf::Route::Hierarchical);
+
+      ASSERT_EQ(route.empty(), expected.empty());
+
+      if (route.empty()) {
+        continue;
+      }
+
+      EXPECT_EQ(route.front(), query.first);
+      EXPECT_EQ(route.back(), query.second);
+      EXPECT_TRUE(isValidRoute(map, route, diagonalCost));
+      EXPECT_LE(computeRouteCost(route, diagonalCost), computeRouteCost(expected, diagonalCost) * 1.5f);
+    }
+  }
+}
+
+TEST(MapTest, RouteHierarchicalUpdate) {
+  gf::Random random(23);
+  gf::SquareMap map = getRandomMap(random, { 128, 128 });
+  auto queries = getRandomQueries(random, map);
+
+  gf::RouteContext context;
+
+  for (std::size_t round = 0; round < 5; ++round) {
+    for (std::size_t i = 0; i < 100; ++i) {
+      gf::Vector2i position = random.computePosition(gf::RectI::fromSize(map.getSize() - 1));
+
+      if (random.computeBernoulli(0.5)) {
+        map.setWalkable(position, !map.isWalkable(position));
+      } else {
+        map.setCell(position, map.isWalkable(position) ? gf::None : gf::EmptyCell);
+      }
+    }
+
+    // the same map with a hierarchy built from scratch
+    gf::SquareMap fresh = map;
+    fresh.setRouteClusterSize(16);
+
+    for (auto& query : queries) {
+      if (!map.isWalkable(query.first) || !map.isWalkable(query.second)) {
+        continue;
+      }
+
+      auto expected = fresh.computeRoute(query.first, query.second, context, gf::Sqrt2, gf::Route::Hierarchical);
+      auto route = map.computeRoute(query.first, query.second, context, gf::Sqrt2, gf::Route::Hierarchical);
+
+      ASSERT_EQ(route.empty(), expected.empty());
+
+      if (route.empty()) {
+        continue;
+      }
+
+      EXPECT_TRUE(isValidRoute(map, route));
+      EXPECT_NEAR(computeRouteCost(route, gf::Sqrt2), computeRouteCost(expected, gf::Sqrt2), 1e-2f);
+    }
+  }
+}
+
+TEST(MapTest, FlowFieldRandom) {
+  gf::Random random(23);
+  gf::SquareMap map = getRandomMap(random, { 128, 128 });
+
+  std::vector<gf::Vector2i> goals;
+
+  for (std::size_t i = 0; i < 3; ++i) {
+    goals.push_back(getRandomWalkablePosition(random, map));
+  }
+
+  for (float diagonalCost : { 0.0f, gf::Sqrt2 }) {
+    gf::FlowField field = map.computeFlowField(goals, diagonalCost);
+    EXPECT_EQ(field.getSize(), map.getSize());
+    EXPECT_TRUE(isOptimalField(map, field, goals, diagonalCost));
+
+    for (std::size_t i = 0; i < 20; ++i) {
+      gf::Vector2i position = getRandomWalkablePosition(random, map);
+      float expected = std::numeric_limits<float>::infinity();
+
+      for (auto goal : goals) {
+        auto route = map.computeRoute(position, goal, diagonalCost, gf::Route::Dijkstra);
+
+        if (!route.empty()) {
+          expected = std::min(expected, computeRouteCost(route, diagonalCost));
+        }
+      }
+
+      if (expected == std::numeric_limits<float>::infinity()) {
+        EXPECT_FALSE(field.isReachable(position));
+        continue;
+      }
+
+      ASSERT_TRUE(field.isReachable(position));
+      EXPECT_NEAR(field.getDistance(position), expected, 1e-2f);
+
+      // follow the field
+
+      while (field.getDistance(position) > 0.0f) {
+        gf::Vector2i next = field.getNextStep(position);
+        ASSERT_EQ(gf::chebyshevDistance(position, next), 1);
+        ASSERT_TRUE(map.isWalkable(next));
+        position = next;
+      }
+
+      EXPECT_NE(std::find(goals.begin(), goals.end(), position), goals.end());
+    }
+  }
+}
+
+TEST(MapTest, FlowFieldUpdate) {
+  gf::Random random(23);
+  gf::SquareMap map = getRandomMap(random, { 128, 128 });
+
+  std::vector<gf::Vector2i> goals;
+
+  for (std::size_t i = 0; i < 3; ++i) {
+    goals.push_back(getRandomWalkablePosition(random, map));
+  }
+
+  gf::FlowField field = map.computeFlowField(goals);
+
+  for (std::size_t round = 0; round < 10; ++round) {
+    std::vector<gf::Vector2i> cells;
+
+    for (std::size_t i = 0; i < 20; ++i) {
+      gf::Vector2i position = random.computePosition(gf::RectI::fromSize(map.getSize() - 1));
+      map.setWalkable(position, !map.isWalkable(position));
+      cells.push_back(position);
+    }
+
+    map.updateFlowField(field, cells);
+    gf::FlowField expected = map.computeFlowField(goals);
+
+    EXPECT_TRUE(isOptimalField(map, field, goals, gf::Sqrt2));
+
+    for (auto position : map.getRange()) {
+      ASSERT_EQ(field.isReachable(position), expected.isReachable(position));
+
+      if (field.isReachable(position)) {
+        EXPECT_NEAR(field.getDistance(position), expected.getDistance(position), 1e-2f);
+      }
+    }
+  }
+}
+
+TEST(MapTest, DISABLED_RouteBenchmark) {
+  gf::Random random(42);
+  gf::SquareMap map = getRandomMap(random);
+  auto queries = getRandomQueries(random, map);
+
+  gf::Clock clock;
+
+  for (auto& query : queries) {
+    computeReferenceAStar(map, query.first, query.second, gf::Sqrt2);
+  }
+
+  std::cout << "Reference A* time: " << clock.restart().asMilliseconds() << "ms\n";
+
+  for (auto& query : queries) {
+    map.computeRoute(query.first, query.second);
+  }
+
+  std::cout << "A* time: " << clock.restart().asMilliseconds() << "ms\n";
+
+  gf::RouteContext context;
+
+  for (auto algorithm : { gf::Route::AStar, gf::Route::JumpPointSearch }) {
+    clock.restart();
+
+    for (auto& query : queries) {
+      map.computeRoute(query.first, query.second, context, gf::Sqrt2, algorithm);
+    }
+
+    std::cout << (algorithm == gf::Route::AStar ? "A*" : "JPS") << " time with context: " << clock.restart().asMilliseconds() << "ms\n";
+  }
+
+  map.computeRoute(queries.front().first, queries.front().second, context, gf::Sqrt2, gf::Route::Hierarchical);
+  std::cout << "HPA* build time: " << clock.restart().asMilliseconds() << "ms\n";
+
+  for (auto& query : queries) {
+    map.computeRoute(query.first, query.second, context, gf::Sqrt2, gf::Route::Hierarchical);
+  }
+
+  std::cout << "HPA* time with context: " << clock.restart().asMilliseconds() << "ms\n";
+
+  for (std::size_t i = 0; i < 10; ++i) {
+    gf::Vector2i position = random.computePosition(gf::RectI::fromSize(map.getSize() - 1));
+    map.setWalkable(position, !map.isWalkable(position));
+    map.computeRoute(queries[i].first, queries[i].second, context, gf::Sqrt2, gf::Route::Hierarchical);
+  }
+
+  std::cout << "HPA* time with 10 updates: " << clock.restart().asMilliseconds() << "ms\n";
+
+  std::vector<gf::Vector2i> goals;
+
+  for (auto& query : queries) {
+    goals.push_back(query.second);
+  }
+
+  clock.restart();
+  gf::FlowField field = map.computeFlowField(goals.front());
+  std::cout << "Flow field time: " << clock.restart().asMilliseconds() << "ms\n";
+
+  field = map.computeFlowField(goals);
+  std::cout << "Flow field time with " << goals.size() << " goals: " << clock.restart().asMilliseconds() << "ms\n";
+
+  std::vector<gf::Vector2i> cells;
+
+  for (std::size_t i = 0; i < 10; ++i) {
+    gf::Vector2i position = random.computePosition(gf::RectI::fromSize(map.getSize() - 1));
+    map.setWalkable(position, !map.isWalkable(position));
+    cells.push_back(position);
+  }
+
+  clock.restart();
+  map.updateFlowField(field, cells);
+  std::cout << "Flow field update time with 10 changes: " << clock.restart().asMicroseconds() << "us\n";
+}
@@ -0,0 +1,258 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/Noises.h>
+
+#include <cmath>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <gf/Clock.h>
+#include <gf/Random.h>
+#include <gf/VectorOps.h>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+  constexpr gf::Vector2d Origin2 = { 10.25, 3.5 };
+  constexpr gf::Vector2d Step2 = { 0.0625, 0.125 };
+  constexpr gf::Vector2i Size2 = { 37, 23 };
+
+  constexpr gf::Vector3d Origin3 = { 10.25, 3.5, 7.75 };
+  constexpr gf::Vector3d Step3 = { 0.0625, 0.125, 0.25 };
+  constexpr gf::Vector3i Size3 = { 13, 11, 7 };
+
+  void checkGrid(gf::Noise2D& noise) {
+    std::vector<double> values(Size2.width * Size2.height);
+    noise.fillGrid(Origin2, Step2, Size2, values);
+
+    for (int j = 0; j < Size2.height; ++j) {
+      for (int i = 0; i < Size2.width; ++i) {
+        double expected = noise.getValue(Origin2.x + i * Step2.x, Origin2.y + j * Step2.y);
+        EXPECT_NEAR(values[j * Size2.width + i], expected, 1e-9);
+      }
+    }
+  }
+
+  void checkGrid(gf::Noise3D& noise) {
+    std::vector<double> values(Size3.x * Size3.y * Size3.z);
+    noise.fillGrid(Origin3, Step3, Size3, values);
+
+    for (int k = 0; k < Size3.z; ++k) {
+      for (int j = 0; j < Size3.y; ++j) {
+        for (int i = 0; i < Size3.x; ++i) {
+          double expected = noise.getValue(Origin3.x + i * Step3.x, Origin3.y + j * Step3.y, Origin3.z + k * Step3.z);
+          EXPECT_NEAR(values[(k * Size3.y + j) * Size3.x + i], expected, 1e-9);
+        }
+      }
+    }
+  }
+
+  // the vectorized kernels follow the scalar computations exactly
+  void checkExactGrid(gf::Noise2D& noise) {
+    static constexpr gf::Vector2d Origin = { -7.3, -2.1 };
+    static constexpr gf::Vector2d Step = { 0.173, 0.137 };
+    static constexpr gf::Vector2i Size = { 87, 31 };
+
+    std::vector<double> values(Size.width * Size.height);
+    noise.fillGrid(Origin, Step, Size, values);
+
+    for (int j = 0; j < Size.height; ++j) {
+      for (int i = 0; i < Size.width; ++i) {
+        double expected = noise.getValue(Origin.x + i * Step.x, Origin.y + j * Step.y);
+        EXPECT_EQ(values[j * Size.width + i], expected);
+      }
+    }
+  }
+
+  void benchmarkGrid(gf::Noise2D& noise, const char *name) {
+    static constexpr gf::Vector2i Size = { 512, 512 };
+    static constexpr gf::Vector2d Step = { 1.0 / 64, 1.0 / 64 };
+    const double SampleCount = Size.width * Size.height;
+
+    std::vector<double> values(Size.width * Size.height);
+    gf::Clock clock;
+
+    for (int j = 0; j < Size.height; ++j) {
+      for (int i = 0; i < Size.width; ++i) {
+        values[j * Size.width + i] = noise.getValue(Origin2.x + i * Step.x, Origin2.y + j * Step.y);
+      }
+    }
+
+    double single = SampleCount / clock.restart().asSeconds();
+    noise.fillGrid(Origin2, Step, Size, values);
+    double grid = SampleCount / clock.restart().asSeconds();
+
+    std::cout << name << ": " << single / 1e6 << "M samples/s with getValue(), " << grid / 1e6 << "M samples/s with fillGrid()\n";
+  }
+
+}
+
+TEST(NoiseTest, FillGrid2D) {
+  gf::Random random(42);
+
+  gf::GradientNoise2D gradient(random, gf::quinticStep);
+  checkGrid(gradient);
+
+  gf::SimplexNoise2D simplex(random);
+  checkGrid(simplex);
+
+  for (auto variant : { gf::OpenSimplex2DVariant::Classic, gf::OpenSimplex2DVariant::XBeforeY }) {
+    gf::OpenSimplexNoise2D openSimplex(random, gf::OpenSimplexType::Super, variant);
+    checkGrid(openSimplex);
+  }
+
+  gf::PerlinNoise2D perlin(random, 0.5);
+  checkGrid(perlin);
+
+  gf::FractalNoise2D fractal(simplex, 0.5, 6, 2.0, 0.5, 0.8);
+  checkGrid(fractal);
+
+  gf::Multifractal2D multifractal(simplex, 0.5);
+  checkGrid(multifractal);
+
+  gf::HeteroTerrain2D hetero(simplex, 0.5, 0.3);
+  checkGrid(hetero);
+
+  gf::HybridMultifractal2D hybrid(simplex, 0.5, 0.3);
+  checkGrid(hybrid);
+
+  gf::RidgedMultifractal2D ridged(simplex, 0.5);
+  checkGrid(ridged);
+
+  gf::ValueNoise2D value(random, gf::cubicStep);
+  checkGrid(value);
+
+  gf::WorleyNoise2D worley(random, 20, gf::euclideanDistance<double, 2>, { -1.0, 1.0 });
+  checkGrid(worley);
+}
+
+TEST(NoiseTest, WorleyThreads) {
+  static constexpr gf::Vector2i Size = { 64, 64 };
+  static constexpr gf::Vector2d Step = { 1.0 / 32, 1.0 / 32 };
+
+  gf::Random random(42);
+  gf::WorleyNoise2D noise(random, 1024, gf::manhattanDistance<double, 2>, { 0.5, 0.3, 0.2 });
+
+  std::vector<double> expected(Size.width * Size.height);
+  noise.fillGrid(Origin2, Step, Size, expected);
+
+  std::vector<double> values(Size.width * Size.height);
+  std::vector<std::thread> threads;
+
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&noise, &values, t]() {
+      for (int j = t; j < Size.height; j += 4) {
+        for (int i = 0; i < Size.width; ++i) {
+          values[j * Size.width + i] = noise.getValue(Origin2.x + i * Step.x, Origin2.y + j * Step.y);
+        }
+      }
+    });
+  }
+
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(values, expected);
+}
+
+TEST(NoiseTest, FillGridSimplex) {
+  gf::Random random(42);
+
+  gf::SimplexNoise2D simplex(random);
+  checkExactGrid(simplex);
+
+  for (auto type : { gf::OpenSimplexType::Super, gf::OpenSimplexType::Fast }) {
+    for (auto variant : { gf::OpenSimplex2DVariant::Classic, gf::OpenSimplex2DVariant::XBeforeY }) {
+      gf::OpenSimplexNoise2D openSimplex(random, type, variant);
+      checkExactGrid(openSimplex);
+    }
+  }
+}
+
+TEST(NoiseTest, FillFloatGrid) {
+  gf::Random random(42);
+
+  gf::OpenSimplexNoise2D noise2(random);
+  std::vector<double> values2(Size2.width * Size2.height);
+  noise2.fillGrid(Origin2, Step2, Size2, values2);
+  std::vector<float> floatValues2(values2.size());
+  noise2.fillFloatGrid(Origin2, Step2, Size2, floatValues2);
+
+  for (std::size_t i = 0; i < values2.size(); ++i) {
+    EXPECT_EQ(floatValues2[i], static_cast<float>(values2[i]));
+  }
+
+  gf::GradientNoise3D noise3(random, gf::quinticStep);
+  std::vector<double> values3(Size3.x * Size3.y * Size3.z);
+  noise3.fillGrid(Origin3, Step3, Size3, values3);
+  std::vector<float> floatValues3(values3.size());
+  noise3.fillFloatGrid(Origin3, Step3, Size3, floatValues3);
+
+  for (std::size_t i = 0; i < values3.size(); ++i) {
+    EXPECT_EQ(floatValues3[i], static_cast<float>(values3[i]));
+  }
+}
+
+TEST(NoiseTest, FillGrid3D) {
+  gf::Random random(42);
+
+  gf::GradientNoise3D gradient(random, gf::quinticStep);
+  checkGrid(gradient);
+
+  for (auto variant : { gf::OpenSimplex3DVariant::Classic, gf::OpenSimplex3DVariant::XYBeforeZ, gf::OpenSimplex3DVariant::XZBeforeY }) {
+    gf::OpenSimplexNoise3D openSimplex(random, gf::OpenSimplexType::Super, variant);
+    checkGrid(openSimplex);
+  }
+
+  gf::PerlinNoise3D perlin(random, 0.5);
+  checkGrid(perlin);
+
+  gf::FractalNoise3D fractal(gradient, 0.5, 6, 2.0, 0.5, 0.8);
+  checkGrid(fractal);
+}
+
+TEST(NoiseTest, DISABLED_FillGridBenchmark) {
+  gf::Random random(42);
+
+  gf::GradientNoise2D gradient(random, gf::quinticStep);
+  benchmarkGrid(gradient, "Gradient");
+
+  gf::SimplexNoise2D simplex(random);
+  benchmarkGrid(simplex, "Simplex");
+
+  gf::OpenSimplexNoise2D openSimplex(random);
+  benchmarkGrid(openSimplex, "OpenSimplex");
+
+  gf::OpenSimplexNoise2D fastOpenSimplex(random, gf::OpenSimplexType::Fast);
+  benchmarkGrid(fastOpenSimplex, "OpenSimplex (fast)");
+
+  gf::PerlinNoise2D perlin(random, 1.0);
+  benchmarkGrid(perlin, "Perlin");
+
+  gf::RidgedMultifractal2D ridged(simplex, 1.0);
+  benchmarkGrid(ridged, "Ridged multifractal of simplex");
+
+  gf::WorleyNoise2D worley(random, 1024, gf::euclideanDistance<double, 2>, { -1.0, 1.0 });
+  benchmarkGrid(worley, "Worley with 1024 points");
+}
@@ -23,12 +23,16 @@
 #include <cstdint>
 #include <cstring>
 
+#include <filesystem>
+#include <iostream>
 #include <limits>
 #include <numeric>
 
 #include <gf/Array2D.h>
+#include <gf/Clock.h>
 #include <gf/Path.h>
 #include <gf/Paths.h>
+#include <gf/PointSequence.h>
 #include <gf/Streams.h>
 #include <gf/VectorOps.h>
 
@@ -37,12 +41,12 @@
 namespace {
 
   template<typename T>
-  void saveAndLoad(T& in, T& out) {
+  void saveAndLoad(T& in, T& out, gf::Serializer::Encoding encoding = gf::Serializer::Encoding::Fixed, std::vector<uint8_t> *saved = nullptr) {
     std::vector<uint8_t> bytes;
 
     {
       gf::BufferOutputStream ostream(&bytes);
-      gf::Serializer serializer(ostream);
+      gf::Serializer serializer(ostream, 0, gf::Serializer::Mode::Direct, encoding);
       serializer | in;
     }
 
@@ -51,6 +55,10 @@ namespace {
       gf::Deserializer deserializer(istream);
       deserializer | out;
     }
+
+    if (saved != nullptr) {
+      *saved = std::move(bytes);
+    }
   }
 
   struct SizeWrapper {
@@ -643,3 +651,539 @@ TEST(SerialTest, Compressed) {
 
   EXPECT_EQ(in1, out1);
 }
+
+TEST(SerialTest, Buffered) {
+  std::vector<float> in1 = { 1.0f, -2.5f, 3.25f };
+  std::string in2 = "gf";
+  int64_t in3 = -42;
+
+  std::vector<uint8_t> directBytes;
+
+  {
+    gf::BufferOutputStream ostream(&directBytes);
+    gf::Serializer ar(ostream, 1);
+    ar | in1 | in2 | in3;
+  }
+
+  std::vector<uint8_t> bufferedBytes;
+
+  {
+    gf::BufferOutputStream ostream(&bufferedBytes);
+    gf::Serializer ar(ostream, 1, gf::Serializer::Mode::Buffered);
+    ar | in1 | in2 | in3;
+    EXPECT_TRUE(bufferedBytes.empty());
+    ar.flush();
+    EXPECT_EQ(bufferedBytes.size(), directBytes.size());
+    ar | in3;
+  }
+
+  directBytes.resize(directBytes.size() + 8, 0xFF);
+  directBytes.back() = static_cast<uint8_t>(-42);
+  EXPECT_EQ(directBytes, bufferedBytes);
+
+  std::vector<float> out1;
+  std::string out2;
+  int64_t out3, out4;
+
+  {
+    gf::BufferInputStream istream(&bufferedBytes);
+    gf::Deserializer ar(istream);
+    ar | out1 | out2 | out3 | out4;
+  }
+
+  EXPECT_EQ(in1, out1);
+  EXPECT_EQ(in2, out2);
+  EXPECT_EQ(in3, out3);
+  EXPECT_EQ(in3, out4);
+}
+
+TEST(SerialTest, Bulk) {
+  std::vector<int16_t> in1 = { -1, 2, -300, 4000 };
+  std::vector<double> in2 = { 0.5, -1e100, 3.0 };
+  std::vector<gf::Vector2f> in3 = { { 1.0f, 2.0f }, { -3.0f, 4.5f } };
+  uint64_t in4[3] = { 1, 0x0123456789ABCDEF, std::numeric_limits<uint64_t>::max() };
+
+  // the bulk copies must produce exactly the element by element format
+  std::vector<uint8_t> bulkBytes;
+
+  {
+    gf::BufferOutputStream ostream(&bulkBytes);
+    gf::Serializer ar(ostream);
+    ar | in1 | in2 | gf::span(in3.data(), in3.size()) | in4;
+  }
+
+  std::vector<uint8_t> itemBytes;
+
+  {
+    gf::BufferOutputStream ostream(&itemBytes);
+    gf::Serializer ar(ostream);
+
+    ar.writeSizeHeader(in1.size());
+
+    for (auto item : in1) {
+      ar | item;
+    }
+
+    ar.writeSizeHeader(in2.size());
+
+    for (auto item : in2) {
+      ar | item;
+    }
+
+    ar.writeSizeHeader(in3.size());
+
+    for (auto item : in3) {
+      ar | item.x | item.y;
+    }
+
+    ar.writeSizeHeader(3);
+
+    for (auto item : in4) {
+      ar | item;
+    }
+  }
+
+  EXPECT_EQ(bulkBytes, itemBytes);
+
+  std::vector<int16_t> out1;
+  std::vector<double> out2;
+  std::vector<gf::Vector2f> out3(in3.size());
+  uint64_t out4[3];
+
+  {
+    gf::BufferInputStream istream(&bulkBytes);
+    gf::Deserializer ar(istream);
+    ar | out1 | out2 | gf::span(out3.data(), out3.size()) | out4;
+  }
+
+  EXPECT_EQ(in1, out1);
+  EXPECT_EQ(in2, out2);
+  EXPECT_EQ(in3, out3);
+
+  for (int i = 0; i < 3; ++i) {
+    EXPECT_EQ(in4[i], out4[i]);
+  }
+}
+
+TEST(SerialTest, CorruptedSize) {
+  static constexpr std::size_t HugeSize = std::size_t(1) << 40;
+
+  for (auto encoding : { gf::Serializer::Encoding::Fixed, gf::Serializer::Encoding::Compact }) {
+    // a huge size followed by only a few elements must fail without allocating the announced size
+    std::vector<uint8_t> bytes;
+
+    {
+      gf::BufferOutputStream ostream(&bytes);
+      gf::Serializer ar(ostream, 0, gf::Serializer::Mode::Direct, encoding);
+      ar | SizeWrapper{ HugeSize } | int32_t(1) | int32_t(2);
+    }
+
+    std::vector<int32_t> out1 = { 42 };
+
+    {
+      gf::BufferInputStream istream(&bytes);
+      gf::Deserializer ar(istream);
+      ar | out1;
+    }
+
+    EXPECT_TRUE(out1.empty());
+
+    std::vector<float> out2 = { 42.0f };
+
+    {
+      gf::BufferInputStream istream(&bytes);
+      gf::Deserializer ar(istream);
+      ar | out2;
+    }
+
+    EXPECT_TRUE(out2.empty());
+
+    bytes.clear();
+
+    {
+      gf::BufferOutputStream ostream(&bytes);
+      gf::Serializer ar(ostream, 0, gf::Serializer::Mode::Direct, encoding);
+      ar | SizeWrapper{ HugeSize } | 'g' | 'f';
+    }
+
+    std::string out4 = "gf";
+
+    {
+      gf::BufferInputStream istream(&bytes);
+      gf::Deserializer ar(istream);
+      ar | out4;
+    }
+
+    EXPECT_TRUE(out4.empty());
+
+    bytes.clear();
+
+    {
+      gf::BufferOutputStream ostream(&bytes);
+      gf::Serializer ar(ostream, 0, gf::Serializer::Mode::Direct, encoding);
+      ar | uint64_t(HugeSize) | 1.0f | 2.0f;
+    }
+
+    gf::PointSequence out3(std::vector<gf::Vector2f>({ { 0.0f, 0.0f } }));
+
+    {
+      gf::BufferInputStream istream(&bytes);
+      gf::Deserializer ar(istream);
+      ar | out3;
+    }
+
+    EXPECT_EQ(out3.getPointCount(), 0u);
+
+    bytes.clear();
+
+    {
+      gf::BufferOutputStream ostream(&bytes);
+      gf::Serializer ar(ostream, 0, gf::Serializer::Mode::Direct, encoding);
+      ar | uint32_t(1 << 20) | uint32_t(1 << 20) | int32_t(1) | int32_t(2);
+    }
+
+    gf::Array2D<int32_t> out5({ 2u, 2u }, 42);
+
+    {
+      gf::BufferInputStream istream(&bytes);
+      gf::Deserializer ar(istream);
+      ar | out5;
+    }
+
+    EXPECT_TRUE(out5.isEmpty());
+  }
+}
+
+TEST(SerialTest, DISABLED_BulkBenchmark) {
+  static constexpr int Size = 1024;
+
+  gf::Array2D<int32_t> in1({ Size, Size });
+  std::iota(in1.begin(), in1.end(), -Size * Size / 2);
+  std::vector<float> in2(Size * Size);
+  std::iota(in2.begin(), in2.end(), 0.5f);
+
+  const gf::Path filename = std::filesystem::temp_directory_path() / "gf_serial_benchmark.dat";
+  const std::size_t total = 2 * sizeof(int32_t) + in1.getDataSize() * sizeof(int32_t) + 4 + in2.size() * sizeof(float);
+
+  auto megabytesPerSecond = [total](gf::Time time) {
+    return static_cast<double>(total) / time.asMicroseconds();
+  };
+
+  auto writeElementByElement = [&](gf::Serializer::Mode mode) {
+    gf::Clock clock;
+    gf::FileOutputStream ostream(filename);
+    gf::Serializer ar(ostream, 0, mode);
+
+    ar | in1.getSize().width | in1.getSize().height;
+
+    for (auto item : in1) {
+      ar | item;
+    }
+
+    ar.writeSizeHeader(in2.size());
+
+    for (auto item : in2) {
+      ar | item;
+    }
+
+    return clock.getElapsedTime();
+  };
+
+  auto writeBulk = [&](gf::Serializer::Mode mode) {
+    gf::Clock clock;
+    gf::FileOutputStream ostream(filename);
+    gf::Serializer ar(ostream, 0, mode);
+    ar | in1 | in2;
+    return clock.getElapsedTime();
+  };
+
+  gf::Time itemTime = writeElementByElement(gf::Serializer::Mode::Direct);
+  gf::Time itemBufferedTime = writeElementByElement(gf::Serializer::Mode::Buffered);
+  gf::Time bulkTime = writeBulk(gf::Serializer::Mode::Direct);
+  gf::Time bulkBufferedTime = writeBulk(gf::Serializer::Mode::Buffered);
+
+  std::vector<int32_t> itemOut1(in1.getDataSize());
+  std::vector<float> itemOut2(in2.size());
+  gf::Clock clock;
+
+  {
+    gf::FileInputStream istream(filename);
+    gf::Deserializer ar(istream);
+
+    int32_t width, height;
+    ar | width | height;
+
+    for (auto& item : itemOut1) {
+      ar | item;
+    }
+
+    std::size_t size;
+    ar.readSizeHeader(size);
+
+    for (auto& item : itemOut2) {
+      ar | item;
+    }
+  }
+
+  gf::Time itemReadTime = clock.restart();
+
+  gf::Array2D<int32_t> out1;
+  std::vector<float> out2;
+
+  {
+    gf::FileInputStream istream(filename);
+    gf::Deserializer ar(istream);
+    ar | out1 | out2;
+  }
+
+  gf::Time bulkReadTime = clock.restart();
+
+  std::filesystem::remove(filename);
+
+  EXPECT_TRUE(std::equal(in1.begin(), in1.end(), itemOut1.begin(), itemOut1.end()));
+  EXPECT_EQ(in2, itemOut2);
+  EXPECT_EQ(in1, out1);
+  EXPECT_EQ(in2, out2);
+
+  std::cout << "Write element by element direct: " << megabytesPerSecond(itemTime) << "MB/s, buffered: " << megabytesPerSecond(itemBufferedTime) << "MB/s\n";
+  std::cout << "Write bulk direct: " << megabytesPerSecond(bulkTime) << "MB/s, buffered: " << megabytesPerSecond(bulkBufferedTime) << "MB/s\n";
+  std::cout << "Read element by element: " << megabytesPerSecond(itemReadTime) << "MB/s, bulk: " << megabytesPerSecond(bulkReadTime) << "MB/s\n";
+}
+
+namespace {
+
+  template<typename T>
+  void checkCompact(std::initializer_list<T> values) {
+    for (T in : values) {
+      T out = 0;
+      saveAndLoad(in, out, gf::Serializer::Encoding::Compact);
+      EXPECT_EQ(in, out);
+    }
+  }
+
+  template<typename T>
+  std::vector<uint8_t> saveCompact(T data) {
+    std::vector<uint8_t> bytes;
+
+    {
+      gf::BufferOutputStream ostream(&bytes);
+      gf::Serializer ar(ostream, 0, gf::Serializer::Mode::Direct, gf::Serializer::Encoding::Compact);
+      ar | data;
+    }
+
+    // remove the header
+    bytes.erase(bytes.begin(), bytes.begin() + 4);
+    return bytes;
+  }
+
+  struct SaveFile {
+    struct Entity {
+      uint32_t id;
+      int32_t health;
+      int16_t level;
+      gf::Vector2f position;
+      gf::Vector2i cell;
+      std::string name;
+      std::vector<uint16_t> inventory;
+    };
+
+    uint64_t seed;
+    int64_t turn;
+    std::vector<Entity> entities;
+    gf::Array2D<int32_t> tiles;
+  };
+
+  template<typename Archive>
+  Archive& operator|(Archive& ar, SaveFile::Entity& entity) {
+    return ar | entity.id | entity.health | entity.level | entity.position | entity.cell | entity.name | entity.inventory;
+  }
+
+  gf::Serializer& operator|(gf::Serializer& ar, const SaveFile& save) {
+    return ar | save.seed | save.turn | save.entities | save.tiles;
+  }
+
+  gf::Deserializer& operator|(gf::Deserializer& ar, SaveFile& save) {
+    return ar | save.seed | save.turn | save.entities | save.tiles;
+  }
+
+  SaveFile createSaveFile(int entityCount, int mapSize) {
+    SaveFile save;
+    save.seed = 0x0123456789ABCDEF;
+    save.turn = 1234;
+
+    for (int i = 0; i < entityCount; ++i) {
+      SaveFile::Entity entity;
+      entity.id = static_cast<uint32_t>(i);
+      entity.health = 100 - i % 120;
+      entity.level = static_cast<int16_t>(i % 50);
+      entity.position = gf::vec(i * 0.5f, i * -0.25f);
+      entity.cell = gf::vec(i % mapSize, i / mapSize);
+      entity.name = "entity" + std::to_string(i);
+      entity.inventory.resize(i % 8);
+      std::iota(entity.inventory.begin(), entity.inventory.end(), static_cast<uint16_t>(i % 500));
+      save.entities.push_back(std::move(entity));
+    }
+
+    save.tiles = gf::Array2D<int32_t>(gf::vec(static_cast<unsigned>(mapSize), static_cast<unsigned>(mapSize)));
+
+    for (auto position : save.tiles.getPositionRange()) {
+      save.tiles(position) = (position.x * 7 + position.y * 3) % 16;
+    }
+
+    return save;
+  }
+
+  void checkSaveFile(const SaveFile& in, const SaveFile& out) {
+    EXPECT_EQ(out.seed, in.seed);
+    EXPECT_EQ(out.turn, in.turn);
+    EXPECT_EQ(out.tiles, in.tiles);
+    ASSERT_EQ(out.entities.size(), in.entities.size());
+
+    for (std::size_t i = 0; i < out.entities.size(); ++i) {
+      EXPECT_EQ(out.entities[i].health, in.entities[i].health);
+      EXPECT_EQ(out.entities[i].position, in.entities[i].position);
+      EXPECT_EQ(out.entities[i].name, in.entities[i].name);
+      EXPECT_EQ(out.entities[i].inventory, in.entities[i].inventory);
+    }
+  }
+
+}
+
+TEST(SerialTest, Compact) {
+  checkCompact<int16_t>({ 0, 1, -1, 63, -64, 64, std::numeric_limits<int16_t>::min(), std::numeric_limits<int16_t>::max() });
+  checkCompact<int32_t>({ 0, -1, 300, -300, std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max() });
+  checkCompact<int64_t>({ 0, -1, 1LL << 40, std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max() });
+  checkCompact<uint16_t>({ 0, 127, 128, std::numeric_limits<uint16_t>::max() });
+  checkCompact<uint32_t>({ 0, 127, 128, 16383, 16384, std::numeric_limits<uint32_t>::max() });
+  checkCompact<uint64_t>({ 0, 127, 128, 1ULL << 63, std::numeric_limits<uint64_t>::max() });
+
+  EXPECT_EQ(saveCompact<uint32_t>(0), std::vector<uint8_t>({ 0x00 }));
+  EXPECT_EQ(saveCompact<uint32_t>(300), std::vector<uint8_t>({ 0xAC, 0x02 }));
+  EXPECT_EQ(saveCompact<int32_t>(-1), std::vector<uint8_t>({ 0x01 }));
+  EXPECT_EQ(saveCompact<int32_t>(1), std::vector<uint8_t>({ 0x02 }));
+  EXPECT_EQ(saveCompact<int32_t>(-64), std::vector<uint8_t>({ 0x7F }));
+  EXPECT_EQ(saveCompact<uint64_t>(std::numeric_limits<uint64_t>::max()), std::vector<uint8_t>({ 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01 }));
+  EXPECT_EQ(saveCompact<float>(1.0f), std::vector<uint8_t>({ 0x3F, 0x80, 0x00, 0x00 }));
+  EXPECT_EQ(saveCompact(SizeWrapper{ 1000 }), std::vector<uint8_t>({ 0xE8, 0x07 }));
+
+  std::vector<int32_t> in1 = { -1, 0, 1, 1000000, std::numeric_limits<int32_t>::min() };
+  std::vector<int32_t> out1;
+  saveAndLoad(in1, out1, gf::Serializer::Encoding::Compact);
+  EXPECT_EQ(in1, out1);
+
+  std::vector<gf::Vector2f> in2 = { { 1.0f, 2.0f }, { -3.0f, 4.5f } };
+  std::vector<gf::Vector2f> out2;
+  saveAndLoad(in2, out2, gf::Serializer::Encoding::Compact);
+  EXPECT_EQ(in2, out2);
+
+  std::string in3 = "gamedev framework";
+  std::string out3;
+  saveAndLoad(in3, out3, gf::Serializer::Encoding::Compact);
+  EXPECT_EQ(in3, out3);
+}
+
+TEST(SerialTest, CompactDetection) {
+  constexpr uint16_t Version = 42;
+  std::vector<uint8_t> bytes;
+
+  {
+    gf::BufferOutputStream ostream(&bytes);
+    gf::Serializer ar(ostream, Version, gf::Serializer::Mode::Buffered, gf::Serializer::Encoding::Compact);
+    EXPECT_EQ(ar.getEncoding(), gf::Serializer::Encoding::Compact);
+    ar | int32_t(-2);
+  }
+
+  EXPECT_EQ(bytes, std::vector<uint8_t>({ 'g', 'v', 0x00, 0x2A, 0x03 }));
+
+  {
+    gf::BufferInputStream istream(&bytes);
+    gf::Deserializer ar(istream);
+    EXPECT_EQ(ar.getEncoding(), gf::Serializer::Encoding::Compact);
+    EXPECT_EQ(ar.getVersion(), Version);
+
+    int32_t out;
+    ar | out;
+    EXPECT_EQ(out, -2);
+  }
+
+  // a value that does not fit in the asked type
+  bytes = { 'g', 'v', 0x00, 0x00, 0x80, 0x80, 0x04 };
+
+  {
+    gf::BufferInputStream istream(&bytes);
+    gf::Deserializer ar(istream);
+    uint16_t out;
+    EXPECT_FALSE(ar.readUnsigned16(out));
+  }
+
+  // a varint that is too long for 64 bits
+  bytes = { 'g', 'v', 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x02 };
+
+  {
+    gf::BufferInputStream istream(&bytes);
+    gf::Deserializer ar(istream);
+    uint64_t out;
+    EXPECT_FALSE(ar.readUnsigned64(out));
+  }
+
+  // a varint that is cut by the end of the stream
+  bytes = { 'g', 'v', 0x00, 0x00, 0xFF, 0xFF };
+
+  {
+    gf::BufferInputStream istream(&bytes);
+    gf::Deserializer ar(istream);
+    int64_t out;
+    EXPECT_FALSE(ar.readSigned64(out));
+  }
+}
+
+TEST(SerialTest, CompactSaveFile) {
+  SaveFile in = createSaveFile(500, 16);
+
+  SaveFile fixedOut;
+  std::vector<uint8_t> fixedBytes;
+  saveAndLoad(in, fixedOut, gf::Serializer::Encoding::Fixed, &fixedBytes);
+  checkSaveFile(in, fixedOut);
+
+  SaveFile compactOut;
+  std::vector<uint8_t> compactBytes;
+  saveAndLoad(in, compactOut, gf::Serializer::Encoding::Compact, &compactBytes);
+  checkSaveFile(in, compactOut);
+
+  EXPECT_LT(compactBytes.size(), fixedBytes.size());
+}
+
+TEST(SerialTest, DISABLED_CompactBenchmark) {
+  SaveFile in = createSaveFile(20000, 256);
+
+  auto encode = [&in](gf::Serializer::Encoding encoding, std::vector<uint8_t>& bytes) {
+    gf::Clock clock;
+    gf::BufferOutputStream ostream(&bytes);
+    gf::Serializer ar(ostream, 0, gf::Serializer::Mode::Buffered, encoding);
+    ar | in;
+    ar.flush();
+    return clock.getElapsedTime();
+  };
+
+  auto decode = [&in](std::vector<uint8_t>& bytes) {
+    gf::Clock clock;
+    gf::BufferInputStream istream(&bytes);
+    gf::Deserializer ar(istream);
+    SaveFile out;
+    ar | out;
+    gf::Time time = clock.getElapsedTime();
+    checkSaveFile(in, out);
+    return time;
+  };
+
+  std::vector<uint8_t> fixedBytes;
+  gf::Time fixedEncodeTime = encode(gf::Serializer::Encoding::Fixed, fixedBytes);
+  gf::Time fixedDecodeTime = decode(fixedBytes);
+
+  std::vector<uint8_t> compactBytes;
+  gf::Time compactEncodeTime = encode(gf::Serializer::Encoding::Compact, compactBytes);
+  gf::Time compactDecodeTime = decode(compactBytes);
+
+  std::cout << "Fixed: " << fixedBytes.size() << " bytes, encode " << fixedEncodeTime.asMicroseconds() << "us, decode " << fixedDecodeTime.asMicroseconds() << "us\n";
+  std::cout << "Compact: " << compactBytes.size() << " bytes, encode " << compactEncodeTime.asMicroseconds() << "us, decode " << compactDecodeTime.asMicroseconds() << "us\n";
+}
@@ -23,6 +23,7 @@
 #include <iostream>
 
 #include <gf/Clock.h>
+#include <gf/Math.h>
 #include <gf/Random.h>
 
 #include "gtest/gtest.h"
@@ -45,6 +46,8 @@ namespace {
   constexpr gf::RectF Bounds = gf::RectF::fromPositionSize({ 0.0f, 0.0f }, { 100.0f, 100.0f });
   constexpr std::size_t SampleSize = 10000;
   constexpr std::size_t QuerySize = 20;
+  constexpr std::size_t QueryBenchmarkSize = 1000;
+  constexpr gf::Vector2f CellSize = { 10.0f, 10.0f };
 
   gf::RectF getRandomBox(gf::Random& random) {
     gf::RectF rect;
@@ -232,6 +235,421 @@ namespace {
 
     EXPECT_EQ(result.set.size(), SampleSize);
   }
+
+  template<typename T>
+  void testQueryCallbackRandom(T& spatial) {
+    gf::Random random(77);
+
+    auto boxes = getRandomBoxes(random);
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      spatial.insert(gf::Handle(i), boxes[i]);
+    }
+
+    for (std::size_t i = 0; i < QuerySize; ++i) {
+      auto queryBox = getRandomQueryBox(random);
+
+      Callback functionResult;
+      gf::SpatialQueryCallback callback = std::ref(functionResult);
+      std::size_t functionFound = spatial.query(queryBox, callback);
+
+      Callback templateResult;
+      std::size_t templateFound = spatial.query(queryBox, std::ref(templateResult));
+
+      std::vector<gf::Handle> handles;
+      std::size_t vectorFound = spatial.query(queryBox, handles);
+
+      std::set<gf::Id> vectorResult;
+
+      for (auto handle : handles) {
+        vectorResult.insert(handle.asId());
+      }
+
+      EXPECT_EQ(functionFound, functionResult.set.size());
+      EXPECT_EQ(templateFound, functionFound);
+      EXPECT_EQ(vectorFound, functionFound);
+      EXPECT_EQ(templateResult.set, functionResult.set);
+      EXPECT_EQ(vectorResult, functionResult.set);
+    }
+  }
+
+  template<typename T>
+  void benchmarkQueryCallback(T& spatial, const char *name) {
+    gf::Random random(77);
+
+    auto boxes = getRandomBoxes(random);
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      spatial.insert(gf::Handle(i), boxes[i]);
+    }
+
+    std::vector<gf::RectF> queryBoxes;
+
+    for (std::size_t i = 0; i < QueryBenchmarkSize; ++i) {
+      queryBoxes.push_back(getRandomQueryBox(random));
+    }
+
+    gf::Clock clock;
+
+    std::size_t functionFound = 0;
+
+    for (auto& queryBox : queryBoxes) {
+      gf::SpatialQueryCallback callback = [&](gf::Handle) { ++functionFound; };
+      spatial.query(queryBox, callback);
+    }
+
+    gf::Time functionTime = clock.restart();
+
+    std::size_t templateFound = 0;
+
+    for (auto& queryBox : queryBoxes) {
+      spatial.query(queryBox, [&](gf::Handle) { ++templateFound; });
+    }
+
+    gf::Time templateTime = clock.restart();
+
+    std::size_t vectorFound = 0;
+    std::vector<gf::Handle> handles;
+
+    for (auto& queryBox : queryBoxes) {
+      handles.clear();
+      vectorFound += spatial.query(queryBox, handles);
+    }
+
+    gf::Time vectorTime = clock.restart();
+
+    EXPECT_EQ(functionFound, templateFound);
+    EXPECT_EQ(functionFound, vectorFound);
+
+    std::cout << name << ", query time (std::function): " << functionTime.asMicroseconds() / QueryBenchmarkSize << "us\n";
+    std::cout << name << ", query time (template): " << templateTime.asMicroseconds() / QueryBenchmarkSize << "us\n";
+    std::cout << name << ", query time (vector): " << vectorTime.asMicroseconds() / QueryBenchmarkSize << "us\n";
+  }
+
+  float getSquareDistance(gf::Vector2f point, const gf::RectF& bounds) {
+    float distance = 0.0f;
+
+    for (std::size_t j = 0; j < 2; ++j) {
+      distance += gf::square(std::max({ bounds.min[j] - point[j], 0.0f, point[j] - bounds.max[j] }));
+    }
+
+    return distance;
+  }
+
+  template<typename T>
+  void testQueryNearestRandom(T& spatial) {
+    gf::Random random(13);
+    gf::SimpleSpatialIndex reference;
+
+    auto boxes = getRandomBoxes(random);
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      reference.insert(gf::Handle(i), boxes[i]);
+      spatial.insert(gf::Handle(i), boxes[i]);
+    }
+
+    gf::Clock clock;
+    gf::Time queryNearestTime = gf::Time::zero();
+
+    for (std::size_t i = 0; i < QuerySize; ++i) {
+      gf::Vector2f point = random.computePosition(Bounds);
+      float maxDistance = (i % 2 == 0) ? std::numeric_limits<float>::max() : random.computeUniformFloat(1.0f, 10.0f);
+      std::size_t count = random.computeUniformInteger<std::size_t>(1, 50);
+
+      std::vector<float> referenceDistances;
+      std::size_t referenceFound = reference.queryNearest(point, count, [&](gf::Handle handle) {
+        referenceDistances.push_back(getSquareDistance(point, boxes[handle.asId()]));
+      }, maxDistance);
+
+      std::vector<float> spatialDistances;
+      clock.restart();
+      std::size_t spatialFound = spatial.queryNearest(point, count, [&](gf::Handle handle) {
+        spatialDistances.push_back(getSquareDistance(point, boxes[handle.asId()]));
+      }, maxDistance);
+      queryNearestTime += clock.restart();
+
+      EXPECT_EQ(referenceFound, spatialFound);
+      EXPECT_LE(spatialFound, count);
+      EXPECT_TRUE(std::is_sorted(spatialDistances.begin(), spatialDistances.end()));
+      EXPECT_EQ(referenceDistances, spatialDistances);
+    }
+
+    std::cout << "Query time (Nearest): " << queryNearestTime.asMicroseconds() / QuerySize << "us\n";
+  }
+
+  bool getRaycastFraction(gf::Vector2f origin, gf::Vector2f displacement, const gf::RectF& bounds, float& fraction) {
+    // sampling along the ray, enough to check the order and the first hits
+    static constexpr int Steps = 1000;
+
+    for (int i = 0; i <= Steps; ++i) {
+      float t = static_cast<float>(i) / Steps;
+
+      if (bounds.contains(origin + t * displacement)) {
+        fraction = t;
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+  template<typename T>
+  void testQueryRaycastRandom(T& spatial) {
+    gf::Random random(31);
+
+    auto boxes = getRandomBoxes(random);
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      spatial.insert(gf::Handle(i), boxes[i]);
+    }
+
+    gf::Clock clock;
+    gf::Time queryRaycastTime = gf::Time::zero();
+
+    for (std::size_t i = 0; i < QuerySize; ++i) {
+      gf::Vector2f origin = random.computePosition(Bounds);
+      gf::Vector2f displacement = random.computePosition(Bounds) - origin;
+
+      std::vector<float> fractions;
+      std::set<gf::Id> hits;
+
+      clock.restart();
+      std::size_t found = spatial.queryRaycast(origin, displacement, [&](gf::Handle handle, float fraction) {
+        fractions.push_back(fraction);
+        hits.insert(handle.asId());
+        return true;
+      });
+      queryRaycastTime += clock.restart();
+
+      EXPECT_EQ(found, fractions.size());
+      EXPECT_TRUE(std::is_sorted(fractions.begin(), fractions.end()));
+
+      for (std::size_t j = 0; j < SampleSize; ++j) {
+        float fraction;
+
+        if (getRaycastFraction(origin, displacement, boxes[j], fraction)) {
+          EXPECT_EQ(hits.count(j), 1u);
+        }
+      }
+
+      // early termination
+
+      std::size_t calls = 0;
+      found = spatial.queryRaycast(origin, displacement, [&](gf::Handle, float fraction) {
+        ++calls;
+        EXPECT_EQ(fraction, fractions.front());
+        return false;
+      });
+
+      EXPECT_EQ(found, calls);
+      EXPECT_EQ(calls, std::min(fractions.size(), std::size_t(1)));
+    }
+
+    std::cout << "Query time (Raycast): " << queryRaycastTime.asMicroseconds() / QuerySize << "us\n";
+
+    for (std::size_t i = 0; i < QuerySize; ++i) {
+      gf::RectF bounds = getRandomBox(random);
+      gf::Vector2f displacement = random.computePosition(Bounds) - bounds.getCenter();
+
+      std::vector<float> fractions;
+      std::set<gf::Id> hits;
+
+      std::size_t found = spatial.querySweep(bounds, displacement, [&](gf::Handle handle, float fraction) {
+        fractions.push_back(fraction);
+        hits.insert(handle.asId());
+        return true;
+      });
+
+      EXPECT_EQ(found, fractions.size());
+      EXPECT_TRUE(std::is_sorted(fractions.begin(), fractions.end()));
+
+      gf::RectF finalBounds = gf::RectF::fromMinMax(bounds.min + displacement, bounds.max + displacement);
+
+      for (std::size_t j = 0; j < SampleSize; ++j) {
+        if (bounds.intersects(boxes[j]) || finalBounds.intersects(boxes[j])) {
+          EXPECT_EQ(hits.count(j), 1u);
+        }
+      }
+    }
+  }
+
+  template<typename T>
+  gf::Time testWorkloadRandom(T& spatial, std::size_t roundCount) {
+    // every index gets the same workload, checked against a reference index
+
+    gf::Random random(2023);
+    gf::SimpleSpatialIndex reference;
+
+    struct Object {
+      gf::SpatialId id;
+      gf::SpatialId referenceId;
+      gf::RectF bounds;
+    };
+
+    std::vector<Object> objects;
+    std::size_t next = 0;
+
+    gf::Clock clock;
+    gf::Time time = gf::Time::zero();
+
+    auto insert = [&]() {
+      auto box = getRandomBox(random);
+      clock.restart();
+      auto id = spatial.insert(gf::Handle(next), box);
+      time += clock.restart();
+      objects.push_back({ id, reference.insert(gf::Handle(next), box), box });
+      ++next;
+    };
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      insert();
+    }
+
+    for (std::size_t round = 0; round < roundCount; ++round) {
+      // move every object a little
+      for (auto& object : objects) {
+        gf::Vector2f position = object.bounds.getPosition();
+        gf::Vector2f size = object.bounds.getSize();
+
+        for (std::size_t j = 0; j < 2; ++j) {
+          position[j] = gf::clamp(position[j] + random.computeUniformFloat(-1.0f, 1.0f), 0.0f, 100.0f - size[j]);
+        }
+
+        object.bounds = gf::RectF::fromPositionSize(position, size);
+        clock.restart();
+        spatial.modify(object.id, object.bounds);
+        time += clock.restart();
+        reference.modify(object.referenceId, object.bounds);
+      }
+
+      // remove and insert some objects
+      for (std::size_t i = 0; i < SampleSize / 10; ++i) {
+        auto index = random.computeUniformInteger<std::size_t>(0, objects.size() - 1);
+        std::swap(objects[index], objects.back());
+        clock.restart();
+        spatial.remove(objects.back().id);
+        time += clock.restart();
+        reference.remove(objects.back().referenceId);
+        objects.pop_back();
+      }
+
+      for (std::size_t i = 0; i < SampleSize / 10; ++i) {
+        insert();
+      }
+
+      for (std::size_t i = 0; i < QuerySize; ++i) {
+        auto queryBox = getRandomQueryBox(random);
+
+        for (auto kind : { gf::SpatialQuery::Intersect, gf::SpatialQuery::Contain }) {
+          Callback referenceResult;
+          reference.query(queryBox, std::ref(referenceResult), kind);
+
+          Callback spatialResult;
+          clock.restart();
+          spatial.query(queryBox, std::ref(spatialResult), kind);
+          time += clock.restart();
+
+          EXPECT_EQ(referenceResult.set, spatialResult.set);
+        }
+      }
+    }
+
+    return time;
+  }
+
+  std::vector<gf::SpatialObject> getRandomObjects(gf::Random& random) {
+    std::vector<gf::SpatialObject> res;
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      res.push_back({ gf::Handle(i), getRandomBox(random) });
+    }
+
+    return res;
+  }
+
+  template<typename T>
+  std::size_t countVisitedNodes(const T& spatial, const gf::RectF& bounds) {
+    std::size_t visited = 0;
+
+    spatial.queryStructure([&](const gf::SpatialStructure& structure) {
+      if (structure.type == gf::SpatialStructureType::Node && structure.bounds.intersects(bounds)) {
+        ++visited;
+      }
+    });
+
+    return visited;
+  }
+
+  template<typename T>
+  void testLoadRandom(T& spatial) {
+    gf::Random random(51);
+
+    auto objects = getRandomObjects(random);
+
+    gf::Clock clock;
+    auto ids = spatial.load(objects);
+    gf::Time loadTime = clock.restart();
+
+    T inserted;
+
+    for (auto& object : objects) {
+      inserted.insert(object.handle, object.bounds);
+    }
+
+    gf::Time insertionTime = clock.restart();
+    std::cout << "Load time: " << loadTime.asMilliseconds() << "ms (insertion time: " << insertionTime.asMilliseconds() << "ms)\n";
+
+    ASSERT_EQ(ids.size(), SampleSize);
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      ASSERT_EQ(spatial[ids[i]].asId(), objects[i].handle.asId());
+    }
+
+    gf::SimpleSpatialIndex reference;
+
+    for (auto& object : objects) {
+      reference.insert(object.handle, object.bounds);
+    }
+
+    std::size_t loadVisited = 0;
+    std::size_t insertionVisited = 0;
+
+    for (std::size_t i = 0; i < QuerySize; ++i) {
+      auto queryBox = getRandomQueryBox(random);
+
+      Callback referenceResult;
+      reference.query(queryBox, std::ref(referenceResult), gf::SpatialQuery::Intersect);
+
+      Callback spatialResult;
+      spatial.query(queryBox, std::ref(spatialResult), gf::SpatialQuery::Intersect);
+
+      EXPECT_EQ(referenceResult.set, spatialResult.set);
+
+      loadVisited += countVisitedNodes(spatial, queryBox);
+      insertionVisited += countVisitedNodes(inserted, queryBox);
+    }
+
+    std::cout << "Visited nodes per query: " << loadVisited / QuerySize << " (insertion: " << insertionVisited / QuerySize << ")\n";
+
+    // the tree must still be usable after a bulk load
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      if (i % 3 == 0) {
+        spatial.modify(ids[i], getRandomBox(random));
+      } else if (i % 3 == 1) {
+        spatial.remove(ids[i]);
+      }
+    }
+
+    for (std::size_t i = 0; i < QuerySize; ++i) {
+      spatial.insert(gf::Handle(SampleSize + i), getRandomBox(random));
+    }
+
+    Callback result;
+    spatial.query(Bounds, std::ref(result), gf::SpatialQuery::Contain);
+
+    EXPECT_EQ(result.set.size(), SampleSize - (SampleSize + 1) / 3 + QuerySize);
+  }
 }
 
 /*
@@ -258,6 +676,11 @@ TEST(SpatialTest, SimpleSpatialIndexModifyRandom) {
   testModifyRandom(spatial);
 }
 
+TEST(SpatialTest, SimpleSpatialIndexQueryCallbackRandom) {
+  gf::SimpleSpatialIndex spatial;
+  testQueryCallbackRandom(spatial);
+}
+
 /*
  * QuadTree
  */
@@ -287,6 +710,16 @@ TEST(SpatialTest, QuadtreeModifyRandom) {
   testModifyRandom(spatial);
 }
 
+TEST(SpatialTest, QuadtreeQueryCallbackRandom) {
+  gf::Quadtree spatial(Bounds);
+  testQueryCallbackRandom(spatial);
+}
+
+TEST(SpatialTest, QuadtreeQueryNearestRandom) {
+  gf::Quadtree spatial(Bounds);
+  testQueryNearestRandom(spatial);
+}
+
 /*
  * DynamicTree
  */
@@ -296,6 +729,109 @@ TEST(SpatialTest, DynamicTreeInsertSimple) {
   testInsertSimple(spatial);
 }
 
+TEST(SpatialTest, DynamicTreeModifyMargin) {
+  static constexpr std::size_t FrameCount = 20;
+  std::size_t previousReinsertions = SampleSize * FrameCount + 1;
+
+  for (float margin : { 0.0f, 0.5f, 2.0f }) {
+    gf::Random random(17);
+    gf::DynamicTree spatial(margin);
+    gf::SimpleSpatialIndex reference;
+
+    auto boxes = getRandomBoxes(random);
+    std::vector<gf::Vector2f> velocities;
+    std::vector<gf::SpatialId> ids;
+    std::vector<gf::SpatialId> referenceIds;
+
+    for (std::size_t i = 0; i < SampleSize; ++i) {
+      ids.push_back(spatial.insert(gf::Handle(i), boxes[i]));
+      referenceIds.push_back(reference.insert(gf::Handle(i), boxes[i]));
+      velocities.push_back(random.computePosition(gf::RectF::fromMinMax({ -0.2f, -0.2f }, { 0.2f, 0.2f })));
+    }
+
+    for (std::size_t frame = 0; frame < FrameCount; ++frame) {
+      for (std::size_t i = 0; i < SampleSize; ++i) {
+        boxes[i] = gf::RectF::fromPositionSize(boxes[i].getPosition() + velocities[i], boxes[i].getSize());
+        spatial.modify(ids[i], boxes[i], velocities[i]);
+        reference.modify(referenceIds[i], boxes[i]);
+      }
+    }
+
+    auto& statistics = spatial.getStatistics();
+    EXPECT_EQ(statistics.modifications, SampleSize * FrameCount);
+    // a larger margin skips more reinsertions
+    EXPECT_LT(statistics.reinsertions, previousReinsertions);
+    previousReinsertions = statistics.reinsertions;
+
+    for (std::size_t i = 0; i < QuerySize; ++i) {
+      auto queryBox = getRandomQueryBox(random);
+
+      Callback referenceResult;
+      reference.query(queryBox, std::ref(referenceResult), gf::SpatialQuery::Intersect);
+
+      Callback spatialResult;
+      spatial.query(queryBox, std::ref(spatialResult), gf::SpatialQuery::Intersect);
+
+      EXPECT_EQ(referenceResult.set, spatialResult.set);
+    }
+
+    spatial.resetStatistics();
+    EXPECT_EQ(spatial.getStatistics().modifications, 0u);
+  }
+}
+
+TEST(SpatialTest, DynamicTreeModifyInsideMargin) {
+  gf::DynamicTree spatial(1.0f);
+  gf::SpatialId id = spatial.insert(gf::Handle(1), gf::RectF::fromPositionSize({ 0.0f, 0.0f }, { 2.0f, 2.0f }));
+
+  // inside the fat bounds: no reinsertion
+  spatial.modify(id, gf::RectF::fromPositionSize({ 0.5f, -0.5f }, { 2.0f, 2.0f }));
+  EXPECT_EQ(spatial.getStatistics().modifications, 1u);
+  EXPECT_EQ(spatial.getStatistics().reinsertions, 0u);
+
+  std::vector<gf::Handle> handles;
+  spatial.query(gf::RectF::fromPositionSize({ 2.25f, 0.0f }, { 0.1f, 0.1f }), handles);
+  EXPECT_EQ(handles.size(), 1u);
+
+  // outside the fat bounds: reinsertion
+  spatial.modify(id, gf::RectF::fromPositionSize({ 5.0f, 5.0f }, { 2.0f, 2.0f }));
+  EXPECT_EQ(spatial.getStatistics().modifications, 2u);
+  EXPECT_EQ(spatial.getStatistics().reinsertions, 1u);
+
+  handles.clear();
+  spatial.query(gf::RectF::fromPositionSize({ 6.0f, 6.0f }, { 0.1f, 0.1f }), handles);
+  EXPECT_EQ(handles.size(), 1u);
+
+  spatial.clear();
+  EXPECT_EQ(spatial.getStatistics().modifications, 0u);
+  EXPECT_EQ(spatial.getStatistics().reinsertions, 0u);
+}
+
+TEST(SpatialTest, DynamicTreeModifyShrink) {
+  gf::DynamicTree spatial(0.5f);
+  gf::SpatialId id = spatial.insert(gf::Handle(1), gf::RectF::fromPositionSize({ 0.0f, 0.0f }, { 1.0f, 1.0f }));
+
+  // a fast object gets large fat bounds
+  spatial.modify(id, gf::RectF::fromPositionSize({ 2.0f, 0.0f }, { 1.0f, 1.0f }), { 10.0f, 0.0f });
+  EXPECT_EQ(spatial.getStatistics().reinsertions, 1u);
+
+  // still fast, inside its fat bounds: no reinsertion
+  spatial.modify(id, gf::RectF::fromPositionSize({ 12.0f, 0.0f }, { 1.0f, 1.0f }), { 10.0f, 0.0f });
+  EXPECT_EQ(spatial.getStatistics().reinsertions, 1u);
+
+  // the object stops, its fat bounds are too large: reinsertion
+  spatial.modify(id, gf::RectF::fromPositionSize({ 12.5f, 0.0f }, { 1.0f, 1.0f }), { 0.0f, 0.0f });
+  EXPECT_EQ(spatial.getStatistics().reinsertions, 2u);
+
+  // the object stays still: no reinsertion
+  spatial.modify(id, gf::RectF::fromPositionSize({ 12.75f, 0.0f }, { 1.0f, 1.0f }), { 0.0f, 0.0f });
+  EXPECT_EQ(spatial.getStatistics().reinsertions, 2u);
+
+  std::vector<gf::Handle> handles;
+  spatial.query(gf::RectF::fromPositionSize({ 13.0f, 0.5f }, { 0.1f, 0.1f }), handles);
+  EXPECT_EQ(handles.size(), 1u);
+}
+
 TEST(SpatialTest, DynamicTreeInsertRandom) {
   gf::DynamicTree spatial;
   testInsertRandom(spatial);
@@ -316,6 +852,21 @@ TEST(SpatialTest, DynamicTreeModifyRandom) {
   testModifyRandom(spatial);
 }
 
+TEST(SpatialTest, DynamicTreeQueryCallbackRandom) {
+  gf::DynamicTree spatial;
+  testQueryCallbackRandom(spatial);
+}
+
+TEST(SpatialTest, DynamicTreeQueryNearestRandom) {
+  gf::DynamicTree spatial;
+  testQueryNearestRandom(spatial);
+}
+
+TEST(SpatialTest, DynamicTreeQueryRaycastRandom) {
+  gf::DynamicTree spatial;
+  testQueryRaycastRandom(spatial);
+}
+
 /*
  * RStartTree
  */
@@ -344,3 +895,200 @@ TEST(SpatialTest, RStarTreeModifyRandom) {
   gf::RStarTree spatial;
   testModifyRandom(spatial);
 }
+
+TEST(SpatialTest, RStarTreeQueryCallbackRandom) {
+  gf::RStarTree spatial;
+  testQueryCallbackRandom(spatial);
+}
+
+TEST(SpatialTest, RStarTreeQueryNearestRandom) {
+  gf::RStarTree spatial;
+  testQueryNearestRandom(spatial);
+}
+
+TEST(SpatialTest, RStarTreeQueryRaycastRandom) {
+  gf::RStarTree spatial;
+  testQueryRaycastRandom(spatial);
+}
+
+TEST(SpatialTest, RStarTreeLoadEmpty) {
+  gf::RStarTree spatial;
+  auto ids = spatial.load(nullptr);
+  EXPECT_TRUE(ids.empty());
+
+  testInsertSimple(spatial);
+}
+
+TEST(SpatialTest, RStarTreeLoadRandom) {
+  gf::RStarTree spatial;
+  testLoadRandom(spatial);
+}
+
+TEST(SpatialTest, RStarTreeClear) {
+  gf::RStarTree spatial;
+  testInsertSimple(spatial);
+  spatial.clear();
+  testInsertSimple(spatial);
+}
+
+/*
+ * SpatialHashGrid
+ */
+
+TEST(SpatialTest, SpatialHashGridInsertSimple) {
+  gf::SpatialHashGrid spatial(CellSize);
+  testInsertSimple(spatial);
+}
+
+TEST(SpatialTest, SpatialHashGridInsertRandom) {
+  gf::SpatialHashGrid spatial(CellSize);
+  testInsertRandom(spatial);
+}
+
+TEST(SpatialTest, SpatialHashGridQueryRandom) {
+  gf::SpatialHashGrid spatial(CellSize);
+  testQueryRandom(spatial);
+}
+
+TEST(SpatialTest, SpatialHashGridRemoveRandom) {
+  gf::SpatialHashGrid spatial(CellSize);
+  testRemoveRandom(spatial);
+}
+
+TEST(SpatialTest, SpatialHashGridModifyRandom) {
+  gf::SpatialHashGrid spatial(CellSize);
+  testModifyRandom(spatial);
+}
+
+TEST(SpatialTest, SpatialHashGridQueryCallbackRandom) {
+  gf::SpatialHashGrid spatial(CellSize);
+  testQueryCallbackRandom(spatial);
+}
+
+TEST(SpatialTest, SpatialHashGridQueryNearestRandom) {
+  gf::SpatialHashGrid spatial(CellSize);
+  testQueryNearestRandom(spatial);
+}
+
+TEST(SpatialTest, SpatialHashGridOversized) {
+  gf::SpatialHashGrid spatial(CellSize);
+  const float Huge = std::numeric_limits<float>::max();
+
+  gf::SpatialId small = spatial.insert(gf::Handle(1), gf::RectF::fromPositionSize({ 10.0f, 10.0f }, { 1.0f, 1.0f }));
+  gf::SpatialId huge = spatial.insert(gf::Handle(2), gf::RectF::fromMinMax({ -Huge, -Huge }, { Huge, Huge }));
+  gf::SpatialId wide = spatial.insert(gf::Handle(3), gf::RectF::fromMinMax({ -1e9f, 0.0f }, { 1e9f, 1.0f }));
+
+  std::vector<gf::Handle> handles;
+  spatial.query(gf::RectF::fromPositionSize({ 10.5f, 0.5f }, { 0.1f, 0.1f }), handles);
+  EXPECT_EQ(handles.size(), 2u);
+
+  handles.clear();
+  spatial.query(gf::RectF::fromPositionSize({ 10.5f, 10.5f }, { 0.1f, 0.1f }), handles);
+  EXPECT_EQ(handles.size(), 2u);
+
+  std::size_t found = spatial.queryNearest({ 1e6f, 1e6f }, 1, [](gf::Handle handle) {
+    EXPECT_EQ(handle.asId(), 2u);
+  });
+  EXPECT_EQ(found, 1u);
+
+  // from oversized to normal and back
+  spatial.modify(huge, gf::RectF::fromPositionSize({ 100.0f, 100.0f }, { 1.0f, 1.0f }));
+  handles.clear();
+  spatial.query(gf::RectF::fromPositionSize({ 10.5f, 10.5f }, { 0.1f, 0.1f }), handles);
+  EXPECT_EQ(handles.size(), 1u);
+
+  spatial.modify(small, gf::RectF::fromMinMax({ -Huge, -Huge }, { Huge, Huge }));
+  spatial.remove(wide);
+  handles.clear();
+  spatial.query(gf::RectF::fromPositionSize({ 100.5f, 100.5f }, { 0.1f, 0.1f }), handles);
+  EXPECT_EQ(handles.size(), 2u);
+}
+
+/*
+ * All indexes
+ */
+
+TEST(SpatialTest, DISABLED_QueryCallbackBenchmark) {
+  {
+    gf::SimpleSpatialIndex spatial;
+    benchmarkQueryCallback(spatial, "SimpleSpatialIndex");
+  }
+
+  {
+    gf::Quadtree spatial(Bounds);
+    benchmarkQueryCallback(spatial, "Quadtree");
+  }
+
+  {
+    gf::DynamicTree spatial;
+    benchmarkQueryCallback(spatial, "DynamicTree");
+  }
+
+  {
+    gf::RStarTree spatial;
+    benchmarkQueryCallback(spatial, "RStarTree");
+  }
+
+  {
+    gf::SpatialHashGrid spatial(CellSize);
+    benchmarkQueryCallback(spatial, "SpatialHashGrid");
+  }
+}
+
+TEST(SpatialTest, WorkloadRandom) {
+  static constexpr std::size_t RoundCount = 2;
+
+  {
+    gf::SimpleSpatialIndex spatial;
+    testWorkloadRandom(spatial, RoundCount);
+  }
+
+  {
+    gf::Quadtree spatial(Bounds);
+    testWorkloadRandom(spatial, RoundCount);
+  }
+
+  {
+    gf::DynamicTree spatial;
+    testWorkloadRandom(spatial, RoundCount);
+  }
+
+  {
+    gf::RStarTree spatial;
+    testWorkloadRandom(spatial, RoundCount);
+  }
+
+  {
+    gf::SpatialHashGrid spatial(CellSize);
+    testWorkloadRandom(spatial, RoundCount);
+  }
+}
+
+TEST(SpatialTest, DISABLED_WorkloadBenchmark) {
+  static constexpr std::size_t RoundCount = 10;
+
+  {
+    gf::SimpleSpatialIndex spatial;
+    std::cout << "Workload time (SimpleSpatialIndex): " << testWorkloadRandom(spatial, RoundCount).asMilliseconds() << "ms\n";
+  }
+
+  {
+    gf::Quadtree spatial(Bounds);
+    std::cout << "Workload time (Quadtree): " << testWorkloadRandom(spatial, RoundCount).asMilliseconds() << "ms\n";
+  }
+
+  {
+    gf::DynamicTree spatial;
+    std::cout << "Workload time (DynamicTree): " << testWorkloadRandom(spatial, RoundCount).asMilliseconds() << "ms\n";
+  }
+
+  {
+    gf::RStarTree spatial;
+    std::cout << "Workload time (RStarTree): " << testWorkloadRandom(spatial, RoundCount).asMilliseconds() << "ms\n";
+  }
+
+  {
+    gf::SpatialHashGrid spatial(CellSize);
+    std::cout << "Workload time (SpatialHashGrid): " << testWorkloadRandom(spatial, RoundCount).asMilliseconds() << "ms\n";
+  }
+}
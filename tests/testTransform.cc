@@ -0,0 +1,184 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/Transform.h>
+
+#include <iostream>
+
+#include <gf/Clock.h>
+#include <gf/Random.h>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+  // the points stay in the cache, so that the computation is measured instead of the memory bandwidth
+  constexpr std::size_t BenchmarkSize = 4096;
+  constexpr std::size_t BenchmarkIterations = 1000;
+
+  std::vector<gf::Vector2f> getRandomPoints(gf::Random& random, std::size_t count) {
+    std::vector<gf::Vector2f> points;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      points.push_back(random.computePosition(gf::RectF::fromPositionSize({ -100.0f, -100.0f }, { 200.0f, 200.0f })));
+    }
+
+    return points;
+  }
+
+  gf::Matrix3f getRandomMatrix(gf::Random& random) {
+    gf::Matrix3f matrix = gf::identityTransform();
+    gf::rotate(matrix, random.computeAngle());
+    gf::scale(matrix, { random.computeUniformFloat(0.5f, 2.0f), random.computeUniformFloat(0.5f, 2.0f) });
+    gf::translate(matrix, random.computePosition(gf::RectF::fromSize({ 100.0f, 100.0f })));
+    return matrix;
+  }
+
+}
+
+TEST(TransformTest, BatchMatrix) {
+  gf::Random random(42);
+  gf::Matrix3f matrix = getRandomMatrix(random);
+
+  // all the sizes around the vector width, for the tails
+  for (std::size_t count = 0; count < 20; ++count) {
+    auto points = getRandomPoints(random, count);
+    std::vector<gf::Vector2f> result(count);
+    gf::transform(matrix, points, result);
+
+    std::vector<float> x, y;
+
+    for (auto point : points) {
+      x.push_back(point.x);
+      y.push_back(point.y);
+    }
+
+    std::vector<float> resultX(count), resultY(count);
+    gf::transform(matrix, x, y, resultX, resultY);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      gf::Vector2f expected = gf::transform(matrix, points[i]);
+      EXPECT_FLOAT_EQ(result[i].x, expected.x);
+      EXPECT_FLOAT_EQ(result[i].y, expected.y);
+      EXPECT_FLOAT_EQ(resultX[i], expected.x);
+      EXPECT_FLOAT_EQ(resultY[i], expected.y);
+    }
+
+    // in place
+    gf::transform(matrix, points, points);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      EXPECT_EQ(points[i], result[i]);
+    }
+  }
+}
+
+TEST(TransformTest, BatchTransform) {
+  gf::Random random(42);
+
+  for (std::size_t count = 1; count < 20; ++count) {
+    auto points = getRandomPoints(random, count);
+    std::vector<gf::Transform> transforms;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      transforms.emplace_back(random.computeAngle(), random.computePosition(gf::RectF::fromSize({ 100.0f, 100.0f })));
+    }
+
+    std::vector<gf::Vector2f> result(count);
+    gf::transform(transforms, points, result);
+
+    std::vector<gf::Vector2f> single(count);
+    gf::transform(transforms.front(), points, single);
+
+    for (std::size_t i = 0; i < count; ++i) {
+      gf::Vector2f expected = gf::transform(transforms[i], points[i]);
+      EXPECT_FLOAT_EQ(result[i].x, expected.x);
+      EXPECT_FLOAT_EQ(result[i].y, expected.y);
+
+      expected = gf::transform(transforms.front(), points[i]);
+      EXPECT_FLOAT_EQ(single[i].x, expected.x);
+      EXPECT_FLOAT_EQ(single[i].y, expected.y);
+    }
+  }
+}
+
+TEST(TransformTest, DISABLED_BatchBenchmark) {
+  gf::Random random(42);
+  gf::Matrix3f matrix = getRandomMatrix(random);
+  auto points = getRandomPoints(random, BenchmarkSize);
+  std::vector<gf::Vector2f> result(points.size());
+
+  std::vector<float> x, y;
+
+  for (auto point : points) {
+    x.push_back(point.x);
+    y.push_back(point.y);
+  }
+
+  std::vector<float> resultX(points.size()), resultY(points.size());
+
+  std::vector<gf::Transform> transforms;
+
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    transforms.emplace_back(random.computeAngle(), random.computePosition(gf::RectF::fromSize({ 100.0f, 100.0f })));
+  }
+
+  gf::Clock clock;
+
+  for (std::size_t k = 0; k < BenchmarkIterations; ++k) {
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      result[i] = gf::transform(matrix, points[i]);
+    }
+  }
+
+  gf::Time singleTime = clock.restart();
+
+  for (std::size_t k = 0; k < BenchmarkIterations; ++k) {
+    gf::transform(matrix, points, result);
+  }
+
+  gf::Time batchTime = clock.restart();
+
+  for (std::size_t k = 0; k < BenchmarkIterations; ++k) {
+    gf::transform(matrix, x, y, resultX, resultY);
+  }
+
+  gf::Time soaTime = clock.restart();
+
+  for (std::size_t k = 0; k < BenchmarkIterations; ++k) {
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      result[i] = gf::transform(transforms[i], points[i]);
+    }
+  }
+
+  gf::Time singleEachTime = clock.restart();
+
+  for (std::size_t k = 0; k < BenchmarkIterations; ++k) {
+    gf::transform(transforms, points, result);
+  }
+
+  gf::Time batchEachTime = clock.restart();
+
+  EXPECT_FLOAT_EQ(result.back().x, gf::transform(transforms.back(), points.back()).x);
+
+  std::cout << "Transformation of " << BenchmarkSize * BenchmarkIterations << " points\n";
+  std::cout << "Matrix: single " << singleTime.asMicroseconds() << "us, batch " << batchTime.asMicroseconds() << "us, SoA " << soaTime.asMicroseconds() << "us\n";
+  std::cout << "Transform per point: single " << singleEachTime.asMicroseconds() << "us, batch " << batchEachTime.asMicroseconds() << "us\n";
+}
@@ -0,0 +1,333 @@
+/*
+ * Gamedev Framework (gf)
+ * Copyright (C) 2016-2022 Julien Bernard
+ *
+ * This software is provided 'as-is', without any express or implied
+ * warranty.  In no event will the authors be held liable for any damages
+ * arising from the use of this software.
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software. If you use this software
+ *    in a product, an acknowledgment in the product documentation would be
+ *    appreciated but is not required.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ */
+#include <gf/Triangulation.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+#include <gf/Clock.h>
+#include <gf/Polygon.h>
+#include <gf/Random.h>
+
+#include "gtest/gtest.h"
+
+namespace {
+
+  double computeOrientation(gf::Vector2f a, gf::Vector2f b, gf::Vector2f c) {
+    return (double(b.x) - a.x) * (double(c.y) - a.y) - (double(b.y) - a.y) * (double(c.x) - a.x);
+  }
+
+  bool isInCircumcircle(gf::Vector2f a, gf::Vector2f b, gf::Vector2f c, gf::Vector2f d) {
+    if (computeOrientation(a, b, c) < 0) {
+      std::swap(b, c);
+    }
+
+    double adx = double(a.x) - d.x, ady = double(a.y) - d.y;
+    double bdx = double(b.x) - d.x, bdy = double(b.y) - d.y;
+    double cdx = double(c.x) - d.x, cdy = double(c.y) - d.y;
+    double ad = adx * adx + ady * ady, bd = bdx * bdx + bdy * bdy, cd = cdx * cdx + cdy * cdy;
+    double det = adx * (bdy * cd - bd * cdy) - ady * (bdx * cd - bd * cdx) + ad * (bdx * cdy - bdy * cdx);
+    return det > 1e-6;
+  }
+
+  // Andrew's monotone chain, without the collinear points
+  std::vector<gf::Vector2f> computeHull(std::vector<gf::Vector2f> points) {
+    std::sort(points.begin(), points.end(), [](gf::Vector2f lhs, gf::Vector2f rhs) {
+      return std::make_pair(lhs.x, lhs.y) < std::make_pair(rhs.x, rhs.y);
+    });
+
+    std::vector<gf::Vector2f> hull(2 * points.size());
+    std::size_t k = 0;
+
+    for (std::size_t i = 0; i < points.size(); ++i) {
+      while (k >= 2 && computeOrientation(hull[k - 2], hull[k - 1], points[i]) <= 0) {
+        --k;
+      }
+
+      hull[k++] = points[i];
+    }
+
+    for (std::size_t i = points.size() - 1, t = k + 1; i > 0; --i) {
+      while (k >= t && computeOrientation(hull[k - 2], hull[k - 1], points[i - 1]) <= 0) {
+        --k;
+      }
+
+      hull[k++] = points[i - 1];
+    }
+
+    hull.resize(k - 1);
+    return hull;
+  }
+
+  double computeHullArea(const std::vector<gf::Vector2f>& points) {
+    auto hull = computeHull(points);
+    double area = 0.0;
+
+    for (std::size_t i = 0; i < hull.size(); ++i) {
+      area += computeOrientation(gf::vec(0.0f, 0.0f), hull[i], hull[(i + 1) % hull.size()]) / 2;
+    }
+
+    return area;
+  }
+
+  std::vector<gf::Vector2f> getRandomPoints(gf::Random& random, std::size_t count) {
+    std::vector<gf::Vector2f> points;
+
+    for (std::size_t i = 0; i < count; ++i) {
+      points.push_back(random.computePosition(gf::RectF::fromSize({ 100.0f, 100.0f })));
+    }
+
+    return points;
+  }
+
+  void checkTriangulation(const gf::DelaunayTriangulation& delaunay, const std::vector<std::size_t>& vertices) {
+    auto triangles = delaunay.getTriangles();
+    std::map<std::pair<std::size_t, std::size_t>, int> edges;
+    std::vector<gf::Vector2f> points;
+    double area = 0.0;
+
+    for (auto vertex : vertices) {
+      points.push_back(delaunay.getPoint(vertex));
+    }
+
+    for (auto& triangle : triangles) {
+      gf::Vector2f p0 = delaunay.getPoint(triangle[0]);
+      gf::Vector2f p1 = delaunay.getPoint(triangle[1]);
+      gf::Vector2f p2 = delaunay.getPoint(triangle[2]);
+
+      double orientation = computeOrientation(p0, p1, p2);
+      EXPECT_GT(orientation, 0.0);
+      area += orientation / 2;
+
+      for (std::size_t i = 0; i < 3; ++i) {
+        ++edges[{ triangle[i], triangle[(i + 1) % 3] }];
+      }
+
+      for (auto vertex : vertices) {
+        if (vertex == triangle[0] || vertex == triangle[1] || vertex == triangle[2] || delaunay.isConstrainedEdge(triangle[0], triangle[1]) || delaunay.isConstrainedEdge(triangle[1], triangle[2]) || delaunay.isConstrainedEdge(triangle[2], triangle[0])) {
+          continue;
+        }
+
+        EXPECT_FALSE(isInCircumcircle(p0, p1, p2, delaunay.getPoint(vertex)));
+      }
+    }
+
+    for (auto& [ edge, count ] : edges) {
+      EXPECT_EQ(count, 1);
+    }
+
+    EXPECT_NEAR(area, computeHullArea(points), 1e-2);
+  }
+
+}
+
+TEST(TriangulationTest, Insert) {
+  gf::Random random(42);
+  auto points = getRandomPoints(random, 1000);
+
+  gf::DelaunayTriangulation delaunay(gf::RectF::fromSize({ 100.0f, 100.0f }));
+  std::vector<std::size_t> vertices;
+
+  for (auto point : points) {
+    vertices.push_back(delaunay.insertPoint(point));
+  }
+
+  for (std::size_t i = 0; i < points.size(); ++i) {
+    EXPECT_EQ(vertices[i], i);
+    EXPECT_EQ(delaunay.insertPoint(points[i]), i);
+  }
+
+  checkTriangulation(delaunay, vertices);
+  EXPECT_EQ(delaunay.getTriangles().size(), 2 * points.size() - 2 - computeHull(points).size());
+}
+
+TEST(TriangulationTest, Grid) {
+  gf::DelaunayTriangulation delaunay(gf::RectF::fromSize({ 10.0f, 10.0f }));
+  std::vector<std::size_t> vertices;
+
+  for (int i = 0; i <= 10; ++i) {
+    for (int j = 0; j <= 10; ++j) {
+      vertices.push_back(delaunay.insertPoint(gf::vec(float(i), float(j))));
+    }
+  }
+
+  checkTriangulation(delaunay, vertices);
+  EXPECT_EQ(delaunay.getTriangles().size(), 200u);
+}
+
+TEST(TriangulationTest, NearlyCollinear) {
+  gf::Random random(42);
+  gf::DelaunayTriangulation delaunay(gf::RectF::fromSize({ 100.0f, 100.0f }));
+  std::vector<std::size_t> vertices;
+
+  // the rounded points are on both sides of the diagonal, near the edges of the super triangle
+  for (std::size_t i = 0; i < 500; ++i) {
+    float t = random.computeUniformFloat(0.0f, 100.0f);
+    vertices.push_back(delaunay.insertPoint(gf::vec(t, t * 0.7f + 1.0f / 3.0f)));
+  }
+
+  vertices.push_back(delaunay.insertPoint(gf::vec(50.0f, 0.0f)));
+  vertices.push_back(delaunay.insertPoint(gf::vec(0.0f, 100.0f)));
+
+  checkTriangulation(delaunay, vertices);
+}
+
+TEST(TriangulationTest, Remove) {
+  gf::Random random(42);
+  auto points = getRandomPoints(random, 500);
+
+  gf::DelaunayTriangulation delaunay(gf::RectF::fromSize({ 100.0f, 100.0f }));
+  std::vector<std::size_t> vertices;
+
+  for (auto point : points) {
+    vertices.push_back(delaunay.insertPoint(point));
+  }
+
+  for (std::size_t i = 0; i < 300; ++i) {
+    std::size_t index = random.computeUniformInteger<std::size_t>(0, vertices.size() - 1);
+    delaunay.removePoint(vertices[index]);
+    vertices.erase(vertices.begin() + index);
+  }
+
+  checkTriangulation(delaunay, vertices);
+}
+
+TEST(TriangulationTest, Locate) {
+  gf::Random random(42);
+  auto points = getRandomPoints(random, 200);
+
+  gf::DelaunayTriangulation delaunay(gf::RectF::fromSize({ 100.0f, 100.0f }));
+
+  for (auto point : points) {
+    delaunay.insertPoint(point);
+  }
+
+  gf::Polygon hull(computeHull(points));
+
+  for (std::size_t i = 0; i < 1000; ++i) {
+    gf::Vector2f point = random.computePosition(gf::RectF::fromSize({ 100.0f, 100.0f }));
+    std::size_t triangle = delaunay.locate(point);
+
+    if (triangle == gf::NullIndex) {
+      EXPECT_FALSE(hull.contains(point));
+      continue;
+    }
+
+    auto vertices = delaunay.getTriangle(triangle);
+
+    for (std::size_t j = 0; j < 3; ++j) {
+      EXPECT_GE(computeOrientation(delaunay.getPoint(vertices[j]), delaunay.getPoint(vertices[(j + 1) % 3]), point), 0.0);
+    }
+  }
+}
+
+TEST(TriangulationTest, Constrained) {
+  gf::Random random(42);
+  auto points = getRandomPoints(random, 500);
+
+  gf::DelaunayTriangulation delaunay(gf::RectF::fromSize({ 100.0f, 100.0f }));
+  std::vector<std::size_t> vertices;
+
+  for (auto point : points) {
+    vertices.push_back(delaunay.insertPoint(point));
+  }
+
+  // a constrained path along the diagonal, through a point in the middle
+  std::size_t v0 = delaunay.insertPoint({ 0.0f, 0.0f });
+  std::size_t v1 = delaunay.insertPoint({ 50.0f, 50.0f });
+  std::size_t v2 = delaunay.insertPoint({ 100.0f, 100.0f });
+  vertices.insert(vertices.end(), { v0, v1, v2 });
+
+  EXPECT_TRUE(delaunay.insertConstrainedEdge(v0, v2));
+  EXPECT_TRUE(delaunay.isConstrainedEdge(v0, v1));
+  EXPECT_TRUE(delaunay.isConstrainedEdge(v2, v1));
+
+  EXPECT_TRUE(delaunay.insertConstrainedEdge(vertices[0], vertices[1]));
+  EXPECT_TRUE(delaunay.isConstrainedEdge(vertices[0], vertices[1]));
+
+  // the constraints are kept when inserting and removing points
+  for (std::size_t i = 0; i < 50; ++i) {
+    std::size_t index = random.computeUniformInteger<std::size_t>(2, vertices.size() - 4);
+    delaunay.removePoint(vertices[index]);
+    vertices.erase(vertices.begin() + index);
+  }
+
+  for (auto point : getRandomPoints(random, 200)) {
+    delaunay.insertPoint(point);
+  }
+
+  EXPECT_TRUE(delaunay.isConstrainedEdge(v0, v1));
+  EXPECT_TRUE(delaunay.isConstrainedEdge(v1, v2));
+  EXPECT_TRUE(delaunay.isConstrainedEdge(vertices[0], vertices[1]));
+
+  // a point on a constrained edge splits it
+  std::size_t v3 = delaunay.insertPoint({ 25.0f, 25.0f });
+  EXPECT_TRUE(delaunay.isConstrainedEdge(v0, v3));
+  EXPECT_TRUE(delaunay.isConstrainedEdge(v3, v1));
+  EXPECT_FALSE(delaunay.isConstrainedEdge(v0, v1));
+
+  // a crossing constrained edge is refused
+  std::size_t v4 = delaunay.insertPoint({ 0.0f, 90.0f });
+  std::size_t v5 = delaunay.insertPoint({ 90.0f, 0.0f });
+  EXPECT_FALSE(delaunay.insertConstrainedEdge(v4, v5));
+}
+
+TEST(TriangulationTest, Function) {
+  std::vector<gf::Vector2f> points = { { 0.0f, 0.0f }, { 10.0f, 0.0f }, { 10.0f, 1.0f }, { 0.0f, 1.0f }, { 5.0f, 0.4f }, { 10.0f, 0.0f } };
+
+  auto triangles = gf::triangulation(points);
+  EXPECT_EQ(triangles.size(), 4u);
+
+  for (auto& triangle : triangles) {
+    for (std::size_t i = 0; i < 3; ++i) {
+      EXPECT_NE(&triangle[i], &points[5]);
+    }
+  }
+
+  std::vector<gf::EdgeRef<gf::Vector2f>> edges = { { points[0], points[2] } };
+  auto constrained = gf::triangulationConstrained(points, edges);
+  EXPECT_EQ(constrained.size(), 4u);
+
+  bool found = false;
+
+  for (auto& triangle : constrained) {
+    for (std::size_t i = 0; i < 3; ++i) {
+      if ((&triangle[i] == &points[0] && &triangle[(i + 1) % 3] == &points[2]) || (&triangle[i] == &points[2] && &triangle[(i + 1) % 3] == &points[0])) {
+        found = true;
+      }
+    }
+  }
+
+  EXPECT_TRUE(found);
+}
+
+TEST(TriangulationTest, DISABLED_Benchmark) {
+  gf::Random random(42);
+  auto points = getRandomPoints(random, 100000);
+
+  gf::Clock clock;
+  auto triangles = gf::triangulation(points);
+  gf::Time time = clock.restart();
+
+  EXPECT_EQ(triangles.size(), 2 * points.size() - 2 - computeHull(points).size());
+  std::cout << "Triangulation of " << points.size() << " points: " << time.asMilliseconds() << "ms\n";
+}
@@ -6,11 +6,12 @@ if has_config("tests") then
     target("gf_core_tests")
         set_kind("binary")
         set_languages("cxx17")
-        add_files("testCirc.cc", "testDice.cc", "testFlags.cc", "testId.cc", "testMatrix.cc", "testMatrix2.cc", "testRange.cc", "testRect.cc", "testSerialization.cc", "testSingleton.cc", "testSpatial.cc", "testSpan.cc", "testVector.cc", "testVector1.cc", "testVector2.cc", "testVector3.cc", "testVector4.cc")
+        add_files("testBroadPhase.cc", "testCirc.cc", "testCollision.cc", "testDice.cc", "testFlags.cc", "testHeightmap.cc", "testId.cc", "testMap.cc", "testMatrix.cc", "testMatrix2.cc", "testNoise.cc", "testRange.cc", "testRect.cc", "testSerialization.cc", "testSingleton.cc", "testSpatial.cc", "testSpan.cc", "testTransform.cc", "testTriangulation.cc", "testVector.cc", "testVector1.cc", "testVector2.cc", "testVector3.cc", "testVector4.cc")
         add_files("main.cc")
         add_deps("gfcore0")
         add_packages("gtest")
         add_tests("default")
+        add_tests("sse2", { runargs = "--gtest_filter=NoiseTest.FillGrid*", runenvs = { GF_NOISE_NO_AVX2 = "1" } })
 
     target("gf_network_tests")
         set_kind("binary")